@@ -92,4 +92,21 @@ protected:
 													double quaternionScale,
 													LoadParameters& parameters,
 													bool showLabelsIn2D = false);
+
+	//! Loads memory-mapped ASCII data with a predefined format
+	/** The data is split into blocks of lines, which are parsed concurrently (without
+		locale) and appended to the cloud(s) in order. The sequence must only describe
+		point attributes (no label nor quaternion).
+	**/
+	CC_FILE_ERROR loadCloudFromMappedAsciiData(	const char* data,
+												qint64 dataSize,
+												QString filenameOrTitle,
+												ccHObject& container,
+												const AsciiOpenDlg::Sequence& openSequence,
+												char separator,
+												bool commaAsDecimal,
+												unsigned approximateNumberOfLines,
+												unsigned maxCloudSize,
+												unsigned skipLines,
+												LoadParameters& parameters);
 };
@@ -20,8 +20,11 @@
 //Qt
 #include <QFile>
 #include <QFileInfo>
+#include <QFuture>
 #include <QSharedPointer>
 #include <QTextStream>
+#include <QThread>
+#include <QtConcurrentMap>
 
 //CClib
 #include <ScalarField.h>
@@ -36,7 +39,9 @@
 #include <ccCoordinateSystem.h>
 
 //System
+#include <algorithm>
 #include <cassert>
+#include <climits>
 #include <cstring>
 
 //Qt
@@ -444,6 +449,26 @@ CC_FILE_ERROR AsciiFilter::loadAsciiData(	const QByteArray& data,
 	return loadStream(stream, sourceName, data.size(), container, parameters);
 }
 
+//! Returns whether the lines can be parsed concurrently (labels and quaternions create entities)
+static bool CanBeParsedConcurrently(const AsciiOpenDlg::Sequence& openSequence)
+{
+	for (const AsciiOpenDlg::SequenceItem& item : openSequence)
+	{
+		switch (item.type)
+		{
+		case ASCII_OPEN_DLG_Label:
+		case ASCII_OPEN_DLG_QuatW:
+		case ASCII_OPEN_DLG_QuatX:
+		case ASCII_OPEN_DLG_QuatY:
+		case ASCII_OPEN_DLG_QuatZ:
+			return false;
+		default:
+			break;
+		}
+	}
+	return true;
+}
+
 CC_FILE_ERROR AsciiFilter::loadStream(	QTextStream& stream,
 										QString filenameOrTitle,
 										qint64 dataSize,
@@ -488,6 +513,38 @@ CC_FILE_ERROR AsciiFilter::loadStream(	QTextStream& stream,
 	bool showLabelsIn2D = openDialog.showLabelsIn2D();
 	double quaternionScale = openDialog.getQuaternionScale();
 
+	//the lines of a file are parsed concurrently if they only describe points
+	QFile* file = qobject_cast<QFile*>(stream.device());
+	if (file && CanBeParsedConcurrently(openSequence))
+	{
+		const uchar* data = file->map(0, dataSize);
+		if (data)
+		{
+			//UTF-16 files are decoded by the stream
+			if (dataSize < 2 || !((data[0] == 0xFF && data[1] == 0xFE) || (data[0] == 0xFE && data[1] == 0xFF)))
+			{
+				CC_FILE_ERROR result = loadCloudFromMappedAsciiData(	reinterpret_cast<const char*>(data),
+																		dataSize,
+																		filenameOrTitle,
+																		container,
+																		openSequence,
+																		separator,
+																		commaAsDecimal,
+																		approximateNumberOfLines,
+																		maxCloudSize,
+																		skipLineCount,
+																		parameters);
+				file->unmap(const_cast<uchar*>(data));
+				return result;
+			}
+			file->unmap(const_cast<uchar*>(data));
+		}
+		else
+		{
+			ccLog::PrintDebug("[ASCII] Failed to map the file in memory, it will be read line by line");
+		}
+	}
+
 	return loadCloudFromFormatedAsciiStream(stream,
 											filenameOrTitle,
 											container,
@@ -1202,3 +1259,632 @@ CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream& stream,
 
 	return result;
 }
+
+//! Size of the blocks of lines parsed concurrently (in bytes)
+static const qint64 s_asciiBlockSize = (4 << 20);
+
+//! Parses a decimal number without locale (common notations only)
+/** \return false if the token couldn't be parsed exactly (it may still be a valid number for QLocale)
+**/
+static bool FastParseDouble(const char* begin, const char* end, char decimalPoint, double& value)
+{
+	static const double s_powersOf10[] = {	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+											1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	const char* p = begin;
+	bool negative = false;
+	if (p != end && (*p == '-' || *p == '+'))
+	{
+		negative = (*p == '-');
+		++p;
+	}
+
+	uint64_t mantissa = 0;
+	int significantDigits = 0;
+	int exponent = 0;
+	bool hasDigits = false;
+	for (; p != end && *p >= '0' && *p <= '9'; ++p)
+	{
+		hasDigits = true;
+		if ((mantissa != 0 || *p != '0') && ++significantDigits > 19)
+			return false;
+		mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+	}
+	if (p != end && *p == decimalPoint)
+	{
+		for (++p; p != end && *p >= '0' && *p <= '9'; ++p)
+		{
+			hasDigits = true;
+			if ((mantissa != 0 || *p != '0') && ++significantDigits > 19)
+				return false;
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+			--exponent;
+		}
+	}
+	if (!hasDigits)
+	{
+		return false;
+	}
+
+	if (p != end && (*p == 'e' || *p == 'E'))
+	{
+		++p;
+		bool negativeExponent = false;
+		if (p != end && (*p == '-' || *p == '+'))
+		{
+			negativeExponent = (*p == '-');
+			++p;
+		}
+		if (p == end || *p < '0' || *p > '9')
+		{
+			return false;
+		}
+		int e = 0;
+		for (; p != end && *p >= '0' && *p <= '9'; ++p)
+		{
+			if (e > 1000)
+				return false;
+			e = e * 10 + (*p - '0');
+		}
+		exponent += (negativeExponent ? -e : e);
+	}
+
+	if (p != end)
+	{
+		//unexpected character
+		return false;
+	}
+
+	//the result is correctly rounded if both the mantissa and the power of 10 are exact doubles
+	if (mantissa > (uint64_t(1) << 53) || exponent < -22 || exponent > 22)
+	{
+		return false;
+	}
+	double v = static_cast<double>(mantissa);
+	v = (exponent < 0 ? v / s_powersOf10[-exponent] : v * s_powersOf10[exponent]);
+	value = (negative ? -v : v);
+
+	return true;
+}
+
+//! Parses an integer without locale
+/** \return false if the token isn't a (32 bits) integer
+**/
+static bool FastParseInt(const char* begin, const char* end, int& value)
+{
+	const char* p = begin;
+	bool negative = false;
+	if (p != end && (*p == '-' || *p == '+'))
+	{
+		negative = (*p == '-');
+		++p;
+	}
+	if (p == end)
+	{
+		return false;
+	}
+
+	int64_t v = 0;
+	for (; p != end; ++p)
+	{
+		if (*p < '0' || *p > '9')
+			return false;
+		v = v * 10 + (*p - '0');
+		if (v > static_cast<int64_t>(INT_MAX) + 1)
+			return false;
+	}
+	v = (negative ? -v : v);
+	if (v > INT_MAX)
+	{
+		return false;
+	}
+	value = static_cast<int>(v);
+
+	return true;
+}
+
+//! Columns read by the concurrent parser
+struct AsciiColumns
+{
+	std::vector<int> slots; //!< index of each column in the values of a point (-1 if the column is not read)
+	std::vector<bool> isInteger; //!< whether each column is read as an integer
+	std::vector<int> coordColumns; //!< X, Y and Z columns (lines with a non numerical coordinate are corrupted)
+	size_t slotCount = 0;
+	int maxPartIndex = -1;
+	char separator = ' ';
+	bool commaAsDecimal = false;
+};
+
+//! Block of lines parsed concurrently
+struct AsciiBlock
+{
+	const char* begin = nullptr;
+	const char* end = nullptr;
+	unsigned lineCount = 0; //!< all the lines (including the empty ones and the comments)
+	unsigned pointCount = 0;
+	std::vector<double> values; //!< values of the read columns (slotCount per point)
+	std::vector<std::pair<unsigned, int>> corruptedLines; //!< line index in the block and number of parts (-1 if a coordinate isn't numerical)
+};
+
+//! Returns the end of the line (or of the data) and the beginning of the next one
+static const char* FindLineEnd(const char* lineStart, const char* dataEnd, const char*& nextLine)
+{
+	const char* lineEnd = static_cast<const char*>(memchr(lineStart, '\n', dataEnd - lineStart));
+	if (!lineEnd)
+	{
+		lineEnd = dataEnd;
+		nextLine = dataEnd;
+	}
+	else
+	{
+		nextLine = lineEnd + 1;
+	}
+	if (lineEnd != lineStart && lineEnd[-1] == '\r')
+	{
+		--lineEnd;
+	}
+	return lineEnd;
+}
+
+static inline bool IsBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+//! Parses the lines of a block (same rules as loadCloudFromFormatedAsciiStream)
+static void ParseAsciiBlock(AsciiBlock& block, const AsciiColumns& columns)
+{
+	block.lineCount = 0;
+	block.pointCount = 0;
+	block.values.clear();
+	block.corruptedLines.clear();
+
+	QLocale locale(columns.commaAsDecimal ? QLocale::French : QLocale::English);
+	const char decimalPoint = (columns.commaAsDecimal ? ',' : '.');
+	const bool blankSeparator = IsBlank(columns.separator);
+	const int partCount = columns.maxPartIndex + 1;
+
+	std::vector<std::pair<const char*, const char*>> parts;
+	parts.reserve(partCount);
+
+	const char* nextLine = block.begin;
+	while (nextLine < block.end)
+	{
+		const char* lineStart = nextLine;
+		const char* lineEnd = FindLineEnd(lineStart, block.end, nextLine);
+		++block.lineCount;
+
+		if (lineStart == lineEnd || (lineEnd - lineStart >= 2 && lineStart[0] == '/' && lineStart[1] == '/'))
+		{
+			//empty lines and comments are ignored
+			continue;
+		}
+
+		//split the line (as with 'simplified().split(separator, QString::SkipEmptyParts)')
+		parts.clear();
+		while (lineStart != lineEnd && IsBlank(*lineStart))
+			++lineStart;
+		while (lineEnd != lineStart && IsBlank(lineEnd[-1]))
+			--lineEnd;
+		for (const char* p = lineStart; p != lineEnd && static_cast<int>(parts.size()) < partCount; )
+		{
+			const char* partEnd = p;
+			if (blankSeparator)
+			{
+				while (partEnd != lineEnd && !IsBlank(*partEnd))
+					++partEnd;
+				parts.emplace_back(p, partEnd);
+				while (partEnd != lineEnd && IsBlank(*partEnd))
+					++partEnd;
+				p = partEnd;
+			}
+			else
+			{
+				while (partEnd != lineEnd && *partEnd != columns.separator)
+					++partEnd;
+				if (partEnd != p)
+				{
+					const char* partStart = p;
+					const char* partStop = partEnd;
+					while (partStart != partStop && IsBlank(*partStart))
+						++partStart;
+					while (partStop != partStart && IsBlank(partStop[-1]))
+						--partStop;
+					parts.emplace_back(partStart, partStop);
+				}
+				p = (partEnd != lineEnd ? partEnd + 1 : lineEnd);
+			}
+		}
+
+		if (static_cast<int>(parts.size()) < partCount)
+		{
+			block.corruptedLines.emplace_back(block.lineCount, static_cast<int>(parts.size()));
+			continue;
+		}
+
+		size_t firstValue = block.values.size();
+		block.values.resize(firstValue + columns.slotCount, 0.0);
+		double* values = block.values.data() + firstValue;
+
+		bool lineIsCorrupted = false;
+		for (int column = 0; column < partCount; ++column)
+		{
+			int slot = columns.slots[column];
+			if (slot < 0)
+			{
+				continue;
+			}
+
+			const char* partStart = parts[column].first;
+			const char* partEnd = parts[column].second;
+			bool ok = true;
+			if (columns.isInteger[column])
+			{
+				int i = 0;
+				if (!FastParseInt(partStart, partEnd, i))
+				{
+					i = QString::fromLatin1(partStart, static_cast<int>(partEnd - partStart)).toInt(&ok);
+				}
+				values[slot] = i;
+			}
+			else if (!FastParseDouble(partStart, partEnd, decimalPoint, values[slot]))
+			{
+				values[slot] = locale.toDouble(QString::fromLatin1(partStart, static_cast<int>(partEnd - partStart)), &ok);
+			}
+
+			if (!ok && std::find(columns.coordColumns.begin(), columns.coordColumns.end(), column) != columns.coordColumns.end())
+			{
+				lineIsCorrupted = true;
+				break;
+			}
+		}
+
+		if (lineIsCorrupted)
+		{
+			block.values.resize(firstValue);
+			block.corruptedLines.emplace_back(block.lineCount, -1);
+			continue;
+		}
+
+		++block.pointCount;
+	}
+}
+
+CC_FILE_ERROR AsciiFilter::loadCloudFromMappedAsciiData(const char* data,
+														qint64 dataSize,
+														QString filenameOrTitle,
+														ccHObject& container,
+														const AsciiOpenDlg::Sequence& openSequence,
+														char separator,
+														bool commaAsDecimal,
+														unsigned approximateNumberOfLines,
+														unsigned maxCloudSize,
+														unsigned skipLines,
+														LoadParameters& parameters)
+{
+	//we may have to "slice" clouds when opening them if they are too big!
+	maxCloudSize = std::min(maxCloudSize, CC_MAX_NUMBER_OF_POINTS_PER_CLOUD);
+	unsigned chunkRank = 1;
+
+	//we initialize the loading accelerator structure and point cloud
+	int maxPartIndex = -1;
+	cloudAttributesDescriptor cloudDesc = prepareCloud(openSequence, std::min(maxCloudSize, approximateNumberOfLines), maxPartIndex, chunkRank);
+	if (!cloudDesc.cloud)
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+
+	//the columns read by the parser (the ones of the first cloud)
+	AsciiColumns columns;
+	columns.maxPartIndex = maxPartIndex;
+	columns.separator = separator;
+	columns.commaAsDecimal = commaAsDecimal;
+	columns.slots.resize(maxPartIndex + 1, -1);
+	columns.isInteger.resize(maxPartIndex + 1, false);
+	{
+		std::vector<int> readColumns(std::begin(cloudDesc.indexes), std::end(cloudDesc.indexes));
+		readColumns.insert(readColumns.end(), cloudDesc.scalarIndexes.begin(), cloudDesc.scalarIndexes.end());
+		for (int column : readColumns)
+		{
+			if (column >= 0 && columns.slots[column] < 0)
+			{
+				columns.slots[column] = static_cast<int>(columns.slotCount++);
+			}
+		}
+		for (int column : { cloudDesc.xCoordIndex, cloudDesc.yCoordIndex, cloudDesc.zCoordIndex })
+		{
+			if (column >= 0)
+				columns.coordColumns.push_back(column);
+		}
+		for (int column : { cloudDesc.iRgbaIndex, cloudDesc.greyIndex })
+		{
+			if (column >= 0)
+				columns.isInteger[column] = true;
+		}
+	}
+
+	const char* dataEnd = data + dataSize;
+	const char* position = data;
+
+	//UTF-8 BOM
+	if (dataSize >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+	{
+		position += 3;
+	}
+
+	//we skip lines as defined on input (empty lines are ignored)
+	for (unsigned i = 0; i < skipLines && position < dataEnd; )
+	{
+		const char* lineStart = position;
+		const char* lineEnd = FindLineEnd(lineStart, dataEnd, position);
+		if (lineEnd != lineStart)
+		{
+			++i;
+		}
+	}
+
+	//progress indicator (one step per block)
+	QScopedPointer<ccProgressDialog> pDlg(nullptr);
+	if (parameters.parentWidget)
+	{
+		pDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
+		pDlg->setMethodTitle(QObject::tr("Open ASCII data [%1]").arg(filenameOrTitle));
+		pDlg->setInfo(QObject::tr("Approximate number of points: %1").arg(approximateNumberOfLines));
+		pDlg->start();
+	}
+	CCCoreLib::NormalizedProgress nprogress(pDlg.data(), static_cast<unsigned>((dataEnd - position) / s_asciiBlockSize + 1));
+
+	//the blocks are parsed by windows: the next window is parsed while the current one is added to the cloud
+	const size_t windowSize = 2 * static_cast<size_t>(std::max(QThread::idealThreadCount(), 1));
+	std::vector<AsciiBlock> windows[2] { std::vector<AsciiBlock>(windowSize), std::vector<AsciiBlock>(windowSize) };
+	size_t windowBlockCounts[2] { 0, 0 };
+
+	auto fillWindow = [&](int w)
+	{
+		size_t count = 0;
+		for (; count < windowSize && position < dataEnd; ++count)
+		{
+			AsciiBlock& block = windows[w][count];
+			block.begin = position;
+			block.end = position + std::min(s_asciiBlockSize, static_cast<qint64>(dataEnd - position));
+			if (block.end < dataEnd)
+			{
+				//the blocks end with a full line
+				const char* newLine = static_cast<const char*>(memchr(block.end - 1, '\n', dataEnd - (block.end - 1)));
+				block.end = (newLine ? newLine + 1 : dataEnd);
+			}
+			position = block.end;
+		}
+		windowBlockCounts[w] = count;
+	};
+
+	auto parseWindow = [&](int w)
+	{
+		return QtConcurrent::map(windows[w].begin(), windows[w].begin() + windowBlockCounts[w], [&columns](AsciiBlock& block) { ParseAsciiBlock(block, columns); });
+	};
+
+	//buffers
+	CCVector3d P(0, 0, 0);
+	CCVector3d Pshift(0, 0, 0);
+	bool preserveCoordinateShift = true;
+
+	unsigned linesRead = 0;
+	unsigned pointsRead = 0;
+	qint64 bytesRead = 0;
+	const qint64 bytesToRead = dataEnd - position;
+
+	CC_FILE_ERROR result = CC_FERR_NO_ERROR;
+
+	auto finalizeCloud = [&]()
+	{
+		if (cloudDesc.cloud->size() < cloudDesc.cloud->capacity())
+		{
+			cloudDesc.cloud->resize(cloudDesc.cloud->size());
+		}
+		if (!cloudDesc.scalarFields.empty())
+		{
+			for (size_t j = 0; j < cloudDesc.scalarFields.size(); ++j)
+			{
+				if (cloudDesc.scalarFields[j]->resizeSafe(cloudDesc.cloud->size(), true, CCCoreLib::NAN_VALUE))
+				{
+					cloudDesc.scalarFields[j]->computeMinAndMax();
+				}
+			}
+			cloudDesc.cloud->setCurrentDisplayedScalarField(0);
+			cloudDesc.cloud->showSF(true);
+		}
+		container.addChild(cloudDesc.cloud);
+		cloudDesc.reset();
+	};
+
+	auto appendBlock = [&](const AsciiBlock& block)
+	{
+		for (const std::pair<unsigned, int>& corruptedLine : block.corruptedLines)
+		{
+			if (corruptedLine.second < 0)
+				ccLog::Warning("[AsciiFilter::Load] Line %i is corrupted (non numerical value found)", linesRead + corruptedLine.first);
+			else
+				ccLog::Warning("[AsciiFilter::Load] Line %i is corrupted (found %i part(s) on %i expected)!", linesRead + corruptedLine.first, corruptedLine.second, maxPartIndex + 1);
+		}
+		linesRead += block.lineCount;
+
+		//the remaining number of points is estimated with the average size of the lines read so far
+		bytesRead += (block.end - block.begin);
+		auto estimatedPointCount = [&]() -> unsigned
+		{
+			double remainingPoints = (pointsRead + block.pointCount) * static_cast<double>(bytesToRead - bytesRead) / std::max<qint64>(bytesRead, 1);
+			return static_cast<unsigned>(std::min(ceil(remainingPoints * 1.02), static_cast<double>(maxCloudSize)));
+		};
+
+		for (unsigned i = 0; i < block.pointCount; ++i)
+		{
+			ccPointCloud* cloud = cloudDesc.cloud;
+
+			//if we have reached the max. number of points per cloud
+			if (cloud->size() == maxCloudSize)
+			{
+				ccLog::PrintDebug("[ASCII] Point %i -> end of chunk (%i points)", pointsRead, maxCloudSize);
+				finalizeCloud();
+
+				cloudDesc = prepareCloud(openSequence, std::min(maxCloudSize, (block.pointCount - i) + estimatedPointCount()), maxPartIndex, ++chunkRank);
+				if (!cloudDesc.cloud)
+				{
+					ccLog::Error("Not enough memory! Process stopped ...");
+					return CC_FERR_NOT_ENOUGH_MEMORY;
+				}
+				if (preserveCoordinateShift)
+				{
+					cloudDesc.cloud->setGlobalShift(Pshift);
+				}
+				cloud = cloudDesc.cloud;
+			}
+			else if (cloud->size() == cloud->capacity())
+			{
+				unsigned newCapacity = std::min(maxCloudSize, cloud->size() + (block.pointCount - i) + estimatedPointCount());
+				if (!cloud->reserve(newCapacity))
+				{
+					ccLog::Error("Not enough memory! Process stopped ...");
+					return CC_FERR_NOT_ENOUGH_MEMORY;
+				}
+			}
+
+			const double* values = block.values.data() + i * columns.slotCount;
+			auto value = [&](int column) -> double
+			{
+				const int slot = (column >= 0 && column < static_cast<int>(columns.slots.size()) ? columns.slots[column] : -1);
+				return (slot >= 0 ? values[slot] : 0.0);
+			};
+
+			P = CCVector3d(value(cloudDesc.xCoordIndex), value(cloudDesc.yCoordIndex), value(cloudDesc.zCoordIndex));
+
+			//first point: check for 'big' coordinates
+			if (pointsRead == 0)
+			{
+				if (HandleGlobalShift(P, Pshift, preserveCoordinateShift, parameters))
+				{
+					if (preserveCoordinateShift)
+					{
+						cloud->setGlobalShift(Pshift);
+					}
+					ccLog::Warning("[ASCIIFilter::loadFile] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", Pshift.x, Pshift.y, Pshift.z);
+				}
+			}
+
+			//add point
+			cloud->addPoint((P + Pshift).toPC());
+
+			//Normal vector
+			if (cloudDesc.hasNorms)
+			{
+				cloud->addNorm(CCVector3(	static_cast<PointCoordinateType>(value(cloudDesc.xNormIndex)),
+											static_cast<PointCoordinateType>(value(cloudDesc.yNormIndex)),
+											static_cast<PointCoordinateType>(value(cloudDesc.zNormIndex)) ));
+			}
+
+			//Colors
+			ccColor::Rgba col(0, 0, 0, 255);
+			if (cloudDesc.hasRGBColors)
+			{
+				if (cloudDesc.iRgbaIndex >= 0)
+				{
+					const uint32_t rgba = static_cast<uint32_t>(static_cast<int>(value(cloudDesc.iRgbaIndex)));
+					col.a = ((rgba >> 24) & 0x0000ff);
+					col.r = ((rgba >> 16) & 0x0000ff);
+					col.g = ((rgba >>  8) & 0x0000ff);
+					col.b = ((rgba      ) & 0x0000ff);
+				}
+				else if (cloudDesc.fRgbaIndex >= 0)
+				{
+					const float rgbaf = static_cast<float>(value(cloudDesc.fRgbaIndex));
+					const uint32_t rgba = *(reinterpret_cast<const uint32_t *>(&rgbaf));
+					col.a = ((rgba >> 24) & 0x0000ff);
+					col.r = ((rgba >> 16) & 0x0000ff);
+					col.g = ((rgba >>  8) & 0x0000ff);
+					col.b = ((rgba      ) & 0x0000ff);
+				}
+				else
+				{
+					if (cloudDesc.redIndex >= 0)
+					{
+						float multiplier = cloudDesc.hasFloatRGBColors[0] ? static_cast<float>(ccColor::MAX) : 1.0f;
+						col.r = static_cast<ColorCompType>(static_cast<float>(value(cloudDesc.redIndex)) * multiplier);
+					}
+					if (cloudDesc.greenIndex >= 0)
+					{
+						float multiplier = cloudDesc.hasFloatRGBColors[1] ? static_cast<float>(ccColor::MAX) : 1.0f;
+						col.g = static_cast<ColorCompType>(static_cast<float>(value(cloudDesc.greenIndex)) * multiplier);
+					}
+					if (cloudDesc.blueIndex >= 0)
+					{
+						float multiplier = cloudDesc.hasFloatRGBColors[2] ? static_cast<float>(ccColor::MAX) : 1.0f;
+						col.b = static_cast<ColorCompType>(static_cast<float>(value(cloudDesc.blueIndex)) * multiplier);
+					}
+					if (cloudDesc.alphaIndex >= 0)
+					{
+						float multiplier = cloudDesc.hasFloatRGBColors[3] ? static_cast<float>(ccColor::MAX) : 1.0f;
+						col.a = static_cast<ColorCompType>(static_cast<float>(value(cloudDesc.alphaIndex)) * multiplier);
+					}
+				}
+				cloud->addColor(col);
+			}
+			else if (cloudDesc.greyIndex >= 0)
+			{
+				col.r = col.g = col.b = static_cast<ColorCompType>(static_cast<int>(value(cloudDesc.greyIndex)));
+				col.a = ccColor::MAX;
+				cloud->addColor(col);
+			}
+
+			//Scalar distance
+			for (size_t j = 0; j < cloudDesc.scalarIndexes.size(); ++j)
+			{
+				cloudDesc.scalarFields[j]->addElement(static_cast<ScalarType>(value(cloudDesc.scalarIndexes[j])));
+			}
+
+			++pointsRead;
+		}
+
+		return CC_FERR_NO_ERROR;
+	};
+
+	//main process
+	int current = 0;
+	fillWindow(current);
+	QFuture<void> future = parseWindow(current);
+	while (windowBlockCounts[current] != 0)
+	{
+		future.waitForFinished();
+
+		const int next = 1 - current;
+		fillWindow(next);
+		future = parseWindow(next);
+
+		for (size_t i = 0; i < windowBlockCounts[current]; ++i)
+		{
+			result = appendBlock(windows[current][i]);
+			if (result == CC_FERR_NO_ERROR && pDlg && !nprogress.oneStep())
+			{
+				//cancel requested
+				result = CC_FERR_CANCELED_BY_USER;
+			}
+			if (result != CC_FERR_NO_ERROR)
+			{
+				break;
+			}
+		}
+		if (result != CC_FERR_NO_ERROR)
+		{
+			future.cancel();
+			break;
+		}
+
+		current = next;
+	}
+	future.waitForFinished();
+
+	if (cloudDesc.cloud)
+	{
+		finalizeCloud();
+	}
+
+	return result;
+}
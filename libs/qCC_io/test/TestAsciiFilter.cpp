@@ -0,0 +1,162 @@
+#include <cmath>
+
+#include "TestAsciiFilter.h"
+
+#include "AsciiFilter.h"
+#include "ccHObject.h"
+#include "ccPointCloud.h"
+
+//! Gives access to both ASCII parsers
+class AsciiParsers : public AsciiFilter
+{
+public:
+	using AsciiFilter::loadCloudFromFormatedAsciiStream;
+	using AsciiFilter::loadCloudFromMappedAsciiData;
+};
+
+static void SetDefaultLoadParameters(FileIOFilter::LoadParameters& params, CCVector3d& shift, bool& shiftEnabled)
+{
+	params.alwaysDisplayLoadDialog = false;
+	params.shiftHandlingMode = ccGlobalShiftManager::Mode::NO_DIALOG;
+	params._coordinatesShiftEnabled = &shiftEnabled;
+	params._coordinatesShift = &shift;
+	params.preserveShiftOnSave = true;
+}
+
+//! Exact comparison (NaN values are considered equal)
+static bool SameValue(double a, double b)
+{
+	return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+void TestAsciiFilter::testMappedParser_data() const
+{
+	QTest::addColumn<QByteArray>("data");
+	QTest::addColumn<char>("separator");
+	QTest::addColumn<bool>("commaAsDecimal");
+	QTest::addColumn<int>("pointCount"); //-1 = as many as the stream parser
+
+	//the big values are in the scalar column (so as to avoid any global shift)
+	QTest::newRow("exponents") << QByteArray(	"1e3 2.5E-2 -3.25e+1 4e22\n"
+												"1.5e-7 2E0 0.5e1 1e-300\n"
+												"10e-1 7E+0 1e0 6.02214076e23\n"
+												"123456789e-30 1e-22 1E4 2.5e-45\n")
+								<< ' ' << false << 4;
+
+	QTest::newRow("signs") << QByteArray(	"-0.5 +3 -0 +1e-2\n"
+											"+0 -1.25e+1 +7.75 -7\n"
+											"-1e-5 +2E+2 -3.0e-0 +4\n")
+							<< ' ' << false << 3;
+
+	//more than 19 significant digits, or a mantissa above 2^53
+	QTest::newRow("long mantissas") << QByteArray(	"1.00000000000000000001 -0.000000000000000000000123456789012345678901 3.14159265358979323846264 12345678901234567890123\n"
+													"9007199254740993e-12 00000000000000000000000012.5 -2.718281828459045235360287 98765432109876543210.5\n"
+													"0.1000000000000000055511151231257827 1234.5678901234567890123e-3 1 -1e-20\n")
+									<< ' ' << false << 3;
+
+	QTest::newRow("comma separator") << QByteArray(	"1.5,-2.25,3e2,4\n"
+													" 5 , 6 ,7,8\n"
+													"-1,,2,3,4\n")
+									<< ',' << false << 3;
+
+	QTest::newRow("decimal comma") << QByteArray(	"1,5;-2,25;3e2;4,125\n"
+													"-0,5;+1,0E-3;7;8\n")
+									<< ';' << true << 2;
+
+	QTest::newRow("blanks") << QByteArray(	"1\t2  3 \t 4\r\n"
+											"\t5 6\t7 8 \n"
+											"9 10 11 12")
+							<< ' ' << false << 3;
+
+	//rejected by the fast parser: QLocale decides
+	QTest::newRow("non-finite and invalid values") << QByteArray(	"1 2 3 4\n"
+																	"nan 2 3 4\n"
+																	"NaN 2 3 4\n"
+																	"1 inf 3 4\n"
+																	"1 2 -inf 4\n"
+																	"1 2 3 nan\n"
+																	"1 2 3 -inf\n"
+																	"1e999 2 3 4\n"
+																	"1 2 3 1e999\n"
+																	"1e 2 3 4\n"
+																	"1.2.3 2 3 4\n"
+																	"- 2 3 4\n"
+																	"0x10 2 3 4\n"
+																	"5 6 7 8\n")
+													<< ' ' << false << -1;
+}
+
+void TestAsciiFilter::testMappedParser() const
+{
+	QFETCH(QByteArray, data);
+	QFETCH(char, separator);
+	QFETCH(bool, commaAsDecimal);
+	QFETCH(int, pointCount);
+
+	const AsciiOpenDlg::Sequence sequence {	AsciiOpenDlg::SequenceItem(ASCII_OPEN_DLG_X, "X"),
+											AsciiOpenDlg::SequenceItem(ASCII_OPEN_DLG_Y, "Y"),
+											AsciiOpenDlg::SequenceItem(ASCII_OPEN_DLG_Z, "Z"),
+											AsciiOpenDlg::SequenceItem(ASCII_OPEN_DLG_Scalar, "Value") };
+	const unsigned lineCount = static_cast<unsigned>(data.count('\n') + 1);
+
+	AsciiParsers parsers;
+
+	ccHObject streamContainer;
+	{
+		CCVector3d shift;
+		bool shiftEnabled = false;
+		FileIOFilter::LoadParameters params;
+		SetDefaultLoadParameters(params, shift, shiftEnabled);
+
+		QTextStream stream(data, QIODevice::ReadOnly);
+		CC_FILE_ERROR error = parsers.loadCloudFromFormatedAsciiStream(stream, "stream", streamContainer, sequence, separator, commaAsDecimal, lineCount, data.size(), CC_MAX_NUMBER_OF_POINTS_PER_CLOUD, 0, 1.0, params);
+		QVERIFY(error == CC_FERR_NO_ERROR);
+	}
+
+	ccHObject mappedContainer;
+	{
+		CCVector3d shift;
+		bool shiftEnabled = false;
+		FileIOFilter::LoadParameters params;
+		SetDefaultLoadParameters(params, shift, shiftEnabled);
+
+		CC_FILE_ERROR error = parsers.loadCloudFromMappedAsciiData(data.constData(), data.size(), "mapped", mappedContainer, sequence, separator, commaAsDecimal, lineCount, CC_MAX_NUMBER_OF_POINTS_PER_CLOUD, 0, params);
+		QVERIFY(error == CC_FERR_NO_ERROR);
+	}
+
+	QVERIFY(streamContainer.getChildrenNumber() == 1);
+	QVERIFY(mappedContainer.getChildrenNumber() == 1);
+	QVERIFY(streamContainer.getChild(0)->isA(CC_TYPES::POINT_CLOUD));
+	QVERIFY(mappedContainer.getChild(0)->isA(CC_TYPES::POINT_CLOUD));
+
+	auto *streamCloud = static_cast<ccPointCloud *>(streamContainer.getChild(0));
+	auto *mappedCloud = static_cast<ccPointCloud *>(mappedContainer.getChild(0));
+	if (pointCount >= 0)
+	{
+		QCOMPARE(static_cast<int>(streamCloud->size()), pointCount);
+	}
+	QVERIFY(streamCloud->size() != 0);
+	QCOMPARE(mappedCloud->size(), streamCloud->size());
+
+	const CCVector3d& streamShift = streamCloud->getGlobalShift();
+	const CCVector3d& mappedShift = mappedCloud->getGlobalShift();
+	QVERIFY(streamShift.x == mappedShift.x && streamShift.y == mappedShift.y && streamShift.z == mappedShift.z);
+
+	QVERIFY(streamCloud->getNumberOfScalarFields() == 1);
+	QVERIFY(mappedCloud->getNumberOfScalarFields() == 1);
+	const CCCoreLib::ScalarField *streamSF = streamCloud->getScalarField(0);
+	const CCCoreLib::ScalarField *mappedSF = mappedCloud->getScalarField(0);
+
+	for (unsigned i = 0; i < streamCloud->size(); ++i)
+	{
+		const CCVector3 *P = streamCloud->getPoint(i);
+		const CCVector3 *Q = mappedCloud->getPoint(i);
+		for (unsigned d = 0; d < 3; ++d)
+		{
+			QVERIFY2(SameValue(P->u[d], Q->u[d]), qPrintable(QString("Point #%1, dim. %2: %3 (stream) != %4 (mapped)").arg(i).arg(d).arg(P->u[d], 0, 'g', 10).arg(Q->u[d], 0, 'g', 10)));
+		}
+		QVERIFY2(SameValue(streamSF->getValue(i), mappedSF->getValue(i)), qPrintable(QString("Point #%1, scalar: %2 (stream) != %3 (mapped)").arg(i).arg(streamSF->getValue(i), 0, 'g', 10).arg(mappedSF->getValue(i), 0, 'g', 10)));
+	}
+}
+
+QTEST_MAIN(TestAsciiFilter)
@@ -0,0 +1,22 @@
+
+#ifndef CC_TEST_ASCII_FILTER_HEADER
+#define CC_TEST_ASCII_FILTER_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+/*
+ * The memory-mapped ASCII parser (which parses the numbers without locale when it can)
+ * must give the same clouds as the line by line (QLocale based) stream parser.
+ */
+class TestAsciiFilter : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+	void testMappedParser_data() const;
+
+	void testMappedParser() const;
+};
+
+
+#endif //CC_TEST_ASCII_FILTER_HEADER
@@ -0,0 +1,127 @@
+#pragma once
+
+//##########################################################################
+//#                                                                        #
+//#                CLOUDCOMPARE PLUGIN: LAS-IO Plugin                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                   COPYRIGHT: Thomas Montaigu                           #
+//#                                                                        #
+//##########################################################################
+
+#include "CopcVlrs.h"
+#include "LasSaver.h"
+
+// qCC_db
+#include <FileIOFilter.h>
+
+// Qt
+#include <QByteArray>
+#include <QString>
+
+// System
+#include <cstdint>
+#include <vector>
+
+namespace CCCoreLib
+{
+	class GenericProgressCallback;
+}
+
+class ccPointCloud;
+
+namespace copc
+{
+	/// Saves a point cloud as a COPC (Cloud Optimized Point Cloud) file.
+	///
+	/// The octree hierarchy is built from the cell codes of the cloud's octree:
+	/// each COPC node of level L subsamples its points on a grid of 2^SAMPLING_GRID_LEVEL
+	/// cells per dimension (i.e. the cells of the octree level L + SAMPLING_GRID_LEVEL),
+	/// the first point of each cell stays in the node and the others go down to the next levels.
+	///
+	/// The points of each node are compressed as a single LAZ chunk (the chunks have variable sizes),
+	/// then the hierarchy is stored in one page of the COPC hierarchy EVLR.
+	/// The header, the VLRs and the point records are those built by the LasSaver
+	/// (which must use the LAS 1.4 point format 6, 7 or 8, see AdaptParameters).
+	class CopcSaver
+	{
+	  public:
+		/// Number of subsampling cells (log2) of a node in each dimension
+		static constexpr unsigned char SAMPLING_GRID_LEVEL = 7;
+
+		CopcSaver(ccPointCloud& cloud, LasSaver& saver);
+
+		/// Forces the LAS 1.4 version and the COPC point format (6, 7 or 8) matching the selected one.
+		///
+		/// The standard fields are mapped to the fields of the new point format
+		/// and waveforms are not saved.
+		static void AdaptParameters(LasSaver::Parameters& parameters);
+
+		/// Saves the file
+		CC_FILE_ERROR save(const QString& filePath, CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+		/// Returns the last (laszip) error message
+		const QString& errorMessage() const
+		{
+			return m_errorMessage;
+		}
+
+	  private:
+		/// A node of the COPC octree with its points
+		struct Node
+		{
+			VoxelKey              key;
+			std::vector<unsigned> pointIndices;
+		};
+
+		/// Statistics of the saved points (for the LAS header and the COPC info)
+		struct Inventory
+		{
+			uint64_t   pointCount{0};
+			uint64_t   pointsByReturn[15] = {0};
+			CCVector3d minCorner;
+			CCVector3d maxCorner;
+			double     gpsTimeMin{0.0};
+			double     gpsTimeMax{0.0};
+
+			void add(const laszip_point& point, const laszip_header& header);
+		};
+
+		/// Builds the nodes (sorted by level) and the COPC info geometry
+		CC_FILE_ERROR buildHierarchy(CCCoreLib::GenericProgressCallback* progressCb);
+
+		/// Compresses the points of a node into a single LAZ chunk
+		CC_FILE_ERROR compressNode(const Node& node, QByteArray& chunk);
+
+		/// Returns the payload of the LASzip VLR (variable chunk sizes)
+		CC_FILE_ERROR createLaszipVlr(QByteArray& payload);
+
+		/// Writes the LAS 1.4 header and the VLRs (COPC info first)
+		void writeHeaderAndVlrs(QDataStream& stream, const QByteArray& laszipVlr) const;
+
+		/// Returns the number of bytes taken by the header and the VLRs
+		uint32_t offsetToPointData(const QByteArray& laszipVlr) const;
+
+		/// Records the laszip error of the writer
+		CC_FILE_ERROR setLaszipError(laszip_POINTER laszipWriter);
+
+	  private:
+		ccPointCloud&      m_cloud;
+		LasSaver&          m_saver;
+		Info               m_info;
+		std::vector<Node>  m_nodes;
+		std::vector<Entry> m_entries;
+		Inventory          m_inventory;
+		/// Offset of the hierarchy EVLR (the only EVLR)
+		uint64_t           m_evlrOffset{0};
+		QString            m_errorMessage;
+	};
+} // namespace copc
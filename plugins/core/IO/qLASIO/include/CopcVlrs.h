@@ -74,6 +74,19 @@ namespace copc
 			return stream;
 		};
 
+		/// Overload the stream insertion operation to write an Info object to a QDataStream.
+		friend QDataStream& operator<<(QDataStream& stream, const Info& copc_info)
+		{
+			stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
+			stream << copc_info.center_x << copc_info.center_y << copc_info.center_z;
+			stream << copc_info.halfsize << copc_info.spacing;
+			stream << static_cast<quint64>(copc_info.root_hier_offset) << static_cast<quint64>(copc_info.root_hier_size);
+			stream << copc_info.gpstime_minimum << copc_info.gpstime_maximum;
+			std::for_each(std::begin(copc_info.reserved), std::end(copc_info.reserved), [&stream](const auto& reserved)
+			              { stream << static_cast<quint64>(reserved); });
+			return stream;
+		};
+
 		static constexpr size_t SIZE = 160;
 
 		/// Geometric parameters (root cell extent)
@@ -197,6 +210,13 @@ namespace copc
 			return stream;
 		};
 
+		friend QDataStream& operator<<(QDataStream& stream, const VoxelKey& key)
+		{
+			stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
+			stream << key.level << key.x << key.y << key.z;
+			return stream;
+		};
+
 		static constexpr size_t SIZE = 16;
 		// octree depth
 		int32_t level{0};
@@ -223,6 +243,14 @@ namespace copc
 			return stream;
 		};
 
+		/// Overload the stream insertion operation to write an Entry object to a QDataStream.
+		friend QDataStream& operator<<(QDataStream& stream, const Entry& entry)
+		{
+			stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
+			stream << entry.key << static_cast<quint64>(entry.offset) << entry.byte_size << entry.point_count;
+			return stream;
+		};
+
 		static constexpr size_t SIZE = VoxelKey::SIZE + 16;
 		VoxelKey                key;
 		/// Absolute offset to the data chunk if the pointCount > 0.
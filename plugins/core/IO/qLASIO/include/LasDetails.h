@@ -36,6 +36,7 @@ class ccPointCloud;
 class ccScalarField;
 
 class QDataStream;
+class QString;
 
 struct laszip_header;
 struct laszip_vlr;
@@ -151,6 +152,8 @@ namespace LasDetails
 
 		static EvlrHeader Waveform();
 
+		static EvlrHeader CopcHierarchy();
+
 		bool isWaveFormDataPackets() const;
 
 		bool isCOPCEntry() const;
@@ -238,4 +241,10 @@ namespace LasDetails
 	/// Clones the content of the `src` vlr into the `dst` vlr.
 	void CloneVlrInto(const laszip_vlr_struct& src, laszip_vlr_struct& dst);
 
+	/// Returns the number of points of the chunks of a LAZ file,
+	/// or 0 if it is unknown (not compressed, variable chunks as in COPC files, etc.)
+	///
+	/// LASzip doesn't expose its own VLR, so it is read directly from the file.
+	uint32_t ReadLazChunkSize(const QString& fileName);
+
 } // namespace LasDetails
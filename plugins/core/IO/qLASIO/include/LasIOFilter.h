@@ -21,6 +21,7 @@
 #include "LasDetails.h"
 #include "LasExtraScalarField.h"
 #include "LasOpenDialog.h"
+#include "LasPointFilter.h"
 
 // System
 #include <memory>
@@ -35,6 +36,11 @@ class LasIOFilter : public FileIOFilter
 	bool          canSave(CC_CLASS_ENUM type, bool& multiple, bool& exclusive) const override;
 	CC_FILE_ERROR saveToFile(ccHObject* entity, const QString& filename, const SaveParameters& parameters) override;
 
+	/// Sets the filter applied to the points of the next loaded files (command line)
+	static void SetLoadFilter(const LasPointFilter& filter);
+	/// Returns the filter applied to the points of the loaded files
+	static const LasPointFilter& LoadFilter();
+
   private:
 	struct FileInfo
 	{
@@ -79,4 +85,6 @@ class LasIOFilter : public FileIOFilter
 
 	std::unique_ptr<FileInfo> m_infoOfLastOpened;
 	LasOpenDialog             m_openDialog{};
+
+	static LasPointFilter s_loadFilter;
 };
@@ -87,6 +87,10 @@ class LasOpenDialog : public QDialog
 	/// according to what the LAS standard says.
 	bool shouldDecomposeClassification() const;
 
+	/// Returns whether the user wants the chunks of the file
+	/// to be decoded concurrently (see LasParallelLoader).
+	bool shouldDecodeInParallel() const;
+
 	/// Returns the action the user wants to do.
 	///
 	/// The action is based on the active tab when the
@@ -0,0 +1,173 @@
+#pragma once
+
+//##########################################################################
+//#                                                                        #
+//#                CLOUDCOMPARE PLUGIN: LAS-IO Plugin                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                   COPYRIGHT: Thomas Montaigu                           #
+//#                                                                        #
+//##########################################################################
+
+#include "LasDetails.h"
+#include "LasExtraScalarField.h"
+#include "LasPointFilter.h"
+#include "LasScalarFieldLoader.h"
+
+// CCCoreLib
+#include <CCGeom.h>
+
+// qCC_db
+#include <FileIOFilter.h>
+
+// Qt
+#include <QMutex>
+#include <QString>
+
+// LASzip
+#include <laszip/laszip_api.h>
+
+// System
+#include <array>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace CCCoreLib
+{
+	class NormalizedProgress;
+}
+
+class ccPointCloud;
+
+/// Loads the points of a LAS/LAZ (or COPC) file with several laszip readers
+/// decoding the chunk intervals concurrently.
+///
+/// The chunk intervals to read are split into tasks (aligned on the LAZ chunks
+/// when the file uses chunks of a fixed size). Each task is decoded into its own
+/// slice of the point cloud and of its scalar fields, which are pre-sized with
+/// the total number of points. The worker threads each open their own laszip reader
+/// on the file and take the tasks in file order. Once all the tasks are decoded,
+/// the slices are compacted (if some points were filtered out), so that the points are
+/// in the same order as with the sequential loading.
+class LasParallelLoader
+{
+  public:
+	/// The (standard and extra) fields of the loader are the ones to load.
+	LasParallelLoader(const QString&        fileName,
+	                  const laszip_header&  laszipHeader,
+	                  LasScalarFieldLoader& loader,
+	                  ccPointCloud&         pointCloud);
+
+	/// Returns whether the parallel loading is worth it (and possible) for the file:
+	/// several threads are available, there are enough points and the file has no waveforms.
+	static bool IsSuitableFor(const laszip_header& laszipHeader, uint64_t pointCount);
+
+	/// Sets the extra scalar fields to be loaded as normals
+	/// (undocumented fields are ignored).
+	void setNormalFields(const std::array<LasExtraScalarField, 3>& normalFields)
+	{
+		m_normalFields = normalFields;
+	}
+
+	/// Sets the global shift applied to the points.
+	void setGlobalShift(const CCVector3d& globalShift)
+	{
+		m_globalShift = globalShift;
+	}
+
+	/// Sets the extent the points of the INTERSECT_BB chunk intervals must be in (COPC).
+	void setClippingExtent(const LasDetails::UnscaledExtent* clippingExtent)
+	{
+		m_clippingExtent = clippingExtent;
+	}
+
+	/// Sets the filter the points must pass (if any).
+	void setPointFilter(const LasPointFilter* pointFilter)
+	{
+		m_pointFilter = pointFilter;
+	}
+
+	/// Sets the progress (one step per loaded point).
+	void setProgress(CCCoreLib::NormalizedProgress* progress)
+	{
+		m_progress = progress;
+	}
+
+	/// Loads the points of the chunk intervals into the point cloud
+	/// (which must be empty, with its normals reserved if some are loaded).
+	///
+	/// The chunk intervals are updated as with the sequential loading
+	/// (offset in the point cloud and number of filtered points).
+	CC_FILE_ERROR load(std::vector<std::reference_wrapper<LasDetails::ChunkInterval>>& chunkIntervals);
+
+	/// Returns the laszip error message (if load failed with CC_FERR_THIRD_PARTY_LIB_FAILURE).
+	const QString& errorMessage() const
+	{
+		return m_errorMessage;
+	}
+
+  private:
+	/// A part of a chunk interval, decoded by a single thread
+	struct Task
+	{
+		/// index of the chunk interval
+		size_t interval{0};
+		/// point offset in the LAS file
+		uint64_t pointOffsetInFile{0};
+		/// point count in the file
+		uint64_t pointCount{0};
+		/// whether each point must be tested against the clipping extent
+		bool testInExtent{false};
+		/// index of the first point of the slice in the point cloud
+		unsigned sliceStart{0};
+		/// number of points actually written in the slice (not filtered)
+		unsigned loadedPointCount{0};
+		/// shift of the RGB components (set by the first point that creates the colors, -1 if none)
+		int colorCompShift{-1};
+	};
+
+	/// Splits the chunk intervals into tasks
+	void createTasks(const std::vector<std::reference_wrapper<LasDetails::ChunkInterval>>& chunkIntervals);
+
+	/// Decodes the tasks (of the given indices) with as many threads as possible.
+	///
+	/// forcedColorCompShift: shift of the RGB components (automatically set by each task if negative)
+	CC_FILE_ERROR decodeTasks(const std::vector<size_t>& taskIndices, int forcedColorCompShift, bool showProgress);
+
+	/// Decodes a task with the reader of the calling thread
+	CC_FILE_ERROR decodeTask(laszip_POINTER reader, LasScalarFieldLoader& loader, Task& task, int forcedColorCompShift, bool showProgress);
+
+	/// Moves the slices so that they are contiguous, and updates the chunk intervals
+	bool compactSlices(const std::vector<std::reference_wrapper<LasDetails::ChunkInterval>>& chunkIntervals);
+
+	/// Records a laszip error (the first one is kept)
+	void setLaszipError(laszip_POINTER reader);
+
+  private:
+	QString                            m_fileName;
+	const laszip_header&               m_laszipHeader;
+	LasScalarFieldLoader&              m_loader;
+	ccPointCloud&                      m_pointCloud;
+	std::array<LasExtraScalarField, 3> m_normalFields{};
+	CCVector3d                         m_globalShift{0, 0, 0};
+	const LasDetails::UnscaledExtent*  m_clippingExtent{nullptr};
+	const LasPointFilter*              m_pointFilter{nullptr};
+	CCCoreLib::NormalizedProgress*     m_progress{nullptr};
+	bool                               m_hasNormals{false};
+
+	std::vector<Task>   m_tasks;
+	std::atomic<size_t> m_nextTask{0};
+	/// first error encountered by a thread (CC_FILE_ERROR)
+	std::atomic<int> m_error{CC_FERR_NO_ERROR};
+	QMutex           m_errorMutex;
+	QString          m_errorMessage;
+};
@@ -33,4 +33,7 @@ class LasPlugin : public QObject
 
 	// Inherited from ccIOPluginInterface
 	ccIOPluginInterface::FilterList getFilters() override;
+
+	// Inherited from ccPluginInterface
+	void registerCommands(ccCommandLineInterface* cmd) override;
 };
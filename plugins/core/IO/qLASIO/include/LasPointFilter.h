@@ -0,0 +1,86 @@
+#pragma once
+
+//##########################################################################
+//#                                                                        #
+//#                CLOUDCOMPARE PLUGIN: LAS-IO Plugin                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                   COPYRIGHT: Thomas Montaigu                           #
+//#                                                                        #
+//##########################################################################
+
+#include "LasDetails.h"
+
+// LASzip
+#include <laszip/laszip_api.h>
+
+// System
+#include <vector>
+
+/// Filter applied to the points while they are decoded,
+/// so that the rejected points are never added to the cloud.
+///
+/// For COPC files, the clipping box and the maximum level are also used
+/// to skip the chunks (nodes) that can't contain accepted points.
+struct LasPointFilter
+{
+	/// Clipping box, in file coordinates (i.e. without the global shift).
+	/// No clipping if invalid.
+	LasDetails::UnscaledExtent box;
+	/// Whether each classification is accepted (all of them if empty)
+	std::vector<bool> classes;
+	/// Whether each return number is accepted (all of them if empty)
+	std::vector<bool> returnNumbers;
+	/// Maximum level of the octree loaded from a COPC file (-1 = all the levels)
+	int copcMaxLevel{-1};
+
+	/// Returns whether a filter is set
+	bool isActive() const
+	{
+		return box.isValid() || !classes.empty() || !returnNumbers.empty() || copcMaxLevel >= 0;
+	}
+
+	/// Returns whether the points must be tested individually
+	bool testsPoints() const
+	{
+		return box.isValid() || !classes.empty() || !returnNumbers.empty();
+	}
+
+	/// Returns whether the point is accepted
+	inline bool accepts(const laszip_point& point, const laszip_F64 coordinates[3]) const
+	{
+		if (box.isValid() && !box.contains(CCVector3d(coordinates[0], coordinates[1], coordinates[2])))
+		{
+			return false;
+		}
+
+		if (!classes.empty())
+		{
+			// the legacy classification only has 5 bits
+			const unsigned classification = point.extended_point_type ? point.extended_classification : point.classification;
+			if (classification >= classes.size() || !classes[classification])
+			{
+				return false;
+			}
+		}
+
+		if (!returnNumbers.empty())
+		{
+			const unsigned returnNumber = point.extended_point_type ? point.extended_return_number : point.return_number;
+			if (returnNumber >= returnNumbers.size() || !returnNumbers[returnNumber])
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
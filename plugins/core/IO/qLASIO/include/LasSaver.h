@@ -55,6 +55,19 @@ class LasSaver
 
 	CC_FILE_ERROR saveNextPoint();
 
+	/// Fills the laszip point with the values of the given point of the cloud
+	///
+	/// \param laszipWriter the writer whose header is used to quantize the coordinates
+	/// \param laszipPoint the point of this writer
+	/// \param pointIndex index of the point in the cloud
+	CC_FILE_ERROR fillPoint(laszip_POINTER laszipWriter, laszip_point* laszipPoint, unsigned pointIndex);
+
+	/// Returns the header built from the parameters (scale, offset, VLRs, etc.)
+	const laszip_header& laszipHeader() const
+	{
+		return m_laszipHeader;
+	}
+
 	bool canSaveWaveforms() const;
 
 	QString getLastError() const;
@@ -53,6 +53,41 @@ class LasScalarFieldLoader
 
 	CC_FILE_ERROR handleExtraScalarFields(const laszip_point& currentPoint);
 
+	/// Creates the scalar fields of all the standard fields and resizes all the
+	/// scalar fields (standard and extra) to pointCount values.
+	///
+	/// This is what allows to set the values of the points in any order (and concurrently,
+	/// each thread using its own copy of the loader), see setScalarFieldValues and
+	/// setExtraScalarFieldValues, instead of appending them with handleScalarFields
+	/// and handleExtraScalarFields.
+	bool resizeScalarFields(unsigned pointCount);
+
+	/// Sets the values of the point at pointIndex in the standard scalar fields
+	/// (which must have been resized with resizeScalarFields).
+	void setScalarFieldValues(unsigned pointIndex, const laszip_point& currentPoint);
+
+	/// Sets the values of the point at pointIndex in the extra scalar fields
+	/// (which must have been resized with resizeScalarFields).
+	CC_FILE_ERROR setExtraScalarFieldValues(unsigned pointIndex, const laszip_point& currentPoint);
+
+	/// Moves the values of the point at sourceIndex to destIndex (in all the scalar fields).
+	void moveScalarFieldValues(unsigned sourceIndex, unsigned destIndex);
+
+	/// Resizes all the scalar fields, and deletes the standard scalar fields
+	/// that only have default values (if such fields should be ignored).
+	///
+	/// To be called once the values of all the points were set with setScalarFieldValues
+	/// and setExtraScalarFieldValues.
+	bool finalizeScalarFields(unsigned pointCount);
+
+	/// Returns whether the RGB value of the point is the one that
+	/// creates the colors of the point cloud (see handleRGBValue).
+	bool createsColors(const laszip_point& currentPoint) const;
+
+	/// Returns the shift to apply to the RGB components of the points,
+	/// according to the RGB value of the point that created the colors.
+	unsigned char colorCompShiftFor(const laszip_point& currentPoint) const;
+
 	inline void setIgnoreFieldsWithDefaultValues(bool state)
 	{
 		m_ignoreFieldsWithDefaultValues = state;
@@ -83,6 +118,11 @@ class LasScalarFieldLoader
 	}
 
   private:
+	/// Calls func(lasScalarField, value) for each standard field, with the value
+	/// of this field for the current point (stops at the first error).
+	template <typename Func>
+	CC_FILE_ERROR visitScalarFieldValues(const laszip_point& currentPoint, Func func);
+
 	/// Handles loading of LAS value into the scalar field that will be part
 	/// of the pointCloud.
 	///
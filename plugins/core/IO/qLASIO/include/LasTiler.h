@@ -18,9 +18,21 @@
 //##########################################################################
 
 #include <FileIOFilter.h>
+#include <QMutex>
+#include <QSemaphore>
 #include <QString>
+#include <QThreadPool>
 #include <laszip/laszip_api.h>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace CCCoreLib
+{
+	class NormalizedProgress;
+}
+
 enum class LasTilingDimensions
 {
 	XY = 0,
@@ -34,6 +46,12 @@ struct LasTilingOptions final
 	LasTilingDimensions dims      = LasTilingDimensions::XY;
 	unsigned            numTiles0 = 0;
 	unsigned            numTiles1 = 0;
+	/// Maximum number of points per tile: the tiles of the grid
+	/// are split (quadtree) until they have less points (0 = no split)
+	uint64_t maxPointsPerTile = 0;
+	/// Width of the buffer around each tile: the points of the neighbouring
+	/// tiles in this buffer are also written in the tile (0 = no buffer)
+	double haloSize = 0.0;
 
 	inline size_t index0() const
 	{
@@ -64,7 +82,119 @@ struct LasTilingOptions final
 	}
 };
 
-/// Tiles the cloud that the reader reads into a grid described by the options.
+/// Splits a LAS/LAZ file into tiles in a single pass over its points.
+///
+/// The tiles are the cells of the grid described by the options, split as a quadtree
+/// while their (estimated) number of points exceeds the maximum. The number of points
+/// of the tiles is estimated beforehand with a sample of the points (read at the start
+/// of the LAZ chunks so that it's cheap).
+///
+/// The points are decoded concurrently by several readers (tasks aligned on the LAZ chunks)
+/// and dispatched into batches per tile, which are written by a pool of writer threads
+/// (each tile has its own writer, opened when the first batch arrives).
+class LasTiler
+{
+  public:
+	LasTiler(const QString& fileName, const laszip_header& laszipHeader, const LasTilingOptions& options);
+	~LasTiler();
+
+	/// Builds the tiles (the reader is used to sample the points if they are split)
+	CC_FILE_ERROR buildTiles(laszip_POINTER laszipReader, uint64_t pointCount);
+
+	/// Reads all the points of the file and writes them in the tiles
+	CC_FILE_ERROR tile(uint64_t pointCount, CCCoreLib::NormalizedProgress* progress);
+
+	/// Returns the number of tiles (some may be empty)
+	size_t tileCount() const
+	{
+		return m_tiles.size();
+	}
+
+	/// Returns the laszip error message (if an operation failed with CC_FERR_THIRD_PARTY_LIB_FAILURE)
+	const QString& errorMessage() const
+	{
+		return m_errorMessage;
+	}
+
+  private:
+	/// Position of a point in the tiling dimensions
+	struct Sample
+	{
+		double u;
+		double v;
+	};
+
+	/// Node of the quadtree of a grid cell (the leaves are the tiles)
+	struct Node
+	{
+		double  min[2];
+		double  max[2];
+		/// index of the first of the 4 children (-1 for a leaf)
+		int     firstChild{-1};
+		/// index of the tile (leaves)
+		int     tile{-1};
+		QString name;
+	};
+
+	/// Output tile
+	struct Tile
+	{
+		QString        fileName;
+		laszip_POINTER writer{nullptr};
+		QMutex         mutex;
+	};
+
+	/// Points to write in a tile
+	struct Batch
+	{
+		std::vector<laszip_point> points;
+		std::vector<laszip_U8>    extraBytes;
+	};
+
+	/// Reads a sample of the points of the file
+	CC_FILE_ERROR samplePoints(laszip_POINTER laszipReader, uint64_t pointCount, std::vector<Sample>& samples);
+	/// Splits a node while its estimated number of points is too large
+	void split(int nodeIndex, std::vector<Sample> samples, double pointsPerSample, unsigned depth);
+	/// Returns the index of the grid cell containing the position
+	int gridCellOf(double u, double v) const;
+	/// Fills `tiles` with the tiles the position must be written in (its own tile first)
+	void tilesOf(double u, double v, std::vector<int>& tiles) const;
+	/// Adds the tiles of the node whose buffer contains the position (except its own tile)
+	void addHaloTiles(int nodeIndex, double u, double v, std::vector<int>& tiles) const;
+
+	/// Queues a batch for the writer pool
+	void submit(int tileIndex, std::shared_ptr<Batch> batch);
+	/// Writes a batch in its tile (called by the writer pool)
+	void writeBatch(int tileIndex, const Batch& batch);
+
+	/// Records a laszip error (the first one is kept)
+	void setLaszipError(laszip_POINTER laszipPointer);
+	/// Records an error (the first one is kept)
+	void setError(CC_FILE_ERROR error);
+
+  private:
+	QString                            m_fileName;
+	const laszip_header&               m_laszipHeader;
+	LasTilingOptions                   m_options;
+	/// Header of the tiles (without the COPC VLR and the EVLRs)
+	laszip_header                      m_tileHeader;
+	std::vector<laszip_vlr_struct>     m_tileVlrs;
+	bool                               m_compress{false};
+	double                             m_mins[3];
+	double                             m_cellSize[2];
+	std::vector<Node>                  m_nodes;
+	std::vector<std::unique_ptr<Tile>> m_tiles;
+
+	QThreadPool         m_writerPool;
+	QSemaphore          m_pendingBatches;
+	std::atomic<size_t> m_nextTask{0};
+	/// first error encountered by a thread (CC_FILE_ERROR)
+	std::atomic<int> m_error{CC_FERR_NO_ERROR};
+	QMutex           m_errorMutex;
+	QString          m_errorMessage;
+};
+
+/// Tiles the cloud that the reader reads as described by the options (see LasTiler).
 ///
 /// This takes ownership of the reader and takes care of closing and deleting it
 CC_FILE_ERROR TileLasReader(laszip_POINTER laszipReader, const QString& originName, const LasTilingOptions& options);
@@ -0,0 +1,827 @@
+//##########################################################################
+//#                                                                        #
+//#                CLOUDCOMPARE PLUGIN: LAS-IO Plugin                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                   COPYRIGHT: Thomas Montaigu                           #
+//#                                                                        #
+//##########################################################################
+
+#include "CopcSaver.h"
+
+#include "LasDetails.h"
+
+// CCCoreLib
+#include <DgmOctree.h>
+#include <GenericProgressCallback.h>
+
+// qCC_db
+#include <ccLog.h>
+#include <ccOctree.h>
+#include <ccPointCloud.h>
+
+// Qt
+#include <QDataStream>
+#include <QFile>
+#include <QtEndian>
+
+// System
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace copc
+{
+	/// LASzip chunk size meaning that the chunks have variable sizes (stored in the chunk table)
+	static constexpr laszip_U32 VARIABLE_CHUNK_SIZE = std::numeric_limits<laszip_U32>::max();
+	/// LAS 1.4 global encoding bit telling that the CRS is stored as WKT (mandatory for the point formats 6-10)
+	static constexpr laszip_U16 GLOBAL_ENCODING_WKT = 0b0001'0000;
+	/// Point format bit used by LASzip to flag compressed points
+	static constexpr quint8 COMPRESSED_POINT_FORMAT_BIT = 0b1000'0000;
+
+	static constexpr uint32_t AC_MIN_LENGTH   = 0x01000000U;
+	static constexpr uint32_t AC_MAX_LENGTH   = 0xFFFFFFFFU;
+	static constexpr uint32_t BM_LENGTH_SHIFT = 13;
+	static constexpr uint32_t BM_MAX_COUNT    = 1U << BM_LENGTH_SHIFT;
+	static constexpr uint32_t DM_LENGTH_SHIFT = 15;
+	static constexpr uint32_t DM_MAX_COUNT    = 1U << DM_LENGTH_SHIFT;
+
+	/// Adaptive model of a bit (same as the ArithmeticBitModel of LASzip)
+	struct BitModel
+	{
+		uint32_t bit0Count{1};
+		uint32_t bitCount{2};
+		uint32_t bit0Prob{1U << (BM_LENGTH_SHIFT - 1)};
+		uint32_t updateCycle{4};
+		uint32_t bitsUntilUpdate{4};
+
+		void update()
+		{
+			// halve counts when a threshold is reached
+			if ((bitCount += updateCycle) > BM_MAX_COUNT)
+			{
+				bitCount  = (bitCount + 1) >> 1;
+				bit0Count = (bit0Count + 1) >> 1;
+				if (bit0Count == bitCount)
+				{
+					++bitCount;
+				}
+			}
+
+			// compute the scaled bit 0 probability
+			const uint32_t scale = 0x80000000U / bitCount;
+			bit0Prob             = (bit0Count * scale) >> (31 - BM_LENGTH_SHIFT);
+
+			// set the frequency of the model updates
+			updateCycle     = std::min((5 * updateCycle) >> 2, 64U);
+			bitsUntilUpdate = updateCycle;
+		}
+	};
+
+	/// Adaptive model of the symbols of an alphabet (same as the ArithmeticModel of LASzip, encoder side)
+	struct SymbolModel
+	{
+		explicit SymbolModel(uint32_t symbols)
+		    : symbolCount(symbols)
+		    , lastSymbol(symbols - 1)
+		    , updateCycle(symbols)
+		    , distribution(symbols, 0)
+		    , counts(symbols, 1)
+		{
+			update();
+			symbolsUntilUpdate = updateCycle = (symbols + 6) >> 1;
+		}
+
+		void update()
+		{
+			// halve counts when a threshold is reached
+			if ((totalCount += updateCycle) > DM_MAX_COUNT)
+			{
+				totalCount = 0;
+				for (uint32_t& count : counts)
+				{
+					totalCount += (count = (count + 1) >> 1);
+				}
+			}
+
+			// compute the cumulative distribution
+			const uint32_t scale = 0x80000000U / totalCount;
+			uint32_t       sum   = 0;
+			for (uint32_t k = 0; k < symbolCount; ++k)
+			{
+				distribution[k] = (scale * sum) >> (31 - DM_LENGTH_SHIFT);
+				sum += counts[k];
+			}
+
+			// set the frequency of the model updates
+			updateCycle        = std::min((5 * updateCycle) >> 2, (symbolCount + 6) << 3);
+			symbolsUntilUpdate = updateCycle;
+		}
+
+		uint32_t              symbolCount;
+		uint32_t              lastSymbol;
+		uint32_t              totalCount{0};
+		uint32_t              updateCycle;
+		uint32_t              symbolsUntilUpdate{0};
+		std::vector<uint32_t> distribution;
+		std::vector<uint32_t> counts;
+	};
+
+	/// Arithmetic encoder producing the same bytes as the ArithmeticEncoder of LASzip
+	class ArithmeticEncoder
+	{
+	  public:
+		void encodeBit(BitModel& model, uint32_t bit)
+		{
+			const uint32_t x = model.bit0Prob * (m_length >> BM_LENGTH_SHIFT);
+			if (bit == 0)
+			{
+				m_length = x;
+				++model.bit0Count;
+			}
+			else
+			{
+				const uint32_t initBase = m_base;
+				m_base += x;
+				m_length -= x;
+				if (initBase > m_base)
+				{
+					propagateCarry();
+				}
+			}
+
+			if (m_length < AC_MIN_LENGTH)
+			{
+				renormalize();
+			}
+			if (--model.bitsUntilUpdate == 0)
+			{
+				model.update();
+			}
+		}
+
+		void encodeSymbol(SymbolModel& model, uint32_t symbol)
+		{
+			assert(symbol <= model.lastSymbol);
+			const uint32_t initBase = m_base;
+			if (symbol == model.lastSymbol)
+			{
+				const uint32_t x = model.distribution[symbol] * (m_length >> DM_LENGTH_SHIFT);
+				m_base += x;
+				m_length -= x;
+			}
+			else
+			{
+				m_length >>= DM_LENGTH_SHIFT;
+				const uint32_t x = model.distribution[symbol] * m_length;
+				m_base += x;
+				m_length = model.distribution[symbol + 1] * m_length - x;
+			}
+
+			if (initBase > m_base)
+			{
+				propagateCarry();
+			}
+			if (m_length < AC_MIN_LENGTH)
+			{
+				renormalize();
+			}
+
+			++model.counts[symbol];
+			if (--model.symbolsUntilUpdate == 0)
+			{
+				model.update();
+			}
+		}
+
+		void writeBits(uint32_t bits, uint32_t value)
+		{
+			assert(bits && bits <= 32);
+			if (bits > 19)
+			{
+				writeRaw(16, value & 0xFFFFU);
+				value >>= 16;
+				bits -= 16;
+			}
+			writeRaw(bits, value);
+		}
+
+		/// Flushes the last bytes (the output is then complete)
+		void done()
+		{
+			const uint32_t initBase    = m_base;
+			bool           anotherByte = true;
+			if (m_length > 2 * AC_MIN_LENGTH)
+			{
+				m_base += AC_MIN_LENGTH;
+				m_length = AC_MIN_LENGTH >> 1;
+			}
+			else
+			{
+				m_base += AC_MIN_LENGTH >> 1;
+				m_length    = AC_MIN_LENGTH >> 9;
+				anotherByte = false;
+			}
+
+			if (initBase > m_base)
+			{
+				propagateCarry();
+			}
+			renormalize();
+
+			// two or three zero bytes to be in sync with the byte reads of the decoder
+			m_bytes.append(anotherByte ? 3 : 2, '\0');
+		}
+
+		const QByteArray& bytes() const
+		{
+			return m_bytes;
+		}
+
+	  private:
+		void writeRaw(uint32_t bits, uint32_t value)
+		{
+			const uint32_t initBase = m_base;
+			m_length >>= bits;
+			m_base += value * m_length;
+			if (initBase > m_base)
+			{
+				propagateCarry();
+			}
+			if (m_length < AC_MIN_LENGTH)
+			{
+				renormalize();
+			}
+		}
+
+		void propagateCarry()
+		{
+			for (int i = m_bytes.size() - 1; i >= 0; --i)
+			{
+				if (static_cast<uint8_t>(m_bytes[i]) != 0xFFU)
+				{
+					m_bytes[i] = static_cast<char>(static_cast<uint8_t>(m_bytes[i]) + 1);
+					return;
+				}
+				m_bytes[i] = 0;
+			}
+			assert(false);
+		}
+
+		void renormalize()
+		{
+			do
+			{
+				m_bytes.append(static_cast<char>(m_base >> 24));
+				m_base <<= 8;
+			} while ((m_length <<= 8) < AC_MIN_LENGTH);
+		}
+
+	  private:
+		uint32_t   m_base{0};
+		uint32_t   m_length{AC_MAX_LENGTH};
+		QByteArray m_bytes;
+	};
+
+	/// Compresses the LAZ chunk table like LASzip does, i.e. the point and byte counts of the chunks
+	/// are coded with an IntegerCompressor of 32 bits and 2 contexts (whose corrector models are reproduced here).
+	static QByteArray EncodeChunkTable(const std::vector<Entry>& entries)
+	{
+		// the 8 upper bits of the large correctors are coded with a model, the lower ones are stored raw
+		constexpr uint32_t BITS_HIGH = 8;
+		constexpr uint32_t CORR_BITS = 32;
+
+		ArithmeticEncoder        encoder;
+		std::vector<SymbolModel> bitsModels(2, SymbolModel(CORR_BITS + 1));
+		BitModel                 corrector0;
+		std::vector<SymbolModel> correctors;
+		correctors.reserve(CORR_BITS + 1);
+		correctors.emplace_back(2); // unused (k = 0 is coded with the bit model)
+		for (uint32_t k = 1; k <= CORR_BITS; ++k)
+		{
+			correctors.emplace_back(1U << std::min(k, BITS_HIGH));
+		}
+
+		auto compress = [&](uint32_t predicted, uint32_t real, uint32_t context)
+		{
+			// same wrap-around as the 32 bits integers of LASzip
+			const int32_t corrector = static_cast<int32_t>(real - predicted);
+
+			// find the tightest interval [ - (2^k - 1)  ...  + (2^k) ] that contains the corrector
+			uint32_t c1 = (corrector <= 0 ? 0U - static_cast<uint32_t>(corrector) : static_cast<uint32_t>(corrector) - 1);
+			uint32_t k  = 0;
+			while (c1)
+			{
+				c1 >>= 1;
+				++k;
+			}
+			encoder.encodeSymbol(bitsModels[context], k);
+
+			if (k == 0)
+			{
+				// the corrector is 0 or 1
+				encoder.encodeBit(corrector0, static_cast<uint32_t>(corrector));
+			}
+			else if (k < CORR_BITS)
+			{
+				// translate the corrector into the k-bit interval [ 0 ... 2^k - 1 ]
+				const int64_t  shifted = (corrector < 0 ? static_cast<int64_t>(corrector) + ((int64_t(1) << k) - 1) : static_cast<int64_t>(corrector) - 1);
+				const uint32_t value   = static_cast<uint32_t>(shifted);
+				if (k <= BITS_HIGH)
+				{
+					encoder.encodeSymbol(correctors[k], value);
+				}
+				else
+				{
+					const uint32_t lowBits = k - BITS_HIGH;
+					encoder.encodeSymbol(correctors[k], value >> lowBits);
+					encoder.writeBits(lowBits, value & ((1U << lowBits) - 1));
+				}
+			}
+		};
+
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			compress(i ? entries[i - 1].point_count : 0, entries[i].point_count, 0);
+			compress(i ? entries[i - 1].byte_size : 0, entries[i].byte_size, 1);
+		}
+		encoder.done();
+
+		QByteArray  table;
+		QDataStream stream(&table, QIODevice::WriteOnly);
+		stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
+		stream << quint32(0); // version
+		stream << static_cast<quint32>(entries.size());
+		stream.writeRawData(encoder.bytes().constData(), encoder.bytes().size());
+		return table;
+	}
+
+	/// The COPC info and the LASzip VLRs are written by the saver
+	static bool ShouldCopyVlr(const laszip_vlr_struct& vlr)
+	{
+		return strncmp(vlr.user_id, "copc", LasDetails::EvlrHeader::USER_ID_SIZE) != 0
+		       && !(vlr.record_id == 22204 && qstrnicmp(vlr.user_id, "laszip encoded", LasDetails::EvlrHeader::USER_ID_SIZE) == 0);
+	}
+
+	static void WriteVlrHeader(QDataStream& stream, const char* userID, quint16 recordID, quint16 recordLength, const char* description)
+	{
+		char userIDData[LasDetails::EvlrHeader::USER_ID_SIZE]{};
+		char descriptionData[LasDetails::EvlrHeader::DESCRIPTION_SIZE]{};
+		strncpy(userIDData, userID, LasDetails::EvlrHeader::USER_ID_SIZE);
+		strncpy(descriptionData, description, LasDetails::EvlrHeader::DESCRIPTION_SIZE);
+
+		stream << quint16(0); // reserved
+		stream.writeRawData(userIDData, LasDetails::EvlrHeader::USER_ID_SIZE);
+		stream << recordID << recordLength;
+		stream.writeRawData(descriptionData, LasDetails::EvlrHeader::DESCRIPTION_SIZE);
+	}
+
+	void CopcSaver::Inventory::add(const laszip_point& point, const laszip_header& header)
+	{
+		const CCVector3d P(point.X * header.x_scale_factor + header.x_offset,
+		                   point.Y * header.y_scale_factor + header.y_offset,
+		                   point.Z * header.z_scale_factor + header.z_offset);
+		if (pointCount == 0)
+		{
+			minCorner = maxCorner = P;
+			gpsTimeMin = gpsTimeMax = point.gps_time;
+		}
+		else
+		{
+			minCorner.x = std::min(minCorner.x, P.x);
+			minCorner.y = std::min(minCorner.y, P.y);
+			minCorner.z = std::min(minCorner.z, P.z);
+			maxCorner.x = std::max(maxCorner.x, P.x);
+			maxCorner.y = std::max(maxCorner.y, P.y);
+			maxCorner.z = std::max(maxCorner.z, P.z);
+			gpsTimeMin  = std::min(gpsTimeMin, point.gps_time);
+			gpsTimeMax  = std::max(gpsTimeMax, point.gps_time);
+		}
+
+		if (point.extended_return_number >= 1 && point.extended_return_number <= 15)
+		{
+			++pointsByReturn[point.extended_return_number - 1];
+		}
+		++pointCount;
+	}
+
+	CopcSaver::CopcSaver(ccPointCloud& cloud, LasSaver& saver)
+	    : m_cloud(cloud)
+	    , m_saver(saver)
+	{
+	}
+
+	void CopcSaver::AdaptParameters(LasSaver::Parameters& parameters)
+	{
+		const uint8_t pointFormat = LasDetails::HasNearInfrared(parameters.pointFormat) ? 8 : (LasDetails::HasRGB(parameters.pointFormat) ? 7 : 6);
+		if (pointFormat != parameters.pointFormat || parameters.versionMinor != 4)
+		{
+			ccLog::Print(QString("[LAS] COPC files are saved with the point format %1 (LAS 1.4)").arg(pointFormat));
+		}
+
+		if (parameters.pointFormat < 6)
+		{
+			// map the fields to the ones of the extended point format
+			std::vector<LasScalarField> standardFields;
+			for (const LasScalarField& field : parameters.standardFields)
+			{
+				try
+				{
+					LasScalarField::Id id = (field.id == LasScalarField::ScanAngleRank ? LasScalarField::ExtendedScanAngle
+					                                                                   : LasScalarField::IdFromName(field.name(), pointFormat));
+					standardFields.emplace_back(id, field.sf);
+				}
+				catch (const std::logic_error&)
+				{
+					ccLog::Warning(QString("[LAS] Field '%1' can't be saved in a COPC file").arg(field.name()));
+				}
+			}
+			parameters.standardFields = std::move(standardFields);
+		}
+
+		parameters.versionMajor       = 1;
+		parameters.versionMinor       = 4;
+		parameters.pointFormat        = pointFormat;
+		parameters.shouldSaveWaveform = false;
+	}
+
+	CC_FILE_ERROR CopcSaver::buildHierarchy(CCCoreLib::GenericProgressCallback* progressCb)
+	{
+		m_nodes.clear();
+
+		// we use the octree of the cloud if it already has one
+		std::unique_ptr<CCCoreLib::DgmOctree> ownOctree;
+		ccOctree::Shared                      sharedOctree = m_cloud.getOctree();
+		const CCCoreLib::DgmOctree*           octree       = sharedOctree.data();
+		if (!octree)
+		{
+			ownOctree.reset(new CCCoreLib::DgmOctree(&m_cloud));
+			if (ownOctree->build(progressCb) <= 0)
+			{
+				m_errorMessage = "Failed to compute the octree";
+				return CC_FERR_NOT_ENOUGH_MEMORY;
+			}
+			octree = ownOctree.get();
+		}
+
+		// the COPC root cube is the (cubical) octree box
+		const PointCoordinateType rootSize   = octree->getCellSize(0);
+		const CCVector3           rootCenter = octree->getOctreeMins() + CCVector3(rootSize, rootSize, rootSize) / 2;
+		const CCVector3d          center     = m_cloud.toGlobal3d<PointCoordinateType>(rootCenter);
+		m_info.center_x                      = center.x;
+		m_info.center_y                      = center.y;
+		m_info.center_z                      = center.z;
+		m_info.halfsize                      = rootSize / (2 * m_cloud.getGlobalScale());
+		m_info.spacing                       = 2 * m_info.halfsize / (1 << SAMPLING_GRID_LEVEL);
+
+		// the points are sorted by cell code, so the points of a cell (at any level) are contiguous
+		const CCCoreLib::DgmOctree::cellsContainer& cells = octree->pointsAndTheirCellCodes();
+		std::vector<unsigned>                       remaining(cells.size());
+		for (unsigned i = 0; i < remaining.size(); ++i)
+		{
+			remaining[i] = i;
+		}
+
+		for (unsigned char level = 0; !remaining.empty(); ++level)
+		{
+			// the deepest level takes all the remaining points
+			const bool          lastLevel     = (level + SAMPLING_GRID_LEVEL >= CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL);
+			const unsigned char samplingLevel = std::min<unsigned char>(level + SAMPLING_GRID_LEVEL, CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL);
+			const unsigned char samplingShift = CCCoreLib::DgmOctree::GET_BIT_SHIFT(samplingLevel);
+			const unsigned char nodeShift     = CCCoreLib::DgmOctree::GET_BIT_SHIFT(level);
+
+			const size_t                   firstNode = m_nodes.size();
+			CCCoreLib::DgmOctree::CellCode previousNodeCode{0};
+			CCCoreLib::DgmOctree::CellCode previousSamplingCode{0};
+			std::vector<unsigned>          next;
+			for (size_t i = 0; i < remaining.size(); ++i)
+			{
+				const CCCoreLib::DgmOctree::IndexAndCode& cell         = cells[remaining[i]];
+				const CCCoreLib::DgmOctree::CellCode      samplingCode = (cell.theCode >> samplingShift);
+				if (!lastLevel && i != 0 && samplingCode == previousSamplingCode)
+				{
+					// the sampling cell is already taken
+					next.push_back(remaining[i]);
+					continue;
+				}
+				previousSamplingCode = samplingCode;
+
+				const CCCoreLib::DgmOctree::CellCode nodeCode = (cell.theCode >> nodeShift);
+				if (m_nodes.size() == firstNode || nodeCode != previousNodeCode)
+				{
+					Tuple3i cellPos;
+					octree->getCellPos(nodeCode, level, cellPos, true);
+					m_nodes.emplace_back();
+					m_nodes.back().key = VoxelKey{level, cellPos.x, cellPos.y, cellPos.z};
+					previousNodeCode   = nodeCode;
+				}
+				m_nodes.back().pointIndices.push_back(cell.theIndex);
+			}
+			remaining.swap(next);
+		}
+
+		return CC_FERR_NO_ERROR;
+	}
+
+	CC_FILE_ERROR CopcSaver::setLaszipError(laszip_POINTER laszipWriter)
+	{
+		laszip_CHAR* errorMsg{nullptr};
+		laszip_get_error(laszipWriter, &errorMsg);
+		m_errorMessage = errorMsg;
+		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+	}
+
+	CC_FILE_ERROR CopcSaver::compressNode(const Node& node, QByteArray& chunk)
+	{
+		const laszip_header& header = m_saver.laszipHeader();
+
+		laszip_POINTER laszipWriter{nullptr};
+		if (laszip_create(&laszipWriter))
+		{
+			m_errorMessage = "laszip failed to create the writer";
+			return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+
+		// the points are written without header in a memory stream, as a single chunk
+		std::ostringstream stream(std::ios::out | std::ios::binary);
+		CC_FILE_ERROR      error = CC_FERR_NO_ERROR;
+		laszip_point*      laszipPoint{nullptr};
+		if (laszip_set_header(laszipWriter, &header)
+		    || laszip_set_chunk_size(laszipWriter, VARIABLE_CHUNK_SIZE)
+		    || laszip_open_writer_stream(laszipWriter, stream, true, true)
+		    || laszip_get_point_pointer(laszipWriter, &laszipPoint))
+		{
+			error = setLaszipError(laszipWriter);
+		}
+
+		for (size_t i = 0; i < node.pointIndices.size() && error == CC_FERR_NO_ERROR; ++i)
+		{
+			error = m_saver.fillPoint(laszipWriter, laszipPoint, node.pointIndices[i]);
+			if (error != CC_FERR_NO_ERROR)
+			{
+				break;
+			}
+			if (laszip_write_point(laszipWriter))
+			{
+				error = setLaszipError(laszipWriter);
+				break;
+			}
+			m_inventory.add(*laszipPoint, header);
+		}
+
+		if (error == CC_FERR_NO_ERROR && laszip_close_writer(laszipWriter))
+		{
+			error = setLaszipError(laszipWriter);
+		}
+		laszip_clean(laszipWriter);
+		laszip_destroy(laszipWriter);
+
+		if (error != CC_FERR_NO_ERROR)
+		{
+			return error;
+		}
+
+		// the stream starts with the offset of the chunk table, which follows the (only) chunk
+		const std::string data = stream.str();
+		if (data.size() < sizeof(quint64))
+		{
+			m_errorMessage = "laszip wrote an unexpected chunk";
+			return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+		const quint64 chunkTableOffset = qFromLittleEndian<quint64>(reinterpret_cast<const uchar*>(data.data()));
+		if (chunkTableOffset < sizeof(quint64) || chunkTableOffset > data.size())
+		{
+			m_errorMessage = "laszip wrote an unexpected chunk";
+			return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+		chunk = QByteArray(data.data() + sizeof(quint64), static_cast<int>(chunkTableOffset - sizeof(quint64)));
+
+		return CC_FERR_NO_ERROR;
+	}
+
+	CC_FILE_ERROR CopcSaver::createLaszipVlr(QByteArray& payload)
+	{
+		laszip_POINTER laszipWriter{nullptr};
+		if (laszip_create(&laszipWriter))
+		{
+			m_errorMessage = "laszip failed to create the writer";
+			return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+
+		CC_FILE_ERROR error = CC_FERR_NO_ERROR;
+		laszip_U8*    vlr{nullptr};
+		laszip_U32    vlrSize{0};
+		if (laszip_set_header(laszipWriter, &m_saver.laszipHeader())
+		    || laszip_set_chunk_size(laszipWriter, VARIABLE_CHUNK_SIZE)
+		    || laszip_create_laszip_vlr(laszipWriter, &vlr, &vlrSize))
+		{
+			error = setLaszipError(laszipWriter);
+		}
+		else
+		{
+			// the buffer belongs to laszip
+			payload = QByteArray(reinterpret_cast<const char*>(vlr), static_cast<int>(vlrSize));
+		}
+
+		laszip_clean(laszipWriter);
+		laszip_destroy(laszipWriter);
+		return error;
+	}
+
+	uint32_t CopcSaver::offsetToPointData(const QByteArray& laszipVlr) const
+	{
+		const laszip_header& header = m_saver.laszipHeader();
+
+		uint32_t offset = LasDetails::HeaderSize(4) + LAS_VLR_HEADER_SIZE + Info::SIZE + LAS_VLR_HEADER_SIZE + laszipVlr.size();
+		for (laszip_U32 i = 0; i < header.number_of_variable_length_records; ++i)
+		{
+			if (ShouldCopyVlr(header.vlrs[i]))
+			{
+				offset += LasDetails::SizeOfVlrs(&header.vlrs[i], 1);
+			}
+		}
+		return offset;
+	}
+
+	void CopcSaver::writeHeaderAndVlrs(QDataStream& stream, const QByteArray& laszipVlr) const
+	{
+		const laszip_header& header = m_saver.laszipHeader();
+
+		std::vector<const laszip_vlr_struct*> vlrs;
+		for (laszip_U32 i = 0; i < header.number_of_variable_length_records; ++i)
+		{
+			if (ShouldCopyVlr(header.vlrs[i]))
+			{
+				vlrs.push_back(&header.vlrs[i]);
+			}
+		}
+
+		stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
+		stream.writeRawData("LASF", 4);
+		stream << static_cast<quint16>(header.file_source_ID);
+		stream << static_cast<quint16>(header.global_encoding | GLOBAL_ENCODING_WKT);
+		stream << static_cast<quint32>(header.project_ID_GUID_data_1);
+		stream << static_cast<quint16>(header.project_ID_GUID_data_2);
+		stream << static_cast<quint16>(header.project_ID_GUID_data_3);
+		stream.writeRawData(reinterpret_cast<const char*>(header.project_ID_GUID_data_4), 8);
+		stream << quint8(1) << quint8(4);
+		stream.writeRawData(header.system_identifier, 32);
+		stream.writeRawData(header.generating_software, 32);
+		stream << static_cast<quint16>(header.file_creation_day) << static_cast<quint16>(header.file_creation_year);
+		stream << LasDetails::HeaderSize(4);
+		stream << offsetToPointData(laszipVlr);
+		stream << static_cast<quint32>(vlrs.size() + 2);
+		stream << static_cast<quint8>(header.point_data_format | COMPRESSED_POINT_FORMAT_BIT);
+		stream << static_cast<quint16>(header.point_data_record_length);
+
+		// the legacy point counts are not used with the point formats 6-10
+		for (int i = 0; i < 6; ++i)
+		{
+			stream << quint32(0);
+		}
+
+		stream << header.x_scale_factor << header.y_scale_factor << header.z_scale_factor;
+		stream << header.x_offset << header.y_offset << header.z_offset;
+		stream << m_inventory.maxCorner.x << m_inventory.minCorner.x;
+		stream << m_inventory.maxCorner.y << m_inventory.minCorner.y;
+		stream << m_inventory.maxCorner.z << m_inventory.minCorner.z;
+
+		stream << quint64(0); // start of the waveform data packet record
+		stream << static_cast<quint64>(m_evlrOffset);
+		stream << quint32(1); // the COPC hierarchy
+		stream << static_cast<quint64>(m_inventory.pointCount);
+		for (uint64_t count : m_inventory.pointsByReturn)
+		{
+			stream << static_cast<quint64>(count);
+		}
+
+		// the COPC info VLR must be the first one
+		WriteVlrHeader(stream, "copc", 1, Info::SIZE, "COPC info VLR");
+		stream << m_info;
+
+		WriteVlrHeader(stream, "laszip encoded", 22204, static_cast<quint16>(laszipVlr.size()), "http://laszip.org");
+		stream.writeRawData(laszipVlr.constData(), laszipVlr.size());
+
+		for (const laszip_vlr_struct* vlr : vlrs)
+		{
+			WriteVlrHeader(stream, vlr->user_id, vlr->record_id, vlr->record_length_after_header, vlr->description);
+			stream.writeRawData(reinterpret_cast<const char*>(vlr->data), vlr->record_length_after_header);
+		}
+	}
+
+	CC_FILE_ERROR CopcSaver::save(const QString& filePath, CCCoreLib::GenericProgressCallback* progressCb)
+	{
+		if (m_cloud.size() == 0)
+		{
+			return CC_FERR_NO_SAVE;
+		}
+
+		CC_FILE_ERROR error = buildHierarchy(progressCb);
+		if (error != CC_FERR_NO_ERROR)
+		{
+			return error;
+		}
+
+		QByteArray laszipVlr;
+		error = createLaszipVlr(laszipVlr);
+		if (error != CC_FERR_NO_ERROR)
+		{
+			return error;
+		}
+
+		QFile file(filePath);
+		if (!file.open(QIODevice::WriteOnly))
+		{
+			return CC_FERR_WRITING;
+		}
+		QDataStream stream(&file);
+		stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
+
+		// the header and the VLRs are written once the points and the hierarchy are known
+		const uint32_t pointDataOffset = offsetToPointData(laszipVlr);
+		file.write(QByteArray(pointDataOffset + sizeof(quint64), '\0'));
+
+		if (progressCb)
+		{
+			progressCb->setMethodTitle("Save COPC file");
+			progressCb->setInfo(qPrintable(QString("Points: %L1 / Nodes: %L2").arg(m_cloud.size()).arg(m_nodes.size())));
+			progressCb->start();
+		}
+		CCCoreLib::NormalizedProgress normProgress(progressCb, m_cloud.size());
+
+		// one chunk per node (breadth first)
+		m_inventory = Inventory();
+		m_entries.clear();
+		m_entries.reserve(m_nodes.size());
+		for (const Node& node : m_nodes)
+		{
+			QByteArray chunk;
+			error = compressNode(node, chunk);
+			if (error != CC_FERR_NO_ERROR)
+			{
+				return error;
+			}
+
+			Entry entry;
+			entry.key         = node.key;
+			entry.offset      = static_cast<uint64_t>(file.pos());
+			entry.byte_size   = chunk.size();
+			entry.point_count = static_cast<int32_t>(node.pointIndices.size());
+			m_entries.push_back(entry);
+
+			if (file.write(chunk) != chunk.size())
+			{
+				return CC_FERR_WRITING;
+			}
+
+			if (progressCb && !normProgress.steps(static_cast<unsigned>(node.pointIndices.size())))
+			{
+				return CC_FERR_CANCELED_BY_USER;
+			}
+		}
+
+		// LAZ chunk table
+		const quint64 chunkTableOffset = static_cast<quint64>(file.pos());
+		file.write(EncodeChunkTable(m_entries));
+
+		// COPC hierarchy (a single page)
+		m_evlrOffset                      = static_cast<uint64_t>(file.pos());
+		LasDetails::EvlrHeader evlrHeader = LasDetails::EvlrHeader::CopcHierarchy();
+		evlrHeader.recordLength           = m_entries.size() * Entry::SIZE;
+		stream << evlrHeader;
+		m_info.root_hier_offset = static_cast<uint64_t>(file.pos());
+		m_info.root_hier_size   = evlrHeader.recordLength;
+		for (const Entry& entry : m_entries)
+		{
+			stream << entry;
+		}
+
+		m_info.gpstime_minimum = m_inventory.gpsTimeMin;
+		m_info.gpstime_maximum = m_inventory.gpsTimeMax;
+
+		file.seek(0);
+		writeHeaderAndVlrs(stream, laszipVlr);
+		assert(file.pos() == pointDataOffset);
+		stream << chunkTableOffset;
+
+		if (stream.status() != QDataStream::Ok)
+		{
+			return CC_FERR_WRITING;
+		}
+
+		ccLog::Print(QString("[LAS] COPC hierarchy: %1 nodes, %2 levels").arg(m_nodes.size()).arg(m_nodes.back().key.level + 1));
+
+		return CC_FERR_NO_ERROR;
+	}
+} // namespace copc
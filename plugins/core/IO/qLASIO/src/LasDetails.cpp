@@ -27,6 +27,7 @@
 #include <ccScalarField.h>
 // Qt
 #include <QDataStream>
+#include <QFile>
 // System
 #include <cstring>
 
@@ -57,6 +58,16 @@ namespace LasDetails
 		return self;
 	}
 
+	EvlrHeader EvlrHeader::CopcHierarchy()
+	{
+		EvlrHeader self;
+		self.recordID = 1'000;
+		strncpy(self.userID, "copc", EvlrHeader::USER_ID_SIZE);
+		strncpy(self.description, "EPT hierarchy", EvlrHeader::DESCRIPTION_SIZE);
+		self.recordLength = 0;
+		return self;
+	}
+
 	uint64_t TrueNumberOfPoints(const laszip_header* laszipHeader)
 	{
 		laszip_U64 pointCount;
@@ -101,6 +112,59 @@ namespace LasDetails
 		return stream;
 	}
 
+	uint32_t ReadLazChunkSize(const QString& fileName)
+	{
+		QFile file(fileName);
+		if (!file.open(QIODevice::ReadOnly))
+		{
+			return 0;
+		}
+
+		QDataStream stream(&file);
+		stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
+
+		uint16_t headerSize{0};
+		uint32_t numVlrs{0};
+		if (!file.seek(94))
+		{
+			return 0;
+		}
+		stream >> headerSize;
+		if (!file.seek(100))
+		{
+			return 0;
+		}
+		stream >> numVlrs;
+
+		qint64 vlrPos = headerSize;
+		for (uint32_t i = 0; i < numVlrs && stream.status() == QDataStream::Ok; ++i)
+		{
+			char     userId[16]{0};
+			uint16_t recordId{0};
+			uint16_t recordLength{0};
+			if (!file.seek(vlrPos + 2) || stream.readRawData(userId, 16) != 16)
+			{
+				return 0;
+			}
+			stream >> recordId >> recordLength;
+
+			if (strncmp(userId, "laszip encoded", 16) == 0 && recordId == 22204)
+			{
+				// compressor (2), coder (2), version (4), options (4), then the chunk size
+				uint32_t chunkSize{0};
+				if (recordLength < 16 || !file.seek(vlrPos + 54 + 12))
+				{
+					return 0;
+				}
+				stream >> chunkSize;
+				return (chunkSize == std::numeric_limits<uint32_t>::max() ? 0 : chunkSize);
+			}
+			vlrPos += 54 + recordLength;
+		}
+
+		return 0;
+	}
+
 	uint16_t PointFormatSize(unsigned pointFormat)
 	{
 		switch (pointFormat)
@@ -18,8 +18,10 @@
 #include "LasIOFilter.h"
 
 #include "CopcLoader.h"
+#include "CopcSaver.h"
 #include "LasMetadata.h"
 #include "LasOpenDialog.h"
+#include "LasParallelLoader.h"
 #include "LasSaveDialog.h"
 #include "LasSaver.h"
 #include "LasScalarFieldLoader.h"
@@ -87,13 +89,25 @@ static CCVector3d GetGlobalShift(FileIOFilter::LoadParameters& parameters,
 	return shift;
 }
 
+LasPointFilter LasIOFilter::s_loadFilter;
+
+void LasIOFilter::SetLoadFilter(const LasPointFilter& filter)
+{
+	s_loadFilter = filter;
+}
+
+const LasPointFilter& LasIOFilter::LoadFilter()
+{
+	return s_loadFilter;
+}
+
 LasIOFilter::LasIOFilter()
     : FileIOFilter({"LAS IO Filter",
                     3.0f, // priority (same as the old PDAL-based plugin)
                     QStringList{"las", "laz"},
                     "las",
                     QStringList{"LAS file (*.las *.laz *.copc.laz)"},
-                    QStringList{"LAS file (*.las *.laz)"},
+                    QStringList{"LAS file (*.las *.laz)", "COPC file (*.copc.laz)"},
                     Import | Export})
 {
 	m_openDialog.resetShouldSkipDialog();
@@ -223,16 +237,32 @@ CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
 		return TileLasReader(laszipReader, fileName, m_openDialog.tilingOptions());
 	}
 
+	// filter set from the command line (the rejected points are never added to the cloud)
+	const LasPointFilter* pointFilter = (s_loadFilter.testsPoints() ? &s_loadFilter : nullptr);
+	if (s_loadFilter.copcMaxLevel >= 0 && !copcLoader)
+	{
+		ccLog::Warning("[LAS] Not a COPC file, the maximum level of the filter is ignored");
+	}
+
 	// Update chunksToReads according to the COPCLoader if needed
 	if (copcLoader)
 	{
-		const uint32_t copcUserDefinedMaxLevel = m_openDialog.copcMaxLevel();
+		uint32_t copcUserDefinedMaxLevel = m_openDialog.copcMaxLevel();
+		if (s_loadFilter.copcMaxLevel >= 0)
+		{
+			copcUserDefinedMaxLevel = std::min(copcUserDefinedMaxLevel, static_cast<uint32_t>(s_loadFilter.copcMaxLevel));
+		}
 		if (copcUserDefinedMaxLevel < static_cast<uint32_t>(copcLoader->maxLevel()))
 		{
 			copcLoader->setMaxLevelConstraint(copcUserDefinedMaxLevel);
 		}
 
-		if (m_openDialog.hasUsableExtent())
+		if (s_loadFilter.box.isValid())
+		{
+			// the nodes that don't intersect the box are skipped
+			copcLoader->setClippingBoxConstraint(s_loadFilter.box);
+		}
+		else if (m_openDialog.hasUsableExtent())
 		{
 			const auto clippingExtent = m_openDialog.copcExtent();
 			if (clippingExtent.isValid())
@@ -243,6 +273,19 @@ CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
 		// Update intervalsToRead and pointCount for current COPC query
 		copcLoader->getChunkIntervalsSet(chunksToRead, pointCount);
 	}
+	else if (s_loadFilter.box.isValid())
+	{
+		// the whole file is skipped if its extent doesn't intersect the box
+		const CCVector3d& boxMin = s_loadFilter.box.minCorner();
+		const CCVector3d& boxMax = s_loadFilter.box.maxCorner();
+		if (boxMin.x > laszipHeader->max_x || boxMax.x < laszipHeader->min_x
+		    || boxMin.y > laszipHeader->max_y || boxMax.y < laszipHeader->min_y
+		    || boxMin.z > laszipHeader->max_z || boxMax.z < laszipHeader->min_z)
+		{
+			fullInterval.status = LasDetails::ChunkInterval::eFilterStatus::FAIL;
+			pointCount          = 0;
+		}
+	}
 
 	std::array<LasExtraScalarField, 3> extraScalarFieldsToLoadAsNormals = m_openDialog.getExtraFieldsToBeLoadedAsNormals(availableExtraScalarFields);
 	bool                               haveToLoadNormals                = std::any_of(extraScalarFieldsToLoadAsNormals.begin(),
@@ -320,177 +363,235 @@ CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
 	CCVector3d    globalShift(0, 0, 0);
 	bool          isglobalShiftDefined = false;
 
-	// Last Point ID of previous interval
-	uint64_t nextPointIndex = 0;
-	for (auto interval : chunksToRead)
+	// the global shift is defined with the first point read from the file
+	auto defineGlobalShift = [&](const laszip_F64 coordinates[3])
 	{
-		// break if previous inner loop (i.e previous interval) leads to an error
-		if (error != CC_FERR_NO_ERROR)
-		{
-			break;
-		}
+		CCVector3d firstPoint(coordinates);
+
+		CCVector3d lasOffset(laszipHeader->x_offset,
+		                     laszipHeader->y_offset,
+		                     0.0 /*laszipHeader->z_offset*/); // it's never a good idea to shift along Z
 
-		LasDetails::ChunkInterval& intervalRef = interval.get();
+		globalShift = GetGlobalShift(parameters,
+		                             preserveGlobalShift,
+		                             lasOffset,
+		                             firstPoint);
 
-		if (intervalRef.status == LasDetails::ChunkInterval::eFilterStatus::FAIL)
+		if (preserveGlobalShift)
 		{
-			continue;
+			pointCloud->setGlobalShift(globalShift);
 		}
 
-		// keep track of the origin of the interval/chunk in the cloud.
-		// this is needed for the LOD mechanism.
-		intervalRef.pointOffsetInCCCloud = pointCloud->size();
-
-		// For COPCLoader we allow to test if point is contained in a given extent
-		bool testInExtent = intervalRef.status == LasDetails::ChunkInterval::eFilterStatus::INTERSECT_BB && copcLoader;
+		if (copcLoader)
+		{
+			copcLoader->setGlobalShift(globalShift);
+		}
 
-		// Minimize seeking for COPC.
-		// It's not clear if it gives some performance improvements but it complexify the code.
-		// since it enforces to keep track of multiples indices in order to generate the proper LOD
-		// data structure.
-		// The main bottleneck in LAZ reading is point decompression but high number of seeking
-		// operation could have an impact on big files.
-		// In a standard LAS/LAZ scenario this is noop since nextPointIndex = 0;
-		if (nextPointIndex != intervalRef.pointOffsetInFile)
+		if (globalShift.norm2() != 0.0)
 		{
-			// Here int64_t is internally converted to uint32_t in LASzip, so it overflows if we have cloud with more
-			// than approx. 4.2B. points laz-perf does not suffer from this limitation.
-			// CC is also limited to unsigned in sizes.
-			// https://github.com/LASzip/LASzip/issues/76
-			// https://github.com/LASzip/LASzip/blob/103c4464611a39853d40aea9c3594b523a6c168b/src/laszip_dll.cpp#L4648
-			laszip_seek_point(laszipReader, static_cast<int64_t>(intervalRef.pointOffsetInFile));
-			nextPointIndex = intervalRef.pointOffsetInFile;
+			ccLog::Warning("[LAS] Cloud has been re-centered! Translation: "
+			               "(%.2f ; %.2f ; %.2f)",
+			               globalShift.x,
+			               globalShift.y,
+			               globalShift.z);
 		}
+		isglobalShiftDefined = true;
+	};
 
-		// Read the points int the interval
-		for (unsigned i = 0; i < intervalRef.pointCount; ++i)
+	// the parallel decoding is only used if it's worth it
+	bool decodeInParallel = m_openDialog.shouldDecodeInParallel() && LasParallelLoader::IsSuitableFor(*laszipHeader, pointCount);
+	if (decodeInParallel)
+	{
+		// the global shift must be known before the points are decoded concurrently
+		for (const LasDetails::ChunkInterval& interval : chunksToRead)
 		{
-			if (laszip_read_point(laszipReader))
+			if (interval.status == LasDetails::ChunkInterval::eFilterStatus::FAIL || interval.pointCount == 0)
+			{
+				continue;
+			}
+			if (laszip_seek_point(laszipReader, static_cast<int64_t>(interval.pointOffsetInFile))
+			    || laszip_read_point(laszipReader)
+			    || laszip_get_coordinates(laszipReader, laszipCoordinates))
 			{
 				error = CC_FERR_THIRD_PARTY_LIB_FAILURE; // error will be logged later
-				break;
+				decodeInParallel = false;
 			}
+			else
+			{
+				defineGlobalShift(laszipCoordinates);
+			}
+			break;
+		}
+	}
 
-			if (laszip_get_coordinates(laszipReader, laszipCoordinates))
+	if (decodeInParallel)
+	{
+		LasParallelLoader parallelLoader(fileName, *laszipHeader, loader, *pointCloud);
+		parallelLoader.setNormalFields(extraScalarFieldsToLoadAsNormals);
+		parallelLoader.setGlobalShift(globalShift);
+		parallelLoader.setClippingExtent(copcLoader ? &copcLoader->clippingExtent() : nullptr);
+		parallelLoader.setPointFilter(pointFilter);
+		parallelLoader.setProgress(normProgress.data());
+
+		error = parallelLoader.load(chunksToRead);
+		if (error == CC_FERR_THIRD_PARTY_LIB_FAILURE)
+		{
+			// the error comes from the readers of the parallel loader
+			ccLog::Warning("[LAS] laszip error: '%s'", qPrintable(parallelLoader.errorMessage()));
+		}
+	}
+	else if (error == CC_FERR_NO_ERROR)
+	{
+		// Last Point ID of previous interval
+		uint64_t nextPointIndex = 0;
+		for (auto interval : chunksToRead)
+		{
+			// break if previous inner loop (i.e previous interval) leads to an error
+			if (error != CC_FERR_NO_ERROR)
 			{
-				error = CC_FERR_THIRD_PARTY_LIB_FAILURE; // error will be logged later
 				break;
 			}
 
-			// increment nextPoint index
-			++nextPointIndex;
+			LasDetails::ChunkInterval& intervalRef = interval.get();
 
-			if (!isglobalShiftDefined)
+			if (intervalRef.status == LasDetails::ChunkInterval::eFilterStatus::FAIL)
 			{
-				CCVector3d firstPoint(laszipCoordinates);
+				continue;
+			}
 
-				CCVector3d lasOffset(laszipHeader->x_offset,
-				                     laszipHeader->y_offset,
-				                     0.0 /*laszipHeader->z_offset*/); // it's never a good idea to shift along Z
+			// keep track of the origin of the interval/chunk in the cloud.
+			// this is needed for the LOD mechanism.
+			intervalRef.pointOffsetInCCCloud = pointCloud->size();
+
+			// For COPCLoader we allow to test if point is contained in a given extent
+			bool testInExtent = intervalRef.status == LasDetails::ChunkInterval::eFilterStatus::INTERSECT_BB && copcLoader;
+
+			// Minimize seeking for COPC.
+			// It's not clear if it gives some performance improvements but it complexify the code.
+			// since it enforces to keep track of multiples indices in order to generate the proper LOD
+			// data structure.
+			// The main bottleneck in LAZ reading is point decompression but high number of seeking
+			// operation could have an impact on big files.
+			// In a standard LAS/LAZ scenario this is noop since nextPointIndex = 0;
+			if (nextPointIndex != intervalRef.pointOffsetInFile)
+			{
+				// Here int64_t is internally converted to uint32_t in LASzip, so it overflows if we have cloud with more
+				// than approx. 4.2B. points laz-perf does not suffer from this limitation.
+				// CC is also limited to unsigned in sizes.
+				// https://github.com/LASzip/LASzip/issues/76
+				// https://github.com/LASzip/LASzip/blob/103c4464611a39853d40aea9c3594b523a6c168b/src/laszip_dll.cpp#L4648
+				laszip_seek_point(laszipReader, static_cast<int64_t>(intervalRef.pointOffsetInFile));
+				nextPointIndex = intervalRef.pointOffsetInFile;
+			}
 
-				globalShift = GetGlobalShift(parameters,
-				                             preserveGlobalShift,
-				                             lasOffset,
-				                             firstPoint);
+			// Read the points int the interval
+			for (unsigned i = 0; i < intervalRef.pointCount; ++i)
+			{
+				if (laszip_read_point(laszipReader))
+				{
+					error = CC_FERR_THIRD_PARTY_LIB_FAILURE; // error will be logged later
+					break;
+				}
 
-				if (preserveGlobalShift)
+				if (laszip_get_coordinates(laszipReader, laszipCoordinates))
 				{
-					pointCloud->setGlobalShift(globalShift);
+					error = CC_FERR_THIRD_PARTY_LIB_FAILURE; // error will be logged later
+					break;
 				}
 
-				if (copcLoader)
+				// increment nextPoint index
+				++nextPointIndex;
+
+				if (!isglobalShiftDefined)
 				{
-					copcLoader->setGlobalShift(globalShift);
+					defineGlobalShift(laszipCoordinates);
 				}
 
-				if (globalShift.norm2() != 0.0)
+				// Test if the point is within the allowed extent:
+				// If the clippingBox intersects the current chunk interval, each point of the chunk must be tested individually.
+				if (testInExtent)
 				{
-					ccLog::Warning("[LAS] Cloud has been re-centered! Translation: "
-					               "(%.2f ; %.2f ; %.2f)",
-					               globalShift.x,
-					               globalShift.y,
-					               globalShift.z);
+					if (!copcLoader->clippingExtent().contains(CCVector3d(laszipCoordinates[0], laszipCoordinates[1], laszipCoordinates[2])))
+					{
+						intervalRef.filteredPointCount++;
+						continue;
+					}
 				}
-				isglobalShiftDefined = true;
-			}
 
-			// Test if the point is within the allowed extent:
-			// If the clippingBox intersects the current chunk interval, each point of the chunk must be tested individually.
-			if (testInExtent)
-			{
-				if (!copcLoader->clippingExtent().contains(CCVector3d(laszipCoordinates[0], laszipCoordinates[1], laszipCoordinates[2])))
+				// Test if the point is accepted by the filter (if any)
+				if (pointFilter && !pointFilter->accepts(*laszipPoint, laszipCoordinates))
 				{
 					intervalRef.filteredPointCount++;
 					continue;
 				}
-			}
-
-			currentPoint.x = static_cast<PointCoordinateType>(laszipCoordinates[0] + globalShift.x);
-			currentPoint.y = static_cast<PointCoordinateType>(laszipCoordinates[1] + globalShift.y);
-			currentPoint.z = static_cast<PointCoordinateType>(laszipCoordinates[2] + globalShift.z);
 
-			pointCloud->addPoint(currentPoint);
+				currentPoint.x = static_cast<PointCoordinateType>(laszipCoordinates[0] + globalShift.x);
+				currentPoint.y = static_cast<PointCoordinateType>(laszipCoordinates[1] + globalShift.y);
+				currentPoint.z = static_cast<PointCoordinateType>(laszipCoordinates[2] + globalShift.z);
 
-			error = loader.handleScalarFields(*pointCloud, *laszipPoint);
-			if (error != CC_FERR_NO_ERROR)
-			{
-				break;
-			}
+				pointCloud->addPoint(currentPoint);
 
-			error = loader.handleExtraScalarFields(*laszipPoint);
-			if (error != CC_FERR_NO_ERROR)
-			{
-				break;
-			}
+				error = loader.handleScalarFields(*pointCloud, *laszipPoint);
+				if (error != CC_FERR_NO_ERROR)
+				{
+					break;
+				}
 
-			if (LasDetails::HasRGB(laszipHeader->point_data_format))
-			{
-				error = loader.handleRGBValue(*pointCloud, *laszipPoint);
+				error = loader.handleExtraScalarFields(*laszipPoint);
 				if (error != CC_FERR_NO_ERROR)
 				{
 					break;
 				}
-			}
 
-			if (waveformLoader)
-			{
-				waveformLoader->loadWaveform(*pointCloud, *laszipPoint);
-			}
+				if (LasDetails::HasRGB(laszipHeader->point_data_format))
+				{
+					error = loader.handleRGBValue(*pointCloud, *laszipPoint);
+					if (error != CC_FERR_NO_ERROR)
+					{
+						break;
+					}
+				}
 
-			if (haveToLoadNormals)
-			{
-				CCVector3 normal{};
-				// Here, the array has 3 values, not because normals have 3 dimensions (x, y, z)
-				// but because extra scalar field may have 3 dimensions.
-				// Regardless of whether the extra scalar field has more than 1 dimensions
-				// we only use the first one for each normal dimension.
-				for (unsigned int normalIndex = 0; normalIndex < 3; ++normalIndex)
+				if (waveformLoader)
+				{
+					waveformLoader->loadWaveform(*pointCloud, *laszipPoint);
+				}
+
+				if (haveToLoadNormals)
 				{
-					const LasExtraScalarField& extraField = extraScalarFieldsToLoadAsNormals[normalIndex];
-					if (extraField.type == LasExtraScalarField::DataType::Undocumented)
+					CCVector3 normal{};
+					// Here, the array has 3 values, not because normals have 3 dimensions (x, y, z)
+					// but because extra scalar field may have 3 dimensions.
+					// Regardless of whether the extra scalar field has more than 1 dimensions
+					// we only use the first one for each normal dimension.
+					for (unsigned int normalIndex = 0; normalIndex < 3; ++normalIndex)
 					{
-						continue;
+						const LasExtraScalarField& extraField = extraScalarFieldsToLoadAsNormals[normalIndex];
+						if (extraField.type == LasExtraScalarField::DataType::Undocumented)
+						{
+							continue;
+						}
+						ScalarType normalsValues[3]{0, 0, 0};
+						error = loader.parseExtraScalarField(extraField, *laszipPoint, normalsValues);
+						if (error != CC_FERR_NO_ERROR)
+						{
+							break;
+						}
+						normal[normalIndex] = normalsValues[0];
 					}
-					ScalarType normalsValues[3]{0, 0, 0};
-					error = loader.parseExtraScalarField(extraField, *laszipPoint, normalsValues);
+
 					if (error != CC_FERR_NO_ERROR)
 					{
 						break;
 					}
-					normal[normalIndex] = normalsValues[0];
+					pointCloud->addNorm(normal);
 				}
 
-				if (error != CC_FERR_NO_ERROR)
+				if (normProgress && !normProgress->oneStep())
 				{
+					error = CC_FERR_CANCELED_BY_USER;
 					break;
 				}
-				pointCloud->addNorm(normal);
-			}
-
-			if (normProgress && !normProgress->oneStep())
-			{
-				error = CC_FERR_CANCELED_BY_USER;
-				break;
 			}
 		}
 	}
@@ -578,18 +679,27 @@ CC_FILE_ERROR LasIOFilter::loadFile(const QString&  fileName,
 		extraField.resetScalarFieldsPointers();
 	}
 
-	// With the copcLoader, we shrink the point cloud to take into account the point that could be filtered in the loading process
+	// With the copcLoader (or a filter), we shrink the point cloud to take into account the point that could be filtered in the loading process
 	// We have to do that before the LOD construction because shrinkTofit clears the LOD.
-	if (copcLoader)
+	if (copcLoader || pointFilter)
 	{
 		pointCloud->shrinkToFit();
 	}
 
 	LasMetadata::SaveMetadataInto(*laszipHeader, *pointCloud, availableExtraScalarFields);
 
-	container.addChild(pointCloud.release());
+	if (s_loadFilter.isActive() && pointCloud->size() == 0 && error == CC_FERR_NO_ERROR)
+	{
+		// no point passes the filter set from the command line (no empty cloud is added)
+		ccLog::Warning("[LAS] No point of the file passes the load filter");
+		error = CC_FERR_NO_LOAD;
+	}
+	else
+	{
+		container.addChild(pointCloud.release());
+	}
 
-	if (error == CC_FERR_THIRD_PARTY_LIB_FAILURE)
+	if (error == CC_FERR_THIRD_PARTY_LIB_FAILURE && !decodeInParallel)
 	{
 		ccLog::Warning("ERROR IS HERE");
 		laszip_get_error(laszipHeader, &errorMsg);
@@ -899,14 +1009,32 @@ CC_FILE_ERROR LasIOFilter::saveToFile(ccHObject* entity, const QString& filename
 		}
 	}
 
-	LasSaver      saver(*pointCloud, params);
+	const bool saveAsCopc = filename.endsWith(".copc.laz", Qt::CaseInsensitive);
+	if (saveAsCopc)
+	{
+		copc::CopcSaver::AdaptParameters(params);
+	}
+
+	LasSaver         saver(*pointCloud, params);
+	ccProgressDialog progressDialog(true, parameters.parentWidget);
+
+	if (saveAsCopc)
+	{
+		copc::CopcSaver copcSaver(*pointCloud, saver);
+		CC_FILE_ERROR   error = copcSaver.save(filename, parameters.parentWidget ? &progressDialog : nullptr);
+		if (error == CC_FERR_THIRD_PARTY_LIB_FAILURE)
+		{
+			ccLog::Warning(QString("[LAS] laszip error :'%1'").arg(copcSaver.errorMessage()));
+		}
+		return error;
+	}
+
 	CC_FILE_ERROR error = saver.open(filename);
 	if (error != CC_FERR_NO_ERROR)
 	{
 		return error;
 	}
 
-	ccProgressDialog progressDialog(true, parameters.parentWidget);
 	progressDialog.setMethodTitle("Saving LAS points");
 	progressDialog.setInfo("Saving points");
 	QScopedPointer<CCCoreLib::NormalizedProgress> normProgress;
@@ -81,6 +81,7 @@ LasOpenDialog::LasOpenDialog(QWidget* parent)
 	connect(unselectAllToolButton, &QPushButton::clicked, this, [&]
 	        { doSelectAll(false); });
 	connect(tilingBrowseToolButton, &QPushButton::clicked, this, &LasOpenDialog::onBrowseTilingOutputDir);
+	connect(tilingAdaptiveCheckBox, &QCheckBox::toggled, tilingMaxPointsDoubleSpinBox, &QWidget::setEnabled);
 	connect(actionTab, &QTabWidget::currentChanged, this, &LasOpenDialog::onCurrentTabChanged);
 	connect(selectAllESFToolButton, &QPushButton::clicked, [&]
 	        { doSelectAllESF(true); });
@@ -114,12 +115,19 @@ LasOpenDialog::LasOpenDialog(QWidget* parent)
 		int     tiling0Count = settings.value("Tiling0", 1).toInt();
 		int     tiling1Count = settings.value("Tiling1", 1).toInt();
 		int     tilingDim    = settings.value("TilingDim", 0).toInt();
+		bool    adaptive     = settings.value("TilingAdaptive", false).toBool();
+		double  maxPoints    = settings.value("TilingMaxPoints", 10.0).toDouble();
+		double  halo         = settings.value("TilingHalo", 0.0).toDouble();
 		settings.endGroup();
 
 		tilingDimensioncomboBox->setCurrentIndex(tilingDim);
 		tilingSpinBox0->setValue(tiling0Count);
 		tilingSpinBox1->setValue(tiling1Count);
 		tilingOutputPathLineEdit->setText(tilingPath);
+		tilingAdaptiveCheckBox->setChecked(adaptive);
+		tilingMaxPointsDoubleSpinBox->setEnabled(adaptive);
+		tilingMaxPointsDoubleSpinBox->setValue(maxPoints);
+		tilingHaloDoubleSpinBox->setValue(halo);
 	}
 }
 
@@ -355,6 +363,11 @@ bool LasOpenDialog::shouldDecomposeClassification() const
 	return decomposeClassificationCheckBox->isChecked();
 }
 
+bool LasOpenDialog::shouldDecodeInParallel() const
+{
+	return parallelDecodingCheckBox->isChecked();
+}
+
 bool LasOpenDialog::isChecked(const LasExtraScalarField& lasExtraScalarField) const
 {
 	return IsCheckedIn(lasExtraScalarField.name, availableExtraScalarFields);
@@ -427,13 +440,25 @@ LasTilingOptions LasOpenDialog::tilingOptions() const
 	settings.setValue("Tiling0", numTiles0);
 	settings.setValue("Tiling1", numTiles1);
 	settings.setValue("TilingDim", index);
+	settings.setValue("TilingAdaptive", tilingAdaptiveCheckBox->isChecked());
+	settings.setValue("TilingMaxPoints", tilingMaxPointsDoubleSpinBox->value());
+	settings.setValue("TilingHalo", tilingHaloDoubleSpinBox->value());
 	settings.endGroup();
 
+	// the maximum number of points is expressed in millions
+	uint64_t maxPointsPerTile = 0;
+	if (tilingAdaptiveCheckBox->isChecked())
+	{
+		maxPointsPerTile = static_cast<uint64_t>(tilingMaxPointsDoubleSpinBox->value() * 1.0e6);
+	}
+
 	return LasTilingOptions{
 	    tilingOutputPathLineEdit->text(),
 	    dimensions,
 	    static_cast<unsigned>(numTiles0),
 	    static_cast<unsigned>(numTiles1),
+	    maxPointsPerTile,
+	    tilingHaloDoubleSpinBox->value(),
 	};
 }
 
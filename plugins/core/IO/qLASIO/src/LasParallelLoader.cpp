@@ -0,0 +1,413 @@
+//##########################################################################
+//#                                                                        #
+//#                CLOUDCOMPARE PLUGIN: LAS-IO Plugin                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                   COPYRIGHT: Thomas Montaigu                           #
+//#                                                                        #
+//##########################################################################
+
+#include "LasParallelLoader.h"
+
+// CCCoreLib
+#include <GenericProgressCallback.h>
+
+// qCC_db
+#include <ccPointCloud.h>
+#include <ccScalarField.h>
+
+// Qt
+#include <QThread>
+#include <QtConcurrentMap>
+
+// System
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+/// Minimum number of points decoded by a task (the default size of a LAZ chunk)
+static const uint64_t s_minTaskPointCount = 50000;
+/// Number of tasks per thread (to balance the load between the threads)
+static const uint64_t s_tasksPerThread = 4;
+/// Number of points between two updates of the progress
+static const unsigned s_progressStep = 4096;
+
+LasParallelLoader::LasParallelLoader(const QString&        fileName,
+                                     const laszip_header&  laszipHeader,
+                                     LasScalarFieldLoader& loader,
+                                     ccPointCloud&         pointCloud)
+    : m_fileName(fileName)
+    , m_laszipHeader(laszipHeader)
+    , m_loader(loader)
+    , m_pointCloud(pointCloud)
+{
+}
+
+bool LasParallelLoader::IsSuitableFor(const laszip_header& laszipHeader, uint64_t pointCount)
+{
+	// the waveforms are read sequentially from the file (or from another one)
+	return !LasDetails::HasWaveform(laszipHeader.point_data_format)
+	       && QThread::idealThreadCount() > 1
+	       && pointCount >= 2 * s_minTaskPointCount;
+}
+
+void LasParallelLoader::createTasks(const std::vector<std::reference_wrapper<LasDetails::ChunkInterval>>& chunkIntervals)
+{
+	m_tasks.clear();
+
+	uint64_t totalPointCount = 0;
+	for (const LasDetails::ChunkInterval& interval : chunkIntervals)
+	{
+		if (interval.status != LasDetails::ChunkInterval::eFilterStatus::FAIL)
+		{
+			totalPointCount += interval.pointCount;
+		}
+	}
+
+	uint64_t taskPointCount = std::max(s_minTaskPointCount, totalPointCount / (QThread::idealThreadCount() * s_tasksPerThread));
+	// the tasks start at the beginning of a chunk, so that
+	// a seek doesn't imply to decompress the previous points of the chunk
+	uint32_t chunkSize = LasDetails::ReadLazChunkSize(m_fileName);
+	if (chunkSize != 0)
+	{
+		taskPointCount = ((taskPointCount + chunkSize - 1) / chunkSize) * chunkSize;
+	}
+
+	unsigned sliceStart = 0;
+	for (size_t i = 0; i < chunkIntervals.size(); ++i)
+	{
+		const LasDetails::ChunkInterval& interval = chunkIntervals[i];
+		if (interval.status == LasDetails::ChunkInterval::eFilterStatus::FAIL)
+		{
+			continue;
+		}
+
+		for (uint64_t offset = 0; offset < interval.pointCount; offset += taskPointCount)
+		{
+			Task task;
+			task.interval          = i;
+			task.pointOffsetInFile = interval.pointOffsetInFile + offset;
+			task.pointCount        = std::min(taskPointCount, interval.pointCount - offset);
+			task.testInExtent      = (interval.status == LasDetails::ChunkInterval::eFilterStatus::INTERSECT_BB && m_clippingExtent);
+			task.sliceStart        = sliceStart;
+			sliceStart += static_cast<unsigned>(task.pointCount);
+			m_tasks.push_back(task);
+		}
+	}
+}
+
+CC_FILE_ERROR LasParallelLoader::load(std::vector<std::reference_wrapper<LasDetails::ChunkInterval>>& chunkIntervals)
+{
+	m_hasNormals = std::any_of(m_normalFields.begin(),
+	                           m_normalFields.end(),
+	                           [](const LasExtraScalarField& e)
+	                           {
+		                           return e.type != LasExtraScalarField::DataType::Undocumented;
+	                           });
+
+	createTasks(chunkIntervals);
+	if (m_tasks.empty())
+	{
+		return CC_FERR_NO_ERROR;
+	}
+
+	// pre-size the point cloud and its fields, so that each task can write into its own slice
+	const unsigned pointCount = m_tasks.back().sliceStart + static_cast<unsigned>(m_tasks.back().pointCount);
+	const bool     hasRGB     = LasDetails::HasRGB(m_laszipHeader.point_data_format);
+	if (!m_pointCloud.resize(pointCount)
+	    || (hasRGB && !m_pointCloud.resizeTheRGBTable(false))
+	    || (m_hasNormals && !m_pointCloud.resizeTheNormsTable())
+	    || !m_loader.resizeScalarFields(pointCount))
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+
+	std::vector<size_t> taskIndices(m_tasks.size());
+	std::iota(taskIndices.begin(), taskIndices.end(), 0);
+	CC_FILE_ERROR error = decodeTasks(taskIndices, -1, true);
+
+	if (hasRGB)
+	{
+		// as with the sequential loading, the first point (in file order) that creates
+		// the colors sets the shift of the RGB components of all the points
+		int colorCompShift = -1;
+		for (const Task& task : m_tasks)
+		{
+			if (task.colorCompShift >= 0)
+			{
+				colorCompShift = task.colorCompShift;
+				break;
+			}
+		}
+
+		if (colorCompShift < 0)
+		{
+			m_pointCloud.unallocateColors();
+		}
+		else if (error == CC_FERR_NO_ERROR)
+		{
+			// the tasks that chose another shift are decoded again (files mixing 8 and 16-bit colors)
+			taskIndices.clear();
+			for (size_t i = 0; i < m_tasks.size(); ++i)
+			{
+				if (m_tasks[i].colorCompShift >= 0 && m_tasks[i].colorCompShift != colorCompShift)
+				{
+					taskIndices.push_back(i);
+				}
+			}
+			if (!taskIndices.empty())
+			{
+				error = decodeTasks(taskIndices, colorCompShift, false);
+			}
+		}
+	}
+
+	// the points decoded so far are kept, even if an error occurred (as with the sequential loading)
+	if (!compactSlices(chunkIntervals) && error == CC_FERR_NO_ERROR)
+	{
+		error = CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+
+	return error;
+}
+
+CC_FILE_ERROR LasParallelLoader::decodeTasks(const std::vector<size_t>& taskIndices, int forcedColorCompShift, bool showProgress)
+{
+	m_nextTask = 0;
+	m_error    = CC_FERR_NO_ERROR;
+
+	int              threadCount = std::min(QThread::idealThreadCount(), static_cast<int>(taskIndices.size()));
+	std::vector<int> threads(std::max(threadCount, 1));
+	QtConcurrent::blockingMap(threads,
+	                          [&](int&)
+	                          {
+		                          laszip_POINTER reader{nullptr};
+		                          laszip_BOOL    isCompressed{false};
+		                          if (laszip_create(&reader))
+		                          {
+			                          m_error = CC_FERR_THIRD_PARTY_LIB_FAILURE;
+			                          return;
+		                          }
+		                          if (laszip_open_reader(reader, qPrintable(m_fileName), &isCompressed))
+		                          {
+			                          setLaszipError(reader);
+			                          laszip_clean(reader);
+			                          laszip_destroy(reader);
+			                          return;
+		                          }
+
+		                          // each thread has its own loader (parsing buffers) but writes into the same fields
+		                          LasScalarFieldLoader loader(m_loader);
+		                          for (size_t i = m_nextTask++; i < taskIndices.size() && m_error == CC_FERR_NO_ERROR; i = m_nextTask++)
+		                          {
+			                          CC_FILE_ERROR error = decodeTask(reader, loader, m_tasks[taskIndices[i]], forcedColorCompShift, showProgress);
+			                          if (error == CC_FERR_THIRD_PARTY_LIB_FAILURE)
+			                          {
+				                          setLaszipError(reader);
+			                          }
+			                          else if (error != CC_FERR_NO_ERROR)
+			                          {
+				                          int noError = CC_FERR_NO_ERROR;
+				                          m_error.compare_exchange_strong(noError, error);
+			                          }
+		                          }
+
+		                          laszip_close_reader(reader);
+		                          laszip_clean(reader);
+		                          laszip_destroy(reader);
+	                          });
+
+	return static_cast<CC_FILE_ERROR>(m_error.load());
+}
+
+CC_FILE_ERROR LasParallelLoader::decodeTask(laszip_POINTER        reader,
+                                            LasScalarFieldLoader& loader,
+                                            Task&                 task,
+                                            int                   forcedColorCompShift,
+                                            bool                  showProgress)
+{
+	task.loadedPointCount = 0;
+	if (forcedColorCompShift < 0)
+	{
+		task.colorCompShift = -1;
+	}
+
+	laszip_point* laszipPoint{nullptr};
+	if (laszip_get_point_pointer(reader, &laszipPoint))
+	{
+		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+	}
+
+	// see LasIOFilter::loadFile regarding the limitations of laszip_seek_point
+	if (laszip_seek_point(reader, static_cast<int64_t>(task.pointOffsetInFile)))
+	{
+		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+	}
+
+	const bool    hasRGB = LasDetails::HasRGB(m_laszipHeader.point_data_format);
+	int           colorCompShift{forcedColorCompShift};
+	laszip_F64    laszipCoordinates[3]{0};
+	unsigned      pointIndex    = task.sliceStart;
+	unsigned      progressSteps = 0;
+	CC_FILE_ERROR error{CC_FERR_NO_ERROR};
+
+	for (uint64_t i = 0; i < task.pointCount; ++i)
+	{
+		if (++progressSteps == s_progressStep)
+		{
+			progressSteps = 0;
+			if (showProgress && m_progress && !m_progress->steps(s_progressStep))
+			{
+				return CC_FERR_CANCELED_BY_USER;
+			}
+			if (m_error != CC_FERR_NO_ERROR)
+			{
+				// another thread failed
+				return CC_FERR_NO_ERROR;
+			}
+		}
+
+		if (laszip_read_point(reader) || laszip_get_coordinates(reader, laszipCoordinates))
+		{
+			return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+
+		if (task.testInExtent && !m_clippingExtent->contains(CCVector3d(laszipCoordinates[0], laszipCoordinates[1], laszipCoordinates[2])))
+		{
+			continue;
+		}
+
+		if (m_pointFilter && !m_pointFilter->accepts(*laszipPoint, laszipCoordinates))
+		{
+			continue;
+		}
+
+		*const_cast<CCVector3*>(m_pointCloud.getPoint(pointIndex)) = CCVector3(static_cast<PointCoordinateType>(laszipCoordinates[0] + m_globalShift.x),
+		                                                                       static_cast<PointCoordinateType>(laszipCoordinates[1] + m_globalShift.y),
+		                                                                       static_cast<PointCoordinateType>(laszipCoordinates[2] + m_globalShift.z));
+
+		loader.setScalarFieldValues(pointIndex, *laszipPoint);
+
+		error = loader.setExtraScalarFieldValues(pointIndex, *laszipPoint);
+		if (error != CC_FERR_NO_ERROR)
+		{
+			return error;
+		}
+
+		if (hasRGB)
+		{
+			if (colorCompShift < 0 && loader.createsColors(*laszipPoint))
+			{
+				colorCompShift      = loader.colorCompShiftFor(*laszipPoint);
+				task.colorCompShift = colorCompShift;
+			}
+
+			if (colorCompShift < 0)
+			{
+				m_pointCloud.setPointColor(pointIndex, ccColor::blackRGB);
+			}
+			else
+			{
+				m_pointCloud.setPointColor(pointIndex,
+				                           ccColor::Rgb(static_cast<ColorCompType>(laszipPoint->rgb[0] >> colorCompShift),
+				                                        static_cast<ColorCompType>(laszipPoint->rgb[1] >> colorCompShift),
+				                                        static_cast<ColorCompType>(laszipPoint->rgb[2] >> colorCompShift)));
+			}
+		}
+
+		if (m_hasNormals)
+		{
+			CCVector3 normal{};
+			// only the first dimension of each extra scalar field is used (see LasIOFilter::loadFile)
+			for (unsigned int normalIndex = 0; normalIndex < 3; ++normalIndex)
+			{
+				const LasExtraScalarField& extraField = m_normalFields[normalIndex];
+				if (extraField.type == LasExtraScalarField::DataType::Undocumented)
+				{
+					continue;
+				}
+				ScalarType normalsValues[3]{0, 0, 0};
+				error = loader.parseExtraScalarField(extraField, *laszipPoint, normalsValues);
+				if (error != CC_FERR_NO_ERROR)
+				{
+					return error;
+				}
+				normal[normalIndex] = normalsValues[0];
+			}
+			m_pointCloud.setPointNormal(pointIndex, normal);
+		}
+
+		++pointIndex;
+		++task.loadedPointCount;
+	}
+
+	if (showProgress && m_progress && progressSteps != 0 && !m_progress->steps(progressSteps))
+	{
+		return CC_FERR_CANCELED_BY_USER;
+	}
+
+	return CC_FERR_NO_ERROR;
+}
+
+bool LasParallelLoader::compactSlices(const std::vector<std::reference_wrapper<LasDetails::ChunkInterval>>& chunkIntervals)
+{
+	unsigned destIndex       = 0;
+	size_t   currentInterval = std::numeric_limits<size_t>::max();
+	for (const Task& task : m_tasks)
+	{
+		LasDetails::ChunkInterval& interval = chunkIntervals[task.interval];
+		if (task.interval != currentInterval)
+		{
+			// keep track of the origin of the interval/chunk in the cloud (LOD mechanism)
+			interval.pointOffsetInCCCloud = destIndex;
+			interval.filteredPointCount   = 0;
+			currentInterval               = task.interval;
+		}
+		interval.filteredPointCount += task.pointCount - task.loadedPointCount;
+
+		if (destIndex != task.sliceStart)
+		{
+			for (unsigned i = 0; i < task.loadedPointCount; ++i)
+			{
+				const unsigned sourceIndex = task.sliceStart + i;
+				*const_cast<CCVector3*>(m_pointCloud.getPoint(destIndex + i)) = *m_pointCloud.getPoint(sourceIndex);
+				if (m_pointCloud.hasColors())
+				{
+					m_pointCloud.setPointColor(destIndex + i, m_pointCloud.getPointColor(sourceIndex));
+				}
+				if (m_hasNormals)
+				{
+					m_pointCloud.setPointNormalIndex(destIndex + i, m_pointCloud.getPointNormalIndex(sourceIndex));
+				}
+				m_loader.moveScalarFieldValues(sourceIndex, destIndex + i);
+			}
+		}
+		destIndex += task.loadedPointCount;
+	}
+
+	return m_pointCloud.resize(destIndex) && m_loader.finalizeScalarFields(destIndex);
+}
+
+void LasParallelLoader::setLaszipError(laszip_POINTER reader)
+{
+	int noError = CC_FERR_NO_ERROR;
+	m_error.compare_exchange_strong(noError, CC_FERR_THIRD_PARTY_LIB_FAILURE);
+
+	laszip_CHAR* errorMsg{nullptr};
+	laszip_get_error(reader, &errorMsg);
+
+	QMutexLocker locker(&m_errorMutex);
+	if (m_errorMessage.isEmpty() && errorMsg)
+	{
+		m_errorMessage = QString(errorMsg);
+	}
+}
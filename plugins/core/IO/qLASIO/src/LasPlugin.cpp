@@ -20,6 +20,9 @@
 #include "LasIOFilter.h"
 #include "LasVlr.h"
 
+// CC
+#include <ccCommandLineInterface.h>
+
 LasPlugin::LasPlugin(QObject* parent)
     : QObject(parent)
     , ccIOPluginInterface(":/CC/plugin/LAS-IO/info.json")
@@ -36,3 +39,137 @@ ccIOPluginInterface::FilterList LasPlugin::getFilters()
 	    FileIOFilter::Shared(new LasIOFilter),
 	};
 }
+
+constexpr char COMMAND_LAS_LOAD_FILTER[]      = "LAS_LOAD_FILTER";
+constexpr char OPTION_LAS_FILTER_BOX[]        = "BOX";
+constexpr char OPTION_LAS_FILTER_CLASSES[]    = "CLASSES";
+constexpr char OPTION_LAS_FILTER_RETURNS[]    = "RETURNS";
+constexpr char OPTION_LAS_FILTER_COPC_LEVEL[] = "COPC_LEVEL";
+
+/// Parses a list of values and ranges (e.g. "2,5-7") into flags
+static bool ParseValues(const QString& text, unsigned maxValue, std::vector<bool>& flags)
+{
+	flags.assign(maxValue + 1, false);
+	for (const QString& token : text.split(',', QString::SkipEmptyParts))
+	{
+		const QStringList bounds = token.split('-');
+		bool              ok0    = false;
+		bool              ok1    = false;
+		const unsigned    first  = bounds.front().toUInt(&ok0);
+		const unsigned    last   = bounds.back().toUInt(&ok1);
+		if (bounds.size() > 2 || !ok0 || !ok1 || first > last || last > maxValue)
+		{
+			return false;
+		}
+		for (unsigned value = first; value <= last; ++value)
+		{
+			flags[value] = true;
+		}
+	}
+	return true;
+}
+
+/// Command line command to filter the points of the next loaded LAS/LAZ files
+///
+/// -LAS_LOAD_FILTER [-BOX xmin ymin zmin xmax ymax zmax] [-CLASSES list] [-RETURNS list] [-COPC_LEVEL level]
+///
+/// The lists are comma separated values or ranges (e.g. "2,5-7").
+/// Without option, the filter is removed.
+class LasLoadFilterCommand : public ccCommandLineInterface::Command
+{
+  public:
+	LasLoadFilterCommand()
+	    : ccCommandLineInterface::Command("Set LAS load filter", COMMAND_LAS_LOAD_FILTER)
+	{
+	}
+
+	~LasLoadFilterCommand() override = default;
+
+	bool process(ccCommandLineInterface& cmd) override
+	{
+		LasPointFilter filter;
+
+		while (!cmd.arguments().empty())
+		{
+			const QString argument = cmd.arguments().front();
+			if (ccCommandLineInterface::IsCommand(argument, OPTION_LAS_FILTER_BOX))
+			{
+				cmd.arguments().pop_front();
+
+				double values[6]{0};
+				for (double& value : values)
+				{
+					bool ok = false;
+					if (!cmd.arguments().empty())
+					{
+						value = cmd.arguments().takeFirst().toDouble(&ok);
+					}
+					if (!ok)
+					{
+						return cmd.error(QObject::tr("Missing or invalid parameter: 6 coordinates expected after '%1' (xmin ymin zmin xmax ymax zmax)").arg(OPTION_LAS_FILTER_BOX));
+					}
+				}
+				if (values[0] > values[3] || values[1] > values[4] || values[2] > values[5])
+				{
+					return cmd.error(QObject::tr("Invalid parameter: the min corner is above the max corner after '%1'").arg(OPTION_LAS_FILTER_BOX));
+				}
+				filter.box.clear();
+				filter.box.add(CCVector3d(values[0], values[1], values[2]));
+				filter.box.add(CCVector3d(values[3], values[4], values[5]));
+				cmd.print(QObject::tr("LAS filter: box (%1 ; %2 ; %3) - (%4 ; %5 ; %6)").arg(values[0]).arg(values[1]).arg(values[2]).arg(values[3]).arg(values[4]).arg(values[5]));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, OPTION_LAS_FILTER_CLASSES))
+			{
+				cmd.arguments().pop_front();
+				if (cmd.arguments().empty() || !ParseValues(cmd.arguments().front(), 255, filter.classes))
+				{
+					return cmd.error(QObject::tr("Missing or invalid parameter: classification codes (0-255) expected after '%1'").arg(OPTION_LAS_FILTER_CLASSES));
+				}
+				cmd.print(QObject::tr("LAS filter: classes %1").arg(cmd.arguments().takeFirst()));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, OPTION_LAS_FILTER_RETURNS))
+			{
+				cmd.arguments().pop_front();
+				if (cmd.arguments().empty() || !ParseValues(cmd.arguments().front(), 15, filter.returnNumbers))
+				{
+					return cmd.error(QObject::tr("Missing or invalid parameter: return numbers (0-15) expected after '%1'").arg(OPTION_LAS_FILTER_RETURNS));
+				}
+				cmd.print(QObject::tr("LAS filter: return numbers %1").arg(cmd.arguments().takeFirst()));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, OPTION_LAS_FILTER_COPC_LEVEL))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+				{
+					filter.copcMaxLevel = cmd.arguments().takeFirst().toInt(&ok);
+				}
+				if (!ok || filter.copcMaxLevel < 0)
+				{
+					return cmd.error(QObject::tr("Missing or invalid parameter: level expected after '%1'").arg(OPTION_LAS_FILTER_COPC_LEVEL));
+				}
+				cmd.print(QObject::tr("LAS filter: COPC levels up to %1").arg(filter.copcMaxLevel));
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		if (!filter.isActive())
+		{
+			cmd.print(QObject::tr("LAS filter: none"));
+		}
+		LasIOFilter::SetLoadFilter(filter);
+
+		return true;
+	}
+};
+
+void LasPlugin::registerCommands(ccCommandLineInterface* cmd)
+{
+	if (cmd)
+	{
+		cmd->registerCommand(ccCommandLineInterface::Command::Shared(new LasLoadFilterCommand));
+	}
+}
@@ -213,56 +213,70 @@ CC_FILE_ERROR LasSaver::saveNextPoint()
 	}
 	laszip_CHAR* errorMsg{nullptr};
 
-	// reset point
-	laszip_I32 num_extra_bytes         = m_laszipPoint->num_extra_bytes;
-	laszip_U8* extra_bytes             = m_laszipPoint->extra_bytes;
-	*m_laszipPoint                     = {};
-	m_laszipPoint->extra_bytes         = extra_bytes;
-	m_laszipPoint->num_extra_bytes     = num_extra_bytes;
-	m_laszipPoint->extended_point_type = m_laszipHeader.point_data_format >= 6;
-
-	const CCVector3* point       = m_cloudToSave.getPoint(m_currentPointIndex);
-	const CCVector3d globalPoint = m_cloudToSave.toGlobal3d<PointCoordinateType>(*point);
+	CC_FILE_ERROR error = fillPoint(m_laszipWriter, m_laszipPoint, m_currentPointIndex);
+	if (error != CC_FERR_NO_ERROR)
+	{
+		return error;
+	}
 
-	if (laszip_set_coordinates(m_laszipWriter, globalPoint.u))
+	if (laszip_write_point(m_laszipWriter))
 	{
 		laszip_get_error(m_laszipWriter, &errorMsg);
 		ccLog::Warning("[LAS] laszip error :'%s'", errorMsg);
 		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
 	}
 
-	m_fieldsSaver.handleScalarFields(m_currentPointIndex, *m_laszipPoint);
-	m_fieldsSaver.handleExtraFields(m_currentPointIndex, *m_laszipPoint);
-
-	if (m_waveformSaver)
+	if (laszip_update_inventory(m_laszipWriter))
 	{
-		m_waveformSaver->handlePoint(m_currentPointIndex, *m_laszipPoint);
+		laszip_get_error(m_laszipWriter, &errorMsg);
+		ccLog::Warning("[LAS] laszip error :'%s'", errorMsg);
+		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
 	}
 
-	if (m_shouldSaveRGB)
-	{
-		assert(LasDetails::HasRGB(m_laszipHeader.point_data_format) && m_cloudToSave.hasColors());
-		const ccColor::Rgba& color = m_cloudToSave.getPointColor(m_currentPointIndex);
-		m_laszipPoint->rgb[0]      = static_cast<laszip_U16>(color.r) << 8;
-		m_laszipPoint->rgb[1]      = static_cast<laszip_U16>(color.g) << 8;
-		m_laszipPoint->rgb[2]      = static_cast<laszip_U16>(color.b) << 8;
-	}
+	++m_currentPointIndex;
 
-	if (laszip_write_point(m_laszipWriter))
+	return CC_FERR_NO_ERROR;
+}
+
+CC_FILE_ERROR LasSaver::fillPoint(laszip_POINTER laszipWriter, laszip_point* laszipPoint, unsigned pointIndex)
+{
+	assert(laszipWriter && laszipPoint && pointIndex < m_cloudToSave.size());
+	laszip_CHAR* errorMsg{nullptr};
+
+	// reset point
+	laszip_I32 num_extra_bytes       = laszipPoint->num_extra_bytes;
+	laszip_U8* extra_bytes           = laszipPoint->extra_bytes;
+	*laszipPoint                     = {};
+	laszipPoint->extra_bytes         = extra_bytes;
+	laszipPoint->num_extra_bytes     = num_extra_bytes;
+	laszipPoint->extended_point_type = m_laszipHeader.point_data_format >= 6;
+
+	const CCVector3* point       = m_cloudToSave.getPoint(pointIndex);
+	const CCVector3d globalPoint = m_cloudToSave.toGlobal3d<PointCoordinateType>(*point);
+
+	if (laszip_set_coordinates(laszipWriter, globalPoint.u))
 	{
-		laszip_get_error(m_laszipWriter, &errorMsg);
+		laszip_get_error(laszipWriter, &errorMsg);
 		ccLog::Warning("[LAS] laszip error :'%s'", errorMsg);
 		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
 	}
 
-	if (laszip_update_inventory(m_laszipWriter))
+	m_fieldsSaver.handleScalarFields(pointIndex, *laszipPoint);
+	m_fieldsSaver.handleExtraFields(pointIndex, *laszipPoint);
+
+	if (m_waveformSaver)
 	{
-		laszip_get_error(m_laszipWriter, &errorMsg);
-		ccLog::Warning("[LAS] laszip error :'%s'", errorMsg);
-		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		m_waveformSaver->handlePoint(pointIndex, *laszipPoint);
 	}
 
-	++m_currentPointIndex;
+	if (m_shouldSaveRGB)
+	{
+		assert(LasDetails::HasRGB(m_laszipHeader.point_data_format) && m_cloudToSave.hasColors());
+		const ccColor::Rgba& color = m_cloudToSave.getPointColor(pointIndex);
+		laszipPoint->rgb[0]        = static_cast<laszip_U16>(color.r) << 8;
+		laszipPoint->rgb[1]        = static_cast<laszip_U16>(color.g) << 8;
+		laszipPoint->rgb[2]        = static_cast<laszip_U16>(color.b) << 8;
+	}
 
 	return CC_FERR_NO_ERROR;
 }
@@ -34,6 +34,27 @@ LasScalarFieldLoader::LasScalarFieldLoader(std::vector<LasScalarField>&      sta
 
 CC_FILE_ERROR LasScalarFieldLoader::handleScalarFields(ccPointCloud&       pointCloud,
                                                        const laszip_point& currentPoint)
+{
+	return visitScalarFieldValues(currentPoint,
+	                              [&](LasScalarField& lasScalarField, auto currentValue)
+	                              {
+		                              return handleScalarField(lasScalarField, pointCloud, currentValue);
+	                              });
+}
+
+void LasScalarFieldLoader::setScalarFieldValues(unsigned pointIndex, const laszip_point& currentPoint)
+{
+	visitScalarFieldValues(currentPoint,
+	                       [pointIndex](LasScalarField& lasScalarField, auto currentValue)
+	                       {
+		                       assert(lasScalarField.sf && pointIndex < lasScalarField.sf->size());
+		                       lasScalarField.sf->setValue(pointIndex, static_cast<ScalarType>(currentValue));
+		                       return CC_FERR_NO_ERROR;
+	                       });
+}
+
+template <typename Func>
+CC_FILE_ERROR LasScalarFieldLoader::visitScalarFieldValues(const laszip_point& currentPoint, Func func)
 {
 	CC_FILE_ERROR error = CC_FERR_NO_ERROR;
 	for (LasScalarField& lasScalarField : m_standardFields)
@@ -41,19 +62,19 @@ CC_FILE_ERROR LasScalarFieldLoader::handleScalarFields(ccPointCloud&       point
 		switch (lasScalarField.id)
 		{
 		case LasScalarField::Intensity:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.intensity);
+			error = func(lasScalarField, currentPoint.intensity);
 			break;
 		case LasScalarField::ReturnNumber:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.return_number);
+			error = func(lasScalarField, currentPoint.return_number);
 			break;
 		case LasScalarField::NumberOfReturns:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.number_of_returns);
+			error = func(lasScalarField, currentPoint.number_of_returns);
 			break;
 		case LasScalarField::ScanDirectionFlag:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.scan_direction_flag);
+			error = func(lasScalarField, currentPoint.scan_direction_flag);
 			break;
 		case LasScalarField::EdgeOfFlightLine:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.edge_of_flight_line);
+			error = func(lasScalarField, currentPoint.edge_of_flight_line);
 			break;
 		case LasScalarField::Classification:
 		{
@@ -64,52 +85,50 @@ CC_FILE_ERROR LasScalarFieldLoader::handleScalarFields(ccPointCloud&       point
 				classification |= (currentPoint.keypoint_flag << 6);
 				classification |= (currentPoint.withheld_flag << 7);
 			}
-			error = handleScalarField(lasScalarField, pointCloud, classification);
+			error = func(lasScalarField, classification);
 			break;
 		}
 		case LasScalarField::SyntheticFlag:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.synthetic_flag);
+			error = func(lasScalarField, currentPoint.synthetic_flag);
 			break;
 		case LasScalarField::KeypointFlag:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.keypoint_flag);
+			error = func(lasScalarField, currentPoint.keypoint_flag);
 			break;
 		case LasScalarField::WithheldFlag:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.withheld_flag);
+			error = func(lasScalarField, currentPoint.withheld_flag);
 			break;
 		case LasScalarField::ScanAngleRank:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.scan_angle_rank);
+			error = func(lasScalarField, currentPoint.scan_angle_rank);
 			break;
 		case LasScalarField::UserData:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.user_data);
+			error = func(lasScalarField, currentPoint.user_data);
 			break;
 		case LasScalarField::PointSourceId:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.point_source_ID);
+			error = func(lasScalarField, currentPoint.point_source_ID);
 			break;
 		case LasScalarField::GpsTime:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.gps_time);
+			error = func(lasScalarField, currentPoint.gps_time);
 			break;
 		case LasScalarField::ExtendedScanAngle:
-			error = handleScalarField(
-			    lasScalarField, pointCloud, currentPoint.extended_scan_angle * SCAN_ANGLE_SCALE);
+			error = func(lasScalarField, currentPoint.extended_scan_angle * SCAN_ANGLE_SCALE);
 			break;
 		case LasScalarField::ExtendedScannerChannel:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.extended_scanner_channel);
+			error = func(lasScalarField, currentPoint.extended_scanner_channel);
 			break;
 		case LasScalarField::OverlapFlag:
-			error =
-			    handleScalarField(lasScalarField, pointCloud, currentPoint.extended_classification_flags & LasDetails::OVERLAP_FLAG_BIT_MASK);
+			error = func(lasScalarField, currentPoint.extended_classification_flags & LasDetails::OVERLAP_FLAG_BIT_MASK);
 			break;
 		case LasScalarField::ExtendedClassification:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.extended_classification);
+			error = func(lasScalarField, currentPoint.extended_classification);
 			break;
 		case LasScalarField::ExtendedReturnNumber:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.extended_return_number);
+			error = func(lasScalarField, currentPoint.extended_return_number);
 			break;
 		case LasScalarField::ExtendedNumberOfReturns:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.extended_number_of_returns);
+			error = func(lasScalarField, currentPoint.extended_number_of_returns);
 			break;
 		case LasScalarField::NearInfrared:
-			error = handleScalarField(lasScalarField, pointCloud, currentPoint.rgb[3]);
+			error = func(lasScalarField, currentPoint.rgb[3]);
 			break;
 		}
 
@@ -160,8 +179,7 @@ CC_FILE_ERROR LasScalarFieldLoader::handleRGBValue(ccPointCloud& pointCloud, con
 {
 	if (!pointCloud.hasColors())
 	{
-		uint16_t currentOredRGB = currentPoint.rgb[0] | currentPoint.rgb[1] | currentPoint.rgb[2];
-		if (m_ignoreFieldsWithDefaultValues && currentOredRGB == 0)
+		if (!createsColors(currentPoint))
 		{
 			// nothing to do
 			return CC_FERR_NO_ERROR;
@@ -172,11 +190,7 @@ CC_FILE_ERROR LasScalarFieldLoader::handleRGBValue(ccPointCloud& pointCloud, con
 			return CC_FERR_NOT_ENOUGH_MEMORY;
 		}
 
-		if (!m_force8bitRgbMode && currentOredRGB > 255)
-		{
-			// LAS colors use 16bits (as they should)
-			m_colorCompShift = 8;
-		}
+		m_colorCompShift = colorCompShiftFor(currentPoint);
 
 		if (pointCloud.size() != 0)
 		{
@@ -226,6 +240,139 @@ CC_FILE_ERROR LasScalarFieldLoader::handleExtraScalarFields(const laszip_point&
 	return CC_FERR_NO_ERROR;
 }
 
+bool LasScalarFieldLoader::createsColors(const laszip_point& currentPoint) const
+{
+	uint16_t currentOredRGB = currentPoint.rgb[0] | currentPoint.rgb[1] | currentPoint.rgb[2];
+	return !m_ignoreFieldsWithDefaultValues || currentOredRGB != 0;
+}
+
+unsigned char LasScalarFieldLoader::colorCompShiftFor(const laszip_point& currentPoint) const
+{
+	uint16_t currentOredRGB = currentPoint.rgb[0] | currentPoint.rgb[1] | currentPoint.rgb[2];
+	if (!m_force8bitRgbMode && currentOredRGB > 255)
+	{
+		// LAS colors use 16bits (as they should)
+		return 8;
+	}
+	return 0;
+}
+
+bool LasScalarFieldLoader::resizeScalarFields(unsigned pointCount)
+{
+	for (LasScalarField& lasScalarField : m_standardFields)
+	{
+		if (!lasScalarField.sf)
+		{
+			lasScalarField.sf = new ccScalarField(lasScalarField.name());
+		}
+		if (!lasScalarField.sf->resizeSafe(pointCount, true, 0))
+		{
+			return false;
+		}
+	}
+
+	for (LasExtraScalarField& extraField : m_extraScalarFields)
+	{
+		for (unsigned dimIndex = 0; dimIndex < extraField.numElements(); ++dimIndex)
+		{
+			if (extraField.scalarFields[dimIndex] && !extraField.scalarFields[dimIndex]->resizeSafe(pointCount, true, 0))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+CC_FILE_ERROR LasScalarFieldLoader::setExtraScalarFieldValues(unsigned pointIndex, const laszip_point& currentPoint)
+{
+	if (currentPoint.num_extra_bytes <= 0 || currentPoint.extra_bytes == nullptr)
+	{
+		return CC_FERR_NO_ERROR;
+	}
+
+	for (const LasExtraScalarField& extraField : m_extraScalarFields)
+	{
+		ScalarType finalValues[3]{0};
+
+		const CC_FILE_ERROR err = parseExtraScalarField(extraField, currentPoint, finalValues);
+		if (err != CC_FERR_NO_ERROR)
+		{
+			return err;
+		}
+
+		for (unsigned dimIndex = 0; dimIndex < extraField.numElements(); ++dimIndex)
+		{
+			if (extraField.scalarFields[dimIndex])
+			{
+				extraField.scalarFields[dimIndex]->setValue(pointIndex, finalValues[dimIndex]);
+			}
+		}
+	}
+	return CC_FERR_NO_ERROR;
+}
+
+void LasScalarFieldLoader::moveScalarFieldValues(unsigned sourceIndex, unsigned destIndex)
+{
+	for (const LasScalarField& lasScalarField : m_standardFields)
+	{
+		if (lasScalarField.sf)
+		{
+			lasScalarField.sf->setValue(destIndex, lasScalarField.sf->getValue(sourceIndex));
+		}
+	}
+
+	for (const LasExtraScalarField& extraField : m_extraScalarFields)
+	{
+		for (unsigned dimIndex = 0; dimIndex < extraField.numElements(); ++dimIndex)
+		{
+			if (extraField.scalarFields[dimIndex])
+			{
+				extraField.scalarFields[dimIndex]->setValue(destIndex, extraField.scalarFields[dimIndex]->getValue(sourceIndex));
+			}
+		}
+	}
+}
+
+bool LasScalarFieldLoader::finalizeScalarFields(unsigned pointCount)
+{
+	for (LasScalarField& lasScalarField : m_standardFields)
+	{
+		if (!lasScalarField.sf)
+		{
+			continue;
+		}
+		if (!lasScalarField.sf->resizeSafe(pointCount))
+		{
+			return false;
+		}
+
+		if (m_ignoreFieldsWithDefaultValues)
+		{
+			// same result as handleScalarField, which only creates the scalar field
+			// once it encounters a value that is not the default one
+			lasScalarField.sf->computeMinAndMax();
+			if (lasScalarField.sf->getMin() == 0 && lasScalarField.sf->getMax() == 0)
+			{
+				lasScalarField.sf->release();
+				lasScalarField.sf = nullptr;
+			}
+		}
+	}
+
+	for (LasExtraScalarField& extraField : m_extraScalarFields)
+	{
+		for (unsigned dimIndex = 0; dimIndex < extraField.numElements(); ++dimIndex)
+		{
+			if (extraField.scalarFields[dimIndex] && !extraField.scalarFields[dimIndex]->resizeSafe(pointCount))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
 template <typename T>
 CC_FILE_ERROR
 LasScalarFieldLoader::handleScalarField(LasScalarField& sfInfo, ccPointCloud& pointCloud, T currentValue)
@@ -16,189 +16,593 @@
 //##########################################################################
 
 #include "LasTiler.h"
+#include "LasDetails.h"
 
 #include <QElapsedTimer>
 #include <QFileInfo>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
 #include <ccProgressDialog.h>
 
-CC_FILE_ERROR TileLasReader(laszip_POINTER laszipReader, const QString& originName, const LasTilingOptions& options)
+#include <algorithm>
+#include <cstring>
+
+/// Number of points read to estimate the number of points of the tiles
+static const uint64_t s_sampleCount = 65536;
+/// Maximum number of runs of consecutive points read to estimate the number of points of the tiles
+static const uint64_t s_maxSampleRuns = 1024;
+/// Maximum depth of the quadtree of a grid cell
+static const unsigned s_maxDepth = 12;
+/// Number of points decoded by a task if the file isn't compressed (the default size of a LAZ chunk)
+static const uint64_t s_defaultTaskPointCount = 50000;
+/// Number of points of a batch sent to the writers
+static const size_t s_batchSize = 4096;
+/// Maximum number of batches waiting for a writer (limits the memory used if the writers are slower)
+static const int s_maxPendingBatches = 256;
+/// Number of points between two updates of the progress
+static const unsigned s_progressStep = 4096;
+
+static unsigned CellIndex(double value, double min, double cellSize, unsigned cellCount)
 {
-	laszip_header* laszipHeader{nullptr};
-	laszip_CHAR*   errorMsg{nullptr};
-
-	if (laszip_get_header_pointer(laszipReader, &laszipHeader))
+	if (cellSize <= 0.0 || value <= min)
 	{
-		laszip_get_error(laszipHeader, &errorMsg);
-		ccLog::Warning("[LAS] laszip error: '%s'", errorMsg);
-		laszip_close_reader(laszipReader);
-		laszip_clean(laszipReader);
-		laszip_destroy(laszipReader);
-		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		return 0;
 	}
+	auto index = static_cast<uint64_t>((value - min) / cellSize);
+	return static_cast<unsigned>(std::min(index, static_cast<uint64_t>(cellCount - 1)));
+}
 
-	laszip_U64 pointCount;
-	if (laszipHeader->version_minor == 4)
+LasTiler::LasTiler(const QString& fileName, const laszip_header& laszipHeader, const LasTilingOptions& options)
+    : m_fileName(fileName)
+    , m_laszipHeader(laszipHeader)
+    , m_options(options)
+    , m_tileHeader(laszipHeader)
+    , m_mins{laszipHeader.min_x, laszipHeader.min_y, laszipHeader.min_z}
+    , m_pendingBatches(s_maxPendingBatches)
+{
+	m_options.numTiles0 = std::max(m_options.numTiles0, 1u);
+	m_options.numTiles1 = std::max(m_options.numTiles1, 1u);
+
+	const double cloudBBox[3] = {
+	    laszipHeader.max_x - laszipHeader.min_x,
+	    laszipHeader.max_y - laszipHeader.min_y,
+	    laszipHeader.max_z - laszipHeader.min_z,
+	};
+	m_cellSize[0] = cloudBBox[m_options.index0()] / m_options.numTiles0;
+	m_cellSize[1] = cloudBBox[m_options.index1()] / m_options.numTiles1;
+
+	// the tiles are plain LAS/LAZ files: the COPC VLR and the EVLRs (COPC hierarchy, etc.) are not copied
+	unsigned removedVlrsSize = 0;
+	for (laszip_U32 i = 0; i < laszipHeader.number_of_variable_length_records; ++i)
 	{
-		pointCount = laszipHeader->extended_number_of_point_records;
+		const laszip_vlr_struct& vlr = laszipHeader.vlrs[i];
+		if (strncmp(vlr.user_id, "copc", LasDetails::EvlrHeader::USER_ID_SIZE) == 0)
+		{
+			removedVlrsSize += LasDetails::SizeOfVlrs(&vlr, 1);
+		}
+		else
+		{
+			m_tileVlrs.push_back(vlr);
+		}
 	}
-	else
+	m_tileHeader.number_of_variable_length_records              = static_cast<laszip_U32>(m_tileVlrs.size());
+	m_tileHeader.vlrs                                           = m_tileVlrs.empty() ? nullptr : m_tileVlrs.data();
+	m_tileHeader.offset_to_point_data                           = laszipHeader.offset_to_point_data - removedVlrsSize;
+	m_tileHeader.start_of_first_extended_variable_length_record = 0;
+	m_tileHeader.number_of_extended_variable_length_records     = 0;
+
+	m_compress = (QFileInfo(fileName).suffix().compare("laz", Qt::CaseInsensitive) == 0);
+
+	m_writerPool.setMaxThreadCount(std::max(QThread::idealThreadCount(), 1));
+}
+
+LasTiler::~LasTiler()
+{
+	m_writerPool.waitForDone();
+
+	for (const std::unique_ptr<Tile>& tile : m_tiles)
 	{
-		pointCount = laszipHeader->number_of_point_records;
+		if (tile->writer)
+		{
+			laszip_close_writer(tile->writer);
+			laszip_clean(tile->writer);
+			laszip_destroy(tile->writer);
+		}
 	}
+}
 
-	laszip_point* laszipPoint{nullptr};
-	if (laszip_get_point_pointer(laszipReader, &laszipPoint))
+CC_FILE_ERROR LasTiler::buildTiles(laszip_POINTER laszipReader, uint64_t pointCount)
+{
+	const size_t index0    = m_options.index0();
+	const size_t index1    = m_options.index1();
+	const double maxs[3]   = {m_laszipHeader.max_x, m_laszipHeader.max_y, m_laszipHeader.max_z};
+	const size_t cellCount = static_cast<size_t>(m_options.numTiles0) * m_options.numTiles1;
+
+	m_nodes.clear();
+	m_nodes.resize(cellCount);
+	for (unsigned i = 0; i < m_options.numTiles0; ++i)
 	{
-		laszip_get_error(laszipHeader, &errorMsg);
-		ccLog::Warning("[LAS] laszip error: '%s'", errorMsg);
-		laszip_close_reader(laszipReader);
-		laszip_clean(laszipReader);
-		laszip_destroy(laszipReader);
-		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		for (unsigned j = 0; j < m_options.numTiles1; ++j)
+		{
+			Node& node  = m_nodes[(static_cast<size_t>(i) * m_options.numTiles1) + j];
+			node.min[0] = m_mins[index0] + i * m_cellSize[0];
+			node.min[1] = m_mins[index1] + j * m_cellSize[1];
+			node.max[0] = (i + 1 == m_options.numTiles0 ? maxs[index0] : node.min[0] + m_cellSize[0]);
+			node.max[1] = (j + 1 == m_options.numTiles1 ? maxs[index1] : node.min[1] + m_cellSize[1]);
+			node.name   = QString("%1_%2").arg(i).arg(j);
+		}
 	}
 
-	ccLog::Print(QString("Tiles: %1 x %2").arg(options.numTiles0).arg(options.numTiles1));
+	if (m_options.maxPointsPerTile != 0 && pointCount > m_options.maxPointsPerTile)
+	{
+		std::vector<Sample> samples;
+		CC_FILE_ERROR       error = samplePoints(laszipReader, pointCount, samples);
+		if (error != CC_FERR_NO_ERROR)
+		{
+			return error;
+		}
+
+		if (!samples.empty())
+		{
+			// each sample stands for the same number of points
+			const double pointsPerSample = static_cast<double>(pointCount) / samples.size();
 
-	std::vector<laszip_POINTER> writers;
-	writers.resize(static_cast<size_t>(options.numTiles0) * options.numTiles1, nullptr);
+			std::vector<std::vector<Sample>> cellSamples(cellCount);
+			for (const Sample& sample : samples)
+			{
+				cellSamples[gridCellOf(sample.u, sample.v)].push_back(sample);
+			}
+			samples.clear();
+			samples.shrink_to_fit();
 
-	CC_FILE_ERROR error = CC_FERR_NO_ERROR;
+			for (size_t i = 0; i < cellCount; ++i)
+			{
+				split(static_cast<int>(i), std::move(cellSamples[i]), pointsPerSample, 0);
+			}
+		}
+	}
 
-	const size_t index0 = options.index0();
-	const size_t index1 = options.index1();
+	// the leaves are the tiles
+	const QFileInfo originInfo(m_fileName);
+	m_tiles.clear();
+	for (Node& node : m_nodes)
+	{
+		if (node.firstChild >= 0)
+		{
+			continue;
+		}
 
-	double cloudMins[3] = {
-	    laszipHeader->min_x,
-	    laszipHeader->min_y,
-	    laszipHeader->min_z,
-	};
+		auto tile = std::make_unique<Tile>();
+		if (!m_options.outputDir.isEmpty())
+		{
+			tile->fileName = m_options.outputDir + '/';
+		}
+		tile->fileName += QString("%1_%2.%3").arg(originInfo.baseName(), node.name, originInfo.suffix());
 
-	double cloudBBox[3] = {
-	    laszipHeader->max_x - laszipHeader->min_x,
-	    laszipHeader->max_y - laszipHeader->min_y,
-	    laszipHeader->max_z - laszipHeader->min_z,
-	};
+		node.tile = static_cast<int>(m_tiles.size());
+		m_tiles.push_back(std::move(tile));
+	}
 
-	double tileSize[2] = {
-	    cloudBBox[index0] / options.numTiles0,
-	    cloudBBox[index1] / options.numTiles1,
-	};
+	return CC_FERR_NO_ERROR;
+}
 
-	laszip_F64 laszipCoordinates[3] = {0};
+CC_FILE_ERROR LasTiler::samplePoints(laszip_POINTER laszipReader, uint64_t pointCount, std::vector<Sample>& samples)
+{
+	laszip_CHAR* errorMsg{nullptr};
 
-	QElapsedTimer timer;
-	timer.start();
+	// runs of consecutive points are read at the start of the LAZ chunks,
+	// so that a seek doesn't imply to decompress the previous points of the chunk
+	const uint32_t chunkSize  = LasDetails::ReadLazChunkSize(m_fileName);
+	const uint64_t chunkCount = (chunkSize != 0 ? (pointCount + chunkSize - 1) / chunkSize : pointCount);
+	const uint64_t runCount   = std::min(chunkCount, s_maxSampleRuns);
+	const uint64_t runLength  = std::max<uint64_t>(s_sampleCount / runCount, 1);
 
-	QFileInfo originInfo(originName);
+	samples.reserve(runCount * runLength);
 
-	ccProgressDialog progressDialog(true);
-	progressDialog.setMethodTitle("Tiling LAS file");
-	progressDialog.setInfo("Tiling...");
-	CCCoreLib::NormalizedProgress normProgress(&progressDialog, pointCount);
-	progressDialog.start();
+	const size_t index0 = m_options.index0();
+	const size_t index1 = m_options.index1();
+	laszip_F64   laszipCoordinates[3]{0};
 
-	for (unsigned i = 0; i < pointCount; ++i)
+	for (uint64_t r = 0; r < runCount; ++r)
 	{
-		if (laszip_read_point(laszipReader))
+		uint64_t runStart = (r * chunkCount) / runCount;
+		if (chunkSize != 0)
 		{
-			laszip_get_error(laszipReader, &errorMsg);
-			ccLog::Warning("[LAS] laszip error :'%s'", errorMsg);
-			error = CC_FERR_THIRD_PARTY_LIB_FAILURE;
-			break;
+			runStart *= chunkSize;
 		}
+		const uint64_t runEnd = std::min(runStart + runLength, pointCount);
 
-		if (laszip_get_coordinates(laszipReader, laszipCoordinates))
+		// see LasIOFilter::loadFile regarding the limitations of laszip_seek_point
+		if (laszip_seek_point(laszipReader, static_cast<int64_t>(runStart)))
 		{
 			laszip_get_error(laszipReader, &errorMsg);
 			ccLog::Warning("[LAS] laszip error :'%s'", errorMsg);
-			error = CC_FERR_THIRD_PARTY_LIB_FAILURE;
-			break;
+			return CC_FERR_THIRD_PARTY_LIB_FAILURE;
 		}
 
-		auto tileI = static_cast<size_t>((laszipCoordinates[index0] - cloudMins[index0]) / tileSize[0]);
-		tileI      = std::min(tileI, static_cast<size_t>(options.numTiles0 - 1));
-		auto tileJ = static_cast<size_t>((laszipCoordinates[index1] - cloudMins[index1]) / tileSize[1]);
-		tileJ      = std::min(tileJ, static_cast<size_t>(options.numTiles1 - 1));
+		for (uint64_t i = runStart; i < runEnd; ++i)
+		{
+			if (laszip_read_point(laszipReader) || laszip_get_coordinates(laszipReader, laszipCoordinates))
+			{
+				laszip_get_error(laszipReader, &errorMsg);
+				ccLog::Warning("[LAS] laszip error :'%s'", errorMsg);
+				return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+			}
+			samples.push_back({laszipCoordinates[index0], laszipCoordinates[index1]});
+		}
+	}
 
-		const size_t tileIndex = (tileI * options.numTiles1) + tileJ;
+	return CC_FERR_NO_ERROR;
+}
 
-		laszip_POINTER& writer = writers[tileIndex];
+void LasTiler::split(int nodeIndex, std::vector<Sample> samples, double pointsPerSample, unsigned depth)
+{
+	if (depth >= s_maxDepth || samples.size() * pointsPerSample <= m_options.maxPointsPerTile)
+	{
+		return;
+	}
 
-		if (writer == nullptr)
-		{
-			QString outputName;
+	// the references to the nodes are invalidated by the creation of the children
+	const Node   parent = m_nodes[nodeIndex];
+	const double mid[2] = {
+	    (parent.min[0] + parent.max[0]) / 2,
+	    (parent.min[1] + parent.max[1]) / 2,
+	};
 
-			if (!options.outputDir.isEmpty())
-			{
-				outputName += options.outputDir;
-				outputName += '/';
-			}
+	const int firstChild          = static_cast<int>(m_nodes.size());
+	m_nodes[nodeIndex].firstChild = firstChild;
+	m_nodes.resize(m_nodes.size() + 4);
 
-			const QString fileName = QString("%1_%2_%3.%4").arg(originInfo.baseName(), QString::number(tileI), QString::number(tileJ), originInfo.suffix());
-			outputName += fileName;
-			const std::string outputNameStd = outputName.toStdString();
+	// the bit 0 of the quadrant is set for the upper half in the first dimension, the bit 1 for the second one
+	for (int q = 0; q < 4; ++q)
+	{
+		Node& child  = m_nodes[firstChild + q];
+		child.min[0] = (q & 1) ? mid[0] : parent.min[0];
+		child.max[0] = (q & 1) ? parent.max[0] : mid[0];
+		child.min[1] = (q & 2) ? mid[1] : parent.min[1];
+		child.max[1] = (q & 2) ? parent.max[1] : mid[1];
+		child.name   = QString("%1_%2").arg(parent.name).arg(q);
+	}
 
-			if (laszip_create(&writer))
-			{
-				ccLog::Warning("[LAS] Failed to create tile writer");
-				error = CC_FERR_THIRD_PARTY_LIB_FAILURE;
-				break;
-			}
+	std::vector<Sample> childSamples[4];
+	for (const Sample& sample : samples)
+	{
+		const int q = (sample.u >= mid[0] ? 1 : 0) | (sample.v >= mid[1] ? 2 : 0);
+		childSamples[q].push_back(sample);
+	}
+	samples.clear();
+	samples.shrink_to_fit();
 
-			if (laszip_set_header(writer, laszipHeader))
-			{
-				laszip_get_error(writer, &errorMsg);
-				ccLog::Warning("[LAS] laszip error :'%s'", errorMsg);
-				error = CC_FERR_THIRD_PARTY_LIB_FAILURE;
-				break;
-			}
+	for (int q = 0; q < 4; ++q)
+	{
+		split(firstChild + q, std::move(childSamples[q]), pointsPerSample, depth + 1);
+	}
+}
 
-			if (laszip_open_writer(writer, outputNameStd.c_str(), false))
-			{
-				laszip_get_error(writer, &errorMsg);
-				ccLog::Warning("[LAS] laszip error :'%s'", errorMsg);
-				error = CC_FERR_THIRD_PARTY_LIB_FAILURE;
-				break;
-			}
+int LasTiler::gridCellOf(double u, double v) const
+{
+	const unsigned i = CellIndex(u, m_mins[m_options.index0()], m_cellSize[0], m_options.numTiles0);
+	const unsigned j = CellIndex(v, m_mins[m_options.index1()], m_cellSize[1], m_options.numTiles1);
+	return static_cast<int>((static_cast<size_t>(i) * m_options.numTiles1) + j);
+}
+
+void LasTiler::tilesOf(double u, double v, std::vector<int>& tiles) const
+{
+	tiles.clear();
+
+	int nodeIndex = gridCellOf(u, v);
+	while (m_nodes[nodeIndex].firstChild >= 0)
+	{
+		const Node& node = m_nodes[nodeIndex];
+		const int   q    = (u >= (node.min[0] + node.max[0]) / 2 ? 1 : 0) | (v >= (node.min[1] + node.max[1]) / 2 ? 2 : 0);
+		nodeIndex        = node.firstChild + q;
+	}
+	tiles.push_back(m_nodes[nodeIndex].tile);
+
+	if (m_options.haloSize <= 0.0)
+	{
+		return;
+	}
+
+	// the grid cells whose buffer may contain the position
+	const double   halo = m_options.haloSize;
+	const double   min0 = m_mins[m_options.index0()];
+	const double   min1 = m_mins[m_options.index1()];
+	const unsigned i0   = CellIndex(u - halo, min0, m_cellSize[0], m_options.numTiles0);
+	const unsigned i1   = CellIndex(u + halo, min0, m_cellSize[0], m_options.numTiles0);
+	const unsigned j0   = CellIndex(v - halo, min1, m_cellSize[1], m_options.numTiles1);
+	const unsigned j1   = CellIndex(v + halo, min1, m_cellSize[1], m_options.numTiles1);
+	for (unsigned i = i0; i <= i1; ++i)
+	{
+		for (unsigned j = j0; j <= j1; ++j)
+		{
+			addHaloTiles(static_cast<int>((static_cast<size_t>(i) * m_options.numTiles1) + j), u, v, tiles);
 		}
+	}
+}
 
-		if (laszip_set_point(writer, laszipPoint))
+void LasTiler::addHaloTiles(int nodeIndex, double u, double v, std::vector<int>& tiles) const
+{
+	const Node&  node = m_nodes[nodeIndex];
+	const double halo = m_options.haloSize;
+	if (u < node.min[0] - halo || u > node.max[0] + halo || v < node.min[1] - halo || v > node.max[1] + halo)
+	{
+		return;
+	}
+
+	if (node.firstChild < 0)
+	{
+		if (node.tile != tiles.front())
 		{
-			laszip_get_error(writer, &errorMsg);
-			ccLog::Warning("[LAS] laszip error :'%s'", errorMsg);
-			error = CC_FERR_THIRD_PARTY_LIB_FAILURE;
-			break;
+			tiles.push_back(node.tile);
 		}
+		return;
+	}
 
-		if (laszip_write_point(writer))
+	for (int q = 0; q < 4; ++q)
+	{
+		addHaloTiles(node.firstChild + q, u, v, tiles);
+	}
+}
+
+CC_FILE_ERROR LasTiler::tile(uint64_t pointCount, CCCoreLib::NormalizedProgress* progress)
+{
+	m_nextTask = 0;
+	m_error    = CC_FERR_NO_ERROR;
+
+	// the tasks start at the beginning of a chunk, so that
+	// a seek doesn't imply to decompress the previous points of the chunk
+	const uint32_t chunkSize      = LasDetails::ReadLazChunkSize(m_fileName);
+	const uint64_t taskPointCount = (chunkSize != 0 ? chunkSize : s_defaultTaskPointCount);
+	const uint64_t taskCount      = (pointCount + taskPointCount - 1) / taskPointCount;
+	if (taskCount == 0)
+	{
+		return CC_FERR_NO_ERROR;
+	}
+
+	const size_t     index0      = m_options.index0();
+	const size_t     index1      = m_options.index1();
+	int              threadCount = static_cast<int>(std::min<uint64_t>(QThread::idealThreadCount(), taskCount));
+	std::vector<int> threads(std::max(threadCount, 1));
+	QtConcurrent::blockingMap(threads,
+	                          [&](int&)
+	                          {
+		                          laszip_POINTER reader{nullptr};
+		                          laszip_BOOL    isCompressed{false};
+		                          laszip_point*  laszipPoint{nullptr};
+		                          if (laszip_create(&reader))
+		                          {
+			                          setError(CC_FERR_THIRD_PARTY_LIB_FAILURE);
+			                          return;
+		                          }
+		                          if (laszip_open_reader(reader, qPrintable(m_fileName), &isCompressed)
+		                              || laszip_get_point_pointer(reader, &laszipPoint))
+		                          {
+			                          setLaszipError(reader);
+			                          laszip_clean(reader);
+			                          laszip_destroy(reader);
+			                          return;
+		                          }
+
+		                          // the points of each tile are gathered in batches, which are all sent at the
+		                          // end of a task (so that a thread doesn't keep more than a task in memory)
+		                          std::vector<std::shared_ptr<Batch>> batches(m_tiles.size());
+		                          std::vector<int>                    tiles;
+		                          laszip_F64                          laszipCoordinates[3]{0};
+		                          unsigned                            progressSteps = 0;
+
+		                          for (size_t t = m_nextTask++; t < taskCount && m_error == CC_FERR_NO_ERROR; t = m_nextTask++)
+		                          {
+			                          const uint64_t taskStart = t * taskPointCount;
+			                          const uint64_t taskEnd   = std::min(taskStart + taskPointCount, pointCount);
+
+			                          // see LasIOFilter::loadFile regarding the limitations of laszip_seek_point
+			                          if (laszip_seek_point(reader, static_cast<int64_t>(taskStart)))
+			                          {
+				                          setLaszipError(reader);
+				                          break;
+			                          }
+
+			                          for (uint64_t i = taskStart; i < taskEnd; ++i)
+			                          {
+				                          if (laszip_read_point(reader) || laszip_get_coordinates(reader, laszipCoordinates))
+				                          {
+					                          setLaszipError(reader);
+					                          break;
+				                          }
+
+				                          tilesOf(laszipCoordinates[index0], laszipCoordinates[index1], tiles);
+				                          for (int tileIndex : tiles)
+				                          {
+					                          std::shared_ptr<Batch>& batch = batches[tileIndex];
+					                          if (!batch)
+					                          {
+						                          batch = std::make_shared<Batch>();
+					                          }
+					                          batch->points.push_back(*laszipPoint);
+					                          if (laszipPoint->num_extra_bytes != 0)
+					                          {
+						                          batch->extraBytes.insert(batch->extraBytes.end(), laszipPoint->extra_bytes, laszipPoint->extra_bytes + laszipPoint->num_extra_bytes);
+					                          }
+					                          if (batch->points.size() == s_batchSize)
+					                          {
+						                          submit(tileIndex, std::move(batch));
+					                          }
+				                          }
+
+				                          if (++progressSteps == s_progressStep)
+				                          {
+					                          progressSteps = 0;
+					                          if (progress && !progress->steps(s_progressStep))
+					                          {
+						                          setError(CC_FERR_CANCELED_BY_USER);
+						                          break;
+					                          }
+				                          }
+			                          }
+
+			                          for (size_t tileIndex = 0; tileIndex < batches.size(); ++tileIndex)
+			                          {
+				                          if (batches[tileIndex])
+				                          {
+					                          submit(static_cast<int>(tileIndex), std::move(batches[tileIndex]));
+				                          }
+			                          }
+		                          }
+
+		                          laszip_close_reader(reader);
+		                          laszip_clean(reader);
+		                          laszip_destroy(reader);
+	                          });
+
+	m_writerPool.waitForDone();
+
+	for (const std::unique_ptr<Tile>& tile : m_tiles)
+	{
+		if (tile->writer == nullptr)
 		{
-			laszip_get_error(writer, &errorMsg);
-			ccLog::Warning("[LAS] laszip error :'%s'", errorMsg);
-			error = CC_FERR_THIRD_PARTY_LIB_FAILURE;
-			break;
+			continue;
 		}
 
-		if (laszip_update_inventory(writer))
+		if (laszip_close_writer(tile->writer))
 		{
-			laszip_get_error(writer, &errorMsg);
-			ccLog::Warning("[LAS] laszip error :'%s'", errorMsg);
-			error = CC_FERR_THIRD_PARTY_LIB_FAILURE;
-			break;
+			setLaszipError(tile->writer);
 		}
+		laszip_clean(tile->writer);
+		laszip_destroy(tile->writer);
+		tile->writer = nullptr;
+	}
 
-		normProgress.oneStep();
+	return static_cast<CC_FILE_ERROR>(m_error.load());
+}
+
+void LasTiler::submit(int tileIndex, std::shared_ptr<Batch> batch)
+{
+	m_pendingBatches.acquire();
+	QtConcurrent::run(&m_writerPool,
+	                  [this, tileIndex, batch]()
+	                  {
+		                  writeBatch(tileIndex, *batch);
+		                  m_pendingBatches.release();
+	                  });
+}
+
+void LasTiler::writeBatch(int tileIndex, const Batch& batch)
+{
+	if (m_error != CC_FERR_NO_ERROR)
+	{
+		return;
 	}
 
-	for (laszip_POINTER writer : writers)
+	Tile&        tile = *m_tiles[tileIndex];
+	QMutexLocker locker(&tile.mutex);
+
+	if (tile.writer == nullptr)
 	{
-		if (writer == nullptr)
+		if (laszip_create(&tile.writer))
 		{
-			continue;
+			tile.writer = nullptr;
+			setError(CC_FERR_THIRD_PARTY_LIB_FAILURE);
+			return;
+		}
+
+		if (laszip_set_header(tile.writer, &m_tileHeader) || laszip_open_writer(tile.writer, qPrintable(tile.fileName), m_compress))
+		{
+			setLaszipError(tile.writer);
+			laszip_clean(tile.writer);
+			laszip_destroy(tile.writer);
+			tile.writer = nullptr;
+			return;
+		}
+	}
+
+	for (size_t i = 0; i < batch.points.size(); ++i)
+	{
+		laszip_point point = batch.points[i];
+		if (point.num_extra_bytes != 0)
+		{
+			// the extra bytes of the points of the batch are contiguous
+			point.extra_bytes = const_cast<laszip_U8*>(batch.extraBytes.data()) + (i * point.num_extra_bytes);
+		}
+
+		if (laszip_set_point(tile.writer, &point) || laszip_write_point(tile.writer) || laszip_update_inventory(tile.writer))
+		{
+			setLaszipError(tile.writer);
+			return;
 		}
+	}
+}
+
+void LasTiler::setLaszipError(laszip_POINTER laszipPointer)
+{
+	setError(CC_FERR_THIRD_PARTY_LIB_FAILURE);
+
+	laszip_CHAR* errorMsg{nullptr};
+	laszip_get_error(laszipPointer, &errorMsg);
+
+	QMutexLocker locker(&m_errorMutex);
+	if (m_errorMessage.isEmpty() && errorMsg)
+	{
+		m_errorMessage = QString(errorMsg);
+	}
+}
+
+void LasTiler::setError(CC_FILE_ERROR error)
+{
+	int noError = CC_FERR_NO_ERROR;
+	m_error.compare_exchange_strong(noError, error);
+}
 
-		laszip_close_writer(writer);
-		laszip_clean(writer);
-		laszip_destroy(writer);
+CC_FILE_ERROR TileLasReader(laszip_POINTER laszipReader, const QString& originName, const LasTilingOptions& options)
+{
+	laszip_header* laszipHeader{nullptr};
+	laszip_CHAR*   errorMsg{nullptr};
+
+	if (laszip_get_header_pointer(laszipReader, &laszipHeader))
+	{
+		laszip_get_error(laszipHeader, &errorMsg);
+		ccLog::Warning("[LAS] laszip error: '%s'", errorMsg);
+		laszip_close_reader(laszipReader);
+		laszip_clean(laszipReader);
+		laszip_destroy(laszipReader);
+		return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+	}
+
+	laszip_U64 pointCount;
+	if (laszipHeader->version_minor == 4)
+	{
+		pointCount = laszipHeader->extended_number_of_point_records;
+	}
+	else
+	{
+		pointCount = laszipHeader->number_of_point_records;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	CC_FILE_ERROR error = CC_FERR_NO_ERROR;
+	{
+		LasTiler tiler(originName, *laszipHeader, options);
+		error = tiler.buildTiles(laszipReader, pointCount);
+
+		if (error == CC_FERR_NO_ERROR)
+		{
+			ccLog::Print(QString("[LAS] Tiles: %1 x %2 (%3 tiles)").arg(options.numTiles0).arg(options.numTiles1).arg(tiler.tileCount()));
+
+			ccProgressDialog progressDialog(true);
+			progressDialog.setMethodTitle("Tiling LAS file");
+			progressDialog.setInfo("Tiling...");
+			CCCoreLib::NormalizedProgress normProgress(&progressDialog, pointCount);
+			progressDialog.start();
+
+			error = tiler.tile(pointCount, &normProgress);
+			if (error == CC_FERR_THIRD_PARTY_LIB_FAILURE && !tiler.errorMessage().isEmpty())
+			{
+				ccLog::Warning("[LAS] laszip error :'%s'", qPrintable(tiler.errorMessage()));
+			}
+		}
 	}
 
 	laszip_close_reader(laszipReader);
@@ -207,7 +611,6 @@ CC_FILE_ERROR TileLasReader(laszip_POINTER laszipReader, const QString& originNa
 
 	if (error == CC_FERR_NO_ERROR)
 	{
-		timer.elapsed();
 		qint64 elapsed_ms = timer.elapsed();
 		qint64 minutes    = elapsed_ms / (1000 * 60);
 		elapsed_ms -= minutes * (1000 * 60);
@@ -0,0 +1,229 @@
+//##########################################################################
+//#                                                                        #
+//#                CLOUDCOMPARE PLUGIN: LAS-IO Plugin                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                   COPYRIGHT: Thomas Montaigu                           #
+//#                                                                        #
+//##########################################################################
+
+#include "TestCopcSaver.h"
+
+#include "CopcLoader.h"
+#include "CopcVlrs.h"
+#include "LasDetails.h"
+#include "LasIOFilter.h"
+
+// qCC_db
+#include <ccPointCloud.h>
+
+// Qt
+#include <QFile>
+#include <QTemporaryDir>
+
+// Laszip
+#include <laszip/laszip_api.h>
+
+// System
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+static constexpr unsigned POINT_COUNT = 20000;
+
+namespace
+{
+	/// COPC file written in a temporary directory
+	struct CopcFile
+	{
+		QTemporaryDir dir;
+		QString       path;
+	};
+
+	/// Saves a random cloud (several octree levels) as a COPC file
+	bool SaveCopcFile(CopcFile& file)
+	{
+		if (!file.dir.isValid())
+		{
+			return false;
+		}
+		file.path = file.dir.filePath("test.copc.laz");
+
+		ccPointCloud cloud("test");
+		if (!cloud.reserve(POINT_COUNT))
+		{
+			return false;
+		}
+		std::mt19937                          generator(1);
+		std::uniform_real_distribution<float> distribution(0.0f, 100.0f);
+		for (unsigned i = 0; i < POINT_COUNT; ++i)
+		{
+			cloud.addPoint(CCVector3(distribution(generator), distribution(generator), distribution(generator) / 10));
+		}
+
+		LasIOFilter                  filter;
+		FileIOFilter::SaveParameters parameters;
+		parameters.alwaysDisplaySaveDialog = false;
+		parameters.parentWidget            = nullptr;
+		return filter.saveToFile(&cloud, file.path, parameters) == CC_FERR_NO_ERROR;
+	}
+
+	/// Laszip reader of a file (only its header is read)
+	class HeaderReader
+	{
+	  public:
+		explicit HeaderReader(const QString& path)
+		{
+			laszip_BOOL isCompressed{false};
+			if (laszip_create(&m_reader))
+			{
+				m_reader = nullptr;
+				return;
+			}
+			if (laszip_open_reader(m_reader, qPrintable(path), &isCompressed) || laszip_get_header_pointer(m_reader, &m_header))
+			{
+				m_header = nullptr;
+			}
+		}
+
+		~HeaderReader()
+		{
+			if (m_reader)
+			{
+				laszip_close_reader(m_reader);
+				laszip_clean(m_reader);
+				laszip_destroy(m_reader);
+			}
+		}
+
+		const laszip_header* header() const
+		{
+			return m_header;
+		}
+
+	  private:
+		laszip_POINTER m_reader{nullptr};
+		laszip_header* m_header{nullptr};
+	};
+
+	/// Reads the COPC info from the first VLR
+	copc::Info ReadInfo(const laszip_header& header)
+	{
+		copc::Info  info;
+		QByteArray  data(reinterpret_cast<const char*>(header.vlrs[0].data), header.vlrs[0].record_length_after_header);
+		QDataStream stream(data);
+		stream >> info;
+		return info;
+	}
+} // namespace
+
+void TestCopcSaver::testPointCount() const
+{
+	CopcFile file;
+	QVERIFY(SaveCopcFile(file));
+
+	ccHObject                    container;
+	FileIOFilter::LoadParameters parameters;
+	CCVector3d                   shift(0, 0, 0);
+	bool                         shiftEnabled = false;
+	parameters.alwaysDisplayLoadDialog        = false;
+	parameters.shiftHandlingMode              = ccGlobalShiftManager::Mode::NO_DIALOG;
+	parameters._coordinatesShiftEnabled       = &shiftEnabled;
+	parameters._coordinatesShift              = &shift;
+
+	LasIOFilter filter;
+	QCOMPARE(filter.loadFile(file.path, container, parameters), CC_FERR_NO_ERROR);
+	QCOMPARE(container.getChildrenNumber(), 1u);
+	QVERIFY(container.getChild(0)->isA(CC_TYPES::POINT_CLOUD));
+	QCOMPARE(static_cast<ccPointCloud*>(container.getChild(0))->size(), POINT_COUNT);
+
+	// the hierarchy is valid (otherwise the file is read as a regular LAZ file)
+	HeaderReader reader(file.path);
+	QVERIFY(reader.header());
+	copc::CopcLoader loader(reader.header(), file.path);
+	QVERIFY(loader.isValid());
+}
+
+void TestCopcSaver::testInfoVlr() const
+{
+	CopcFile file;
+	QVERIFY(SaveCopcFile(file));
+
+	HeaderReader reader(file.path);
+	const laszip_header* header = reader.header();
+	QVERIFY(header);
+	QCOMPARE(header->version_minor, static_cast<laszip_U8>(4));
+	QVERIFY(header->number_of_variable_length_records > 0);
+
+	const laszip_vlr_struct& vlr = header->vlrs[0];
+	QCOMPARE(strncmp(vlr.user_id, "copc", LasDetails::EvlrHeader::USER_ID_SIZE), 0);
+	QCOMPARE(vlr.record_id, static_cast<laszip_U16>(1));
+	QCOMPARE(static_cast<size_t>(vlr.record_length_after_header), static_cast<size_t>(copc::Info::SIZE));
+
+	// the root hierarchy page is the payload of the only EVLR
+	const copc::Info info = ReadInfo(*header);
+	QCOMPARE(header->number_of_extended_variable_length_records, static_cast<laszip_U32>(1));
+	QCOMPARE(info.root_hier_offset, static_cast<uint64_t>(header->start_of_first_extended_variable_length_record + LasDetails::EvlrHeader::SIZE));
+	QVERIFY(info.halfsize > 0);
+	QVERIFY(info.spacing > 0);
+}
+
+void TestCopcSaver::testHierarchy() const
+{
+	CopcFile file;
+	QVERIFY(SaveCopcFile(file));
+
+	HeaderReader reader(file.path);
+	const laszip_header* header = reader.header();
+	QVERIFY(header);
+	const copc::Info info       = ReadInfo(*header);
+	const uint64_t   evlrOffset = static_cast<uint64_t>(header->start_of_first_extended_variable_length_record);
+
+	QFile input(file.path);
+	QVERIFY(input.open(QFile::ReadOnly));
+	QVERIFY(input.seek(evlrOffset));
+	QDataStream stream(&input);
+
+	LasDetails::EvlrHeader evlrHeader;
+	stream >> evlrHeader;
+	QVERIFY(evlrHeader.isCOPCEntry());
+	QCOMPARE(evlrHeader.recordLength, info.root_hier_size);
+	QCOMPARE(evlrHeader.recordLength % copc::Entry::SIZE, static_cast<uint64_t>(0));
+	QCOMPARE(static_cast<uint64_t>(input.pos()), info.root_hier_offset);
+
+	std::vector<copc::Entry> entries(evlrHeader.recordLength / copc::Entry::SIZE);
+	for (copc::Entry& entry : entries)
+	{
+		stream >> entry;
+	}
+	QCOMPARE(stream.status(), QDataStream::Ok);
+	QVERIFY(std::any_of(entries.begin(), entries.end(), [](const copc::Entry& entry)
+	                    { return entry.key == copc::VoxelKey::Root(); }));
+
+	// the chunks lie between the point data offset and the EVLR (the chunk table being in between), without overlapping
+	std::sort(entries.begin(), entries.end(), [](const copc::Entry& a, const copc::Entry& b)
+	          { return a.offset < b.offset; });
+	uint64_t pointCount = 0;
+	uint64_t chunkEnd   = static_cast<uint64_t>(header->offset_to_point_data);
+	for (const copc::Entry& entry : entries)
+	{
+		QVERIFY(!entry.isHierarchyPage());
+		QVERIFY(entry.point_count >= 0);
+		QVERIFY(entry.byte_size > 0);
+		QVERIFY(entry.offset >= chunkEnd);
+		chunkEnd = entry.offset + entry.byte_size;
+		pointCount += entry.point_count;
+	}
+	QVERIFY(chunkEnd <= evlrOffset);
+	QCOMPARE(pointCount, static_cast<uint64_t>(POINT_COUNT));
+}
+
+QTEST_MAIN(TestCopcSaver)
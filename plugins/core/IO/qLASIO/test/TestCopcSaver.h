@@ -0,0 +1,35 @@
+#pragma once
+
+//##########################################################################
+//#                                                                        #
+//#                CLOUDCOMPARE PLUGIN: LAS-IO Plugin                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                   COPYRIGHT: Thomas Montaigu                           #
+//#                                                                        #
+//##########################################################################
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+/// Saves a small cloud as a COPC file and reads it back
+class TestCopcSaver : public QObject
+{
+	Q_OBJECT
+
+  private Q_SLOTS:
+	/// Checks the number of points read back by the LAS filter
+	void testPointCount() const;
+	/// Checks that the COPC info VLR is the first VLR and that it points to the hierarchy EVLR
+	void testInfoVlr() const;
+	/// Checks the offsets and sizes of the hierarchy entries
+	void testHierarchy() const;
+};
@@ -0,0 +1,83 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_BENCHMARK_HEADER
+#define Q_RFC_BENCHMARK_HEADER
+
+#include "SyntheticCloud.h"
+
+//Qt
+#include <QStringList>
+
+//system
+#include <string>
+#include <vector>
+
+//! Throughput benchmark of the classification pipeline on synthetic clouds
+/** For each cloud size, a synthetic labelled cloud is generated, then trained on and classified with
+	each thread count. The wall times of the pipeline steps are taken from the profiling reports of the
+	training and the classification:
+	- conversion: reading the labels of the cloud
+	- features: computing the features of all the points (classification)
+	- training: sampling the core points, training and saving the forest
+	- classification: loading the forest, inference and labelling (without the features)
+	The scaling efficiency of a step is its speedup with respect to the smallest thread count, divided
+	by the ratio of the thread counts (1 for a perfect scaling).
+**/
+class Benchmark
+{
+public:
+	//! Benchmark settings
+	struct Settings
+	{
+		std::vector<std::size_t> sizes = { 100000, 1000000 }; //!< number of points of each cloud
+		std::vector<int> threads; //!< thread counts (1 and the ideal thread count if empty)
+		SyntheticCloud::Layout layout;
+		int nscales = 5;
+		double min_scale = -1.0; //!< automatically estimated if <= 0
+		bool octree_neighborhoods = false; //!< requires min_scale
+		int num_trees = 25;
+		int max_depth = 20;
+		int max_core_points = 0; //!< all the points are used for training if <= 0
+		unsigned seed = 0;
+	};
+
+	//! Measure of a pipeline step
+	struct Result
+	{
+		std::size_t points = 0;
+		int threads = 0;
+		std::string step;
+		double wallTime = 0; //!< (s)
+		double cpuTime = 0; //!< (s, all threads)
+		double pointsPerSecond = 0;
+		double efficiency = 0; //!< scaling efficiency (1 with the smallest thread count)
+		float accuracy = 0; //!< ratio of correctly classified points (same for all the steps of a run)
+	};
+
+	//! Runs the benchmark
+	/** \return false on error (see errorMessage)
+	**/
+	bool run(const Settings& settings, std::vector<Result>& results, QString& errorMessage);
+
+	//! Returns a human readable report
+	static QStringList Report(const std::vector<Result>& results);
+	//! Saves the results as a CSV file (one step per line)
+	static bool SaveCSV(const QString& filename, const std::vector<Result>& results, QString& errorMessage);
+};
+
+#endif //Q_RFC_BENCHMARK_HEADER
@@ -0,0 +1,98 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_CLASSIFICATION_OUTPUT_HEADER
+#define Q_RFC_CLASSIFICATION_OUTPUT_HEADER
+
+//Qt
+#include <QString>
+
+//system
+#include <string>
+#include <utility>
+#include <vector>
+
+class ccPointCloud;
+class ccScalarField;
+
+//! Classification output (labels, class probabilities and exported features) stored in scalar fields
+/** The scalar fields are allocated for all the points of the cloud before the classification, then filled
+	in place by the classifier (in parallel, without intermediate containers). They are only added to the
+	cloud by attach(), so that the classification can run in a background thread. The fields that are not
+	attached are released with the output.
+**/
+class ClassificationOutput
+{
+public:
+	//! Default constructor
+	ClassificationOutput();
+	//! Destructor (releases the fields that are not attached)
+	~ClassificationOutput();
+
+	ClassificationOutput(const ClassificationOutput&) = delete;
+	ClassificationOutput& operator=(const ClassificationOutput&) = delete;
+
+	//! Allocates the label field (-1 for the unclassified points)
+	/** \param classNames names of the classes (in the order of the labels)
+		\param probabilities whether the per-class probability fields and the confidence field (highest probability) are allocated
+	**/
+	bool init(unsigned pointCount, const std::vector<std::string>& classNames, bool probabilities, QString& errorMessage);
+	//! Releases all the fields (that are not attached)
+	void clear();
+
+	//! Returns whether the fields are allocated
+	bool isValid() const { return m_labels != nullptr; }
+	//! Returns the number of points
+	unsigned size() const { return m_pointCount; }
+	//! Returns the class names
+	const std::vector<std::string>& classNames() const { return m_classNames; }
+
+	//! Returns the label field
+	ccScalarField* labels() const { return m_labels; }
+	//! Returns whether the class probabilities are exported
+	bool hasProbabilities() const { return !m_probabilities.empty(); }
+	//! Returns the probability field of a class
+	ccScalarField* probability(std::size_t classIndex) const { return m_probabilities[classIndex]; }
+	//! Returns the confidence field (highest class probability)
+	ccScalarField* confidence() const { return m_confidence; }
+
+	//! Returns the field of an exported feature, allocated on the first call (NaN for the points without value)
+	/** Not thread-safe. Returns nullptr if there is not enough memory.
+	**/
+	ccScalarField* feature(const std::string& name);
+	//! Returns the fields of the exported features (in the order they were allocated)
+	const std::vector<std::pair<std::string, ccScalarField*>>& features() const { return m_features; }
+
+	//! Adds the fields to a cloud (with a unique name)
+	/** The output is empty afterwards.
+		\return the index of the label field in the cloud, or -1 on error (see errorMessage)
+	**/
+	int attach(ccPointCloud* cloud, QString& errorMessage);
+
+protected:
+	//! Allocates a field (nullptr if not enough memory)
+	ccScalarField* allocate(const std::string& name, float value) const;
+
+	unsigned m_pointCount;
+	std::vector<std::string> m_classNames;
+	ccScalarField* m_labels;
+	std::vector<ccScalarField*> m_probabilities;
+	ccScalarField* m_confidence;
+	std::vector<std::pair<std::string, ccScalarField*>> m_features;
+};
+
+#endif //Q_RFC_CLASSIFICATION_OUTPUT_HEADER
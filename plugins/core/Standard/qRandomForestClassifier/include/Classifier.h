@@ -18,7 +18,10 @@
 #ifndef Q_RFC_CGAL_CLASSIFIER_HEADER
 #define Q_RFC_CGAL_CLASSIFIER_HEADER
 
+#include "ClassificationOutput.h"
+#include "CloudView.h"
 #include "qRFCEvaluationDialog.h"
+#include "StageProfiler.h"
 
 //qCC_plugins
 #include <ccMainAppInterface.h>
@@ -28,35 +31,24 @@
 #include <ccScalarField.h>
 #include <CCTypes.h>
 
-// CGAL
-#if defined (_MSC_VER) && !defined (_WIN64)
-#pragma warning(disable:4244) // boost::number_distance::distance()
-// converts 64 to 32 bits integers
-#endif
+//system
+#include <memory>
 
-#include <CGAL/Simple_cartesian.h>
-#include <CGAL/Classification.h>
-#include <CGAL/Point_set_3.h>
-#include <CGAL/Point_set_3/IO.h>
-#include <CGAL/Real_timer.h>
+class FeatureCache;
+class ModelBundle;
+class FlatForest;
+class PrunedFeatureGenerator;
 
-typedef CGAL::Simple_cartesian<ScalarType> Kernel;
-typedef Kernel::Point_3 Point;
-typedef CGAL::Point_set_3<Point> Point_set;
-typedef Kernel::Iso_cuboid_3 Iso_cuboid_3;
-
-typedef Point_set::Point_map Pmap;
-typedef Point_set::Vector_map Vmap;
-typedef Point_set::Property_map<int> Imap;
-typedef Point_set::Property_map<float> Fmap;
-typedef Point_set::Property_map<CGAL::IO::Color> Cmap;
+//! Features a trained classifier actually uses (so that only these ones are generated)
+struct Feature_pruning
+{
+	std::vector<bool> used; //!< whether each feature is used by the classifier (in the classifier feature order, all if empty)
+	std::vector<std::string> names; //!< names of the features (in the classifier feature order)
+	std::unique_ptr<PrunedFeatureGenerator> generator;
 
-namespace Classification = CGAL::Classification;
-typedef Classification::Label_handle                                            Label_handle;
-typedef Classification::Feature_handle                                          Feature_handle;
-typedef Classification::Label_set                                               Label_set;
-typedef Classification::Feature_set                                             Feature_set;
-typedef Classification::Point_set_feature_generator<Kernel, Point_set, Pmap>    Feature_generator;
+	Feature_pruning();
+	~Feature_pruning();
+};
 
 // Options for regularizing the classifier
 namespace Regularization {
@@ -205,23 +197,62 @@ public:
 		std::vector<int> classes_list;
 		int nscales;
 		double min_scale;
+		bool octree_neighborhoods; //!< the neighborhoods of the scales are searched with an octree (requires min_scale, saved with the classifier)
 		bool evaluate_params;
-		int max_core_points;
+		int max_core_points; //!< max number of labelled points used for training (all if <= 0)
+		bool balance_classes; //!< whether the core points are shared equally between the classes
+		double sampling_voxel_size; //!< at most one core point per voxel and class (disabled if <= 0)
+		unsigned seed; //!< seed of the core points sampling
 		size_t num_trees;
 		size_t max_depth;
 		std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*>> features;
 		std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*>> eval_features;
+		QString output_path; //!< classifier output file (the user is asked for one if empty)
+		QString feature_cache_dir; //!< feature cache directory (no cache if empty)
+		int parallel_clouds; //!< max number of clouds whose features are computed at the same time (multi-cloud training)
+		int cv_folds; //!< number of cross-validation folds (disabled if < 2)
+		double cv_block_size; //!< size of the spatial blocks of the folds (deduced from the scales if <= 0)
+		std::vector<size_t> grid_num_trees; //!< numbers of trees to evaluate (num_trees only if empty)
+		std::vector<size_t> grid_max_depth; //!< max depths to evaluate (max_depth only if empty)
+		std::vector<int> grid_max_core_points; //!< max numbers of core points to evaluate (max_core_points only if empty)
+		QString cv_report_path; //!< cross-validation report file (CSV, optional)
+		QString profile_path; //!< profiling report file (JSON, optional)
+		QString base_classifier_path; //!< classifier whose trees are kept, the new trees being appended (warm start, optional)
+		size_t max_trees; //!< warm start: the least accurate trees on the new labels are removed beyond this number of trees (no limit if 0)
 
 		TrainParams() :
 			classes_list({ 0, 1 }),
 			nscales(5),
 			min_scale(-1),
+			octree_neighborhoods(false),
 			evaluate_params(false),
 			max_core_points(0),
+			balance_classes(false),
+			sampling_voxel_size(0),
+			seed(0),
 			num_trees(25),
 			max_depth(20),
 			features(),
-			eval_features() { }
+			eval_features(),
+			output_path(),
+			feature_cache_dir(),
+			parallel_clouds(1),
+			cv_folds(0),
+			cv_block_size(0),
+			grid_num_trees(),
+			grid_max_depth(),
+			grid_max_core_points(),
+			cv_report_path(),
+			profile_path(),
+			base_classifier_path(),
+			max_trees(0) { }
+	};
+	//! Labelled cloud (multi-cloud training)
+	struct TrainingCloud
+	{
+		ccPointCloud* cloud;
+		ccScalarField* labels;
+		std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*>> features; //!< same sources for all the clouds
 	};
 	//! Classify parameters
 	struct ClassifyParams
@@ -230,33 +261,168 @@ public:
 		int nscales;
 		double min_scale;
 		bool export_features;
+		bool export_probabilities; //!< the class probabilities of the forest and the confidence (highest probability) are exported
 		Regularization::Method reg_type;
 		std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> > eval_features;
 		CCCoreLib::ScalarField* labels;
+		double tile_size; //!< size of the (XY) tiles, tiled classification is disabled if <= 0
+		double tile_halo; //!< overlap around each tile, deduced from the largest scale if <= 0
+		double subsampling_distance; //!< only a spatially subsampled cloud is classified if > 0 (the labels are then transferred)
+		int transfer_neighbors; //!< number of neighbors of the label transfer majority vote (1: nearest neighbor)
+		int reg_neighbors; //!< number of neighbors of each point used by the regularization
+		float graphcut_strength; //!< strength of the graph cut regularization
+		int graphcut_subdivisions; //!< number of subdivisions of the graph cut (deduced from the memory budget if <= 0)
+		double graphcut_memory_budget; //!< memory budget of the graph cut in MB (one subdivision per thread if <= 0)
+		QString feature_cache_dir; //!< feature cache directory (no cache if empty)
+		QString profile_path; //!< profiling report file (JSON, optional)
 
 		ClassifyParams() :
 			classes_list({ 0, 1 }),
 			nscales(5),
 			min_scale(-1),
 			export_features(false),
+			export_probabilities(false),
 			reg_type(Regularization::Method::NONE),
 			eval_features(),
-			labels(nullptr) { }
+			labels(nullptr),
+			tile_size(0),
+			tile_halo(0),
+			subsampling_distance(0),
+			transfer_neighbors(1),
+			reg_neighbors(12),
+			graphcut_strength(0.2f),
+			graphcut_subdivisions(0),
+			graphcut_memory_budget(0),
+			feature_cache_dir(),
+			profile_path() { }
 	};
 	//! Trains classifier given two point clouds representing class #1 and class #2 (feature collection phase)
 	QString train(ccPointCloud* cloud1, ccPointCloud* cloud2, std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> > features1, std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> > features2, const TrainParams& params = TrainParams());
 	//! Trains classifier with multiple classes provided in a scalar field (feature collection phase)
 	QString train(ccPointCloud* cloud, ccScalarField* scalarField, const TrainParams& params = TrainParams());
+	//! Trains classifier with several clouds, each with a scalar field of labels (feature collection phase)
+	/** The features of each cloud are computed independently, and only the ones of its core points are kept
+		(the core points are selected on each cloud with the sampling parameters, then once more on all the clouds).
+		The first cloud sets the min. scale if it is not set.
+	**/
+	QString train(const std::vector<TrainingCloud>& clouds, const TrainParams& params = TrainParams());
+	//! Updates an existing classifier with new labels (warm start, feature collection phase)
+	/** The scales, classes and features of the classifier (params.base_classifier_path) are used. The features are only
+		computed around the labelled points (e.g. a few corrected ones), then params.num_trees trees are trained on them and
+		appended to the forest (the least accurate trees on the new labels are removed beyond params.max_trees trees).
+	**/
+	QString update(ccPointCloud* cloud, ccScalarField* scalarField, const TrainParams& params);
 	//! Trains classifier (generic phase)
-	QString train(Point_set pts, Feature_set& features, const TrainParams& params = TrainParams(), ccProgressDialog* progressDlg = nullptr, CCCoreLib::NormalizedProgress* nProgress = nullptr);
+	/** \param input range of point indices the features were computed on
+		\param labels ground truth label of each point (-1 for unlabelled points), may be modified by subsampling
+		\param view cloud(s) the features were computed on (only required by the spatial subsampling)
+	**/
+	QString train(const Index_range& input, std::vector<int>& labels, Feature_set& features, const TrainParams& params = TrainParams(), CCCoreLib::GenericProgressCallback* progressCb = nullptr, CCCoreLib::NormalizedProgress* nProgress = nullptr, const Cloud_view* view = nullptr);
 	//! Performs classification on input point cloud given a trained classifier configuration file
-	std::pair<std::vector<int>, std::map<std::string, std::vector<float>>> classify(ccPointCloud* cloud1, QString classifierFilePath, const ClassifyParams& params = ClassifyParams());
+	/** The labels (and the probabilities and features, if exported) are written in the scalar fields of the output,
+		which are not added to the cloud (see ClassificationOutput::attach).
+		\return false on error or if the classification was canceled (the output is then empty)
+	**/
+	bool classify(ccPointCloud* cloud1, QString classifierFilePath, ClassificationOutput& output, const ClassifyParams& params = ClassifyParams());
 	//! Extracts human readable information from trained classifier configuration file
 	QStringList readETHZRandomForestClassifierData(QString classifierFilePath);
 
+	//! Sets the progress callback (e.g. to run in a background thread)
+	/** If set, it is used instead of the progress dialogs, and no dialog is opened at all (the output
+		path of the trained classifier must be set and the evaluation report is only stored).
+		The console messages are stored as well (see flushConsoleMessages).
+	**/
+	void setProgressCallback(CCCoreLib::GenericProgressCallback* progressCb) { m_progressCallback = progressCb; }
+	//! Displays the console messages stored while running with a progress callback (must be called by the GUI thread)
+	void flushConsoleMessages();
+	//! Returns the evaluation report of the last classification (HTML, only if labels were provided)
+	const std::string& evaluationReport() const { return m_evaluationReport; }
+	//! Returns the profile of the last training or classification
+	const StageProfiler& profiler() const { return m_profiler; }
+
 protected:
+	//! Console messages (to be displayed later by the main thread)
+	typedef std::vector<std::pair<QString, ccMainAppInterface::ConsoleMessageLevel>> ConsoleMessages;
+
+	//! Displays a message in the console (or stores it if messages is set, or if a progress callback is set)
+	void dispToConsole(const QString& message, ccMainAppInterface::ConsoleMessageLevel level = ccMainAppInterface::STD_CONSOLE_MESSAGE, ConsoleMessages* messages = nullptr);
+	//! Disables the octree neighborhoods if they can't be used for training (they require a min. scale and a single cloud)
+	void checkOctreeNeighborhoods(TrainParams& params, bool twoClouds);
+
+	//! Computes the selected features on the given cloud(s) (feature collection phase)
+	/** features2 is only used (and must have the same layout as features1) if the view contains a second cloud.
+		If a cache directory is set, the generated features are read from (or saved to) the feature cache.
+		The feature generator is only instantiated if some features actually have to be generated.
+		\param minScale voxel size of the first scale (automatically estimated if <= 0), updated with the one actually used
+		\param pruning if set (and if the features are not cached), only the point based features used by the classifier are generated
+		\param octreeNeighborhoods the point based features are computed with octree neighborhoods (requires pruning, a known
+			minScale and a single cloud; the cache is not used)
+		\param messages if set, the console messages are stored instead of being displayed (worker threads)
+	**/
+	bool generateFeatures(	const Cloud_view& view,
+							const Index_range& input,
+							int nscales,
+							double& minScale,
+							const QString& cacheDir,
+							const std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> >& features1,
+							const std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> >& features2,
+							std::unique_ptr<Feature_generator>& generator,
+							std::unique_ptr<FeatureCache>& cache,
+							Feature_set& features,
+							Feature_pruning* pruning = nullptr,
+							bool octreeNeighborhoods = false,
+							ConsoleMessages* messages = nullptr);
+
+	//! Feature values of the core points of a cloud (multi-cloud training)
+	struct TrainingRows
+	{
+		std::vector<std::string> names; //!< feature names
+		std::vector<std::vector<float>> columns; //!< feature values (one column per feature)
+		std::vector<int> labels; //!< label of each row
+		ConsoleMessages messages; //!< console messages (the rows are collected by worker threads)
+	};
+
+	//! Computes the features of the core points of a labelled cloud (multi-cloud training)
+	/** It may run in a worker thread: the console messages are stored in the rows.
+		\param index index of the cloud (the seed of the core points sampling depends on it)
+	**/
+	bool collectTrainingRows(const TrainingCloud& cloud, std::size_t index, const TrainParams& params, double& minScale, TrainingRows& rows);
+
+	//! Classifies the points of a view (whole cloud or tile)
+	/** Only the first coreCount points of the view are output (the others are only used as neighborhood).
+		Labels and exported features are written at the index of each point in its cloud.
+		If the model has a feature schema, the computed features must match it.
+		\param usedFeatures whether each feature of the model is used by the forest (all features are generated if empty)
+		\param flatForest compiled forest (the ETHZ classifier is used instead if not set)
+	**/
+	bool classifyView(	const Cloud_view& view,
+						std::size_t coreCount,
+						const ModelBundle& model,
+						const std::vector<bool>& usedFeatures,
+						const FlatForest* flatForest,
+						Label_set& labels,
+						const ClassifyParams& params,
+						ClassificationOutput& output,
+						CCCoreLib::GenericProgressCallback* progressCb = nullptr,
+						CCCoreLib::NormalizedProgress* nProgress = nullptr);
+
+	//! Starts the progress notification (with the progress callback or a new progress dialog)
+	CCCoreLib::GenericProgressCallback* startProgress(const char* info, const char* iconPath);
+	//! Returns whether the user canceled the process (through the progress callback)
+	bool isCanceled() const;
+	//! Outputs the profiling report (console, and file if set)
+	void reportProfile(const QString& operation, const QString& filename);
+
 	//! Main application interface
 	ccMainAppInterface* m_app;
+	//! Progress callback (optional)
+	CCCoreLib::GenericProgressCallback* m_progressCallback;
+	//! Console messages stored by a background run (see flushConsoleMessages)
+	ConsoleMessages m_consoleMessages;
+	//! Evaluation report of the last classification
+	std::string m_evaluationReport;
+	//! Profile of the last training or classification
+	StageProfiler m_profiler;
 };
 
 
@@ -0,0 +1,162 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_CLOUD_VIEW_HEADER
+#define Q_RFC_CLOUD_VIEW_HEADER
+
+//qCC_db
+#include <ccPointCloud.h>
+#include <CCTypes.h>
+
+// CGAL
+#if defined (_MSC_VER) && !defined (_WIN64)
+#pragma warning(disable:4244) // boost::number_distance::distance()
+// converts 64 to 32 bits integers
+#endif
+
+#include <CGAL/Simple_cartesian.h>
+#include <CGAL/Classification.h>
+#include <CGAL/Real_timer.h>
+
+// Boost
+#include <boost/range/irange.hpp>
+
+typedef CGAL::Simple_cartesian<PointCoordinateType> Kernel;
+typedef Kernel::Point_3 Point;
+typedef Kernel::Vector_3 Vector;
+typedef Kernel::Iso_cuboid_3 Iso_cuboid_3;
+
+//! Range of point indices used as input range by the CGAL classification package
+typedef boost::integer_range<std::size_t> Index_range;
+
+//! One or two point clouds seen as a single range of point indices (without copying their data)
+/** The points of the second cloud (if any) are indexed after the ones of the first cloud.
+	Alternatively, a subset of the first cloud can be viewed (e.g. a tile) through a list of point indices.
+**/
+struct Cloud_view
+{
+	Cloud_view(ccPointCloud* c1 = nullptr, ccPointCloud* c2 = nullptr)
+		: cloud1(c1)
+		, cloud2(c2)
+		, split(c1 ? c1->size() : 0)
+		, subset(nullptr) { }
+
+	Cloud_view(ccPointCloud* c1, const std::vector<unsigned>* indices)
+		: cloud1(c1)
+		, cloud2(nullptr)
+		, split(indices->size())
+		, subset(indices) { }
+
+	ccPointCloud* cloud1;
+	ccPointCloud* cloud2;
+	std::size_t split;
+	const std::vector<unsigned>* subset;
+
+	std::size_t size() const { return split + (cloud2 ? cloud2->size() : 0); }
+	Index_range range() const { return boost::irange<std::size_t>(0, size()); }
+	//! Returns the index of a point in its own cloud
+	inline unsigned localIndex(std::size_t i) const {
+		return subset ? (*subset)[i] : static_cast<unsigned>(i < split ? i : i - split);
+	}
+	inline ccPointCloud* cloudOf(std::size_t i) const { return (i < split) ? cloud1 : cloud2; }
+
+	inline const CCVector3* point(std::size_t i) const { return cloudOf(i)->getPoint(localIndex(i)); }
+	inline const ccColor::Rgba& color(std::size_t i) const { return cloudOf(i)->getPointColor(localIndex(i)); }
+	inline const CCVector3& normal(std::size_t i) const { return cloudOf(i)->getPointNormal(localIndex(i)); }
+	bool hasColors() const { return cloud1->hasColors() && (!cloud2 || cloud2->hasColors()); }
+	bool hasNormals() const { return cloud1->hasNormals() && (!cloud2 || cloud2->hasNormals()); }
+};
+
+// CGAL points are directly mapped onto the cloud coordinates
+static_assert(sizeof(Point) == sizeof(CCVector3), "CGAL point and CCVector3 layouts differ");
+
+//! Lvalue property map: point index -> point coordinates (mapped in place onto the cloud(s))
+/** CGAL keeps references to the points returned by this map (e.g. in its kd-trees), hence the lvalue category.
+**/
+struct CC_point_map
+{
+	typedef std::size_t key_type;
+	typedef Point value_type;
+	typedef const Point& reference;
+	typedef boost::lvalue_property_map_tag category;
+
+	Cloud_view view;
+
+	friend inline const Point& get(const CC_point_map& map, std::size_t i) {
+		return *reinterpret_cast<const Point*>(map.view.point(i));
+	}
+};
+
+//! Readable property map: point index -> point color (read in place from the cloud(s))
+struct CC_color_map
+{
+	typedef std::size_t key_type;
+	typedef CGAL::IO::Color value_type;
+	typedef CGAL::IO::Color reference;
+	typedef boost::readable_property_map_tag category;
+
+	Cloud_view view;
+
+	friend inline CGAL::IO::Color get(const CC_color_map& map, std::size_t i) {
+		const ccColor::Rgba& C = map.view.color(i);
+		return CGAL::IO::Color(C.r, C.g, C.b);
+	}
+};
+
+//! Readable property map: point index -> point normal (read in place from the cloud(s))
+struct CC_normal_map
+{
+	typedef std::size_t key_type;
+	typedef Vector value_type;
+	typedef Vector reference;
+	typedef boost::readable_property_map_tag category;
+
+	Cloud_view view;
+
+	friend inline Vector get(const CC_normal_map& map, std::size_t i) {
+		const CCVector3& N = map.view.normal(i);
+		return Vector(N.x, N.y, N.z);
+	}
+};
+
+//! Readable property map: point index -> scalar value (read in place from one scalar field per cloud)
+struct CC_scalar_map
+{
+	typedef std::size_t key_type;
+	typedef float value_type;
+	typedef float reference;
+	typedef boost::readable_property_map_tag category;
+
+	CCCoreLib::ScalarField* sf1 = nullptr;
+	CCCoreLib::ScalarField* sf2 = nullptr;
+	Cloud_view view;
+
+	friend inline float get(const CC_scalar_map& map, std::size_t i) {
+		return ((i < map.view.split) ? map.sf1 : map.sf2)->getValue(map.view.localIndex(i));
+	}
+};
+
+namespace Classification = CGAL::Classification;
+typedef Classification::Label_handle                                                 Label_handle;
+typedef Classification::Feature_handle                                               Feature_handle;
+typedef Classification::Label_set                                                    Label_set;
+typedef Classification::Feature_set                                                  Feature_set;
+typedef Classification::Point_set_feature_generator<Kernel, Index_range, CC_point_map> Feature_generator;
+typedef Classification::Feature::Simple_feature<Index_range, CC_scalar_map>          Scalar_feature;
+typedef Classification::Point_set_neighborhood<Kernel, Index_range, CC_point_map>     Neighborhood;
+
+#endif //Q_RFC_CLOUD_VIEW_HEADER
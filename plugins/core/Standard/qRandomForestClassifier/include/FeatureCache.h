@@ -0,0 +1,95 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_FEATURE_CACHE_HEADER
+#define Q_RFC_FEATURE_CACHE_HEADER
+
+#include "Classifier.h"
+
+//Qt
+#include <QFile>
+#include <QString>
+
+//! Feature whose values are read from a (memory mapped) column of floats
+class Cached_feature : public CGAL::Classification::Feature_base
+{
+public:
+	Cached_feature(const std::string& name, const float* values)
+		: m_values(values)
+	{
+		this->set_name(name);
+	}
+
+	float value(std::size_t pt_index) override { return m_values[pt_index]; }
+
+protected:
+	const float* m_values;
+};
+
+//! On-disk cache of the computed features (CGAL generated, color and normal based features)
+/** The cache file name is a hash of the point coordinates (and colors / normals if used) and of the
+	feature parameters, so that the features of a cloud are only computed once for a given set of scales.
+	The feature values are stored as columns of floats and directly read from the memory mapped file.
+**/
+class FeatureCache
+{
+public:
+	//! Returns whether the features of a given source can be cached
+	static bool IsCacheable(Features::Source source);
+
+	//! Computes the cache key of a set of points for given feature parameters
+	static QString Key(const Cloud_view& view, int nscales, double minScale, const std::vector<Features::Source>& sources);
+
+	//! Default constructor
+	FeatureCache(const QString& directory, const QString& key);
+
+	//! Returns the cache file path
+	QString filePath() const { return m_file.fileName(); }
+
+	//! Tries to load (map) the cache file
+	/** \return false if the file doesn't exist or is invalid (cache miss)
+	**/
+	bool load(std::size_t pointCount);
+	//! Returns whether the cache file has been loaded
+	bool isLoaded() const { return m_data != nullptr; }
+	//! Returns the voxel size of the first scale the cached features were computed with
+	double voxelSize() const { return m_voxelSize; }
+
+	//! Adds the cached features of a given source to a feature set
+	void addFeatures(Features::Source source, Feature_set& features) const;
+
+	//! Saves the cacheable features of a feature set
+	/** \param sources source of each feature of the set
+		\param voxelSize voxel size of the first scale
+	**/
+	bool save(Feature_set& features, const std::vector<Features::Source>& sources, std::size_t pointCount, double voxelSize);
+
+protected:
+	struct Entry
+	{
+		Features::Source source;
+		std::string name;
+		const float* values;
+	};
+
+	QFile m_file;
+	uchar* m_data;
+	double m_voxelSize;
+	std::vector<Entry> m_entries;
+};
+
+#endif //Q_RFC_FEATURE_CACHE_HEADER
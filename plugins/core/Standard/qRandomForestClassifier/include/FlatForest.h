@@ -0,0 +1,94 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_FLAT_FOREST_HEADER
+#define Q_RFC_FLAT_FOREST_HEADER
+
+#include "ModelBundle.h"
+
+//! Random forest compiled into contiguous node tables (for fast inference)
+/** The nodes of all the trees are stored as a structure of arrays (split feature, threshold, children)
+	and the leaves point to their class distribution. The points are evaluated by blocks: the feature
+	values of a block are first gathered in a column-major matrix, then all the points of the block
+	go down each tree level by level (leaves loop on themselves, so that the traversal is branch-free).
+	The class probabilities are the same as the ones of the ETHZ random forest classifier.
+**/
+class FlatForest
+{
+public:
+	//! Default constructor
+	FlatForest();
+
+	//! Compiles a (loaded) ETHZ random forest
+	/** \return false if the forest is empty or has an unexpected structure
+	**/
+	bool compile(const ModelBundle::Forest& forest);
+
+	//! Returns whether a forest has been compiled
+	bool isValid() const { return !m_roots.empty(); }
+	//! Returns the number of classes
+	std::size_t classCount() const { return m_classCount; }
+	//! Returns the number of features
+	std::size_t featureCount() const { return m_featureCount; }
+	//! Returns the number of nodes (all trees)
+	std::size_t nodeCount() const { return m_feature.size(); }
+
+	//! Computes the class probabilities of the points (classCount values per point)
+	void evaluate(const Feature_set& features, std::size_t pointCount, std::vector<float>& probabilities) const;
+
+protected:
+	//! Evaluates a block of points (columns: featureCount columns of s_blockSize values)
+	void evaluateBlock(const float* columns, std::size_t count, float* probabilities) const;
+
+	std::size_t m_classCount;
+	std::size_t m_featureCount;
+
+	//! Nodes (structure of arrays)
+	std::vector<uint32_t> m_feature; //!< split feature (0 for leaves)
+	std::vector<float> m_threshold; //!< the 'high' child is selected if the feature value is strictly greater (+inf for leaves)
+	std::vector<uint32_t> m_children; //!< 'low' and 'high' children of each node (leaves are their own children)
+	std::vector<uint32_t> m_distribution; //!< offset of the class distribution of each leaf
+
+	std::vector<float> m_distributions; //!< class distributions of the leaves
+	std::vector<uint32_t> m_roots; //!< root node of each tree
+	std::vector<uint32_t> m_depths; //!< depth of each tree
+	std::vector<uint32_t> m_usedFeatures; //!< features used by at least one split
+};
+
+//! Classifier returning precomputed class probabilities (e.g. by FlatForest)
+/** It can be used with the classification (and regularization) functions of the CGAL Classification package.
+**/
+class Precomputed_classifier
+{
+public:
+	Precomputed_classifier(const std::vector<float>& probabilities, std::size_t classCount)
+		: m_probabilities(probabilities)
+		, m_classCount(classCount)
+	{}
+
+	void operator()(std::size_t item_index, std::vector<float>& out) const
+	{
+		const float* p = m_probabilities.data() + item_index * m_classCount;
+		out.assign(p, p + m_classCount);
+	}
+
+protected:
+	const std::vector<float>& m_probabilities;
+	std::size_t m_classCount;
+};
+
+#endif //Q_RFC_FLAT_FOREST_HEADER
@@ -0,0 +1,101 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_FOREST_EVALUATOR_HEADER
+#define Q_RFC_FOREST_EVALUATOR_HEADER
+
+#include "Classifier.h"
+
+//Qt
+#include <QStringList>
+
+//system
+#include <functional>
+
+//! k-fold cross-validation and grid search of the random forest parameters
+/** All the configurations are evaluated with the same (already computed) features. The labelled points
+	are split into k folds, either by spatial blocks (so that the neighborhoods of the training and test
+	points barely overlap) or at random. Each (configuration, fold) pair trains a forest on the other folds
+	and predicts the labels of the fold, and the pairs run concurrently. Each labelled point is predicted
+	exactly once per configuration, so the scores of a configuration are computed on all the labelled points.
+**/
+class ForestEvaluator
+{
+public:
+	//! Forest parameters
+	struct Configuration
+	{
+		std::size_t numTrees = 25;
+		std::size_t maxDepth = 20;
+		int maxCorePoints = 0; //!< max number of training points of each fold (all if <= 0)
+	};
+
+	//! Scores of a configuration
+	struct Result
+	{
+		Configuration config;
+		double trainTime = 0; //!< total training time of the folds (s)
+		double inferenceTime = 0; //!< total inference time of the folds (s)
+		float accuracy = 0;
+		float meanF1 = 0;
+		float meanIoU = 0;
+		std::vector<float> precision; //!< per label
+		std::vector<float> recall; //!< per label
+		std::vector<float> iou; //!< per label
+	};
+
+	//! Default constructor
+	/** \param groundTruth label index of each point (-1 for the unlabelled ones)
+	**/
+	ForestEvaluator(Label_set& labels, Feature_set& features, const std::vector<int>& groundTruth);
+
+	//! Splits the labelled points into k folds of (XY) spatial blocks
+	void makeSpatialFolds(int k, const Cloud_view& view, double blockSize, unsigned seed);
+	//! Splits the labelled points into k random folds
+	void makeRandomFolds(int k, unsigned seed);
+	//! Returns the number of folds
+	int foldCount() const { return m_foldCount; }
+
+	//! Evaluates the configurations
+	/** \param balanceClasses whether the training points of each fold are balanced between the classes
+		\param seed seed of the training points sampling
+		\param isCanceled returns whether the evaluation should be stopped (optional)
+		\return false if the evaluation was canceled
+	**/
+	bool evaluate(	const std::vector<Configuration>& configurations,
+					bool balanceClasses,
+					unsigned seed,
+					std::vector<Result>& results,
+					std::function<bool()> isCanceled = std::function<bool()>());
+
+	//! Returns the index of the best result (highest mean IoU)
+	static std::size_t Best(const std::vector<Result>& results);
+	//! Returns a human readable report
+	QStringList report(const std::vector<Result>& results) const;
+	//! Saves the results as a CSV file (one configuration per line)
+	bool saveCSV(const QString& filename, const std::vector<Result>& results, QString& errorMessage) const;
+
+protected:
+	Label_set& m_labels;
+	Feature_set& m_features;
+	const std::vector<int>& m_groundTruth;
+	//! Fold of each point (-1 for the unlabelled ones)
+	std::vector<int> m_folds;
+	int m_foldCount;
+};
+
+#endif //Q_RFC_FOREST_EVALUATOR_HEADER
@@ -0,0 +1,65 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_FOREST_TRAINER_HEADER
+#define Q_RFC_FOREST_TRAINER_HEADER
+
+#include "CloudView.h"
+
+//system
+#include <functional>
+
+//! Trains the trees of an ETHZ random forest by chunks (so that the progress can be reported and the training canceled)
+/** The ETHZ classifier only applies the number of trees and the max. depth when its forest is created: the
+	trees added to an existing forest are grown with the parameters stored in the forest. They are updated
+	before each chunk that differs from the previous one, so that exactly the requested trees are added.
+**/
+class ForestTrainer
+{
+public:
+	//! ETHZ random forest classifier
+	typedef Classification::ETHZ::Random_forest_classifier Forest_classifier;
+	//! ETHZ random forest
+	typedef CGAL::internal::liblearning::RandomForest::RandomForest
+		< CGAL::internal::liblearning::RandomForest::NodeGini
+		< CGAL::internal::liblearning::RandomForest::AxisAlignedSplitter> > Forest;
+
+	//! Callback called before each chunk with the number of trees already trained (returns false to cancel)
+	typedef std::function<bool(std::size_t)> Chunk_callback;
+
+	//! Trains (or adds) trees
+	/** \param reset whether the trees of the classifier are replaced (otherwise the new trees are added to them)
+		\param treeCount number of trees to train
+		\param maxDepth max. depth of the new trees
+		\param callback called before each chunk (optional)
+		\return false if the training was canceled
+	**/
+	static bool Train(	Forest_classifier& classifier,
+						const std::vector<int>& groundTruth,
+						bool reset,
+						std::size_t treeCount,
+						std::size_t maxDepth,
+						const Chunk_callback& callback = Chunk_callback());
+
+	//! Returns the number of trees of a classifier
+	static std::size_t TreeCount(const Forest_classifier& classifier);
+
+	//! Sets the parameters of the next trees added to the forest of a classifier
+	static void SetTreeParams(Forest_classifier& classifier, std::size_t treeCount, std::size_t maxDepth);
+};
+
+#endif //Q_RFC_FOREST_TRAINER_HEADER
@@ -0,0 +1,91 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_K_NEIGHBOR_GRAPH_HEADER
+#define Q_RFC_K_NEIGHBOR_GRAPH_HEADER
+
+#include "Classifier.h"
+#include "OctreeNeighborhood.h"
+
+//system
+#include <unordered_map>
+
+//! k nearest neighbors of all the points of a cloud view (computed once, in parallel)
+/** The graph can be used instead of a neighborhood query by the regularization functions of the CGAL
+	Classification package (see Query), so that the neighbors of each point are only searched once.
+	As with Point_set_neighborhood::k_neighbor_query, each point is one of its own neighbors.
+**/
+class KNeighborGraph
+{
+public:
+	//! Default constructor
+	/** \param k number of neighbors of each point (at most the number of points)
+	**/
+	KNeighborGraph(const Cloud_view& view, const Neighborhood& neighborhood, std::size_t k);
+	//! Constructor with octree neighborhoods (all the points)
+	KNeighborGraph(const Cloud_view& view, const OctreeNeighborhood& neighborhood, std::size_t k);
+
+	//! Returns the number of neighbors of each point
+	std::size_t k() const { return m_k; }
+	//! Returns the number of points
+	std::size_t size() const { return m_k ? m_neighbors.size() / m_k : 0; }
+	//! Returns the neighbors of a point (k indices)
+	const uint32_t* neighbors(std::size_t index) const { return m_neighbors.data() + index * m_k; }
+	//! Returns the memory used by the graph (in bytes)
+	std::size_t memoryUsage() const { return m_neighbors.size() * sizeof(uint32_t); }
+
+	//! Returns the index of a point (mapped onto the cloud coordinates by CC_point_map)
+	std::size_t indexOf(const Point& point) const;
+
+	//! Neighbor query (NeighborQuery concept of the CGAL Classification package)
+	class Query
+	{
+	public:
+		typedef Point value_type;
+
+		Query(const KNeighborGraph& graph) : m_graph(graph) {}
+
+		template <typename OutputIterator>
+		OutputIterator operator()(const value_type& query, OutputIterator output) const
+		{
+			const uint32_t* neighbors = m_graph.neighbors(m_graph.indexOf(query));
+			for (std::size_t i = 0; i < m_graph.k(); ++i)
+			{
+				*(output++) = static_cast<std::size_t>(neighbors[i]);
+			}
+			return output;
+		}
+
+	protected:
+		const KNeighborGraph& m_graph;
+	};
+
+	//! Returns a neighbor query over the graph
+	Query query() const { return Query(*this); }
+
+protected:
+	//! Searches the neighbors of all the points
+	template <typename NeighborQuery> void build(const NeighborQuery& neighborQuery);
+
+	const Cloud_view& m_view;
+	std::size_t m_k;
+	std::vector<uint32_t> m_neighbors;
+	//! Index of each point in the view, by local index (views of a subset only)
+	std::unordered_map<unsigned, uint32_t> m_subsetIndexes;
+};
+
+#endif //Q_RFC_K_NEIGHBOR_GRAPH_HEADER
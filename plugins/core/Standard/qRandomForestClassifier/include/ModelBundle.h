@@ -0,0 +1,100 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_MODEL_BUNDLE_HEADER
+#define Q_RFC_MODEL_BUNDLE_HEADER
+
+#include "Classifier.h"
+
+//Qt
+#include <QString>
+#include <QStringList>
+
+//! Trained classifier file: ETHZ random forest + description of the features it was trained with
+/** The feature schema (sources, scales, ordered feature names) and the classes are stored
+	with the forest, so that the exact same features can be computed at classification time.
+	Files only containing an ETHZ random forest (older classifier files) can still be loaded
+	(without schema).
+**/
+class ModelBundle
+{
+public:
+	//! ETHZ random forest
+	typedef CGAL::internal::liblearning::RandomForest::RandomForest
+		< CGAL::internal::liblearning::RandomForest::NodeGini
+		< CGAL::internal::liblearning::RandomForest::AxisAlignedSplitter> > Forest;
+
+	//! Feature source used for training
+	struct Source
+	{
+		Features::Source source;
+		std::string sf_name; //!< scalar field name (CC_SCALAR_FIELD only)
+	};
+
+	//! Default constructor
+	ModelBundle();
+
+	int nscales; //!< number of scales (0 if unknown)
+	double min_scale; //!< voxel size of the first scale (-1 if unknown)
+	bool octree_neighborhoods; //!< whether the point based features were computed with octree neighborhoods
+	std::vector<int> classes_list;
+	std::vector<std::string> label_names; //!< name of each label (same order as classes_list, without the unlabelled class)
+	std::vector<Source> sources; //!< feature sources (in the order they were computed)
+	std::vector<std::string> features; //!< ordered names of the features the forest was trained with
+	std::string forest; //!< ETHZ random forest configuration
+
+	//! Returns whether the feature schema is known
+	bool hasSchema() const { return nscales > 0 && !sources.empty() && !features.empty(); }
+
+	//! Loads a classifier file
+	bool load(const QString& filename, QString& errorMessage);
+	//! Saves a classifier file
+	bool save(const QString& filename, QString& errorMessage) const;
+
+	//! Resolves the feature sources for a given cloud
+	/** \return false if a scalar field is missing (see errorMessage)
+	**/
+	bool getFeatures(ccPointCloud* cloud, std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> >& out, QString& errorMessage) const;
+
+	//! Reads the ETHZ random forest
+	void readForest(Forest& rfc) const;
+
+	//! Returns whether each feature is used by (at least one split node of) the forest
+	/** \return false if the forest can't be read or if the schema is unknown
+	**/
+	bool getFeatureUsage(std::vector<bool>& used) const;
+
+	//! Returns a human readable description of the schema
+	QStringList description() const;
+
+	//! Keeps the trees of the forest with the best accuracy on a set of samples (the other ones are removed)
+	/** \param count number of trees to keep
+		\param samples feature values of the samples (row-major, one row of features.size() values per sample)
+		\param labels label index of each sample
+		\return the number of removed trees
+	**/
+	std::size_t keepBestTrees(std::size_t count, const std::vector<float>& samples, const std::vector<int>& labels);
+
+	//! Merges the forests of several classifier files (e.g. trained independently) into a single one
+	/** All the files must have been trained with the same classes and features. The trees of all
+		the forests are gathered in the forest of the first file (with its schema).
+		\return false if a file can't be loaded or if the files are incompatible (see errorMessage)
+	**/
+	static bool Merge(const QStringList& filenames, ModelBundle& merged, QString& errorMessage);
+};
+
+#endif //Q_RFC_MODEL_BUNDLE_HEADER
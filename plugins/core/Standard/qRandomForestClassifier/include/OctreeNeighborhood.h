@@ -0,0 +1,151 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_OCTREE_NEIGHBORHOOD_HEADER
+#define Q_RFC_OCTREE_NEIGHBORHOOD_HEADER
+
+#include "CloudView.h"
+
+//qCC_db
+#include <ccOctree.h>
+
+//CCCoreLib
+#include <ReferenceCloud.h>
+
+//system
+#include <map>
+
+//! Neighborhoods of a cloud view answered with an octree (instead of the CGAL kd-trees)
+/** The octree of the cloud is used if it was already computed (plain view of a single cloud),
+	otherwise a single octree is computed for the view (it serves all the scales).
+	As with Point_set_neighborhood, the queries can be made on all the points or on a voxel
+	simplification of the view: one point per cell (the closest to the centroid of the cell) of the
+	octree level whose cell size is the closest to the voxel size. The cells of a level depend on the
+	bounding box of the octree: the effective scales are not exactly the ones of the CGAL voxels.
+	The queries return point indices in the view (NeighborQuery concept of the CGAL Classification package).
+**/
+class OctreeNeighborhood
+{
+public:
+	//! Default constructor
+	/** Views of two clouds are not supported (see isValid).
+	**/
+	OctreeNeighborhood(const Cloud_view& view, CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+	//! Returns whether the octree is available
+	bool isValid() const { return m_octree != nullptr; }
+	//! Returns whether the octree of the cloud is used (i.e. no octree was computed)
+	bool isShared() const { return !m_sharedOctree.isNull(); }
+
+	//! Returns the octree level whose cell size is the closest to a given voxel size
+	unsigned char levelFor(float voxelSize) const;
+
+	//! k nearest neighbors query
+	class K_neighbor_query
+	{
+	public:
+		typedef Point value_type;
+
+		K_neighbor_query(const OctreeNeighborhood& neighborhood, unsigned k, unsigned char level, bool simplified)
+			: m_neighborhood(neighborhood), m_k(k), m_level(level), m_simplified(simplified) {}
+
+		template <typename OutputIterator>
+		OutputIterator operator()(const value_type& query, OutputIterator output) const
+		{
+			std::vector<unsigned> neighbors;
+			m_neighborhood.kNearest(CCVector3(query.x(), query.y(), query.z()), m_k, m_level, m_simplified, neighbors);
+			for (unsigned index : neighbors)
+			{
+				*(output++) = static_cast<std::size_t>(index);
+			}
+			return output;
+		}
+
+	protected:
+		const OctreeNeighborhood& m_neighborhood;
+		unsigned m_k;
+		unsigned char m_level; //!< search level (all the points) or level of the cells (simplification)
+		bool m_simplified;
+	};
+
+	//! Spherical neighborhood query
+	class Sphere_neighbor_query
+	{
+	public:
+		typedef Point value_type;
+
+		Sphere_neighbor_query(const OctreeNeighborhood& neighborhood, PointCoordinateType radius, unsigned char level, bool simplified)
+			: m_neighborhood(neighborhood), m_radius(radius), m_level(level), m_simplified(simplified) {}
+
+		template <typename OutputIterator>
+		OutputIterator operator()(const value_type& query, OutputIterator output) const
+		{
+			std::vector<unsigned> neighbors;
+			m_neighborhood.inSphere(CCVector3(query.x(), query.y(), query.z()), m_radius, m_level, m_simplified, neighbors);
+			for (unsigned index : neighbors)
+			{
+				*(output++) = static_cast<std::size_t>(index);
+			}
+			return output;
+		}
+
+	protected:
+		const OctreeNeighborhood& m_neighborhood;
+		PointCoordinateType m_radius;
+		unsigned char m_level; //!< search level (all the points) or level of the cells (simplification)
+		bool m_simplified;
+	};
+
+	//! Returns a query of the k nearest neighbors among all the points
+	K_neighbor_query k_neighbor_query(unsigned k) const;
+	//! Returns a query of the k nearest neighbors among the points of a voxel simplification
+	/** The cells of the matching level are listed by the first call (not thread-safe).
+	**/
+	K_neighbor_query k_neighbor_query(unsigned k, float voxelSize) { return K_neighbor_query(*this, k, prepareLevel(voxelSize), true); }
+	//! Returns a query of the neighbors in a sphere among all the points
+	Sphere_neighbor_query sphere_neighbor_query(PointCoordinateType radius) const;
+	//! Returns a query of the neighbors in a sphere among the points of a voxel simplification
+	/** The cells of the matching level are listed by the first call (not thread-safe).
+	**/
+	Sphere_neighbor_query sphere_neighbor_query(PointCoordinateType radius, float voxelSize) { return Sphere_neighbor_query(*this, radius, prepareLevel(voxelSize), true); }
+
+protected:
+	//! Non-empty cells of a level and their representative point
+	struct Cells
+	{
+		std::vector<CCCoreLib::DgmOctree::CellCode> codes; //!< truncated cell codes (sorted)
+		std::vector<unsigned> points; //!< representative point of each cell
+	};
+
+	//! Lists the cells of the level matching a voxel size (if not done yet), returns the level
+	unsigned char prepareLevel(float voxelSize);
+
+	//! Searches the k nearest neighbors of a point (sorted by increasing distance)
+	void kNearest(const CCVector3& P, unsigned k, unsigned char level, bool simplified, std::vector<unsigned>& neighbors) const;
+	//! Searches the neighbors of a point in a sphere
+	void inSphere(const CCVector3& P, PointCoordinateType radius, unsigned char level, bool simplified, std::vector<unsigned>& neighbors) const;
+	//! Visits the representative points of the cells at a given (Chebyshev) distance from a cell
+	template <typename Visitor> void visitShell(const Cells& cells, unsigned char level, const Tuple3i& center, int distance, Visitor visitor) const;
+
+	const CCCoreLib::DgmOctree* m_octree;
+	ccOctree::Shared m_sharedOctree;
+	std::unique_ptr<CCCoreLib::ReferenceCloud> m_subset;
+	std::unique_ptr<CCCoreLib::DgmOctree> m_ownOctree;
+	std::map<unsigned char, Cells> m_cells;
+};
+
+#endif //Q_RFC_OCTREE_NEIGHBORHOOD_HEADER
@@ -0,0 +1,97 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_PRUNED_FEATURE_GENERATOR_HEADER
+#define Q_RFC_PRUNED_FEATURE_GENERATOR_HEADER
+
+#include "CloudView.h"
+#include "OctreeNeighborhood.h"
+#include "StageProfiler.h"
+
+//! Placeholder for a feature the classifier never uses (keeps the feature indices of the forest)
+class Unused_feature : public CGAL::Classification::Feature_base
+{
+public:
+	Unused_feature(const std::string& name)
+	{
+		this->set_name(name);
+	}
+
+	float value(std::size_t) override { return 0.f; }
+};
+
+//! Generates a subset of the features of Point_set_feature_generator
+/** The features are added in the same order as with Point_set_feature_generator, but only the scale
+	structures (neighborhood, local eigen analysis, planimetric grid) required by the used point based
+	features are computed, and the unused point based features are replaced by placeholders.
+	The voxel size of the first scale must be known (it is not estimated).
+	The neighborhoods of the local eigen analyses can be answered by an octree (see OctreeNeighborhood)
+	instead of a kd-tree per scale.
+**/
+class PrunedFeatureGenerator
+{
+public:
+	//! Number of point based features per scale
+	static const std::size_t FeaturesPerScale = 10;
+	//! Radius of the largest neighborhood used by the features (the elevation of the coarsest scale)
+	/** The points farther than this radius from a point don't change its features (e.g. size of a tile halo).
+		\param voxelSize voxel size of the first scale (doubled at each scale)
+	**/
+	static double SupportRadius(int nscales, double voxelSize);
+
+	//! Default constructor
+	/** \param octree octree neighborhoods (optional, CGAL neighborhoods otherwise)
+	**/
+	PrunedFeatureGenerator(const Index_range& input, CC_point_map pointMap, int nscales, float voxelSize, std::unique_ptr<OctreeNeighborhood> octree = nullptr);
+
+	//! Adds the point based features (placeholders for the unused ones)
+	/** \param used whether each point based feature is used (FeaturesPerScale values per scale)
+		\param names names of the point based features (used for the placeholders)
+		\param profiler records the computation of the structures of each scale (optional)
+	**/
+	void generatePointBasedFeatures(Feature_set& features, const std::vector<bool>& used, const std::vector<std::string>& names, StageProfiler* profiler = nullptr);
+	//! Adds the color based features (same as Point_set_feature_generator)
+	void generateColorBasedFeatures(Feature_set& features, CC_color_map colorMap);
+	//! Adds the normal based features (same as Point_set_feature_generator)
+	void generateNormalBasedFeatures(Feature_set& features, CC_normal_map normalMap);
+
+	//! Returns the number of scales
+	int scaleCount() const { return static_cast<int>(m_scales.size()); }
+	//! Returns the octree neighborhoods (if any)
+	const OctreeNeighborhood* octree() const { return m_octree.get(); }
+
+protected:
+	typedef Classification::Local_eigen_analysis Local_eigen_analysis;
+	typedef Classification::Planimetric_grid<Kernel, Index_range, CC_point_map> Planimetric_grid;
+
+	//! Structures of a scale (only computed if required)
+	struct Scale
+	{
+		float voxelSize = 0.f;
+		std::unique_ptr<Neighborhood> neighborhood; //!< CGAL neighborhoods only
+		std::unique_ptr<Local_eigen_analysis> eigen;
+		std::unique_ptr<Planimetric_grid> grid;
+	};
+
+	Index_range m_input;
+	CC_point_map m_pointMap;
+	Iso_cuboid_3 m_bbox;
+	std::vector<Scale> m_scales;
+	std::unique_ptr<OctreeNeighborhood> m_octree;
+};
+
+#endif //Q_RFC_PRUNED_FEATURE_GENERATOR_HEADER
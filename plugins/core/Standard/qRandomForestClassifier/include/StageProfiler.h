@@ -0,0 +1,106 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_STAGE_PROFILER_HEADER
+#define Q_RFC_STAGE_PROFILER_HEADER
+
+//Qt
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+
+//CGAL
+#include <CGAL/Real_timer.h>
+
+//system
+#include <string>
+#include <vector>
+
+//! Records the wall time, CPU time, peak memory and throughput of the stages of a training or a classification
+/** The stages with the same name (e.g. the stages of each tile) are accumulated. Stages can be recorded
+	from several threads at once. The report is a JSON document.
+**/
+class StageProfiler
+{
+public:
+	//! Profiled stage
+	struct Stage
+	{
+		std::string name;
+		unsigned count = 0; //!< number of times the stage was run
+		double wallTime = 0; //!< (s)
+		double cpuTime = 0; //!< CPU time of the process, all threads (s)
+		std::size_t peakMemory = 0; //!< peak resident memory of the process at the end of the stage (bytes)
+		std::size_t points = 0; //!< number of processed points
+	};
+
+	//! Records a stage, from its construction to its destruction
+	/** Nothing is recorded if the profiler is null.
+	**/
+	class Scope
+	{
+	public:
+		Scope(StageProfiler* profiler, const std::string& name, std::size_t points = 0);
+		~Scope();
+
+		//! Sets the number of processed points (if unknown when the stage starts)
+		void setPoints(std::size_t points) { m_stage.points = points; }
+		//! Records the stage now (instead of at destruction)
+		void stop();
+
+	protected:
+		StageProfiler* m_profiler;
+		Stage m_stage;
+		CGAL::Real_timer m_timer;
+		double m_cpuStart;
+	};
+
+	//! Default constructor
+	StageProfiler();
+
+	//! Clears the recorded stages (and restarts the total time)
+	void clear();
+	//! Adds (or accumulates) a stage
+	void add(const Stage& stage);
+	//! Returns the recorded stages (in the order they were first recorded)
+	std::vector<Stage> stages() const;
+	//! Returns the wall time since the profiler was cleared (s)
+	double wallTime() const;
+	//! Returns the CPU time of the process since the profiler was cleared (s)
+	double cpuTime() const;
+
+	//! Returns the JSON report
+	/** \param operation name of the profiled operation (e.g. "training")
+		\param compact whether the document is written on a single line
+	**/
+	QByteArray toJson(const QString& operation, bool compact) const;
+	//! Saves the JSON report
+	bool save(const QString& filename, const QString& operation, QString& errorMessage) const;
+
+	//! Returns the CPU time of the process (s)
+	static double CpuTime();
+	//! Returns the peak resident memory of the process (bytes, 0 if unknown)
+	static std::size_t PeakMemory();
+
+protected:
+	mutable QMutex m_mutex;
+	std::vector<Stage> m_stages;
+	CGAL::Real_timer m_total;
+	double m_cpuStart;
+};
+
+#endif //Q_RFC_STAGE_PROFILER_HEADER
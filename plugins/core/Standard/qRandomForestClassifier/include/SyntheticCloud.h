@@ -0,0 +1,71 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_SYNTHETIC_CLOUD_HEADER
+#define Q_RFC_SYNTHETIC_CLOUD_HEADER
+
+//Qt
+#include <QString>
+
+//system
+#include <vector>
+
+class ccPointCloud;
+
+//! Generates synthetic labelled clouds (benchmarks)
+/** The scene is a square of noisy ground with objects standing on it, laid out on a regular grid of
+	cells (one object per cell, its kind drawn at random among the enabled ones). The ground keeps the
+	same density whatever the number of points: the scene grows with the cloud.
+	The labels are stored in a "Classification" scalar field. They are consecutive: 0 for the ground, then
+	the enabled object kinds (in the order of the Kind enum).
+**/
+class SyntheticCloud
+{
+public:
+	//! Kinds of generated surfaces
+	enum Kind
+	{
+		GROUND = 0,
+		PLANES = 1, //!< boxes (vertical walls and flat roofs)
+		CYLINDERS = 2, //!< poles and trunks
+		VEGETATION = 3 //!< noisy ellipsoidal crowns
+	};
+
+	//! Class layout of the scene
+	struct Layout
+	{
+		bool planes = true;
+		bool cylinders = true;
+		bool vegetation = true;
+		double spacing = 0.1; //!< mean distance between the ground points
+		double noise = 0.01; //!< standard deviation of the noise added to the surfaces
+		double cellSize = 10.0; //!< size of the cell of each object
+		double groundRatio = 0.4; //!< ratio of ground points (all the points if no object is enabled)
+	};
+
+	//! Returns the kinds of a layout (ground first, the label of a kind is its index)
+	static std::vector<Kind> Kinds(const Layout& layout);
+	//! Returns the labels of a layout
+	static std::vector<int> Classes(const Layout& layout);
+
+	//! Generates a cloud
+	/** \return the cloud (with a "Classification" scalar field) or nullptr if not enough memory (see errorMessage)
+	**/
+	static ccPointCloud* Generate(std::size_t pointCount, const Layout& layout, unsigned seed, QString& errorMessage);
+};
+
+#endif //Q_RFC_SYNTHETIC_CLOUD_HEADER
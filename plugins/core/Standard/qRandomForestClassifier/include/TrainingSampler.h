@@ -0,0 +1,71 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_TRAINING_SAMPLER_HEADER
+#define Q_RFC_TRAINING_SAMPLER_HEADER
+
+#include "Classifier.h"
+
+//system
+#include <random>
+
+//! Selects the labelled points (core points) the classifier is trained with
+/** The labelled points are read once: each class (or all the classes together) feeds a reservoir
+	of at most maxPoints points, so that the selection doesn't depend on the order of the points.
+	If the classes are balanced, the point budget is then shared equally between the classes (the
+	share a class can't use is given to the other ones). If a voxel size is set, only one (random)
+	point per voxel and class is considered, so that dense areas don't dominate the training set.
+	The selection only depends on the seed (deterministic).
+**/
+class TrainingSampler
+{
+public:
+	//! Default constructor
+	/** \param maxPoints max number of selected points (no limit if 0)
+		\param balanceClasses whether the point budget is shared equally between the classes
+		\param voxelSize voxel size of the spatial stratification (disabled if <= 0)
+		\param seed seed of the random generator
+	**/
+	TrainingSampler(std::size_t maxPoints, bool balanceClasses, double voxelSize, unsigned seed);
+
+	//! Returns whether the sampler would discard points
+	bool isActive() const { return m_maxPoints != 0 || m_voxelSize > 0; }
+
+	//! Selects the core points (the labels of the other points are set to -1)
+	/** \param view cloud(s) the labels relate to (only required for the spatial stratification)
+		\return the number of selected points
+	**/
+	std::size_t select(std::vector<int>& groundTruth, const Cloud_view* view);
+
+protected:
+	//! Points of a reservoir
+	struct Reservoir
+	{
+		std::size_t seen = 0;
+		std::vector<std::size_t> indices;
+	};
+
+	//! Adds a point to a reservoir
+	void add(Reservoir& reservoir, std::size_t capacity, std::size_t index);
+
+	std::size_t m_maxPoints;
+	bool m_balanceClasses;
+	double m_voxelSize;
+	std::mt19937 m_rng;
+};
+
+#endif //Q_RFC_TRAINING_SAMPLER_HEADER
@@ -54,8 +54,17 @@ public:
 	std::vector<int> getClassIndices() const;
 	//! Returns whether the features should be outputted for the user
 	bool getExportFeatures() const;
+	bool getExportProbabilities() const;
 	//! Returns the labels for evaluating the given point cloud
 	CCCoreLib::ScalarField* getEvaluationLabels() const;
+	//! Returns the tile size (0 if tiled classification is disabled)
+	double getTileSize() const;
+	//! Returns the tile halo (0 for automatic)
+	double getTileHalo() const;
+	//! Returns the min. distance between the points of the classified subsampled cloud (0 if disabled)
+	double getSubsamplingDistance() const;
+	//! Returns the number of neighbors of the label transfer majority vote
+	int getTransferNeighbors() const;
 
 	//! Loads parameters from persistent settings
 	void loadParamsFromPersistentSettings();
@@ -0,0 +1,961 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_PLUGIN_COMMANDS_HEADER
+#define Q_RFC_PLUGIN_COMMANDS_HEADER
+
+//CloudCompare
+#include "ccCommandLineInterface.h"
+
+//Qt
+#include <QDir>
+#include <QFileInfo>
+
+//Local
+#include "Classifier.h"
+#include "ModelBundle.h"
+#include "qRFCTools.h"
+
+static const char COMMAND_RFC_TRAIN[] = "RFC_TRAIN";
+static const char COMMAND_RFC_CLASSIFY[] = "RFC_CLASSIFY";
+static const char COMMAND_RFC_MERGE[] = "RFC_MERGE";
+static const char COMMAND_RFC_SCALES[] = "SCALES";
+static const char COMMAND_RFC_MIN_SCALE[] = "MIN_SCALE";
+static const char COMMAND_RFC_OCTREE_NEIGHBORHOODS[] = "OCTREE_NEIGHBORHOODS";
+static const char COMMAND_RFC_CLASSES[] = "CLASSES";
+static const char COMMAND_RFC_FEATURES[] = "FEATURES";
+static const char COMMAND_RFC_MAX_CORE_POINTS[] = "MAX_CORE_POINTS";
+static const char COMMAND_RFC_BALANCE_CLASSES[] = "BALANCE_CLASSES";
+static const char COMMAND_RFC_SAMPLING_VOXEL[] = "SAMPLING_VOXEL";
+static const char COMMAND_RFC_SEED[] = "SEED";
+static const char COMMAND_RFC_TRAIN_CLOUDS[] = "TRAIN_CLOUDS";
+static const char COMMAND_RFC_PARALLEL_CLOUDS[] = "PARALLEL_CLOUDS";
+static const char COMMAND_RFC_NUM_TREES[] = "NUM_TREES";
+static const char COMMAND_RFC_MAX_DEPTH[] = "MAX_DEPTH";
+static const char COMMAND_RFC_BASE_CLASSIFIER[] = "BASE_CLASSIFIER";
+static const char COMMAND_RFC_MAX_TREES[] = "MAX_TREES";
+static const char COMMAND_RFC_LABEL_SF[] = "LABEL_SF";
+static const char COMMAND_RFC_EVALUATE[] = "EVALUATE";
+static const char COMMAND_RFC_REGULARIZATION[] = "REGULARIZATION";
+static const char COMMAND_RFC_EXPORT_FEATURES[] = "EXPORT_FEATURES";
+static const char COMMAND_RFC_EXPORT_PROBABILITIES[] = "EXPORT_PROBABILITIES";
+static const char COMMAND_RFC_EVAL_SF[] = "EVAL_SF";
+static const char COMMAND_RFC_TILE_SIZE[] = "TILE_SIZE";
+static const char COMMAND_RFC_TILE_HALO[] = "TILE_HALO";
+static const char COMMAND_RFC_FEATURE_CACHE[] = "FEATURE_CACHE";
+static const char COMMAND_RFC_SUBSAMPLE[] = "SUBSAMPLE";
+static const char COMMAND_RFC_TRANSFER_NEIGHBORS[] = "TRANSFER_NEIGHBORS";
+static const char COMMAND_RFC_REG_NEIGHBORS[] = "REG_NEIGHBORS";
+static const char COMMAND_RFC_GRAPH_CUT_STRENGTH[] = "GRAPH_CUT_STRENGTH";
+static const char COMMAND_RFC_GRAPH_CUT_SUBDIVISIONS[] = "GRAPH_CUT_SUBDIVISIONS";
+static const char COMMAND_RFC_GRAPH_CUT_MEMORY[] = "GRAPH_CUT_MEMORY";
+static const char COMMAND_RFC_CV_FOLDS[] = "CV_FOLDS";
+static const char COMMAND_RFC_CV_BLOCK_SIZE[] = "CV_BLOCK_SIZE";
+static const char COMMAND_RFC_CV_REPORT[] = "CV_REPORT";
+static const char COMMAND_RFC_GRID_NUM_TREES[] = "GRID_NUM_TREES";
+static const char COMMAND_RFC_GRID_MAX_DEPTH[] = "GRID_MAX_DEPTH";
+static const char COMMAND_RFC_GRID_MAX_CORE_POINTS[] = "GRID_MAX_CORE_POINTS";
+static const char COMMAND_RFC_PROFILE[] = "PROFILE";
+
+//! Feature keywords accepted after -FEATURES (anything else is considered as a scalar field name)
+static const char RFC_FEATURE_POINT[] = "POINT_FEATURES";
+static const char RFC_FEATURE_COLORS[] = "COLORS";
+static const char RFC_FEATURE_NORMALS[] = "NORMALS";
+
+//! Options shared by the training and classification commands
+struct RFCCommonOptions
+{
+	int nscales = 5;
+	double min_scale = -1.0;
+	std::vector<int> classes_list = { 0, 1 };
+	bool classes_set = false; //!< whether -CLASSES was given
+	QStringList features = { RFC_FEATURE_POINT };
+	QString feature_cache_dir;
+	QString profile_path;
+
+	//! Tries to consume a shared option from the command line arguments
+	/** \return false if the current argument is not a shared option (or on error, see 'error')
+	**/
+	bool consume(ccCommandLineInterface& cmd, bool& error)
+	{
+		error = false;
+		QString argument = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_SCALES))
+		{
+			cmd.arguments().pop_front();
+			bool ok = false;
+			if (!cmd.arguments().empty())
+				nscales = cmd.arguments().takeFirst().toInt(&ok);
+			if (!ok || nscales < 1)
+			{
+				error = true;
+				return cmd.error(QString("Invalid parameter: number of scales after '%1'").arg(COMMAND_RFC_SCALES));
+			}
+			cmd.print(QString("Number of scales: %1").arg(nscales));
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_MIN_SCALE))
+		{
+			cmd.arguments().pop_front();
+			bool ok = false;
+			if (!cmd.arguments().empty())
+				min_scale = cmd.arguments().takeFirst().toDouble(&ok);
+			if (!ok)
+			{
+				error = true;
+				return cmd.error(QString("Invalid parameter: minimum scale after '%1'").arg(COMMAND_RFC_MIN_SCALE));
+			}
+			if (min_scale <= 0)
+				min_scale = -1.0;
+			cmd.print(QString("Minimum scale: %1").arg(min_scale));
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_CLASSES))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				error = true;
+				return cmd.error(QString("Missing parameter: class indices after '%1'").arg(COMMAND_RFC_CLASSES));
+			}
+			//class indices are given as a single token (e.g. "-1,0,1,2")
+			QStringList tokens = cmd.arguments().takeFirst().replace(',', ' ').split(' ', QString::SkipEmptyParts);
+			classes_list.clear();
+			for (const QString& token : tokens)
+			{
+				bool ok = false;
+				int index = token.toInt(&ok);
+				if (!ok)
+				{
+					error = true;
+					return cmd.error(QString("Invalid class index '%1' after '%2'").arg(token, COMMAND_RFC_CLASSES));
+				}
+				classes_list.push_back(index);
+			}
+			if (classes_list.size() < 2)
+			{
+				error = true;
+				return cmd.error("Classes list is invalid, not enough classes were defined.");
+			}
+			classes_set = true;
+			cmd.print(QString("Class indices: %1").arg(tokens.join(' ')));
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_FEATURES))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				error = true;
+				return cmd.error(QString("Missing parameter: features list after '%1'").arg(COMMAND_RFC_FEATURES));
+			}
+			//features are given as a single comma separated token (e.g. "POINT_FEATURES,COLORS,Intensity")
+			features = cmd.arguments().takeFirst().split(',', QString::SkipEmptyParts);
+			cmd.print(QString("Features: %1").arg(features.join(", ")));
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_FEATURE_CACHE))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				error = true;
+				return cmd.error(QString("Missing parameter: cache directory after '%1'").arg(COMMAND_RFC_FEATURE_CACHE));
+			}
+			feature_cache_dir = cmd.arguments().takeFirst();
+			cmd.print(QString("Feature cache directory: %1").arg(feature_cache_dir));
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_PROFILE))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				error = true;
+				return cmd.error(QString("Missing parameter: report file after '%1'").arg(COMMAND_RFC_PROFILE));
+			}
+			profile_path = cmd.arguments().takeFirst();
+			cmd.print(QString("Profiling report: %1").arg(profile_path));
+		}
+		else
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	//! Resolves the feature list for a given cloud
+	bool getFeatures(ccCommandLineInterface& cmd, ccPointCloud* cloud, std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> >& out) const
+	{
+		out.clear();
+		for (const QString& feature : features)
+		{
+			if (feature.toUpper() == RFC_FEATURE_POINT)
+			{
+				out.push_back({ Features::Source::CGAL_GENERATED_FEATURE, nullptr });
+			}
+			else if (feature.toUpper() == RFC_FEATURE_COLORS)
+			{
+				if (!cloud->hasColors())
+					return cmd.error(QString("Cloud '%1' has no colors").arg(cloud->getName()));
+				out.push_back({ Features::Source::CC_COLOR_FIELD, nullptr });
+			}
+			else if (feature.toUpper() == RFC_FEATURE_NORMALS)
+			{
+				if (!cloud->hasNormals())
+					return cmd.error(QString("Cloud '%1' has no normals").arg(cloud->getName()));
+				out.push_back({ Features::Source::CC_NORMALS_FIELD, nullptr });
+			}
+			else
+			{
+				int sfIdx = cloud->getScalarFieldIndexByName(feature.toStdString().c_str());
+				if (sfIdx < 0)
+					return cmd.error(QString("Cloud '%1' has no scalar field named '%2'").arg(cloud->getName(), feature));
+				out.push_back({ Features::Source::CC_SCALAR_FIELD, cloud->getScalarField(sfIdx) });
+			}
+		}
+		if (out.empty())
+			return cmd.error("No features selected.");
+		return true;
+	}
+
+	//! Returns the profiling report file of a classified cloud (one file per cloud if several are classified)
+	QString getProfilePath(size_t cloudIndex, size_t cloudCount, const QString& prefix = QString()) const
+	{
+		if (profile_path.isEmpty() || (cloudCount < 2 && prefix.isEmpty()))
+		{
+			return profile_path;
+		}
+		QFileInfo info(profile_path);
+		QString suffix = info.suffix().isEmpty() ? QString() : "." + info.suffix();
+		QString name = info.completeBaseName() + prefix + (cloudCount < 2 ? QString() : QString("_%1").arg(cloudIndex + 1)) + suffix;
+		return info.dir().absoluteFilePath(name);
+	}
+};
+
+//! Reads a list of positive integers given as a single token (e.g. "10,25,50")
+static bool GetRFCIntegerList(ccCommandLineInterface& cmd, const char* option, std::vector<int>& values)
+{
+	cmd.arguments().pop_front();
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QString("Missing parameter: list of values after '%1'").arg(option));
+	}
+	QStringList tokens = cmd.arguments().takeFirst().split(',', QString::SkipEmptyParts);
+	values.clear();
+	for (const QString& token : tokens)
+	{
+		bool ok = false;
+		int value = token.toInt(&ok);
+		if (!ok || value <= 0)
+		{
+			return cmd.error(QString("Invalid value '%1' after '%2'").arg(token, option));
+		}
+		values.push_back(value);
+	}
+	if (values.empty())
+	{
+		return cmd.error(QString("Missing parameter: list of values after '%1'").arg(option));
+	}
+	cmd.print(QString("%1: %2").arg(option, tokens.join(' ')));
+	return true;
+}
+
+//! Returns the scalar field of a cloud with a given name
+static ccScalarField* GetRFCScalarField(ccPointCloud* cloud, const QString& name)
+{
+	int sfIdx = cloud->getScalarFieldIndexByName(name.toStdString().c_str());
+	return (sfIdx < 0 ? nullptr : static_cast<ccScalarField*>(cloud->getScalarField(sfIdx)));
+}
+
+//! Stores the classification results in the cloud and saves it (if auto-save is enabled)
+static bool ApplyRFCResults(ccCommandLineInterface& cmd, CLCloudDesc& desc, bool success, ClassificationOutput& output)
+{
+	if (!success)
+	{
+		return cmd.error(QString("Failed to classify cloud '%1'").arg(desc.pc->getName()));
+	}
+
+	QString errorMessage;
+	int idx = output.attach(desc.pc, errorMessage);
+	if (idx < 0)
+	{
+		return cmd.error(errorMessage);
+	}
+	if (!errorMessage.isEmpty())
+	{
+		cmd.warning(errorMessage);
+	}
+	desc.pc->setCurrentDisplayedScalarField(idx);
+
+	if (cmd.autoSaveMode())
+	{
+		QString errorStr = cmd.exportEntity(desc, "CLASSIFIED");
+		if (!errorStr.isEmpty())
+		{
+			return cmd.error(errorStr);
+		}
+	}
+
+	return true;
+}
+
+struct CommandRFCTrain : public ccCommandLineInterface::Command
+{
+	CommandRFCTrain() : ccCommandLineInterface::Command("RFC Train", COMMAND_RFC_TRAIN) {}
+
+	virtual bool process(ccCommandLineInterface& cmd) override
+	{
+		cmd.print("[RFC]");
+		if (cmd.arguments().empty())
+		{
+			return cmd.error(QString("Missing parameter: classifier output filename (.bin) after \"-%1\"").arg(COMMAND_RFC_TRAIN));
+		}
+
+		RFCCommonOptions options;
+		Classifier::TrainParams params;
+		QString labelSFName;
+		bool evaluate = false;
+		int trainCloudCount = 1;
+
+		//optional parameters
+		while (!cmd.arguments().empty())
+		{
+			bool error = false;
+			if (options.consume(cmd, error))
+			{
+				continue;
+			}
+			if (error)
+			{
+				return false;
+			}
+
+			QString argument = cmd.arguments().front();
+			if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_MAX_CORE_POINTS))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.max_core_points = cmd.arguments().takeFirst().toInt(&ok);
+				if (!ok || params.max_core_points < 0)
+				{
+					return cmd.error(QString("Invalid parameter: max core points after '%1'").arg(COMMAND_RFC_MAX_CORE_POINTS));
+				}
+				cmd.print(QString("Max core points: %1").arg(params.max_core_points));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_BALANCE_CLASSES))
+			{
+				cmd.arguments().pop_front();
+				params.balance_classes = true;
+				cmd.print("Core points balanced between classes");
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_OCTREE_NEIGHBORHOODS))
+			{
+				cmd.arguments().pop_front();
+				params.octree_neighborhoods = true;
+				cmd.print("Octree neighborhoods");
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_SAMPLING_VOXEL))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.sampling_voxel_size = cmd.arguments().takeFirst().toDouble(&ok);
+				if (!ok || params.sampling_voxel_size < 0)
+				{
+					return cmd.error(QString("Invalid parameter: sampling voxel size after '%1'").arg(COMMAND_RFC_SAMPLING_VOXEL));
+				}
+				cmd.print(QString("Sampling voxel size: %1").arg(params.sampling_voxel_size));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_SEED))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.seed = cmd.arguments().takeFirst().toUInt(&ok);
+				if (!ok)
+				{
+					return cmd.error(QString("Invalid parameter: seed after '%1'").arg(COMMAND_RFC_SEED));
+				}
+				cmd.print(QString("Sampling seed: %1").arg(params.seed));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_TRAIN_CLOUDS))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					trainCloudCount = cmd.arguments().takeFirst().toInt(&ok);
+				if (!ok || trainCloudCount < 1)
+				{
+					return cmd.error(QString("Invalid parameter: number of training clouds after '%1'").arg(COMMAND_RFC_TRAIN_CLOUDS));
+				}
+				cmd.print(QString("Training clouds: %1").arg(trainCloudCount));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_PARALLEL_CLOUDS))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.parallel_clouds = cmd.arguments().takeFirst().toInt(&ok);
+				if (!ok || params.parallel_clouds < 1)
+				{
+					return cmd.error(QString("Invalid parameter: number of parallel clouds after '%1'").arg(COMMAND_RFC_PARALLEL_CLOUDS));
+				}
+				cmd.print(QString("Parallel clouds: %1").arg(params.parallel_clouds));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_NUM_TREES))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.num_trees = cmd.arguments().takeFirst().toUInt(&ok);
+				if (!ok || params.num_trees == 0)
+				{
+					return cmd.error(QString("Invalid parameter: number of trees after '%1'").arg(COMMAND_RFC_NUM_TREES));
+				}
+				cmd.print(QString("Number of trees: %1").arg(params.num_trees));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_MAX_DEPTH))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.max_depth = cmd.arguments().takeFirst().toUInt(&ok);
+				if (!ok || params.max_depth == 0)
+				{
+					return cmd.error(QString("Invalid parameter: max tree depth after '%1'").arg(COMMAND_RFC_MAX_DEPTH));
+				}
+				cmd.print(QString("Max tree depth: %1").arg(params.max_depth));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_BASE_CLASSIFIER))
+			{
+				cmd.arguments().pop_front();
+				if (cmd.arguments().empty())
+				{
+					return cmd.error(QString("Missing parameter: classifier filename after '%1'").arg(COMMAND_RFC_BASE_CLASSIFIER));
+				}
+				params.base_classifier_path = cmd.arguments().takeFirst();
+				cmd.print(QString("Classifier to update: %1").arg(params.base_classifier_path));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_MAX_TREES))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.max_trees = cmd.arguments().takeFirst().toUInt(&ok);
+				if (!ok || params.max_trees == 0)
+				{
+					return cmd.error(QString("Invalid parameter: max number of trees after '%1'").arg(COMMAND_RFC_MAX_TREES));
+				}
+				cmd.print(QString("Max number of trees: %1").arg(params.max_trees));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_CV_FOLDS))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.cv_folds = cmd.arguments().takeFirst().toInt(&ok);
+				if (!ok || params.cv_folds < 2)
+				{
+					return cmd.error(QString("Invalid parameter: number of folds (at least 2) after '%1'").arg(COMMAND_RFC_CV_FOLDS));
+				}
+				cmd.print(QString("Cross-validation folds: %1").arg(params.cv_folds));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_CV_BLOCK_SIZE))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.cv_block_size = cmd.arguments().takeFirst().toDouble(&ok);
+				if (!ok || params.cv_block_size < 0)
+				{
+					return cmd.error(QString("Invalid parameter: block size after '%1'").arg(COMMAND_RFC_CV_BLOCK_SIZE));
+				}
+				cmd.print(QString("Cross-validation block size: %1").arg(params.cv_block_size));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_CV_REPORT))
+			{
+				cmd.arguments().pop_front();
+				if (cmd.arguments().empty())
+				{
+					return cmd.error(QString("Missing parameter: report filename after '%1'").arg(COMMAND_RFC_CV_REPORT));
+				}
+				params.cv_report_path = cmd.arguments().takeFirst();
+				cmd.print(QString("Cross-validation report: %1").arg(params.cv_report_path));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_GRID_NUM_TREES))
+			{
+				std::vector<int> values;
+				if (!GetRFCIntegerList(cmd, COMMAND_RFC_GRID_NUM_TREES, values))
+				{
+					return false;
+				}
+				params.grid_num_trees.assign(values.begin(), values.end());
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_GRID_MAX_DEPTH))
+			{
+				std::vector<int> values;
+				if (!GetRFCIntegerList(cmd, COMMAND_RFC_GRID_MAX_DEPTH, values))
+				{
+					return false;
+				}
+				params.grid_max_depth.assign(values.begin(), values.end());
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_GRID_MAX_CORE_POINTS))
+			{
+				if (!GetRFCIntegerList(cmd, COMMAND_RFC_GRID_MAX_CORE_POINTS, params.grid_max_core_points))
+				{
+					return false;
+				}
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_LABEL_SF))
+			{
+				cmd.arguments().pop_front();
+				if (cmd.arguments().empty())
+				{
+					return cmd.error(QString("Missing parameter: label scalar field name after '%1'").arg(COMMAND_RFC_LABEL_SF));
+				}
+				labelSFName = cmd.arguments().takeFirst();
+				cmd.print(QString("Label scalar field: %1").arg(labelSFName));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_EVALUATE))
+			{
+				cmd.arguments().pop_front();
+				evaluate = true;
+			}
+			else
+			{
+				//we assume the parameter is the classifier output filename
+				params.output_path = argument;
+				cmd.arguments().pop_front();
+				break;
+			}
+		}
+
+		if (params.output_path.isEmpty())
+		{
+			return cmd.error("Classifier output filename not set");
+		}
+		if (params.cv_folds < 2 && (!params.grid_num_trees.empty() || !params.grid_max_depth.empty() || !params.grid_max_core_points.empty()))
+		{
+			return cmd.error(QString("The parameter grid requires '%1'").arg(COMMAND_RFC_CV_FOLDS));
+		}
+		if (!params.base_classifier_path.isEmpty() && (labelSFName.isEmpty() || trainCloudCount > 1))
+		{
+			return cmd.error(QString("'%1' requires a single training cloud and '%2'").arg(COMMAND_RFC_BASE_CLASSIFIER, COMMAND_RFC_LABEL_SF));
+		}
+		if (params.max_trees > 0 && params.base_classifier_path.isEmpty())
+		{
+			return cmd.error(QString("'%1' requires '%2'").arg(COMMAND_RFC_MAX_TREES, COMMAND_RFC_BASE_CLASSIFIER));
+		}
+
+		params.nscales = options.nscales;
+		params.min_scale = options.min_scale;
+		params.classes_list = options.classes_list;
+		params.feature_cache_dir = options.feature_cache_dir;
+		params.profile_path = options.profile_path;
+		params.evaluate_params = evaluate;
+
+		Classifier classifier; //no main application: no dialogs
+		size_t evaluationStart = 0;
+		std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> > features;
+		QString classifierPath;
+
+		if (labelSFName.isEmpty())
+		{
+			//two clouds mode: the first cloud is class #0, the second one is class #1
+			if (options.classes_set)
+			{
+				return cmd.error(QString("'%1' can't be used with two training clouds (their classes are 0 and 1), use '%2' instead").arg(COMMAND_RFC_CLASSES, COMMAND_RFC_LABEL_SF));
+			}
+			if (cmd.clouds().size() < 2)
+			{
+				return cmd.error(QString("Not enough clouds loaded (2 are expected: class #0 and class #1) or use '%1'").arg(COMMAND_RFC_LABEL_SF));
+			}
+			ccPointCloud* cloud1 = cmd.clouds()[0].pc;
+			ccPointCloud* cloud2 = cmd.clouds()[1].pc;
+
+			std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> > features1, features2;
+			if (!options.getFeatures(cmd, cloud1, features1) || !options.getFeatures(cmd, cloud2, features2))
+			{
+				return false;
+			}
+
+			params.classes_list = { 0, 1 };
+			classifierPath = classifier.train(cloud1, cloud2, features1, features2, params);
+			evaluationStart = 2;
+		}
+		else if (trainCloudCount > 1)
+		{
+			//multi-cloud mode: the first clouds are used for training (each with its own scalar field of labels)
+			if (cmd.clouds().size() < static_cast<size_t>(trainCloudCount))
+			{
+				return cmd.error(QString("Not enough clouds loaded (%1 are expected for training)").arg(trainCloudCount));
+			}
+			std::vector<Classifier::TrainingCloud> trainingClouds(trainCloudCount);
+			for (int i = 0; i < trainCloudCount; ++i)
+			{
+				Classifier::TrainingCloud& trainingCloud = trainingClouds[i];
+				trainingCloud.cloud = cmd.clouds()[i].pc;
+				trainingCloud.labels = GetRFCScalarField(trainingCloud.cloud, labelSFName);
+				if (!trainingCloud.labels)
+				{
+					return cmd.error(QString("Cloud '%1' has no scalar field named '%2'").arg(trainingCloud.cloud->getName(), labelSFName));
+				}
+				if (!qRFCTools::validScalarField(trainingCloud.labels))
+				{
+					return cmd.error(QString("Invalid label scalar field in cloud '%1'. Detected non-integer values.").arg(trainingCloud.cloud->getName()));
+				}
+				if (!options.getFeatures(cmd, trainingCloud.cloud, trainingCloud.features))
+				{
+					return false;
+				}
+			}
+
+			classifierPath = classifier.train(trainingClouds, params);
+			evaluationStart = static_cast<size_t>(trainCloudCount);
+		}
+		else
+		{
+			if (cmd.clouds().empty())
+			{
+				return cmd.error("At least one cloud must be loaded");
+			}
+			ccPointCloud* cloud = cmd.clouds().front().pc;
+			ccScalarField* labelSF = GetRFCScalarField(cloud, labelSFName);
+			if (!labelSF)
+			{
+				return cmd.error(QString("Cloud '%1' has no scalar field named '%2'").arg(cloud->getName(), labelSFName));
+			}
+			if (!qRFCTools::validScalarField(labelSF))
+			{
+				return cmd.error("Invalid label scalar field specified. Detected non-integer values.");
+			}
+
+			if (!params.base_classifier_path.isEmpty())
+			{
+				//the scales, classes and features are the ones of the classifier to update
+				classifierPath = classifier.update(cloud, labelSF, params);
+			}
+			else
+			{
+				if (!options.getFeatures(cmd, cloud, params.features))
+				{
+					return false;
+				}
+				classifierPath = classifier.train(cloud, labelSF, params);
+			}
+			evaluationStart = 1;
+		}
+
+		if (classifierPath.isEmpty())
+		{
+			return cmd.error("Classifier either not created or saved.");
+		}
+		cmd.print(QString("Classifier saved to '%1'").arg(classifierPath));
+
+		if (evaluate)
+		{
+			//the remaining clouds are classified with the new classifier
+			for (size_t i = evaluationStart; i < cmd.clouds().size(); ++i)
+			{
+				CLCloudDesc& desc = cmd.clouds()[i];
+
+				Classifier::ClassifyParams classifyParams;
+				classifyParams.nscales = params.nscales;
+				classifyParams.min_scale = params.min_scale;
+				classifyParams.classes_list = params.classes_list;
+				classifyParams.feature_cache_dir = params.feature_cache_dir;
+				classifyParams.profile_path = options.getProfilePath(i - evaluationStart, cmd.clouds().size() - evaluationStart, "_classification");
+				if (!options.getFeatures(cmd, desc.pc, classifyParams.eval_features))
+				{
+					return false;
+				}
+
+				ClassificationOutput output;
+				bool success = classifier.classify(desc.pc, classifierPath, output, classifyParams);
+				if (!ApplyRFCResults(cmd, desc, success, output))
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+};
+
+struct CommandRFCClassify : public ccCommandLineInterface::Command
+{
+	CommandRFCClassify() : ccCommandLineInterface::Command("RFC Classify", COMMAND_RFC_CLASSIFY) {}
+
+	virtual bool process(ccCommandLineInterface& cmd) override
+	{
+		cmd.print("[RFC]");
+		if (cmd.arguments().empty())
+		{
+			return cmd.error(QString("Missing parameter: classifier filename (.bin) after \"-%1\"").arg(COMMAND_RFC_CLASSIFY));
+		}
+
+		RFCCommonOptions options;
+		Classifier::ClassifyParams params;
+		QString evalSFName;
+		QString classifierFilename;
+
+		//optional parameters
+		while (!cmd.arguments().empty())
+		{
+			bool error = false;
+			if (options.consume(cmd, error))
+			{
+				continue;
+			}
+			if (error)
+			{
+				return false;
+			}
+
+			QString argument = cmd.arguments().front();
+			if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_REGULARIZATION))
+			{
+				cmd.arguments().pop_front();
+				if (cmd.arguments().empty())
+				{
+					return cmd.error(QString("Missing parameter: regularization type after '%1'").arg(COMMAND_RFC_REGULARIZATION));
+				}
+				QString regType = cmd.arguments().takeFirst().toUpper();
+				if (regType == "NONE")
+					params.reg_type = Regularization::Method::NONE;
+				else if (regType == "GRAPH_CUT")
+					params.reg_type = Regularization::Method::GRAPH_CUT;
+				else if (regType == "LOCAL_SMOOTHING")
+					params.reg_type = Regularization::Method::LOCAL_SMOOTHING;
+				else
+					return cmd.error(QString("Unknown regularization type '%1' (NONE, GRAPH_CUT or LOCAL_SMOOTHING expected)").arg(regType));
+				cmd.print(QString("Regularization: %1").arg(Regularization::getName(params.reg_type).c_str()));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_EXPORT_FEATURES))
+			{
+				cmd.arguments().pop_front();
+				params.export_features = true;
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_EXPORT_PROBABILITIES))
+			{
+				cmd.arguments().pop_front();
+				params.export_probabilities = true;
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_TILE_SIZE))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.tile_size = cmd.arguments().takeFirst().toDouble(&ok);
+				if (!ok || params.tile_size <= 0)
+				{
+					return cmd.error(QString("Invalid parameter: tile size after '%1'").arg(COMMAND_RFC_TILE_SIZE));
+				}
+				cmd.print(QString("Tile size: %1").arg(params.tile_size));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_TILE_HALO))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.tile_halo = cmd.arguments().takeFirst().toDouble(&ok);
+				if (!ok || params.tile_halo < 0)
+				{
+					return cmd.error(QString("Invalid parameter: tile halo after '%1'").arg(COMMAND_RFC_TILE_HALO));
+				}
+				cmd.print(QString("Tile halo: %1").arg(params.tile_halo));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_SUBSAMPLE))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.subsampling_distance = cmd.arguments().takeFirst().toDouble(&ok);
+				if (!ok || params.subsampling_distance <= 0)
+				{
+					return cmd.error(QString("Invalid parameter: subsampling distance after '%1'").arg(COMMAND_RFC_SUBSAMPLE));
+				}
+				cmd.print(QString("Subsampling distance: %1").arg(params.subsampling_distance));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_TRANSFER_NEIGHBORS))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.transfer_neighbors = cmd.arguments().takeFirst().toInt(&ok);
+				if (!ok || params.transfer_neighbors < 1)
+				{
+					return cmd.error(QString("Invalid parameter: number of neighbors after '%1'").arg(COMMAND_RFC_TRANSFER_NEIGHBORS));
+				}
+				cmd.print(QString("Label transfer neighbors: %1").arg(params.transfer_neighbors));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_REG_NEIGHBORS))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.reg_neighbors = cmd.arguments().takeFirst().toInt(&ok);
+				if (!ok || params.reg_neighbors < 1)
+				{
+					return cmd.error(QString("Invalid parameter: number of neighbors after '%1'").arg(COMMAND_RFC_REG_NEIGHBORS));
+				}
+				cmd.print(QString("Regularization neighbors: %1").arg(params.reg_neighbors));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_GRAPH_CUT_STRENGTH))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.graphcut_strength = cmd.arguments().takeFirst().toFloat(&ok);
+				if (!ok || params.graphcut_strength < 0)
+				{
+					return cmd.error(QString("Invalid parameter: graph cut strength after '%1'").arg(COMMAND_RFC_GRAPH_CUT_STRENGTH));
+				}
+				cmd.print(QString("Graph cut strength: %1").arg(params.graphcut_strength));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_GRAPH_CUT_SUBDIVISIONS))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.graphcut_subdivisions = cmd.arguments().takeFirst().toInt(&ok);
+				if (!ok || params.graphcut_subdivisions < 0)
+				{
+					return cmd.error(QString("Invalid parameter: number of graph cut subdivisions after '%1'").arg(COMMAND_RFC_GRAPH_CUT_SUBDIVISIONS));
+				}
+				cmd.print(QString("Graph cut subdivisions: %1").arg(params.graphcut_subdivisions));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_GRAPH_CUT_MEMORY))
+			{
+				cmd.arguments().pop_front();
+				bool ok = false;
+				if (!cmd.arguments().empty())
+					params.graphcut_memory_budget = cmd.arguments().takeFirst().toDouble(&ok);
+				if (!ok || params.graphcut_memory_budget < 0)
+				{
+					return cmd.error(QString("Invalid parameter: graph cut memory budget (MB) after '%1'").arg(COMMAND_RFC_GRAPH_CUT_MEMORY));
+				}
+				cmd.print(QString("Graph cut memory budget: %1 MB").arg(params.graphcut_memory_budget));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RFC_EVAL_SF))
+			{
+				cmd.arguments().pop_front();
+				if (cmd.arguments().empty())
+				{
+					return cmd.error(QString("Missing parameter: evaluation scalar field name after '%1'").arg(COMMAND_RFC_EVAL_SF));
+				}
+				evalSFName = cmd.arguments().takeFirst();
+			}
+			else
+			{
+				//we assume the parameter is the classifier filename
+				classifierFilename = argument;
+				cmd.arguments().pop_front();
+				break;
+			}
+		}
+
+		if (classifierFilename.isEmpty())
+		{
+			return cmd.error("Classifier filename not set");
+		}
+		if (!QFileInfo(classifierFilename).isFile())
+		{
+			return cmd.error(QString("Classifier file '%1' does not exist").arg(classifierFilename));
+		}
+
+		if (cmd.clouds().empty())
+		{
+			return cmd.error("At least one cloud must be loaded");
+		}
+
+		params.nscales = options.nscales;
+		params.min_scale = options.min_scale;
+		params.classes_list = options.classes_list;
+		params.feature_cache_dir = options.feature_cache_dir;
+
+		Classifier classifier; //no main application: no dialogs
+		for (size_t i = 0; i < cmd.clouds().size(); ++i)
+		{
+			CLCloudDesc& desc = cmd.clouds()[i];
+			params.profile_path = options.getProfilePath(i, cmd.clouds().size());
+			if (!options.getFeatures(cmd, desc.pc, params.eval_features))
+			{
+				return false;
+			}
+
+			params.labels = nullptr;
+			if (!evalSFName.isEmpty())
+			{
+				params.labels = GetRFCScalarField(desc.pc, evalSFName);
+				if (!params.labels)
+				{
+					return cmd.error(QString("Cloud '%1' has no scalar field named '%2'").arg(desc.pc->getName(), evalSFName));
+				}
+			}
+
+			ClassificationOutput output;
+			bool success = classifier.classify(desc.pc, classifierFilename, output, params);
+			if (!ApplyRFCResults(cmd, desc, success, output))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
+
+struct CommandRFCMerge : public ccCommandLineInterface::Command
+{
+	CommandRFCMerge() : ccCommandLineInterface::Command("RFC Merge", COMMAND_RFC_MERGE) {}
+
+	virtual bool process(ccCommandLineInterface& cmd) override
+	{
+		cmd.print("[RFC]");
+
+		//output file followed by the classifier files to merge
+		QStringList filenames;
+		while (!cmd.arguments().empty() && !cmd.arguments().front().startsWith('-'))
+		{
+			filenames << cmd.arguments().takeFirst();
+		}
+		if (filenames.size() < 3)
+		{
+			return cmd.error(QString("Missing parameter: output filename (.bin) and at least 2 classifier files after \"-%1\"").arg(COMMAND_RFC_MERGE));
+		}
+		QString outputPath = filenames.takeFirst();
+
+		ModelBundle merged;
+		QString errorMessage;
+		if (!ModelBundle::Merge(filenames, merged, errorMessage) || !merged.save(outputPath, errorMessage))
+		{
+			return cmd.error(errorMessage);
+		}
+
+		Classifier classifier; //no main application: no dialogs
+		for (const QString& line : classifier.readETHZRandomForestClassifierData(outputPath))
+		{
+			cmd.print(line);
+		}
+		cmd.print(QString("Classifier saved to '%1'").arg(outputPath));
+
+		return true;
+	}
+};
+
+#endif //Q_RFC_PLUGIN_COMMANDS_HEADER
@@ -0,0 +1,118 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_JOB_RUNNER_HEADER
+#define Q_RFC_JOB_RUNNER_HEADER
+
+//CCCoreLib
+#include <GenericProgressCallback.h>
+
+//Qt
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+//system
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+
+class QProgressDialog;
+class ccMainAppInterface;
+
+//! Thread-safe progress callback (updated by a background job, read by the GUI thread)
+class qRFCJobProgress : public CCCoreLib::GenericProgressCallback
+{
+public:
+	qRFCJobProgress();
+
+	// Inherited from GenericProgressCallback
+	void update(float percent) override;
+	void setMethodTitle(const char* methodTitle) override;
+	void setInfo(const char* infoStr) override;
+	void start() override {}
+	void stop() override {}
+	bool isCancelRequested() override { return m_canceled; }
+
+	//! Requests the job to stop (as soon as possible)
+	void cancel() { m_canceled = true; }
+	//! Returns the current state of the job
+	void get(QString& title, QString& info, int& percent);
+
+protected:
+	std::atomic<int> m_percent;
+	std::atomic<bool> m_canceled;
+	QMutex m_mutex;
+	QString m_title;
+	QString m_info;
+};
+
+//! Runs the training and classification jobs in the background (one at a time)
+/** The jobs are queued and run in a worker thread, while a non-modal progress dialog displays the
+	progress of the current job (and lets the user cancel it). The job results must be applied to the
+	entities of the DB tree in the 'finished' function, which is called in the GUI thread.
+**/
+class qRFCJobRunner : public QObject
+{
+	Q_OBJECT
+
+public:
+	//! Background job
+	struct Job
+	{
+		//! Job title (displayed in the progress dialog)
+		QString title;
+		//! Runs the job (in the worker thread), returns whether it succeeded
+		std::function<bool(CCCoreLib::GenericProgressCallback*)> run;
+		//! Called in the GUI thread once the job is done (optional)
+		std::function<void(bool success, bool canceled)> finished;
+	};
+
+	//! Default constructor
+	explicit qRFCJobRunner(ccMainAppInterface* app, QObject* parent = nullptr);
+	//! Destructor (cancels the queued jobs and waits for the current one)
+	~qRFCJobRunner() override;
+
+	//! Adds a job to the queue (it is started right away if no other job is running)
+	void enqueue(const Job& job);
+	//! Returns the number of jobs (running or queued)
+	std::size_t jobCount() const { return m_queue.size() + (m_running ? 1 : 0); }
+	//! Cancels the current job and the queued ones
+	void cancelAll();
+
+protected:
+	//! Starts the next queued job
+	void startNext();
+	//! Called once the current job is done
+	void onJobFinished();
+	//! Updates the progress dialog
+	void refreshProgress();
+
+	ccMainAppInterface* m_app;
+	std::deque<Job> m_queue;
+	Job m_current;
+	bool m_running;
+	std::unique_ptr<qRFCJobProgress> m_progress;
+	QFutureWatcher<bool> m_watcher;
+	QTimer m_timer;
+	QProgressDialog* m_progressDlg;
+};
+
+#endif //Q_RFC_JOB_RUNNER_HEADER
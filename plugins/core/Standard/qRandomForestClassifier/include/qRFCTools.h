@@ -19,6 +19,8 @@
 #define Q_RFC_TOOLS_HEADER
 
 //system
+#include <map>
+#include <string>
 #include <vector>
 
 //qCC_db
@@ -37,6 +39,7 @@ class ccPointCloud;
 class ccHObject;
 class ccMainAppInterface;
 class ccScalarField;
+class ClassificationOutput;
 
 namespace CCCoreLib {
 	class GenericProgressCallback;
@@ -67,6 +70,25 @@ public:
 
 	// Determine whether a scalar field is a list of integers
 	static bool validScalarField(CCCoreLib::ScalarField* SF);
+
+	//! Transfers the labels computed on a subsampled cloud to all the points of the full cloud
+	/** Each point gets the majority label of its k nearest neighbors in the subsampled cloud (the label
+		of the nearest one on ties), and the probabilities and feature values of its nearest neighbor.
+		\param sampledCloud subsampled cloud (its octree is computed if necessary)
+		\param sampledOutput classification output of the subsampled cloud
+		\param cloud full cloud
+		\param output classification output of the full cloud (already initialized)
+		\param k number of neighbors of the majority vote
+		\param votes whether the ratio of the neighbors that have the selected label is exported (as the "Label votes" feature)
+		\return false if the octree couldn't be computed or the process was canceled
+	**/
+	static bool TransferLabels(	ccPointCloud* sampledCloud,
+								const ClassificationOutput& sampledOutput,
+								ccPointCloud* cloud,
+								ClassificationOutput& output,
+								unsigned k,
+								bool votes = false,
+								CCCoreLib::GenericProgressCallback* progressCb = nullptr);
 };
 
 #endif //Q_RFC_TOOLS_HEADER
@@ -63,11 +63,19 @@ public:
 	double getMinScale() const;
 	//! Returns the number of scales
 	int getNScale() const;
+	//! Returns whether the neighborhoods are searched with an octree
+	bool getOctreeNeighborhoods() const;
 	//! Returns the number of scales
 	int getNClasses() const;
 	std::vector<int> getClassIndices() const;
 	//! Returns the max number of core points to use
 	int getMaxCorePoints() const;
+	//! Returns whether the core points are shared equally between the classes
+	bool getBalanceClasses() const;
+	//! Returns the voxel size of the spatial sampling of the core points (disabled if 0)
+	double getSamplingVoxelSize() const;
+	//! Returns the seed of the core points sampling
+	unsigned getSeed() const;
 	//! Returns whether the features should be outputted for the user
 	bool getEvaluateParams() const;
 	//! Returns the number of trees
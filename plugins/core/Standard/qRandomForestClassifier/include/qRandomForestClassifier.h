@@ -19,6 +19,8 @@
 
 #include "ccStdPluginInterface.h"
 
+class qRFCJobRunner;
+
 //! Random Forest Classification Plugin
 class qRFC : public QObject, public ccStdPluginInterface
 {
@@ -33,16 +35,22 @@ public:
 	// Inherited from ccStdPluginInterface
 	void onNewSelection( const ccHObject::Container &selectedEntities ) override;
 	QList<QAction *> getActions() override;
+	void registerCommands(ccCommandLineInterface* cmd) override;
 
 protected:
 	//! Perform point cloud classification given a trained classifier
 	void doClassifyAction();
 	//! Train point cloud classifier
 	void doTrainAction();
+	//! Returns the background job runner (created on first call)
+	qRFCJobRunner* jobRunner();
 
 	QAction* m_classifyAction;
 	QAction* m_trainAction;
 
 	//! Currently selected entities;
 	ccHObject::Container m_selectedEntities;
+
+	//! Background jobs (training and classification)
+	qRFCJobRunner* m_jobRunner;
 };
@@ -0,0 +1,256 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "Benchmark.h"
+
+#include "Classifier.h"
+
+//Qt
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+
+//system
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <memory>
+
+//TBB
+#ifdef CGAL_LINKED_WITH_TBB
+#include <tbb/global_control.h>
+#endif
+
+namespace
+{
+	//! Limits the number of threads of the parallel algorithms (CGAL/TBB and Qt) during its lifetime
+	class ThreadLimit
+	{
+	public:
+		explicit ThreadLimit(int threads)
+			: m_previous(QThreadPool::globalInstance()->maxThreadCount())
+#ifdef CGAL_LINKED_WITH_TBB
+			, m_control(tbb::global_control::max_allowed_parallelism, static_cast<std::size_t>(threads))
+#endif
+		{
+			QThreadPool::globalInstance()->setMaxThreadCount(threads);
+		}
+
+		~ThreadLimit()
+		{
+			QThreadPool::globalInstance()->setMaxThreadCount(m_previous);
+		}
+
+	protected:
+		int m_previous;
+#ifdef CGAL_LINKED_WITH_TBB
+		tbb::global_control m_control;
+#endif
+	};
+
+	//! Wall and CPU times of a step
+	struct Times
+	{
+		double wall = 0;
+		double cpu = 0;
+	};
+
+	//! Returns the total times of the feature stages of a profile
+	Times FeatureTimes(const StageProfiler& profiler)
+	{
+		Times times;
+		for (const StageProfiler::Stage& stage : profiler.stages())
+		{
+			// the structures of each scale (pruned generator) are computed within the 'features: point' stage
+			if (stage.name.compare(0, 10, "features: ") != 0 || (stage.name.compare(0, 16, "features: scale ") == 0 && stage.name != "features: scale structures"))
+				continue;
+			times.wall += stage.wallTime;
+			times.cpu += stage.cpuTime;
+		}
+		return times;
+	}
+
+	//! Returns the times of a stage of a profile
+	Times StageTimes(const StageProfiler& profiler, const std::string& name)
+	{
+		Times times;
+		for (const StageProfiler::Stage& stage : profiler.stages())
+		{
+			if (stage.name == name)
+			{
+				times.wall += stage.wallTime;
+				times.cpu += stage.cpuTime;
+			}
+		}
+		return times;
+	}
+}
+
+bool Benchmark::run(const Settings& settings, std::vector<Result>& results, QString& errorMessage)
+{
+	results.clear();
+
+	std::vector<int> threads = settings.threads;
+	if (threads.empty())
+	{
+		threads.push_back(1);
+		if (QThread::idealThreadCount() > 1)
+			threads.push_back(QThread::idealThreadCount());
+	}
+	std::sort(threads.begin(), threads.end());
+	threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+
+	QTemporaryDir tempDir;
+	if (!tempDir.isValid())
+	{
+		errorMessage = "Failed to create a temporary directory (classifier files)";
+		return false;
+	}
+	const QString classifierPath = tempDir.filePath("benchmark.bin");
+
+	Classifier::TrainParams trainParams;
+	trainParams.classes_list = SyntheticCloud::Classes(settings.layout);
+	trainParams.nscales = settings.nscales;
+	trainParams.min_scale = settings.min_scale;
+	trainParams.octree_neighborhoods = settings.octree_neighborhoods;
+	trainParams.num_trees = settings.num_trees;
+	trainParams.max_depth = settings.max_depth;
+	trainParams.max_core_points = settings.max_core_points;
+	trainParams.seed = settings.seed;
+	trainParams.features = { { Features::Source::CGAL_GENERATED_FEATURE, nullptr } };
+	trainParams.output_path = classifierPath;
+
+	Classifier::ClassifyParams classifyParams;
+	classifyParams.classes_list = trainParams.classes_list;
+	classifyParams.nscales = settings.nscales;
+	classifyParams.min_scale = settings.min_scale;
+	classifyParams.eval_features = trainParams.features;
+
+	for (std::size_t size : settings.sizes)
+	{
+		std::unique_ptr<ccPointCloud> cloud(SyntheticCloud::Generate(size, settings.layout, settings.seed, errorMessage));
+		if (!cloud)
+		{
+			return false;
+		}
+		ccScalarField* groundTruth = static_cast<ccScalarField*>(cloud->getScalarField(cloud->getScalarFieldIndexByName("Classification")));
+
+		ClassificationOutput output;
+		std::size_t firstResult = results.size();
+		for (int threadCount : threads)
+		{
+			ThreadLimit limit(threadCount);
+			std::cout << "[benchmark] " << size << " points, " << threadCount << " thread(s)" << std::endl;
+
+			Classifier classifier; //no main application: no dialogs
+			if (classifier.train(cloud.get(), groundTruth, trainParams).isEmpty())
+			{
+				errorMessage = QString("Failed to train the classifier (%1 points)").arg(size);
+				return false;
+			}
+			const StageProfiler& profiler = classifier.profiler();
+			Times conversion = StageTimes(profiler, "conversion");
+			Times trainFeatures = FeatureTimes(profiler);
+			Times training{ profiler.wallTime() - conversion.wall - trainFeatures.wall, profiler.cpuTime() - conversion.cpu - trainFeatures.cpu };
+
+			if (!classifier.classify(cloud.get(), classifierPath, output, classifyParams))
+			{
+				errorMessage = QString("Failed to classify the cloud (%1 points)").arg(size);
+				return false;
+			}
+			Times features = FeatureTimes(profiler);
+			Times classification{ profiler.wallTime() - features.wall, profiler.cpuTime() - features.cpu };
+
+			std::size_t correct = 0;
+			for (unsigned i = 0; i < cloud->size(); ++i)
+			{
+				if (output.labels()->getValue(i) == groundTruth->getValue(i))
+					++correct;
+			}
+			const float accuracy = static_cast<float>(correct) / std::max<std::size_t>(1, cloud->size());
+
+			for (const auto& step : std::vector<std::pair<std::string, Times>>{ { "conversion", conversion }, { "features", features }, { "training", training }, { "classification", classification } })
+			{
+				Result result;
+				result.points = size;
+				result.threads = threadCount;
+				result.step = step.first;
+				result.wallTime = step.second.wall;
+				result.cpuTime = step.second.cpu;
+				result.pointsPerSecond = (result.wallTime > 0 ? size / result.wallTime : 0);
+				result.accuracy = accuracy;
+				results.push_back(result);
+			}
+		}
+
+		// scaling efficiency (with respect to the smallest thread count)
+		std::map<std::string, const Result*> reference;
+		for (std::size_t i = firstResult; i < results.size(); ++i)
+		{
+			Result& result = results[i];
+			if (reference.find(result.step) == reference.end())
+				reference[result.step] = &result;
+			const Result& base = *reference[result.step];
+			if (result.wallTime > 0)
+				result.efficiency = (base.wallTime * base.threads) / (result.wallTime * result.threads);
+		}
+	}
+
+	return true;
+}
+
+QStringList Benchmark::Report(const std::vector<Result>& results)
+{
+	QStringList report;
+	report << "Points | Threads | Step | Wall time (s) | CPU time (s) | Points/s | Scaling efficiency | Accuracy";
+	for (const Result& result : results)
+	{
+		report << QString("%1 | %2 | %3 | %4 | %5 | %6 | %7 | %8")
+			.arg(result.points)
+			.arg(result.threads)
+			.arg(QString::fromStdString(result.step))
+			.arg(result.wallTime, 0, 'f', 3)
+			.arg(result.cpuTime, 0, 'f', 3)
+			.arg(result.pointsPerSecond, 0, 'f', 0)
+			.arg(result.efficiency, 0, 'f', 2)
+			.arg(result.accuracy, 0, 'f', 3);
+	}
+	return report;
+}
+
+bool Benchmark::SaveCSV(const QString& filename, const std::vector<Result>& results, QString& errorMessage)
+{
+	QFile file(filename);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+	{
+		errorMessage = QString("Failed to open file [%1] for writing").arg(filename);
+		return false;
+	}
+
+	QTextStream stream(&file);
+	stream << "points,threads,step,wall_time,cpu_time,points_per_second,efficiency,accuracy\n";
+	for (const Result& result : results)
+	{
+		stream << result.points << "," << result.threads << "," << QString::fromStdString(result.step) << ","
+			<< result.wallTime << "," << result.cpuTime << "," << result.pointsPerSecond << ","
+			<< result.efficiency << "," << result.accuracy << "\n";
+	}
+
+	return true;
+}
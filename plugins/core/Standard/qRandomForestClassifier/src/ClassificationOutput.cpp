@@ -0,0 +1,184 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "ClassificationOutput.h"
+
+//qCC_db
+#include <ccPointCloud.h>
+#include <ccScalarField.h>
+
+//system
+#include <cassert>
+
+//! Returns a scalar field name not used by the cloud (empty if none is found)
+static std::string UniqueName(ccPointCloud* cloud, const std::string& name)
+{
+	if (cloud->getScalarFieldIndexByName(name.c_str()) == -1)
+	{
+		return name;
+	}
+	for (size_t i = 0; i < 256; ++i)
+	{
+		std::string candidate = name + " " + std::to_string(i);
+		if (cloud->getScalarFieldIndexByName(candidate.c_str()) == -1)
+		{
+			return candidate;
+		}
+	}
+	return std::string();
+}
+
+ClassificationOutput::ClassificationOutput()
+	: m_pointCount(0)
+	, m_labels(nullptr)
+	, m_confidence(nullptr)
+{
+}
+
+ClassificationOutput::~ClassificationOutput()
+{
+	clear();
+}
+
+void ClassificationOutput::clear()
+{
+	if (m_labels)
+		m_labels->release();
+	for (ccScalarField* sf : m_probabilities)
+		sf->release();
+	if (m_confidence)
+		m_confidence->release();
+	for (auto& feature : m_features)
+		feature.second->release();
+
+	m_pointCount = 0;
+	m_classNames.clear();
+	m_labels = nullptr;
+	m_probabilities.clear();
+	m_confidence = nullptr;
+	m_features.clear();
+}
+
+ccScalarField* ClassificationOutput::allocate(const std::string& name, float value) const
+{
+	ccScalarField* sf = new ccScalarField(name.c_str());
+	if (!sf->resizeSafe(m_pointCount, true, value))
+	{
+		sf->release();
+		return nullptr;
+	}
+	return sf;
+}
+
+bool ClassificationOutput::init(unsigned pointCount, const std::vector<std::string>& classNames, bool probabilities, QString& errorMessage)
+{
+	clear();
+	m_pointCount = pointCount;
+	m_classNames = classNames;
+
+	m_labels = allocate("Classification", -1.f);
+	bool success = (m_labels != nullptr);
+	if (success && probabilities)
+	{
+		for (const std::string& name : classNames)
+		{
+			ccScalarField* sf = allocate("Probability " + name, CCCoreLib::NAN_VALUE);
+			if (!sf)
+			{
+				success = false;
+				break;
+			}
+			m_probabilities.push_back(sf);
+		}
+		m_confidence = success ? allocate("Confidence", CCCoreLib::NAN_VALUE) : nullptr;
+		success = (m_confidence != nullptr);
+	}
+
+	if (!success)
+	{
+		clear();
+		errorMessage = "Not enough memory to store classification output.";
+		return false;
+	}
+	return true;
+}
+
+ccScalarField* ClassificationOutput::feature(const std::string& name)
+{
+	for (auto& feature : m_features)
+	{
+		if (feature.first == name)
+			return feature.second;
+	}
+
+	ccScalarField* sf = allocate(name, CCCoreLib::NAN_VALUE);
+	if (sf)
+		m_features.push_back({ name, sf });
+	return sf;
+}
+
+int ClassificationOutput::attach(ccPointCloud* cloud, QString& errorMessage)
+{
+	assert(cloud);
+	if (!m_labels || m_pointCount != cloud->size())
+	{
+		errorMessage = "Classification output size does not match point cloud size.";
+		return -1;
+	}
+
+	std::string labelName = UniqueName(cloud, m_labels->getName());
+	if (labelName.empty())
+	{
+		errorMessage = "Name 'Classification' scalar field already exists.";
+		return -1;
+	}
+
+	std::vector<ccScalarField*> fields = { m_labels };
+	fields.insert(fields.end(), m_probabilities.begin(), m_probabilities.end());
+	if (m_confidence)
+		fields.push_back(m_confidence);
+	for (auto& feature : m_features)
+		fields.push_back(feature.second);
+
+	int labelIndex = -1;
+	for (ccScalarField* sf : fields)
+	{
+		std::string name = UniqueName(cloud, sf->getName());
+		if (!name.empty())
+			sf->setName(name.c_str());
+		sf->computeMinAndMax();
+		int idx = cloud->addScalarField(sf);
+		if (idx < 0)
+		{
+			errorMessage = "Not enough memory to store classification output.";
+			sf->release();
+		}
+		else if (sf == m_labels)
+		{
+			labelIndex = idx;
+		}
+	}
+
+	// the fields now belong to the cloud
+	m_labels = nullptr;
+	m_probabilities.clear();
+	m_confidence = nullptr;
+	m_features.clear();
+	m_pointCount = 0;
+
+	return labelIndex;
+}
@@ -16,793 +16,1305 @@
 //##########################################################################
 
 #include "Classifier.h"
+#include "FeatureCache.h"
+#include "FlatForest.h"
+#include "ForestEvaluator.h"
+#include "ForestTrainer.h"
+#include "KNeighborGraph.h"
+#include "ModelBundle.h"
+#include "PrunedFeatureGenerator.h"
+#include "TrainingSampler.h"
+#include "qRFCTools.h"
+
+//CCCoreLib
+#include <CloudSamplingTools.h>
 
 //qCC_db
 #include <ccProgressDialog.h>
 
+//CGAL
+#include <CGAL/for_each.h>
+
 //Qt
 #include <QSettings>
 #include <QFileDialog>
+#include <QMutex>
 #include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 
 //system
-#include <random>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <sstream>
+
+Classifier::Classifier(ccMainAppInterface* app) : m_app(app), m_progressCallback(nullptr) {}
+
+CCCoreLib::GenericProgressCallback* Classifier::startProgress(const char* info, const char* iconPath) {
+	CCCoreLib::GenericProgressCallback* progressCb = m_progressCallback;
+	if (progressCb == nullptr && m_app) {
+		ccProgressDialog* progressDlg = new ccProgressDialog(true, (QWidget*)m_app->getMainWindow());
+		progressDlg->setWindowIcon(QIcon(iconPath));
+		progressDlg->reset();
+		progressCb = progressDlg;
+	}
+	if (progressCb) {
+		progressCb->setInfo(info);
+		progressCb->setMethodTitle("Classification");
+		progressCb->start();
+	}
+	return progressCb;
+}
+
+bool Classifier::isCanceled() const {
+	return m_progressCallback && m_progressCallback->isCancelRequested();
+}
 
-Classifier::Classifier(ccMainAppInterface* app) : m_app(app) {}
+void Classifier::reportProfile(const QString& operation, const QString& filename) {
+	QByteArray json = m_profiler.toJson(operation, true);
+	std::cout << "[profile] " << json.constData() << std::endl;
+	dispToConsole("[qRandomForestClassifier] profile: " + QString::fromUtf8(json));
+
+	if (!filename.isEmpty()) {
+		QString errorMessage;
+		if (!m_profiler.save(filename, operation, errorMessage)) {
+			std::cerr << errorMessage.toStdString() << std::endl;
+			dispToConsole(errorMessage, ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+		}
+	}
+}
+
+Feature_pruning::Feature_pruning() {}
+Feature_pruning::~Feature_pruning() {}
 
 QStringList Classifier::readETHZRandomForestClassifierData(QString classifierFilePath) {
 	assert(classifierFilePath.size() > 0);
 	assert(QFileInfo(classifierFilePath).exists());
 
 	CGAL::internal::liblearning::RandomForest::ForestParams forestParams;
-	typedef CGAL::internal::liblearning::RandomForest::RandomForest
-		< CGAL::internal::liblearning::RandomForest::NodeGini
-		< CGAL::internal::liblearning::RandomForest::AxisAlignedSplitter> > Forest;
-	std::shared_ptr<Forest> rfc = std::make_shared<Forest>(forestParams);
+	std::shared_ptr<ModelBundle::Forest> rfc = std::make_shared<ModelBundle::Forest>(forestParams);
 
 	QStringList fileDesc;
 
-	std::ifstream input(classifierFilePath.toStdString(), std::ios_base::binary);
-	if (!input) {
-		if (m_app)
-			m_app->dispToConsole(QString("Failed to open file [%1]").arg(classifierFilePath), ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+	ModelBundle model;
+	QString errorMessage;
+	if (!model.load(classifierFilePath, errorMessage)) {
+		dispToConsole(errorMessage, ccMainAppInterface::ERR_CONSOLE_MESSAGE);
 		return fileDesc;
 	}
-	rfc->read(input);
-	input.close();
+	model.readForest(*rfc);
 
 	fileDesc << QString("No. of classes: %1").arg(rfc->params.n_classes);
 	fileDesc << QString("No. of features: %1").arg(rfc->params.n_features);
 	fileDesc <<			"====================";
 	fileDesc << QString("No. of samples: %1").arg(rfc->params.n_samples);
-	fileDesc << QString("No. of trees: %1").arg(rfc->params.n_trees);
+	// the trees may have been trained by chunks or added to an existing forest (n_trees is the number of trees added by the last training)
+	fileDesc << QString("No. of trees: %1").arg(rfc->trees.size());
 	fileDesc << QString("No. of in-bag-samples: %1").arg(rfc->params.n_in_bag_samples);
 	fileDesc << QString("Min. no. of samples per node: %1").arg(rfc->params.min_samples_per_node);
 	fileDesc << QString("Max depth: %1").arg(rfc->params.max_depth);
 	fileDesc << QString("Sample reduction: %1").arg(rfc->params.sample_reduction);
 
+	fileDesc << "====================";
+	fileDesc << model.description();
+
 	return fileDesc;
 }
 
-std::pair<std::vector<int>, std::map<std::string, std::vector<float>>> Classifier::classify(ccPointCloud* cloud, QString classifierFilePath, const ClassifyParams& params) {
-	assert(classifierFilePath.size() > 0);
-	assert(QFileInfo(classifierFilePath).exists());
+//! Tile of a cloud: core points (first) followed by halo points
+struct Tile
+{
+	std::vector<unsigned> indices;
+	std::size_t coreCount = 0;
+};
+
+//! Regular XY grid of tiles over a cloud
+class TileGrid
+{
+public:
+	TileGrid(ccPointCloud* cloud, double tileSize, double halo)
+		: m_cloud(cloud)
+		, m_tileSize(tileSize)
+		, m_halo(halo)
+	{
+		m_cloud->getBoundingBox(m_minCorner, m_maxCorner);
+		m_nx = std::max(1u, static_cast<unsigned>(std::ceil((m_maxCorner.x - m_minCorner.x) / tileSize)));
+		m_ny = std::max(1u, static_cast<unsigned>(std::ceil((m_maxCorner.y - m_minCorner.y) / tileSize)));
+
+		// sort the points by tile (counting sort)
+		std::vector<unsigned> cellIndexes(m_cloud->size());
+		m_cellStart.assign(static_cast<size_t>(m_nx) * m_ny + 1, 0);
+		for (unsigned i = 0; i < m_cloud->size(); ++i) {
+			const CCVector3* P = m_cloud->getPoint(i);
+			cellIndexes[i] = cell(xIndex(P->x), yIndex(P->y));
+			++m_cellStart[cellIndexes[i] + 1];
+		}
+		for (size_t c = 1; c < m_cellStart.size(); ++c) {
+			m_cellStart[c] += m_cellStart[c - 1];
+		}
+		m_sorted.resize(m_cloud->size());
+		std::vector<unsigned> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+		for (unsigned i = 0; i < m_cloud->size(); ++i) {
+			m_sorted[fill[cellIndexes[i]]++] = i;
+		}
+	}
 
-	ccProgressDialog* progressDlg = nullptr;
-	CCCoreLib::NormalizedProgress* nProgress = nullptr;
-	if (m_app) {
-		progressDlg = new ccProgressDialog(true, (QWidget*) m_app->getMainWindow());
-		progressDlg->setWindowIcon(QIcon(":/CC/plugin/qRandomForestClassifier/images/icon_classify.png"));
-		progressDlg->reset();
-		progressDlg->setInfo("Converting point clouds");
-		progressDlg->setMethodTitle("Classification");
-		if (nProgress == nullptr)
-			nProgress = new CCCoreLib::NormalizedProgress(&(*progressDlg), 6);
-		progressDlg->start();
+	unsigned count() const { return m_nx * m_ny; }
+	//! Returns the number of core points of a tile
+	unsigned coreCount(unsigned index) const { return m_cellStart[index + 1] - m_cellStart[index]; }
+
+	//! Extracts a tile (core points + halo)
+	void getTile(unsigned index, Tile& tile) const {
+		tile.indices.clear();
+		tile.indices.insert(tile.indices.end(), m_sorted.begin() + m_cellStart[index], m_sorted.begin() + m_cellStart[index + 1]);
+		tile.coreCount = tile.indices.size();
+		if (tile.coreCount == 0 || m_halo <= 0)
+			return;
+
+		unsigned ix = index % m_nx;
+		unsigned iy = index / m_nx;
+		double minX = m_minCorner.x + ix * m_tileSize - m_halo;
+		double maxX = m_minCorner.x + (ix + 1) * m_tileSize + m_halo;
+		double minY = m_minCorner.y + iy * m_tileSize - m_halo;
+		double maxY = m_minCorner.y + (iy + 1) * m_tileSize + m_halo;
+		unsigned x0 = xIndex(minX), x1 = xIndex(maxX);
+		unsigned y0 = yIndex(minY), y1 = yIndex(maxY);
+		for (unsigned y = y0; y <= y1; ++y) {
+			for (unsigned x = x0; x <= x1; ++x) {
+				unsigned c = cell(x, y);
+				if (c == index)
+					continue;
+				for (unsigned k = m_cellStart[c]; k < m_cellStart[c + 1]; ++k) {
+					const CCVector3* P = m_cloud->getPoint(m_sorted[k]);
+					if (P->x >= minX && P->x <= maxX && P->y >= minY && P->y <= maxY)
+						tile.indices.push_back(m_sorted[k]);
+				}
+			}
+		}
 	}
 
-	std::vector<Point> points;
-	points.reserve(cloud->size());
-	for (unsigned i = 0; i < cloud->size(); ++i) {
-		const auto pt_cc = cloud->getPoint(i)->toDouble();
-		double x = pt_cc[0];
-		double y = pt_cc[1];
-		double z = pt_cc[2];
-		points.push_back(Point(x, y, z));
+protected:
+	unsigned xIndex(double x) const { return std::min(m_nx - 1, static_cast<unsigned>(std::max(0.0, (x - m_minCorner.x) / m_tileSize))); }
+	unsigned yIndex(double y) const { return std::min(m_ny - 1, static_cast<unsigned>(std::max(0.0, (y - m_minCorner.y) / m_tileSize))); }
+	unsigned cell(unsigned x, unsigned y) const { return y * m_nx + x; }
+
+	ccPointCloud* m_cloud;
+	double m_tileSize;
+	double m_halo;
+	CCVector3 m_minCorner, m_maxCorner;
+	unsigned m_nx = 1, m_ny = 1;
+	std::vector<unsigned> m_cellStart;
+	std::vector<unsigned> m_sorted;
+};
+
+//! Estimates the min. scale of a tiled cloud (same estimation as Point_set_feature_generator: mean range of the 12 nearest neighbors)
+/** Only the core points of the most populated tile are used (so that the memory stays bounded by the tile size).
+**/
+static double EstimateMinScale(ccPointCloud* cloud, double tileSize) {
+	TileGrid grid(cloud, tileSize, 0);
+	unsigned largest = 0;
+	for (unsigned i = 1; i < grid.count(); ++i) {
+		if (grid.coreCount(i) > grid.coreCount(largest))
+			largest = i;
 	}
+	Tile tile;
+	grid.getTile(largest, tile);
+
+	Cloud_view view(cloud, &tile.indices);
+	Index_range input = view.range();
+	Neighborhood neighborhood(input, CC_point_map{ view });
+	Classification::Local_eigen_analysis eigen = Classification::Local_eigen_analysis::create_from_point_set
+		(input, CC_point_map{ view }, neighborhood.k_neighbor_query(12), CGAL::Parallel_if_available_tag());
+	return eigen.mean_range();
+}
 
-	Point_set pts;
-	std::copy(points.begin(), points.end(), pts.point_back_inserter());
-	std::cout << "number of points = " << pts.number_of_points() << std::endl;
+bool Classifier::classify(ccPointCloud* cloud, QString classifierFilePath, ClassificationOutput& output, const ClassifyParams& inputParams) {
+	assert(classifierFilePath.size() > 0);
+	assert(QFileInfo(classifierFilePath).exists());
 
-	if (nProgress && !nProgress->oneStep()) {
-		return {};
-	}
-	if (progressDlg)
-		progressDlg->setInfo("Computing features");
-	Feature_set features;
+	m_profiler.clear();
+	output.clear();
 
-	std::cerr << "Generating features" << std::endl;
-	CGAL::Real_timer t;
-	t.start();
-	Feature_generator generator(pts, pts.point_map(), params.nscales);
-	features.begin_parallel_additions();
-	for (const auto& feature : params.eval_features) {
-		Features::Source source = feature.first;
-		if (source == Features::Source::CGAL_GENERATED_FEATURE) {
-			//if (type == Features::Type::POINTFEATURES)
-			generator.generate_point_based_features(features);
+	// read the classifier once (it is loaded for each tile in tiled mode)
+	ModelBundle model;
+	QString errorMessage;
+	if (!model.load(classifierFilePath, errorMessage)) {
+		std::cerr << errorMessage.toStdString() << std::endl;
+		dispToConsole(errorMessage, ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		return false;
+	}
 
-			// bool point_features_generated = false;
-			//for (const auto& feature : params.features) {
-			//	Features::Type type = feature.third;
-			//  if (type== Features::Type::POINTFEATURES) point_features_generated = true;
-			//}
-			//if (type == Features::Type::EIGENVALUES && !point_features_generated)
-			//	generator.generate_eigen_features(features);
+	ClassifyParams params = inputParams;
+
+	// classify a spatially subsampled version of the cloud (the labels are then transferred to all the points)
+	ccPointCloud* fullCloud = cloud;
+	std::unique_ptr<ccPointCloud> sampledCloud;
+	if (params.subsampling_distance > 0) {
+		StageProfiler::Scope stage(&m_profiler, "subsampling", cloud->size());
+		CCCoreLib::CloudSamplingTools::SFModulationParams modParams(false);
+		std::unique_ptr<CCCoreLib::ReferenceCloud> sampled(CCCoreLib::CloudSamplingTools::resampleCloudSpatially(cloud, static_cast<PointCoordinateType>(params.subsampling_distance), modParams));
+		if (sampled)
+			sampledCloud.reset(cloud->partialClone(sampled.get()));
+		if (!sampledCloud) {
+			dispToConsole("[RFC] Failed to subsample the cloud (not enough memory?)", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			return false;
 		}
-		if (source == Features::Source::CC_COLOR_FIELD) {
-			if (!cloud->hasColors()) {
-				if (m_app)
-					m_app->dispToConsole("No color property found", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-			}
-			else {
-				Cmap colorMap;
-				bool cmAdded;
-				std::tie(colorMap, cmAdded) = pts.add_property_map<Cmap::value_type>("colors");
+		std::cout << "[classify] cloud subsampled: " << sampledCloud->size() << " / " << cloud->size() << " points" << std::endl;
 
-				if (!cmAdded) {
-					if (m_app)
-						m_app->dispToConsole("Failed to add \"colors\" field.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-				}
-				else {
-					for (size_t i = 0; i < cloud->size(); ++i) {
-						const ccColor::Rgba& cc_color = cloud->getPointColor(i);
-						colorMap[i] = { cc_color.r,cc_color.g,cc_color.b };
-					}
-					generator.generate_color_based_features(features, colorMap);
-					std::cout << "Colors successfully added" << std::endl;
-				}
+		// the scalar fields are cloned with the points
+		for (auto& feature : params.eval_features) {
+			if (feature.first == Features::Source::CC_SCALAR_FIELD && feature.second) {
+				int sfIdx = sampledCloud->getScalarFieldIndexByName(feature.second->getName().c_str());
+				feature.second = (sfIdx >= 0 ? sampledCloud->getScalarField(sfIdx) : nullptr);
 			}
 		}
-		if (source == Features::Source::CC_NORMALS_FIELD) {
-			if (!cloud->hasNormals()) {
-				if (m_app)
-					m_app->dispToConsole("No normals property found", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-			}
-			else {
-				Vmap normalMap;
-				bool nmAdded;
-				std::tie(normalMap, nmAdded) = pts.add_normal_map();
-				if (!nmAdded) {
-					if (m_app)
-						m_app->dispToConsole("Failed to add \"normal\" field.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-				}
-				else {
-					for (size_t i = 0; i < cloud->size(); ++i) {
-						const CCVector3& cc_normal = cloud->getPointNormal(i);
-						normalMap[i] = { cc_normal.x,cc_normal.y,cc_normal.z };
-					}
-					generator.generate_normal_based_features(features, normalMap);
-					std::cout << "Normals successfully added" << std::endl;
-				}
-			}
+		cloud = sampledCloud.get();
+	}
+
+	// use the features, scales and classes the classifier was trained with (if known)
+	if (model.hasSchema()) {
+		if (model.nscales != params.nscales) {
+			dispToConsole(QString("[RFC] The classifier was trained with %1 scale(s), the number of scales is set accordingly").arg(model.nscales), ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+			params.nscales = model.nscales;
 		}
-		if (source == Features::Source::CC_SCALAR_FIELD) {
-			CCCoreLib::ScalarField* SF = feature.second;
-			if (SF == nullptr) {
-				if (m_app) {
-					m_app->dispToConsole("Invalid pointer to scalar field.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-				}
-				if (progressDlg) {
-					progressDlg->stop();
-				}
-				return {};
-			}
-			std::string name = SF->getName();
-			std::replace(name.begin(), name.end(), '_', ' '); // replace underscores with spaces
-			if (SF->size() != cloud->size() || SF->size() != pts.number_of_points()) {
-				std::cout << "[classify] scalar field (" << name << ") size does not match point cloud size (CC cloud size: " << cloud->size() << ", CGAL cloud size: " << pts.number_of_points() << ", CC scalar size: " << SF->size() << ")" << std::endl;
-				if (m_app)
-					m_app->dispToConsole("Scalar field size does not match point cloud size.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-				if (progressDlg)
-					progressDlg->stop();
-				return {};
+		if (model.min_scale > 0) {
+			if (params.min_scale > 0 && std::abs(params.min_scale - model.min_scale) > 1.0e-6 * model.min_scale) {
+				dispToConsole(QString("[RFC] The classifier was trained with a min. scale of %1, the min. scale is set accordingly").arg(model.min_scale), ccMainAppInterface::WRN_CONSOLE_MESSAGE);
 			}
-			Fmap featureMap;
-			bool fmAdded;
-			std::tie(featureMap, fmAdded) = pts.add_property_map<float>(name);
-			if (!fmAdded) {
-				std::cout << "\tproperty map couldn't be added [" << name << "]" << std::endl;
-				continue;
-			}
-			std::cout << "[classify] scalar name: " << name << std::endl;
-			for (size_t j = 0; j < SF->size(); ++j) {
-				featureMap[j] = SF->getValue(j);
-			}
-			features.add<CGAL::Classification::Feature::Simple_feature<Point_set, Fmap> >(pts, featureMap, name);
-			std::cout << "[classify] feature [" << name << "] added" << std::endl;
+			params.min_scale = model.min_scale;
+		}
+		if (!model.classes_list.empty() && model.classes_list != params.classes_list) {
+			dispToConsole("[RFC] The classes are set to the ones the classifier was trained with", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+			params.classes_list = model.classes_list;
 		}
+		// the features are rebuilt from the schema (only the sources the classifier was trained with are computed)
+		if (!model.getFeatures(cloud, params.eval_features, errorMessage)) {
+			std::cerr << errorMessage.toStdString() << std::endl;
+			dispToConsole(errorMessage, ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			return false;
+		}
+		std::cout << "[classify] scales: " << params.nscales << ", min. scale: " << params.min_scale << ", features: " << model.features.size() << (model.octree_neighborhoods ? ", octree neighborhoods" : "") << std::endl;
 	}
-	features.end_parallel_additions();
-	t.stop();
-	std::cerr << "Done in " << t.time() << " second(s)" << std::endl;
 
-	if (nProgress && !nProgress->oneStep()) {
-		return {};
+	// the tiles must be classified with the same scales: the min. scale is estimated once (on the most populated tile)
+	if (params.tile_size > 0 && params.min_scale <= 0) {
+		StageProfiler::Scope stage(&m_profiler, "min. scale estimation", cloud->size());
+		params.min_scale = EstimateMinScale(cloud, params.tile_size);
+		std::cout << "[classify] estimated min. scale: " << params.min_scale << std::endl;
+		dispToConsole(QString("[RFC] Min. scale is not set, estimated min. scale: %1").arg(params.min_scale), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+	}
+
+	// only generate the features the forest splits on (all of them are needed to export them)
+	std::vector<bool> usedFeatures;
+	if (model.hasSchema() && params.min_scale > 0 && !params.export_features) {
+		if (model.getFeatureUsage(usedFeatures)) {
+			std::cout << "[classify] " << std::count(usedFeatures.begin(), usedFeatures.end(), true) << " feature(s) used by the classifier" << std::endl;
+		}
+		else {
+			usedFeatures.clear();
+		}
 	}
 
+	const bool tiled = (params.tile_size > 0);
+
+	CCCoreLib::NormalizedProgress* nProgress = nullptr;
+	CCCoreLib::GenericProgressCallback* progressCb = startProgress(tiled ? "Splitting point cloud in tiles" : "Converting point clouds", ":/CC/plugin/qRandomForestClassifier/images/icon_classify.png");
+
 	// Add labels
 	Label_set labels;
 	//for (size_t i = 0; i < params.nclasses; ++i) labels.add(("class #" + std::to_string(i)).c_str());
 	for (int index : params.classes_list) {
 		if (index == -1) // unlabelled class
 			continue;
-		labels.add(("class #" + std::to_string(index)).c_str(), CGAL::IO::Color(0, 0, 0), index);
+		std::string name = "class #" + std::to_string(index);
+		if (model.hasSchema() && labels.size() < model.label_names.size())
+			name = model.label_names[labels.size()];
+		labels.add(name.c_str(), CGAL::IO::Color(0, 0, 0), index);
 	}
 
-	std::vector<int> label_indices(pts.size(), -1);
+	// compile the forest once for fast inference (the ETHZ classifier is used as fallback)
+	FlatForest flatForest;
+	{
+		StageProfiler::Scope stage(&m_profiler, "forest compilation");
+		CGAL::internal::liblearning::RandomForest::ForestParams forestParams;
+		ModelBundle::Forest rfc(forestParams);
+		model.readForest(rfc);
+		if (flatForest.compile(rfc) && flatForest.classCount() == labels.size()) {
+			std::cout << "[classify] forest compiled (" << flatForest.nodeCount() << " nodes)" << std::endl;
+		}
+		else {
+			std::cout << "[classify] the forest can't be compiled, the ETHZ classifier is used" << std::endl;
+			flatForest = FlatForest();
+		}
+	}
 
-	if (nProgress && !nProgress->oneStep()) {
-		return {};
+	// the (subsampled) cloud is classified first, then the labels are transferred to the output
+	std::vector<std::string> classNames;
+	for (Label_handle label : labels) {
+		classNames.push_back(label->name());
+	}
+	ClassificationOutput sampledOutput;
+	ClassificationOutput& cloudOutput = (sampledCloud ? sampledOutput : output);
+	if (!cloudOutput.init(cloud->size(), classNames, params.export_probabilities, errorMessage)) {
+		std::cerr << errorMessage.toStdString() << std::endl;
+		dispToConsole(errorMessage, ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		if (progressCb)
+			progressCb->stop();
+		return false;
 	}
-	if (progressDlg)
-		progressDlg->setInfo("Initializing classifier");
 
-	std::cout << "[classify] Using ETHZ Random Forest Classifier" << std::endl;
+	if (!tiled) {
+		if (progressCb)
+			nProgress = new CCCoreLib::NormalizedProgress(progressCb, 6);
 
-	std::cout << "[classify] features:" << std::endl;
-	for (const auto& feature : features) {
-		std::cout << "      name: " << feature->name() << std::endl;
-	}
-	std::cout << "[classify] pts size: " << pts.number_of_points() << std::endl;
-	std::cout << "[classify] pts props:" << std::endl;
-	for (const auto& props : pts.properties()) {
-		std::cout << "      name: " << props << std::endl;
+		Cloud_view view(cloud);
+		if (!classifyView(view, view.size(), model, usedFeatures, flatForest.isValid() ? &flatForest : nullptr, labels, params, cloudOutput, progressCb, nProgress)) {
+			if (progressCb)
+				progressCb->stop();
+			output.clear();
+			return false;
+		}
 	}
-	std::cout << "[classify] labels size: " << labels.size() << std::endl;
-	
-	Classification::ETHZ::Random_forest_classifier classifier(labels, features);
+	else {
+		double halo = params.tile_halo;
+		if (halo <= 0) {
+			halo = PrunedFeatureGenerator::SupportRadius(params.nscales, params.min_scale);
+		}
+
+		std::unique_ptr<TileGrid> tileGrid;
+		{
+			StageProfiler::Scope stage(&m_profiler, "tiling", cloud->size());
+			tileGrid.reset(new TileGrid(cloud, params.tile_size, halo));
+		}
+		const TileGrid& grid = *tileGrid;
+		std::cout << "[classify] " << grid.count() << " tile(s) (size: " << params.tile_size << ", halo: " << halo << ")" << std::endl;
 
-	std::cout << "[classify] classifier built" << std::endl;
-	std::cout << "[classify] loading configuration" << std::endl;
+		if (progressCb) {
+			progressCb->setInfo(qPrintable(QString("Classifying %1 tile(s)").arg(grid.count())));
+			nProgress = new CCCoreLib::NormalizedProgress(progressCb, grid.count());
+		}
 
-	std::ifstream fin(classifierFilePath.toStdString(), std::ios_base::binary);
-	if (!fin) {
-		std::cerr << "Failed to open file [" << classifierFilePath.toStdString() << "]" << std::endl;
-		if (progressDlg)
-			progressDlg->stop();
-		return {};
+		Tile tile;
+		for (unsigned i = 0; i < grid.count(); ++i) {
+			grid.getTile(i, tile);
+			if (tile.coreCount != 0) {
+				std::cout << "[classify] tile #" << i << ": " << tile.coreCount << " core points, " << tile.indices.size() - tile.coreCount << " halo points" << std::endl;
+				Cloud_view view(cloud, &tile.indices);
+				if (!classifyView(view, tile.coreCount, model, usedFeatures, flatForest.isValid() ? &flatForest : nullptr, labels, params, cloudOutput)) {
+					if (progressCb)
+						progressCb->stop();
+					output.clear();
+					return false;
+				}
+			}
+			if (nProgress && !nProgress->oneStep()) {
+				if (progressCb)
+					progressCb->stop();
+				output.clear();
+				return false;
+			}
+		}
 	}
-	classifier.load_configuration(fin);
-	fin.close();
-	std::cout << "[classify] classifier configured" << std::endl;
 
-	if (nProgress && !nProgress->oneStep()) {
-		return {};
+	if (progressCb)
+		progressCb->stop();
+
+	if (sampledCloud) {
+		StageProfiler::Scope stage(&m_profiler, "label transfer", fullCloud->size());
+		if (!output.init(fullCloud->size(), classNames, params.export_probabilities, errorMessage)
+			|| !qRFCTools::TransferLabels(sampledCloud.get(), sampledOutput, fullCloud, output, static_cast<unsigned>(std::max(1, params.transfer_neighbors)), params.export_features, progressCb)) {
+			if (!isCanceled())
+				dispToConsole("[RFC] Failed to transfer the labels to the full cloud", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			output.clear();
+			return false;
+		}
+		sampledOutput.clear();
+		cloud = fullCloud;
 	}
-	if (progressDlg)
-		progressDlg->setInfo("Performing classification");
 
-	t.reset();
-	t.start();
+	if (params.labels != nullptr) {
+		StageProfiler::Scope stage(&m_profiler, "evaluation", cloud->size());
+
+		// set labels
+		std::vector<int> ground_truth(cloud->size());
+		std::vector<int> label_indices(cloud->size());
+		for (size_t i = 0; i < cloud->size(); ++i) {
+			ground_truth[i] = (int) params.labels->getValue(i);
+			label_indices[i] = (int) output.labels()->getValue(i);
+		}
+
+		// evaluate results
+		Classification::Evaluation evaluation(labels, ground_truth, label_indices);
+		stage.stop();
+
+		if (m_app) {
+			// convert to html (useful as the user can easily copy-paste the tabulated results elsewhere)
+			std::stringstream ss;
+			evaluation.output_to_html(ss, evaluation);
+			m_evaluationReport = ss.str();
+			// background jobs can't open dialogs (the report is displayed once the job is done)
+			if (!m_progressCallback) {
+				EvaluationDialog ctDlg(m_evaluationReport, (QWidget*)m_app->getMainWindow());
+				ctDlg.exec();
+			}
+		}
+		else {
+			std::cout << "Precision, recall, F1 scores and IoU:" << std::endl;
+			for (Label_handle l : labels) {
+				std::cout << " * " << l->name() << ": "
+					<< evaluation.precision(l) << " ; "
+					<< evaluation.recall(l) << " ; "
+					<< evaluation.f1_score(l) << " ; "
+					<< evaluation.intersection_over_union(l) << std::endl;
+			}
+		}
+	}
+
+	reportProfile("classification", params.profile_path);
+
+	return true;
+}
+
+// approximate memory used by the graph cut (alpha expansion graph and label costs)
+static const double s_graphCutBytesPerPoint = 96.0;
+static const double s_graphCutBytesPerEdge = 64.0;
+
+//! Returns the number of subdivisions of the graph cut
+/** The subdivisions are processed in parallel (one per thread at a time): there are at least as many subdivisions
+	as threads, and more if the graphs of the subdivisions processed at the same time would exceed the memory budget.
+**/
+static std::size_t GraphCutSubdivisions(std::size_t pointCount, std::size_t labelCount, std::size_t k, const Classifier::ClassifyParams& params) {
+	if (params.graphcut_subdivisions > 0)
+		return static_cast<std::size_t>(params.graphcut_subdivisions);
+
+	std::size_t threadCount = static_cast<std::size_t>(std::max(1, QThread::idealThreadCount()));
+	if (params.graphcut_memory_budget <= 0)
+		return threadCount;
+
+	double bytes = pointCount * (s_graphCutBytesPerPoint + labelCount * sizeof(double) + k * s_graphCutBytesPerEdge);
+	double budget = params.graphcut_memory_budget * 1024.0 * 1024.0;
+	return std::max(threadCount, static_cast<std::size_t>(std::ceil(bytes * threadCount / budget)));
+}
+
+//! Classifies the points with a given classifier and regularization method
+template <typename ClassifierType>
+static void RunClassification(	const Index_range& input,
+								const CC_point_map& point_map,
+								const Label_set& labels,
+								const ClassifierType& classifier,
+								const Classifier::ClassifyParams& params,
+								const KNeighborGraph* graph,
+								std::size_t subdivisions,
+								std::vector<int>& label_indices) {
 	switch (params.reg_type) {
 	case Regularization::Method::LOCAL_SMOOTHING:
 		Classification::classify_with_local_smoothing<CGAL::Parallel_if_available_tag>
-			(pts, pts.point_map(), labels, classifier,
-				generator.neighborhood().k_neighbor_query(12),
+			(input, point_map, labels, classifier,
+				graph->query(),
 				label_indices);
 		break;
 	case Regularization::Method::GRAPH_CUT:
 		Classification::classify_with_graphcut<CGAL::Parallel_if_available_tag>
-			(pts, pts.point_map(), labels, classifier,
-				generator.neighborhood().k_neighbor_query(12),
-				0.2f, QThread::idealThreadCount(), label_indices);
+			(input, point_map, labels, classifier,
+				graph->query(),
+				params.graphcut_strength, subdivisions, label_indices);
 		break;
 	default:
-		Classification::classify<CGAL::Parallel_if_available_tag>(pts, labels, classifier, label_indices);
+		Classification::classify<CGAL::Parallel_if_available_tag>(input, labels, classifier, label_indices);
 	}
-	t.stop();
-	std::cerr << "Classification done in " << t.time() << " second(s)" << std::endl;
+}
 
-	std::map<std::string, std::vector<float>> exportedFeatures;
+bool Classifier::classifyView(	const Cloud_view& view,
+								std::size_t coreCount,
+								const ModelBundle& model,
+								const std::vector<bool>& usedFeatures,
+								const FlatForest* flatForest,
+								Label_set& labels,
+								const ClassifyParams& params,
+								ClassificationOutput& output,
+								CCCoreLib::GenericProgressCallback* progressCb,
+								CCCoreLib::NormalizedProgress* nProgress) {
+	assert(coreCount <= view.size());
+
+	Index_range input = view.range();
+	CC_point_map point_map{ view };
 
 	if (nProgress && !nProgress->oneStep()) {
-		return {};
+		return false;
 	}
-	if (params.export_features) {
-		if (progressDlg)
-			progressDlg->setInfo("Exporting features");
-		std::cout << "[classify] exporting features:" << std::endl;
-		for (auto& feature : features) {
-			std::string featname = feature->name();
-			std::cout << "\tname: " << featname << std::endl;
-			std::replace(featname.begin(), featname.end(), '_', ' '); // replace underscores with spaces
-			std::vector<float> indicies;
-			indicies.reserve(pts.number_of_points());
-			for (size_t i = 0; i < pts.number_of_points(); ++i) {
-				indicies.push_back(feature->value(i));
-			}
-
-			exportedFeatures.insert({ featname, indicies });
+	if (progressCb)
+		progressCb->setInfo("Computing features");
+	std::unique_ptr<Feature_generator> generator;
+	std::unique_ptr<FeatureCache> cache;
+	Feature_pruning pruning;
+	pruning.used = usedFeatures;
+	pruning.names = model.features;
+	Feature_set features;
 
-			if (!progressDlg || progressDlg->wasCanceled()) {
-				return {};
-			}
-		}
+	double minScale = params.min_scale;
+	// the features must be computed with the same neighborhoods as for training
+	const bool prune = (!usedFeatures.empty() || model.octree_neighborhoods);
+	if (!generateFeatures(view, input, params.nscales, minScale, params.feature_cache_dir, params.eval_features, {}, generator, cache, features, prune ? &pruning : nullptr, model.octree_neighborhoods)) {
+		return false;
 	}
 
-	if (progressDlg)
-		progressDlg->stop();
-
-	if (params.labels != nullptr) {
-		// set labels
-		Imap label_map;
-		bool lm_found;
-		std::tie(label_map, lm_found) = pts.add_property_map<int>("label");
-		for (size_t i = 0; i < cloud->size(); ++i) {
-			label_map[i] = (int) params.labels->getValue(i);
+	// the forest evaluates the features by index: they must be computed in the same order as for training
+	if (model.hasSchema()) {
+		bool match = (features.size() == model.features.size());
+		for (std::size_t i = 0; match && i < features.size(); ++i) {
+			match = (features[i]->name() == model.features[i]);
+		}
+		if (!match) {
+			std::cerr << "[classify] computed features don't match the classifier features" << std::endl;
+			dispToConsole("The computed features don't match the ones the classifier was trained with", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			return false;
 		}
-
-		// evaluate results
-		Classification::Evaluation evaluation(labels, pts.range(label_map), label_indices);
-
-		// convert to html (useful as the user can easily copy-paste the tabulated results elsewhere)
-		std::stringstream ss;
-		evaluation.output_to_html(ss, evaluation);
-		EvaluationDialog ctDlg(ss.str(), (QWidget*)m_app->getMainWindow());
-		ctDlg.exec();
 	}
 
-	std::cout << "Returning classification results (label_indices size: " << label_indices.size() << ")" << std::endl;
-
-	return { label_indices, exportedFeatures };
-}
-
-QString Classifier::train(ccPointCloud* cloud1, ccPointCloud* cloud2, std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> > features1, std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> > features2, const TrainParams& params) {
-	ccProgressDialog* progressDlg = nullptr;
-	CCCoreLib::NormalizedProgress* nProgress = nullptr;
-
-	if (m_app) {
-		progressDlg = new ccProgressDialog(true, (QWidget*)m_app->getMainWindow());
-		progressDlg->setWindowIcon(QIcon(":/CC/plugin/qRandomForestClassifier/images/icon_train.png"));
-		progressDlg->reset();
-		progressDlg->setInfo("Converting point clouds");
-		progressDlg->setMethodTitle("Classification");
-		if (nProgress == nullptr)
-			nProgress = new CCCoreLib::NormalizedProgress(&(*progressDlg), 4);
-		progressDlg->start();
+	if (nProgress && !nProgress->oneStep()) {
+		return false;
 	}
 
-	Point_set pts;
+	std::vector<int> label_indices(input.size(), -1);
 
-	std::vector<Point> points;
-	points.reserve(cloud1->size() + cloud2->size());
-	for (unsigned i = 0; i < cloud1->size(); ++i) {
-		const auto pt_cc = cloud1->getPoint(i)->toDouble();
-		double x = pt_cc[0];
-		double y = pt_cc[1];
-		double z = pt_cc[2];
-		points.push_back(Point(x, y, z));
-	}
-	for (unsigned i = 0; i < cloud2->size(); ++i) {
-		const auto pt_cc = cloud2->getPoint(i)->toDouble();
-		double x = pt_cc[0];
-		double y = pt_cc[1];
-		double z = pt_cc[2];
-		points.push_back(Point(x, y, z));
+	if (nProgress && !nProgress->oneStep()) {
+		return false;
 	}
-	std::copy(points.begin(), points.end(), pts.point_back_inserter());
+	if (progressCb)
+		progressCb->setInfo("Initializing classifier");
 
-	Imap label_map;
-	bool lm_found;
-	std::tie(label_map,lm_found) = pts.add_property_map<int>("label");
-	for (size_t i = 0; i < cloud1->size(); ++i) {
-		label_map[i] = 0;
+	if (flatForest && flatForest->featureCount() != features.size()) {
+		std::cout << "[classify] feature count mismatch, the ETHZ classifier is used" << std::endl;
+		flatForest = nullptr;
 	}
-	for (size_t i = 0; i < cloud2->size(); ++i) {
-		label_map[cloud1->size() + i] = 1;
+
+	std::unique_ptr<Classification::ETHZ::Random_forest_classifier> classifier;
+	if (!flatForest) {
+		StageProfiler::Scope stage(&m_profiler, "forest loading");
+		classifier.reset(new Classification::ETHZ::Random_forest_classifier(labels, features));
+		std::istringstream config(model.forest, std::ios_base::binary);
+		classifier->load_configuration(config);
 	}
 
 	if (nProgress && !nProgress->oneStep()) {
-		return "";
+		return false;
+	}
+	if (progressCb)
+		progressCb->setInfo("Performing classification");
+
+	// the class probabilities of all the points are computed at once with the compiled forest
+	std::vector<float> probabilities;
+	if (flatForest) {
+		StageProfiler::Scope stage(&m_profiler, "inference", input.size());
+		flatForest->evaluate(features, input.size(), probabilities);
 	}
-	if (progressDlg)
-		progressDlg->setInfo("Computing features");
-	Feature_set features;
 
-	std::cerr << "Generating features" << std::endl;
-	CGAL::Real_timer t;
-	t.start();
-	Feature_generator generator(pts, pts.point_map(), params.nscales);
-	features.begin_parallel_additions();
-	//for (const auto& feature : params.features) {
-	for (int it=0; it < features1.size(); it++) {
-		const auto& feature1 = features1[it];
-		const auto& feature2 = features2[it];
-		if (feature1.first != feature2.first) {
-			if (m_app)
-				m_app->dispToConsole("Scalar field mismatch", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-			if (progressDlg)
-				progressDlg->stop();
-			return "";
+	// the regularization relies on a kNN graph computed once (with the neighborhood of the generator, an octree, or a dedicated kd-tree if the features were cached)
+	std::unique_ptr<KNeighborGraph> graph;
+	std::size_t subdivisions = 1;
+	if (params.reg_type != Regularization::Method::NONE) {
+		const std::size_t k = static_cast<std::size_t>(std::max(params.reg_neighbors, 1));
+		const OctreeNeighborhood* octree = (pruning.generator ? pruning.generator->octree() : nullptr);
+		std::unique_ptr<OctreeNeighborhood> cloudOctree;
+		if (!octree && !generator && !view.subset && !view.cloud2 && view.cloud1->getOctree()) {
+			// no need for a kd-tree if the cloud already has an octree
+			cloudOctree.reset(new OctreeNeighborhood(view));
+			octree = cloudOctree.get();
 		}
-		Features::Source source = feature1.first;
-		if (source == Features::Source::CGAL_GENERATED_FEATURE) {
-			//if (type == Features::Type::POINTFEATURES)
-			generator.generate_point_based_features(features);
-
-			// bool point_features_generated = false;
-			//for (const auto& feature : params.features) {
-			//	Features::Type type = feature.third;
-			//  if (type== Features::Type::POINTFEATURES) point_features_generated = true;
-			//}
-			//if (type == Features::Type::EIGENVALUES && !point_features_generated)
-			//	generator.generate_eigen_features(features);
+		StageProfiler::Scope stage(&m_profiler, "regularization: kNN graph", input.size());
+		if (octree) {
+			graph.reset(new KNeighborGraph(view, *octree, k));
 		}
-		if (source == Features::Source::CC_COLOR_FIELD) {
-			if (!cloud1->hasColors() || !cloud2->hasColors()) {
-				if (m_app)
-					m_app->dispToConsole("No color property found", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		else {
+			std::unique_ptr<Neighborhood> cacheNeighborhood;
+			const Neighborhood* neighborhood = nullptr;
+			if (generator) {
+				neighborhood = &generator->neighborhood();
 			}
 			else {
-				Cmap color_map;
-				bool cm_added;
-				std::tie(color_map, cm_added) = pts.add_property_map<Cmap::value_type>("colors");
-
-				if (!cm_added) {
-					if (m_app)
-						m_app->dispToConsole("Failed to add \"colors\" field.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-				}
-				else {
-					for (size_t i = 0; i < cloud1->size(); ++i) {
-						const ccColor::Rgba& cc_color = cloud1->getPointColor(i);
-						color_map[i] = { cc_color.r,cc_color.g,cc_color.b };
-					}
-					for (size_t i = 0; i < cloud2->size(); ++i) {
-						const ccColor::Rgba& cc_color = cloud2->getPointColor(i);
-						color_map[cloud1->size() + i] = { cc_color.r,cc_color.g,cc_color.b };
-					}
-					generator.generate_color_based_features(features, color_map);
-					std::cout << "Colors successfully added" << std::endl;
-				}
+				cacheNeighborhood.reset(new Neighborhood(input, point_map));
+				neighborhood = cacheNeighborhood.get();
 			}
+			graph.reset(new KNeighborGraph(view, *neighborhood, k));
 		}
-		if (source == Features::Source::CC_NORMALS_FIELD) {
-			if (!cloud1->hasNormals() || !cloud2->hasNormals()) {
-				if (m_app)
-					m_app->dispToConsole("No normals property found", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-			}
-			else {
-				Vmap normal_map;
-				bool nm_added;
-				std::tie(normal_map, nm_added) = pts.add_normal_map();
-				if (!nm_added) {
-					if (m_app)
-						m_app->dispToConsole("Failed to add \"normal\" field.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-				}
-				else {
-					for (size_t i = 0; i < cloud1->size(); ++i) {
-						const CCVector3& cc_normal = cloud1->getPointNormal(i);
-						normal_map[i] = { cc_normal.x,cc_normal.y,cc_normal.z };
-					}
-					for (size_t i = 0; i < cloud2->size(); ++i) {
-						const CCVector3& cc_normal = cloud2->getPointNormal(i);
-						normal_map[cloud1->size() + i] = { cc_normal.x,cc_normal.y,cc_normal.z };
-					}
-					generator.generate_normal_based_features(features, normal_map);
-					std::cout << "Normals successfully added" << std::endl;
-				}
-			}
+
+		if (params.reg_type == Regularization::Method::GRAPH_CUT) {
+			subdivisions = GraphCutSubdivisions(input.size(), labels.size(), graph->k(), params);
+			std::cout << "[classify] graph cut: strength " << params.graphcut_strength << ", " << subdivisions << " subdivision(s)" << std::endl;
 		}
-		if (source == Features::Source::CC_SCALAR_FIELD) {
-			CCCoreLib::ScalarField* SF1 = feature1.second;
-			CCCoreLib::ScalarField* SF2 = feature2.second;
-			if (SF1 == nullptr || SF2 == nullptr) {
-				std::cout << "[train two clouds] invalid pointer to scalar field (cloud1: " << ((SF1 == nullptr) ? "nullptr" : SF1->getName()) << ", cloud2: " << ((SF2 == nullptr) ? "nullptr" : SF2->getName()) << ")" << std::endl;
-				if (m_app)
-					m_app->dispToConsole("Invalid pointer to scalar field.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-				if (progressDlg)
-					progressDlg->stop();
-				return "";
-			}
-			if (strcmp(SF1->getName().c_str(), SF2->getName().c_str()) != 0) {
-				if (m_app)
-					m_app->dispToConsole("Scalar field name mismatch.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-				if (progressDlg)
-					progressDlg->stop();
-				return "";
-			}
-			std::string name = SF1->getName();
-			std::replace(name.begin(), name.end(), '_', ' '); // replace underscores with spaces
-			Fmap feature_map;
-			bool fm_added;
-			std::tie(feature_map, fm_added) = pts.add_property_map<float>(name);
-			if (!fm_added) {
-				std::cout << "\tproperty map couldn't be added [" << name << "]" << std::endl;
-				continue;
+	}
+
+	if (flatForest) {
+		StageProfiler::Scope stage(&m_profiler, params.reg_type == Regularization::Method::NONE ? "labelling" : "regularization", input.size());
+		RunClassification(input, point_map, labels, Precomputed_classifier(probabilities, labels.size()), params, graph.get(), subdivisions, label_indices);
+	}
+	else {
+		// the ETHZ classifier is evaluated during the labelling (or regularization)
+		StageProfiler::Scope stage(&m_profiler, params.reg_type == Regularization::Method::NONE ? "inference" : "inference and regularization", input.size());
+		RunClassification(input, point_map, labels, *classifier, params, graph.get(), subdivisions, label_indices);
+	}
+
+	// only the core points are output (at their index in the cloud)
+	const Index_range cores = boost::irange<std::size_t>(0, coreCount);
+	ccScalarField* labelField = output.labels();
+	CGAL::for_each<CGAL::Parallel_if_available_tag>(cores, [&](std::size_t i) -> bool {
+		labelField->setValue(view.localIndex(i), static_cast<ScalarType>(label_indices[i]));
+		return true;
+	});
+
+	if (output.hasProbabilities()) {
+		StageProfiler::Scope stage(&m_profiler, "export: probabilities", coreCount);
+		const std::size_t classCount = labels.size();
+		CGAL::for_each<CGAL::Parallel_if_available_tag>(cores, [&](std::size_t i) -> bool {
+			std::vector<float> values;
+			if (flatForest)
+				values.assign(probabilities.begin() + i * classCount, probabilities.begin() + (i + 1) * classCount);
+			else
+				(*classifier)(i, values);
+			unsigned index = view.localIndex(i);
+			float confidence = 0;
+			for (std::size_t c = 0; c < classCount; ++c) {
+				output.probability(c)->setValue(index, values[c]);
+				confidence = std::max(confidence, values[c]);
 			}
-			for (size_t j = 0; j < cloud1->size(); ++j) {
-				feature_map[j] = SF1->getValue(j);
+			output.confidence()->setValue(index, confidence);
+			return true;
+		});
+	}
+
+	if (nProgress && !nProgress->oneStep()) {
+		return false;
+	}
+	if (params.export_features) {
+		if (progressCb)
+			progressCb->setInfo("Exporting features");
+		StageProfiler::Scope stage(&m_profiler, "export", coreCount);
+		for (auto& feature : features) {
+			std::string featname = feature->name();
+			std::replace(featname.begin(), featname.end(), '_', ' '); // replace underscores with spaces
+			ccScalarField* featureField = output.feature(featname);
+			if (!featureField) {
+				dispToConsole("Not enough memory to store exported features.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+				return false;
 			}
-			for (size_t j = 0; j < cloud2->size(); ++j) {
-				feature_map[cloud1->size() + j] = SF2->getValue(j);
+			CGAL::for_each<CGAL::Parallel_if_available_tag>(cores, [&](std::size_t i) -> bool {
+				featureField->setValue(view.localIndex(i), feature->value(i));
+				return true;
+			});
+
+			if (progressCb && progressCb->isCancelRequested()) {
+				return false;
 			}
-			features.add<CGAL::Classification::Feature::Simple_feature<Point_set, Fmap> >(pts, feature_map, name);
-			std::cout << "[train two clouds] feature [" << name << "] added." << std::endl;
 		}
 	}
-	features.end_parallel_additions();
-	t.stop();
-	std::cerr << "Done in " << t.time() << " second(s)" << std::endl;
 
-	return train(pts, features, params, progressDlg, nProgress);
+	return true;
+}
+
+void Classifier::checkOctreeNeighborhoods(TrainParams& params, bool twoClouds) {
+	if (params.octree_neighborhoods && (twoClouds || params.min_scale <= 0)) {
+		params.octree_neighborhoods = false;
+		dispToConsole(QString("[RFC] Octree neighborhoods require %1, the CGAL neighborhoods are used").arg(twoClouds ? "a single cloud per class" : "a min. scale"), ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+	}
+}
+
+QString Classifier::train(ccPointCloud* cloud1, ccPointCloud* cloud2, std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> > features1, std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> > features2, const TrainParams& params) {
+	m_profiler.clear();
+
+	CCCoreLib::NormalizedProgress* nProgress = nullptr;
+	CCCoreLib::GenericProgressCallback* progressCb = startProgress("Converting point clouds", ":/CC/plugin/qRandomForestClassifier/images/icon_train.png");
+	if (progressCb)
+		nProgress = new CCCoreLib::NormalizedProgress(progressCb, 4);
+
+	if (features1.size() != features2.size()) {
+		dispToConsole("Scalar field mismatch", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		if (progressCb)
+			progressCb->stop();
+		return "";
+	}
+
+	Cloud_view view(cloud1, cloud2);
+	Index_range input = view.range();
+
+	std::vector<int> ground_truth(view.size(), 1);
+	std::fill(ground_truth.begin(), ground_truth.begin() + view.split, 0);
+
+	if (nProgress && !nProgress->oneStep()) {
+		return "";
+	}
+	if (progressCb)
+		progressCb->setInfo("Computing features");
+	std::unique_ptr<Feature_generator> generator;
+	std::unique_ptr<FeatureCache> cache;
+	Feature_set features;
+	TrainParams trainParams = params; // the base scale actually used is saved with the classifier
+	trainParams.features = features1; // the feature sources are saved with the classifier
+	checkOctreeNeighborhoods(trainParams, true);
+
+	if (!generateFeatures(view, input, params.nscales, trainParams.min_scale, params.feature_cache_dir, features1, features2, generator, cache, features)) {
+		if (progressCb)
+			progressCb->stop();
+		return "";
+	}
+
+	return train(input, ground_truth, features, trainParams, progressCb, nProgress, &view);
 }
 
 QString Classifier::train(ccPointCloud* cloud, ccScalarField* scalarField, const TrainParams& params) {
 	assert(cloud->size() == scalarField->size()); // Point cloud and scalar field size mismatch
 
-	ccProgressDialog* progressDlg = nullptr;
+	m_profiler.clear();
+
 	CCCoreLib::NormalizedProgress* nProgress = nullptr;
-	if (m_app) {
-		progressDlg = new ccProgressDialog(true, (QWidget*)m_app->getMainWindow());
-		progressDlg->setWindowIcon(QIcon(":/CC/plugin/qRandomForestClassifier/images/icon_train.png"));
-		progressDlg->reset();
-		progressDlg->setInfo("Convering point cloud");
-		progressDlg->setMethodTitle("Classification");
-		if (nProgress == nullptr)
-			nProgress = new CCCoreLib::NormalizedProgress(&(*progressDlg), 4);
-		progressDlg->start();
+	CCCoreLib::GenericProgressCallback* progressCb = startProgress("Converting point cloud", ":/CC/plugin/qRandomForestClassifier/images/icon_train.png");
+	if (progressCb)
+		nProgress = new CCCoreLib::NormalizedProgress(progressCb, 4);
+
+	StageProfiler::Scope conversionStage(&m_profiler, "conversion", cloud->size());
+	Cloud_view view(cloud);
+	Index_range input = view.range();
+
+	std::vector<int> ground_truth(view.size());
+	for (size_t i = 0; i < cloud->size(); ++i) {
+		ground_truth[i] = (int) scalarField->getValue(i);
 	}
+	conversionStage.stop();
 
-	Point_set pts;
+	if (nProgress && !nProgress->oneStep()) {
+		return "";
+	}
+	if (progressCb)
+		progressCb->setInfo("Computing features");
+	std::unique_ptr<Feature_generator> generator;
+	std::unique_ptr<FeatureCache> cache;
+	Feature_pruning pruning; // all the features are generated (octree neighborhoods only)
+	Feature_set features;
+	TrainParams trainParams = params; // the base scale actually used is saved with the classifier
+	checkOctreeNeighborhoods(trainParams, false);
 
-	std::vector<Point> points;
-	points.reserve(cloud->size());
+	if (!generateFeatures(view, input, params.nscales, trainParams.min_scale, params.feature_cache_dir, params.features, {}, generator, cache, features, &pruning, trainParams.octree_neighborhoods)) {
+		if (progressCb)
+			progressCb->stop();
+		return "";
+	}
+
+	return train(input, ground_truth, features, trainParams, progressCb, nProgress, &view);
+}
+
+//! Selects the points of a cloud in the (XY) neighborhood of its labelled points
+/** The cloud is split in square cells of the size of the neighborhood: the points of the cells containing labelled points
+	and of their neighbor cells are selected.
+**/
+static void SelectLabelledNeighborhood(ccPointCloud* cloud, const std::vector<int>& ground_truth, double distance, std::vector<unsigned>& indices) {
+	indices.clear();
+	CCVector3 bbMin, bbMax;
+	cloud->getBoundingBox(bbMin, bbMax);
+	auto cellOf = [&](unsigned i) {
+		const CCVector3* P = cloud->getPoint(i);
+		return std::make_pair(static_cast<int64_t>(std::floor((P->x - bbMin.x) / distance)), static_cast<int64_t>(std::floor((P->y - bbMin.y) / distance)));
+	};
+
+	std::set<std::pair<int64_t, int64_t>> cells;
+	for (unsigned i = 0; i < cloud->size(); ++i) {
+		if (ground_truth[i] == -1)
+			continue;
+		std::pair<int64_t, int64_t> cell = cellOf(i);
+		for (int64_t dx = -1; dx <= 1; ++dx)
+			for (int64_t dy = -1; dy <= 1; ++dy)
+				cells.insert({ cell.first + dx, cell.second + dy });
+	}
 	for (unsigned i = 0; i < cloud->size(); ++i) {
-		const auto pt_cc = cloud->getPoint(i)->toDouble();
-		double x = pt_cc[0];
-		double y = pt_cc[1];
-		double z = pt_cc[2];
-		points.push_back(Point(x, y, z));
+		if (cells.find(cellOf(i)) != cells.end())
+			indices.push_back(i);
 	}
-	std::copy(points.begin(), points.end(), pts.point_back_inserter());
+}
+
+QString Classifier::update(ccPointCloud* cloud, ccScalarField* scalarField, const TrainParams& params) {
+	assert(cloud->size() == scalarField->size()); // Point cloud and scalar field size mismatch
+
+	m_profiler.clear();
+
+	// the classifier to update sets the scales, classes and features
+	ModelBundle model;
+	QString errorMessage;
+	if (!model.load(params.base_classifier_path, errorMessage) || !model.hasSchema() || model.min_scale <= 0) {
+		if (errorMessage.isEmpty())
+			errorMessage = QString("Classifier file [%1] has no feature description: it can't be updated").arg(params.base_classifier_path);
+		std::cerr << errorMessage.toStdString() << std::endl;
+		dispToConsole(errorMessage, ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		return "";
+	}
+	TrainParams trainParams = params;
+	trainParams.nscales = model.nscales;
+	trainParams.min_scale = model.min_scale;
+	trainParams.octree_neighborhoods = model.octree_neighborhoods;
+	trainParams.classes_list = model.classes_list;
+	if (!model.getFeatures(cloud, trainParams.features, errorMessage)) {
+		std::cerr << errorMessage.toStdString() << std::endl;
+		dispToConsole(errorMessage, ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		return "";
+	}
+
+	CCCoreLib::NormalizedProgress* nProgress = nullptr;
+	CCCoreLib::GenericProgressCallback* progressCb = startProgress("Converting point cloud", ":/CC/plugin/qRandomForestClassifier/images/icon_train.png");
+	if (progressCb)
+		nProgress = new CCCoreLib::NormalizedProgress(progressCb, 4);
 
-	Imap label_map;
-	bool lm_found;
-	std::tie(label_map, lm_found) = pts.add_property_map<int>("label");
+	// only the neighborhood of the labelled points is needed (same extent as the tile halo)
+	StageProfiler::Scope conversionStage(&m_profiler, "conversion", cloud->size());
+	std::vector<int> cloudTruth(cloud->size());
 	for (size_t i = 0; i < cloud->size(); ++i) {
-		label_map[i] = (int) scalarField->getValue(i);
+		cloudTruth[i] = (int) scalarField->getValue(i);
 	}
+	std::vector<unsigned> indices;
+	SelectLabelledNeighborhood(cloud, cloudTruth, PrunedFeatureGenerator::SupportRadius(model.nscales, model.min_scale), indices);
+	if (indices.empty()) {
+		dispToConsole("No labelled points", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		if (progressCb)
+			progressCb->stop();
+		return "";
+	}
+	Cloud_view view(cloud, &indices);
+	Index_range input = view.range();
+	std::vector<int> ground_truth(view.size());
+	for (size_t i = 0; i < view.size(); ++i) {
+		ground_truth[i] = cloudTruth[view.localIndex(i)];
+	}
+	conversionStage.stop();
+	std::cout << "[train] updating [" << params.base_classifier_path.toStdString() << "]: features computed on " << view.size() << " / " << cloud->size() << " point(s)" << std::endl;
 
 	if (nProgress && !nProgress->oneStep()) {
 		return "";
 	}
-	if (progressDlg)
-		progressDlg->setInfo("Computing features");
+	if (progressCb)
+		progressCb->setInfo("Computing features");
+	std::unique_ptr<Feature_generator> generator;
+	std::unique_ptr<FeatureCache> cache;
+	Feature_pruning pruning; // all the features are generated (octree neighborhoods only)
 	Feature_set features;
 
-	std::cerr << "Generating features" << std::endl;
-	CGAL::Real_timer t;
-	t.start();
-	Feature_generator generator(pts, pts.point_map(), params.nscales);
-	features.begin_parallel_additions();
-	for (const auto& feature : params.features) {
-		Features::Source source = feature.first;
-		if (source == Features::Source::CGAL_GENERATED_FEATURE) {
-			//if (type == Features::Type::POINTFEATURES)
-			generator.generate_point_based_features(features);
+	// the cache is not used (only a part of the cloud)
+	if (!generateFeatures(view, input, trainParams.nscales, trainParams.min_scale, QString(), trainParams.features, {}, generator, cache, features, &pruning, trainParams.octree_neighborhoods)) {
+		if (progressCb)
+			progressCb->stop();
+		return "";
+	}
+	bool match = (features.size() == model.features.size());
+	for (std::size_t i = 0; match && i < features.size(); ++i) {
+		match = (features[i]->name() == model.features[i]);
+	}
+	if (!match) {
+		dispToConsole("The computed features don't match the ones the classifier was trained with", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		if (progressCb)
+			progressCb->stop();
+		return "";
+	}
 
-			// bool point_features_generated = false;
-			//for (const auto& feature : params.features) {
-			//	Features::Type type = feature.third;
-			//  if (type== Features::Type::POINTFEATURES) point_features_generated = true;
-			//}
-			//if (type == Features::Type::EIGENVALUES && !point_features_generated)
-			//	generator.generate_eigen_features(features);
-		}
-		if (source == Features::Source::CC_COLOR_FIELD) {
-			if (!cloud->hasColors()) {
-				if (m_app)
-					m_app->dispToConsole("No color property found", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-			}
-			else {
-				Cmap color_map;
-				bool cm_added;
-				std::tie(color_map, cm_added) = pts.add_property_map<Cmap::value_type>("colors");
+	return train(input, ground_truth, features, trainParams, progressCb, nProgress, &view);
+}
 
-				if (!cm_added) {
-					if (m_app)
-						m_app->dispToConsole("Failed to add \"colors\" field.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-				}
-				else {
-					for (size_t i = 0; i < cloud->size(); ++i) {
-						const ccColor::Rgba& cc_color = cloud->getPointColor(i);
-						color_map[i] = { cc_color.r,cc_color.g,cc_color.b };
-					}
-					generator.generate_color_based_features(features, color_map);
-					std::cout << "Colors successfully added" << std::endl;
-				}
-			}
-		}
-		if (source == Features::Source::CC_NORMALS_FIELD) {
-			if (!cloud->hasNormals()) {
-				if (m_app)
-					m_app->dispToConsole("No normals property found", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-			}
-			else {
-				Vmap normal_map;
-				bool nm_added;
-				std::tie(normal_map, nm_added) = pts.add_normal_map();
-				if (!nm_added) {
-					if (m_app)
-						m_app->dispToConsole("Failed to add \"normal\" field.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-				}
-				else {
-					for (size_t i = 0; i < cloud->size(); ++i) {
-						const CCVector3& cc_normal = cloud->getPointNormal(i);
-						normal_map[i] = { cc_normal.x,cc_normal.y,cc_normal.z };
-					}
-					generator.generate_normal_based_features(features, normal_map);
-					std::cout << "Normals successfully added" << std::endl;
-				}
-			}
-		}
-		if (source == Features::Source::CC_SCALAR_FIELD) {
-			CCCoreLib::ScalarField* SF = feature.second;
-			if (SF == nullptr) {
-				if (m_app)
-					m_app->dispToConsole("Invalid pointer to scalar field.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-				if (progressDlg)
-					progressDlg->stop();
-				return "";
-			}
-			std::string name = SF->getName();
-			std::replace(name.begin(), name.end(), '_', ' '); // replace underscores with spaces
-			if (SF->size() != cloud->size() || SF->size() != pts.number_of_points()) {
-				std::cout << "[train] scalar field (" << name << ") size does not match point cloud size (CC cloud size: " << cloud->size() << ", CGAL cloud size: " << pts.number_of_points() << ", CC scalar size: " << SF->size() << ")" << std::endl;
-				if (m_app)
-					m_app->dispToConsole("Scalar field size does not match point cloud size.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-				if (progressDlg)
-					progressDlg->stop();
-				return "";
-			}
-			Fmap feature_map;
-			bool fm_added;
-			std::cout << "[train] pts.add_property_map SF name: " << name << std::endl;
-			std::tie(feature_map, fm_added) = pts.add_property_map<float>(name);
-			if (!fm_added) {
-				std::cout << "\tproperty map couldn't be added [" << name << "]" << std::endl;
-				continue;
-			}
-			for (size_t j = 0; j < SF->size(); ++j) {
-				feature_map[j] = SF->getValue(j);
-			}
-			features.add<CGAL::Classification::Feature::Simple_feature<Point_set, Fmap> >(pts, feature_map, name);
-			std::cout << "[train] feature [" << name << "] added" << std::endl;
-		}
+bool Classifier::collectTrainingRows(const TrainingCloud& trainingCloud, size_t index, const TrainParams& params, double& minScale, TrainingRows& rows) {
+	assert(trainingCloud.cloud && trainingCloud.labels);
+	if (trainingCloud.cloud->size() != trainingCloud.labels->size()) {
+		dispToConsole(QString("Cloud '%1': scalar field size does not match point cloud size").arg(trainingCloud.cloud->getName()), ccMainAppInterface::ERR_CONSOLE_MESSAGE, &rows.messages);
+		return false;
+	}
+
+	Cloud_view view(trainingCloud.cloud);
+	Index_range input = view.range();
+
+	// select the core points first (only their features are kept)
+	std::vector<int> ground_truth(view.size());
+	for (size_t i = 0; i < view.size(); ++i) {
+		ground_truth[i] = (int) trainingCloud.labels->getValue(i);
+	}
+	TrainingSampler sampler(static_cast<size_t>(std::max(params.max_core_points, 0)), params.balance_classes, params.sampling_voxel_size, params.seed + static_cast<unsigned>(index));
+	if (sampler.isActive())
+		sampler.select(ground_truth, &view);
+	std::vector<size_t> corePoints;
+	for (size_t i = 0; i < ground_truth.size(); ++i) {
+		if (ground_truth[i] != -1)
+			corePoints.push_back(i);
 	}
-	//std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> > features = {};
-	features.end_parallel_additions();
-	t.stop();
-	std::cerr << "Done in " << t.time() << " second(s)" << std::endl;
 
-	std::cout << "[train add features] features:" << std::endl;
-	for (const auto& feature : features) {
-		std::cout << "      name: " << feature->name() << std::endl;
+	std::unique_ptr<Feature_generator> generator;
+	std::unique_ptr<FeatureCache> cache;
+	Feature_pruning pruning; // all the features are generated (octree neighborhoods only)
+	Feature_set features;
+	if (!generateFeatures(view, input, params.nscales, minScale, params.feature_cache_dir, trainingCloud.features, {}, generator, cache, features, &pruning, params.octree_neighborhoods, &rows.messages)) {
+		return false;
 	}
-	std::cout << "[train add features] pts props:" << std::endl;
-	for (const auto& props : pts.properties()) {
-		std::cout << "      name: " << props << std::endl;
+
+	rows.names.resize(features.size());
+	rows.columns.resize(features.size());
+	for (size_t f = 0; f < features.size(); ++f) {
+		Feature_handle feature = features[f];
+		rows.names[f] = feature->name();
+		rows.columns[f].resize(corePoints.size());
+		for (size_t r = 0; r < corePoints.size(); ++r) {
+			rows.columns[f][r] = feature->value(corePoints[r]);
+		}
+	}
+	rows.labels.resize(corePoints.size());
+	for (size_t r = 0; r < corePoints.size(); ++r) {
+		rows.labels[r] = ground_truth[corePoints[r]];
 	}
 
-	return train(pts, features, params, progressDlg, nProgress);
+	std::cout << "[train] cloud '" << trainingCloud.cloud->getName().toStdString() << "': " << corePoints.size() << " core point(s), " << features.size() << " feature(s)" << std::endl;
+	return true;
 }
 
-QString Classifier::train(Point_set pts, Feature_set& features, const TrainParams& params, ccProgressDialog* progressDlg, CCCoreLib::NormalizedProgress* nProgress) {
-	assert(features.size() > 0); // No features passed
+QString Classifier::train(const std::vector<TrainingCloud>& clouds, const TrainParams& params) {
+	if (clouds.empty()) {
+		return "";
+	}
 
-	// get labels
-	Imap label_map;
-	bool lm_found;
-	std::tie(label_map, lm_found) = pts.property_map<int>("label");
-	assert(lm_found); // Label map not found
+	m_profiler.clear();
 
-	if (m_app && progressDlg == nullptr) {
-		progressDlg = new ccProgressDialog(true, (QWidget*)m_app->getMainWindow());
-		progressDlg->setWindowIcon(QIcon(":/CC/plugin/qRandomForestClassifier/images/icon_train.png"));
-		progressDlg->reset();
-		progressDlg->setInfo("Training classifier");
-		progressDlg->setMethodTitle("Classification");
-		if (nProgress == nullptr)
-			nProgress = new CCCoreLib::NormalizedProgress(&(*progressDlg), 3);
-		progressDlg->start();
+	CCCoreLib::NormalizedProgress* nProgress = nullptr;
+	CCCoreLib::GenericProgressCallback* progressCb = startProgress(qPrintable(QString("Computing features (%1 clouds)").arg(clouds.size())), ":/CC/plugin/qRandomForestClassifier/images/icon_train.png");
+	if (progressCb)
+		nProgress = new CCCoreLib::NormalizedProgress(progressCb, static_cast<unsigned>(clouds.size()) + 3);
+
+	TrainParams trainParams = params; // the base scale actually used is saved with the classifier
+	trainParams.features = clouds.front().features; // the feature sources are saved with the classifier
+	checkOctreeNeighborhoods(trainParams, false);
+
+	std::vector<TrainingRows> rows(clouds.size());
+	std::vector<char> success(clouds.size(), 0);
+	QMutex progressMutex;
+	bool canceled = false;
+	auto collect = [&](size_t i) {
+		double minScale = trainParams.min_scale;
+		success[i] = collectTrainingRows(clouds[i], i, trainParams, minScale, rows[i]) ? 1 : 0;
+		QMutexLocker locker(&progressMutex);
+		if (nProgress && !nProgress->oneStep())
+			canceled = true;
+		return minScale;
+	};
+
+	// the stages of the clouds computed in parallel are accumulated (their wall times overlap)
+	StageProfiler::Scope featureStage(&m_profiler, "features: all clouds");
+	size_t first = 0;
+	if (trainParams.min_scale <= 0) {
+		// all the clouds must share the base scale of the first one
+		trainParams.min_scale = collect(0);
+		first = 1;
 	}
-	if (nProgress == nullptr)
-		nProgress = new CCCoreLib::NormalizedProgress(&(*progressDlg), 3);
+	if (first == 0 || success[0] != 0) {
+		// each cloud has its own feature generator (and neighborhood)
+		QThreadPool pool;
+		pool.setMaxThreadCount(std::max(1, params.parallel_clouds));
+		std::vector<QFuture<double>> futures;
+		for (size_t i = first; i < clouds.size(); ++i) {
+			futures.push_back(QtConcurrent::run(&pool, [&collect, i]() { return collect(i); }));
+		}
+		for (QFuture<double>& future : futures) {
+			future.waitForFinished();
+		}
+	}
+	featureStage.stop();
 
-	// subsample points for training
-	size_t n_unassigned = 0;
-	for (size_t i = 0; i < pts.number_of_points(); ++i) {
-		n_unassigned += (label_map[i] == -1) ? 1 : 0;
+	// the console can only be used by the calling thread
+	for (TrainingRows& cloudRows : rows) {
+		for (const auto& message : cloudRows.messages) {
+			dispToConsole(message.first, message.second);
+		}
+		cloudRows.messages.clear();
 	}
-	size_t n_assigned = pts.number_of_points() - n_unassigned;
 
-	if (nProgress && !nProgress->oneStep()) {
+	if (canceled || isCanceled() || std::find(success.begin(), success.end(), 0) != success.end()) {
+		if (!canceled && !isCanceled())
+			dispToConsole("Failed to compute the features of (at least) one cloud", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		if (progressCb)
+			progressCb->stop();
 		return "";
 	}
-	if (n_assigned > params.max_core_points && params.max_core_points > 0) {
-		if (progressDlg)
-			progressDlg->setInfo("Subsampling labelled points for training");
 
-		size_t n = pts.number_of_points();
-		std::vector<size_t> assigned_points;
-		for (size_t i = 0; i < pts.number_of_points(); ++i) {
-			if (label_map[i] != -1) {
-				assigned_points.push_back(i);
-			}
+	// concatenate the rows of all the clouds
+	StageProfiler::Scope matrixStage(&m_profiler, "training matrix");
+	TrainingRows all;
+	all.names = rows.front().names;
+	all.columns.resize(all.names.size());
+	for (TrainingRows& cloudRows : rows) {
+		if (cloudRows.names != all.names) {
+			dispToConsole("The clouds don't have the same features", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			if (progressCb)
+				progressCb->stop();
+			return "";
 		}
-		std::random_device rd;
-		std::default_random_engine rng{ rd() };
-		std::shuffle(std::begin(assigned_points), std::end(assigned_points), rng);
-		for (size_t i = params.max_core_points; i < assigned_points.size(); ++i) {
-			label_map[assigned_points[i]] = -1;
+		for (size_t f = 0; f < all.columns.size(); ++f) {
+			all.columns[f].insert(all.columns[f].end(), cloudRows.columns[f].begin(), cloudRows.columns[f].end());
 		}
+		all.labels.insert(all.labels.end(), cloudRows.labels.begin(), cloudRows.labels.end());
+		cloudRows = TrainingRows(); // release memory
+	}
+	matrixStage.setPoints(all.labels.size());
+	matrixStage.stop();
+	std::cout << "[train] training matrix: " << all.labels.size() << " row(s), " << all.names.size() << " feature(s)" << std::endl;
+	if (all.labels.empty()) {
+		dispToConsole("No labelled points to train the classifier with", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		if (progressCb)
+			progressCb->stop();
+		return "";
+	}
 
-		n_unassigned = 0;
-		for (size_t i = 0; i < pts.number_of_points(); ++i) {
-			n_unassigned += (label_map[i] == -1) ? 1 : 0;
-		}
-		n_assigned = pts.number_of_points() - n_unassigned;
+	Feature_set features;
+	for (size_t f = 0; f < all.names.size(); ++f) {
+		features.add<Cached_feature>(all.names[f], all.columns[f].data());
 	}
 
+	// the core points have already been spatially sampled (on each cloud)
+	trainParams.sampling_voxel_size = 0;
+	Index_range input = boost::irange<std::size_t>(0, all.labels.size());
+	return train(input, all.labels, features, trainParams, progressCb, nProgress);
+}
+
+QString Classifier::train(const Index_range& input, std::vector<int>& ground_truth, Feature_set& features, const TrainParams& params, CCCoreLib::GenericProgressCallback* progressCb, CCCoreLib::NormalizedProgress* nProgress, const Cloud_view* view) {
+	assert(features.size() > 0); // No features passed
+	assert(ground_truth.size() == input.size()); // Label map size mismatch
+
+	if (progressCb == nullptr)
+		progressCb = startProgress("Training classifier", ":/CC/plugin/qRandomForestClassifier/images/icon_train.png");
+	if (nProgress == nullptr)
+		nProgress = new CCCoreLib::NormalizedProgress(progressCb, 3);
+
+	size_t n_assigned = input.size() - std::count(ground_truth.begin(), ground_truth.end(), -1);
 
 	CGAL::Real_timer t;
 
+	// warm start: the trees of an existing classifier are kept
+	ModelBundle baseModel;
+	if (!params.base_classifier_path.isEmpty()) {
+		QString errorMessage;
+		if (!baseModel.load(params.base_classifier_path, errorMessage)) {
+			std::cerr << errorMessage.toStdString() << std::endl;
+			dispToConsole(errorMessage, ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			if (progressCb)
+				progressCb->stop();
+			return "";
+		}
+		if (baseModel.features.size() != features.size()) {
+			dispToConsole("The computed features don't match the ones the classifier was trained with", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			if (progressCb)
+				progressCb->stop();
+			return "";
+		}
+	}
+
 	// Create class labels
 	Label_set labels;
 	//for (size_t i = 0; i < params.nclasses; ++i) labels.add(("class #" + std::to_string(i)).c_str());
 	for (int index : params.classes_list) {
 		if (index == -1) // unlabelled class
 			continue;
-		labels.add(("class #" + std::to_string(index)).c_str(), CGAL::IO::Color(0, 0, 0), index);
+		std::string name = "class #" + std::to_string(index);
+		if (labels.size() < baseModel.label_names.size())
+			name = baseModel.label_names[labels.size()];
+		labels.add(name.c_str(), CGAL::IO::Color(0, 0, 0), index);
 	}
 
 	// Check if ground truth is valid for this label set
 	if (nProgress && !nProgress->oneStep()) {
 		return "";
 	}
-	if (progressDlg)
-		progressDlg->setInfo("Validating ground truths");
-	if (!labels.is_valid_ground_truth(pts.range(label_map), true)) {
-		if (m_app)
-			m_app->dispToConsole("Ground truths are invalid", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-		if (progressDlg)
-			progressDlg->stop();
+	if (progressCb)
+		progressCb->setInfo("Validating ground truths");
+	if (!labels.is_valid_ground_truth(ground_truth, true)) {
+		dispToConsole("Ground truths are invalid", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		if (progressCb)
+			progressCb->stop();
 		return "";
 	}
 
-	std::vector<int> label_indices(pts.size(), -1);
+	// cross-validation (and selection of the forest parameters), on all the labelled points
+	size_t num_trees = params.num_trees;
+	size_t max_depth = params.max_depth;
+	int max_core_points = params.max_core_points;
+	if (params.cv_folds > 1 && !baseModel.forest.empty()) {
+		// the folds would only evaluate forests trained on the new labels
+		dispToConsole("[RFC] Cross-validation is not available when updating a classifier", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+	}
+	else if (params.cv_folds > 1) {
+		if (progressCb)
+			progressCb->setInfo(qPrintable(QString("%1-fold cross-validation").arg(params.cv_folds)));
+
+		std::vector<ForestEvaluator::Configuration> configurations;
+		for (size_t trees : params.grid_num_trees.empty() ? std::vector<size_t>{ params.num_trees } : params.grid_num_trees) {
+			for (size_t depth : params.grid_max_depth.empty() ? std::vector<size_t>{ params.max_depth } : params.grid_max_depth) {
+				for (int corePoints : params.grid_max_core_points.empty() ? std::vector<int>{ params.max_core_points } : params.grid_max_core_points) {
+					ForestEvaluator::Configuration config;
+					config.numTrees = trees;
+					config.maxDepth = depth;
+					config.maxCorePoints = corePoints;
+					configurations.push_back(config);
+				}
+			}
+		}
+
+		ForestEvaluator evaluator(labels, features, ground_truth);
+		// spatial blocks larger than the support of the features (random folds if the scale is unknown)
+		double blockSize = params.cv_block_size;
+		if (blockSize <= 0 && params.min_scale > 0)
+			blockSize = 2 * PrunedFeatureGenerator::SupportRadius(params.nscales, params.min_scale);
+		if (view && blockSize > 0)
+			evaluator.makeSpatialFolds(params.cv_folds, *view, blockSize, params.seed);
+		else
+			evaluator.makeRandomFolds(params.cv_folds, params.seed);
+
+		std::vector<ForestEvaluator::Result> results;
+		StageProfiler::Scope stage(&m_profiler, "cross-validation", n_assigned * configurations.size());
+		t.reset();
+		t.start();
+		if (!evaluator.evaluate(configurations, params.balance_classes, params.seed, results, [this]() { return isCanceled(); })) {
+			if (progressCb)
+				progressCb->stop();
+			return "";
+		}
+		t.stop();
 
-	std::cerr << "[train] Using ETHZ Random Forest Classifier" << std::endl;
-	Classification::ETHZ::Random_forest_classifier classifier(labels, features);
+		QStringList report = evaluator.report(results);
+		report << QString("Cross-validation done in %1 second(s)").arg(t.time());
+		if (configurations.size() > 1) {
+			size_t best = ForestEvaluator::Best(results);
+			num_trees = results[best].config.numTrees;
+			max_depth = results[best].config.maxDepth;
+			max_core_points = results[best].config.maxCorePoints;
+			report << QString("Best configuration (mean IoU): trees: %1, max depth: %2, max core points: %3").arg(num_trees).arg(max_depth).arg(max_core_points);
+		}
+		for (const QString& line : report) {
+			std::cout << "[train] " << line.toStdString() << std::endl;
+			dispToConsole("[qRandomForestClassifier] " + line);
+		}
+
+		if (!params.cv_report_path.isEmpty()) {
+			QString errorMessage;
+			if (!evaluator.saveCSV(params.cv_report_path, results, errorMessage)) {
+				std::cerr << errorMessage.toStdString() << std::endl;
+				dispToConsole(errorMessage, ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+			}
+		}
+	}
 
+	// subsample points for training
 	if (nProgress && !nProgress->oneStep()) {
 		return "";
 	}
-	if (progressDlg)
-		progressDlg->setInfo("Training classifier");
+	TrainingSampler sampler(static_cast<size_t>(std::max(max_core_points, 0)), params.balance_classes, params.sampling_voxel_size, params.seed);
+	if (sampler.isActive() && (n_assigned > static_cast<size_t>(max_core_points) || params.sampling_voxel_size > 0)) {
+		if (progressCb)
+			progressCb->setInfo("Subsampling labelled points for training");
+		StageProfiler::Scope stage(&m_profiler, "core point sampling", n_assigned);
+		n_assigned = sampler.select(ground_truth, view);
+	}
 
-	std::cout << "[train] features:" << std::endl;
-	for (const auto& feature : features) {
-		std::cout << "      name: " << feature->name() << std::endl;
+	Classification::ETHZ::Random_forest_classifier classifier(labels, features);
+
+	// the new trees are appended to the ones of the existing classifier
+	const bool warmStart = !baseModel.forest.empty();
+	if (warmStart) {
+		StageProfiler::Scope stage(&m_profiler, "forest loading");
+		if (params.max_trees > 0) {
+			// the least accurate trees on the new labels are replaced
+			std::vector<float> samples;
+			std::vector<int> sampleLabels;
+			samples.reserve(n_assigned * features.size());
+			sampleLabels.reserve(n_assigned);
+			for (std::size_t i = 0; i < ground_truth.size(); ++i) {
+				if (ground_truth[i] == -1)
+					continue;
+				for (std::size_t f = 0; f < features.size(); ++f)
+					samples.push_back(features[f]->value(i));
+				sampleLabels.push_back(ground_truth[i]);
+			}
+			std::size_t removed = baseModel.keepBestTrees(params.max_trees > num_trees ? params.max_trees - num_trees : 0, samples, sampleLabels);
+			std::cout << "[train] " << removed << " tree(s) of the existing classifier removed (least accurate on the new labels)" << std::endl;
+		}
+		// the stored forest parameters are the ones of the existing trees: they are replaced by the
+		// requested ones before the new trees are added (see ForestTrainer)
+		std::istringstream config(baseModel.forest, std::ios_base::binary);
+		classifier.load_configuration(config);
 	}
-	std::cout << "[train] pts size: " << pts.number_of_points() << std::endl;
-	std::cout << "[train] pts props:" << std::endl;
-	for (const auto& props : pts.properties()) {
-		std::cout << "      name: " << props << std::endl;
+
+	if (nProgress && !nProgress->oneStep()) {
+		return "";
 	}
-	std::cout << "[train] label_map size: " << std::distance(label_map.begin(), label_map.end()) << std::endl;
-	std::cerr << "Training" << std::endl;
-	t.reset();
-	t.start();
-	classifier.train(pts.range(label_map), true, params.num_trees, params.max_depth);
-	t.stop();
-	std::cerr << "Done in " << t.time() << " second(s)" << std::endl;
+	if (progressCb)
+		progressCb->setInfo("Training classifier");
+
+	std::cout << "[train] " << features.size() << " feature(s), " << n_assigned << " core point(s)" << std::endl;
+	StageProfiler::Scope trainingStage(&m_profiler, "training", n_assigned);
+	// the trees are trained by chunks (so that the training can be canceled and its progress reported)
+	const std::size_t initialTreeCount = warmStart ? ForestTrainer::TreeCount(classifier) : 0;
+	bool trainingDone = ForestTrainer::Train(classifier, ground_truth, !warmStart, num_trees, max_depth, [&](std::size_t trained) {
+		if (progressCb) {
+			if (progressCb->isCancelRequested())
+				return false;
+			progressCb->setInfo(qPrintable(QString("Training classifier (%1/%2 trees)").arg(trained).arg(num_trees)));
+		}
+		return true;
+	});
+	if (!trainingDone) {
+		progressCb->stop();
+		return "";
+	}
+	trainingStage.stop();
 
+	const std::size_t treeCount = ForestTrainer::TreeCount(classifier);
+	if (treeCount != initialTreeCount + num_trees) {
+		if (progressCb)
+			progressCb->stop();
+		dispToConsole(QString("Training failed: %1 tree(s) trained instead of %2").arg(treeCount - initialTreeCount).arg(num_trees), ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		return "";
+	}
 
-	if (progressDlg)
-		progressDlg->stop();
+	if (progressCb)
+		progressCb->stop();
 	
 	// Save configuration for later use
-	QString fname = QFileDialog::getSaveFileName(nullptr,
-		QString("Save classifier"),
-		"ethz_random_forest.bin",
-		QString("ETHZ Random Forest Classifier (*.bin);;All Files (*)"));
+	QString fname = params.output_path;
+	if (fname.isEmpty() && m_app && !m_progressCallback) {
+		fname = QFileDialog::getSaveFileName(nullptr,
+			QString("Save classifier"),
+			"ethz_random_forest.bin",
+			QString("ETHZ Random Forest Classifier (*.bin);;All Files (*)"));
+	}
 
 	if (!fname.isNull() && !fname.isEmpty()) {
-		std::ofstream fconfig(fname.toStdString(), std::ios_base::binary);
+		StageProfiler::Scope stage(&m_profiler, "saving");
+
+		// the forest is saved with the description of its features
+		ModelBundle model;
+		model.nscales = params.nscales;
+		model.min_scale = params.min_scale;
+		model.octree_neighborhoods = params.octree_neighborhoods;
+		model.classes_list = params.classes_list;
+		for (Label_handle label : labels) {
+			model.label_names.push_back(label->name());
+		}
+		for (const auto& feature : params.features) {
+			ModelBundle::Source source;
+			source.source = feature.first;
+			if (feature.first == Features::Source::CC_SCALAR_FIELD && feature.second)
+				source.sf_name = feature.second->getName();
+			model.sources.push_back(source);
+		}
+		for (const auto& feature : features) {
+			model.features.push_back(feature->name());
+		}
+		std::ostringstream fconfig(std::ios_base::binary);
 		classifier.save_configuration(fconfig);
+		model.forest = fconfig.str();
+
+		QString errorMessage;
+		if (!model.save(fname, errorMessage)) {
+			std::cerr << errorMessage.toStdString() << std::endl;
+			dispToConsole(errorMessage, ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			return "";
+		}
+		stage.stop();
+		reportProfile("training", params.profile_path);
 
 		// save parameter
 		QSettings settings("qRandomForestClassifier");
@@ -811,51 +1323,215 @@ QString Classifier::train(Point_set pts, Feature_set& features, const TrainParam
 		settings.setValue("CurrentFilePath", currentFilePath);
 		return currentFilePath;
 	}
-	
 
-	// Doesn't make sense for training, but for validation
-	/*
-	t.reset();
-	t.start();
-	Classification::classify_with_graphcut<CGAL::Parallel_if_available_tag>
-		(pts, pts.point_map(), labels, classifier,
-			generator.neighborhood().k_neighbor_query(12),
-			0.2f, 1, label_indices);
-	t.stop();
-	std::cerr << "Classification with graphcut done in " << t.time() << " second(s)" << std::endl;
-
-	std::cerr << "Precision, recall, F1 scores and IoU:" << std::endl;
-	Classification::Evaluation evaluation(labels, pts.range(label_map), label_indices);
-	for (Label_handle l : labels)
-	{
-		std::cerr << " * " << l->name() << ": "
-			<< evaluation.precision(l) << " ; "
-			<< evaluation.recall(l) << " ; "
-			<< evaluation.f1_score(l) << " ; "
-			<< evaluation.intersection_over_union(l) << std::endl;
+	reportProfile("training", params.profile_path);
+
+	return "";
+}
+
+//! Returns the name of a feature source (profiling report)
+static std::string FeatureSourceName(Features::Source source) {
+	switch (source) {
+	case Features::Source::CGAL_GENERATED_FEATURE:
+		return "point";
+	case Features::Source::CC_COLOR_FIELD:
+		return "colors";
+	case Features::Source::CC_NORMALS_FIELD:
+		return "normals";
+	case Features::Source::CC_SCALAR_FIELD:
+		return "scalar fields";
+	default:
+		return "other";
 	}
-	if (params.export_features) {
-		t.reset();
-		t.start();
-		for (auto& feature : features) {
-			std::string featname = feature->name();
-			std::vector<float> indicies;
-			indicies.reserve(pts.number_of_points());
-			for (size_t i = 0; i < pts.number_of_points(); ++i) {
-				indicies.push_back(feature->value(i));
+}
+
+void Classifier::dispToConsole(const QString& message, ccMainAppInterface::ConsoleMessageLevel level, ConsoleMessages* messages) {
+	if (messages)
+		messages->emplace_back(message, level);
+	else if (m_progressCallback)
+		m_consoleMessages.emplace_back(message, level); // background job
+	else if (m_app)
+		m_app->dispToConsole(message, level);
+}
+
+void Classifier::flushConsoleMessages() {
+	if (m_app) {
+		for (const auto& message : m_consoleMessages)
+			m_app->dispToConsole(message.first, message.second);
+	}
+	m_consoleMessages.clear();
+}
+
+bool Classifier::generateFeatures(	const Cloud_view& view,
+									const Index_range& input,
+									int nscales,
+									double& minScale,
+									const QString& cacheDir,
+									const std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> >& features1,
+									const std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> >& features2,
+									std::unique_ptr<Feature_generator>& generator,
+									std::unique_ptr<FeatureCache>& cache,
+									Feature_set& features,
+									Feature_pruning* pruning,
+									bool octreeNeighborhoods,
+									ConsoleMessages* messages) {
+	const bool twoClouds = (view.cloud2 != nullptr);
+	assert(!twoClouds || features1.size() == features2.size());
+
+	if (octreeNeighborhoods && (!pruning || minScale <= 0 || twoClouds)) {
+		dispToConsole("Octree neighborhoods require a min. scale and a single cloud", ccMainAppInterface::ERR_CONSOLE_MESSAGE, messages);
+		return false;
+	}
+
+	// look for the generated features in the cache first (it only holds features computed with the CGAL neighborhoods)
+	if (!cacheDir.isEmpty() && !octreeNeighborhoods) {
+		std::vector<Features::Source> cacheableSources;
+		for (const auto& feature : features1) {
+			if (FeatureCache::IsCacheable(feature.first))
+				cacheableSources.push_back(feature.first);
+		}
+		if (!cacheableSources.empty()) {
+			StageProfiler::Scope stage(&m_profiler, "features: cache loading", view.size());
+			cache.reset(new FeatureCache(cacheDir, FeatureCache::Key(view, nscales, minScale, cacheableSources)));
+			if (cache->load(view.size())) {
+				std::cout << "[features] reading features from cache [" << cache->filePath().toStdString() << "]" << std::endl;
+			}
+		}
+	}
+	const bool fromCache = (cache && cache->isLoaded());
+
+	if (fromCache) {
+		if (cache->voxelSize() > 0)
+			minScale = cache->voxelSize();
+	}
+	else if (pruning && minScale > 0 && (octreeNeighborhoods || !pruning->used.empty())) {
+		// the scale structures are only computed for the used features
+		std::unique_ptr<OctreeNeighborhood> octree;
+		if (octreeNeighborhoods) {
+			StageProfiler::Scope stage(&m_profiler, "features: octree", view.size());
+			octree.reset(new OctreeNeighborhood(view));
+			if (!octree->isValid()) {
+				dispToConsole("Failed to compute the octree (not enough memory?)", ccMainAppInterface::ERR_CONSOLE_MESSAGE, messages);
+				return false;
 			}
+			std::cout << "[features] octree neighborhoods (" << (octree->isShared() ? "octree of the cloud" : "octree computed") << ")" << std::endl;
+		}
+		pruning->generator.reset(new PrunedFeatureGenerator(input, CC_point_map{ view }, nscales, static_cast<float>(minScale), std::move(octree)));
+	}
+	else {
+		// the base scale is only estimated by CGAL if it is not set (the structures of all the scales are computed at once)
+		StageProfiler::Scope stage(&m_profiler, "features: scale structures", view.size());
+		generator.reset(new Feature_generator(input, CC_point_map{ view }, nscales, minScale > 0 ? static_cast<float>(minScale) : -1.f));
+		minScale = generator->grid_resolution(0);
+	}
+
+	// source of each feature (for the cache)
+	std::vector<Features::Source> sources;
 
-			exportedFeatures.insert({ featname, indicies });
+	for (size_t it = 0; it < features1.size(); ++it) {
+		if (isCanceled()) {
+			return false;
 		}
-		std::cout << "Features exported:" << std::endl;
-		for (auto feat : exportedFeatures) {
-			std::cout << "\t" << feat.first << std::endl;
+		const auto& feature1 = features1[it];
+		const auto& feature2 = twoClouds ? features2[it] : feature1;
+		if (feature1.first != feature2.first) {
+			dispToConsole("Scalar field mismatch", ccMainAppInterface::ERR_CONSOLE_MESSAGE, messages);
+			return false;
 		}
-		t.stop();
-		std::cerr << "Exported features in " << t.time() << " second(s)" << std::endl;
+		Features::Source source = feature1.first;
+
+		// the features of a source are computed in parallel (and the sources one after the other, so that each one is profiled)
+		StageProfiler::Scope stage(&m_profiler, "features: " + FeatureSourceName(source), view.size());
+		features.begin_parallel_additions();
+		if (source == Features::Source::CGAL_GENERATED_FEATURE) {
+			if (fromCache) {
+				cache->addFeatures(source, features);
+			}
+			else if (generator) {
+				generator->generate_point_based_features(features);
+			}
+			else {
+				std::size_t first = features.size();
+				std::size_t last = first + nscales * PrunedFeatureGenerator::FeaturesPerScale;
+				// all the features are generated if their usage is unknown
+				std::vector<bool> used(last - first, true);
+				std::vector<std::string> names(last - first);
+				if (!pruning->used.empty()) {
+					if (last > pruning->used.size() || last > pruning->names.size()) {
+						dispToConsole("Feature layout mismatch", ccMainAppInterface::ERR_CONSOLE_MESSAGE, messages);
+						features.end_parallel_additions();
+						return false;
+					}
+					used.assign(pruning->used.begin() + first, pruning->used.begin() + last);
+					names.assign(pruning->names.begin() + first, pruning->names.begin() + last);
+				}
+				pruning->generator->generatePointBasedFeatures(features, used, names, &m_profiler);
+			}
+		}
+		if (source == Features::Source::CC_COLOR_FIELD) {
+			if (!view.hasColors()) {
+				dispToConsole("No color property found", ccMainAppInterface::ERR_CONSOLE_MESSAGE, messages);
+			}
+			else {
+				if (fromCache)
+					cache->addFeatures(source, features);
+				else if (generator)
+					generator->generate_color_based_features(features, CC_color_map{ view });
+				else
+					pruning->generator->generateColorBasedFeatures(features, CC_color_map{ view });
+			}
+		}
+		if (source == Features::Source::CC_NORMALS_FIELD) {
+			if (!view.hasNormals()) {
+				dispToConsole("No normals property found", ccMainAppInterface::ERR_CONSOLE_MESSAGE, messages);
+			}
+			else {
+				if (fromCache)
+					cache->addFeatures(source, features);
+				else if (generator)
+					generator->generate_normal_based_features(features, CC_normal_map{ view });
+				else
+					pruning->generator->generateNormalBasedFeatures(features, CC_normal_map{ view });
+			}
+		}
+		if (source == Features::Source::CC_SCALAR_FIELD) {
+			CCCoreLib::ScalarField* SF1 = feature1.second;
+			CCCoreLib::ScalarField* SF2 = twoClouds ? feature2.second : nullptr;
+			if (SF1 == nullptr || (twoClouds && SF2 == nullptr)) {
+				dispToConsole("Invalid pointer to scalar field.", ccMainAppInterface::ERR_CONSOLE_MESSAGE, messages);
+				features.end_parallel_additions();
+				return false;
+			}
+			if (twoClouds && strcmp(SF1->getName().c_str(), SF2->getName().c_str()) != 0) {
+				dispToConsole("Scalar field name mismatch.", ccMainAppInterface::ERR_CONSOLE_MESSAGE, messages);
+				features.end_parallel_additions();
+				return false;
+			}
+			std::string name = SF1->getName();
+			std::replace(name.begin(), name.end(), '_', ' '); // replace underscores with spaces
+			if (SF1->size() != view.cloud1->size() || (twoClouds && SF2->size() != view.cloud2->size())) {
+				std::cout << "[features] scalar field (" << name << ") size does not match point cloud size (CC cloud size: " << view.cloud1->size() << ", CC scalar size: " << SF1->size() << ")" << std::endl;
+				dispToConsole("Scalar field size does not match point cloud size.", ccMainAppInterface::ERR_CONSOLE_MESSAGE, messages);
+				features.end_parallel_additions();
+				return false;
+			}
+			// the scalar values are read in place (no copy)
+			features.add<Scalar_feature>(input, CC_scalar_map{ SF1, SF2, view }, name);
+		}
+		features.end_parallel_additions();
+		sources.resize(features.size(), source);
+	}
+	if (isCanceled()) {
+		return false;
 	}
-	*/
 
+	// the placeholders of the unused features must not be cached
+	if (cache && !fromCache && generator) {
+		StageProfiler::Scope stage(&m_profiler, "features: cache saving", view.size());
+		if (cache->save(features, sources, view.size(), minScale))
+			std::cout << "[features] features saved to cache [" << cache->filePath().toStdString() << "]" << std::endl;
+		else dispToConsole(QString("Failed to write feature cache [%1]").arg(cache->filePath()), ccMainAppInterface::WRN_CONSOLE_MESSAGE, messages);
+	}
 
-	return "";
+	return true;
 }
@@ -0,0 +1,266 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "FeatureCache.h"
+
+//Qt
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+
+//system
+#include <cstring>
+
+// File layout:
+//  - header: magic (8 bytes), version (uint32), feature count (uint32), point count (uint64), voxel size (double)
+//  - for each feature: source (int32), name length (uint32), name (without trailing zero)
+//  - padding up to a multiple of 16 bytes
+//  - for each feature: point count floats
+static const char s_magic[8] = { 'R', 'F', 'C', 'F', 'E', 'A', 'T', '\0' };
+static const uint32_t s_version = 2;
+static const size_t s_alignment = 16;
+//! Number of values processed at once when hashing or writing a column
+static const size_t s_blockSize = 65536;
+
+bool FeatureCache::IsCacheable(Features::Source source)
+{
+	return (source == Features::Source::CGAL_GENERATED_FEATURE
+		|| source == Features::Source::CC_COLOR_FIELD
+		|| source == Features::Source::CC_NORMALS_FIELD);
+}
+
+QString FeatureCache::Key(const Cloud_view& view, int nscales, double minScale, const std::vector<Features::Source>& sources)
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+
+	hash.addData(reinterpret_cast<const char*>(&s_version), sizeof(s_version));
+	hash.addData(reinterpret_cast<const char*>(&nscales), sizeof(nscales));
+	hash.addData(reinterpret_cast<const char*>(&minScale), sizeof(minScale));
+	for (Features::Source source : sources)
+	{
+		int32_t s = static_cast<int32_t>(source);
+		hash.addData(reinterpret_cast<const char*>(&s), sizeof(s));
+	}
+
+	const bool useColors = (std::find(sources.begin(), sources.end(), Features::Source::CC_COLOR_FIELD) != sources.end());
+	const bool useNormals = (std::find(sources.begin(), sources.end(), Features::Source::CC_NORMALS_FIELD) != sources.end());
+
+	std::vector<CCVector3> block;
+	std::vector<ccColor::Rgba> colorBlock;
+	block.reserve(s_blockSize);
+	colorBlock.reserve(s_blockSize);
+	const size_t count = view.size();
+	for (size_t start = 0; start < count; start += s_blockSize)
+	{
+		size_t stop = std::min(count, start + s_blockSize);
+
+		block.clear();
+		for (size_t i = start; i < stop; ++i)
+			block.push_back(*view.point(i));
+		hash.addData(reinterpret_cast<const char*>(block.data()), static_cast<int>(block.size() * sizeof(CCVector3)));
+
+		if (useColors)
+		{
+			colorBlock.clear();
+			for (size_t i = start; i < stop; ++i)
+				colorBlock.push_back(view.color(i));
+			hash.addData(reinterpret_cast<const char*>(colorBlock.data()), static_cast<int>(colorBlock.size() * sizeof(ccColor::Rgba)));
+		}
+		if (useNormals)
+		{
+			block.clear();
+			for (size_t i = start; i < stop; ++i)
+				block.push_back(view.normal(i));
+			hash.addData(reinterpret_cast<const char*>(block.data()), static_cast<int>(block.size() * sizeof(CCVector3)));
+		}
+	}
+
+	return QString::fromLatin1(hash.result().toHex());
+}
+
+FeatureCache::FeatureCache(const QString& directory, const QString& key)
+	: m_file(QDir(directory).absoluteFilePath(key + ".rfcfeat"))
+	, m_data(nullptr)
+	, m_voxelSize(-1.0)
+{
+}
+
+bool FeatureCache::load(std::size_t pointCount)
+{
+	m_entries.clear();
+	m_data = nullptr;
+
+	if (!m_file.exists() || !m_file.open(QFile::ReadOnly))
+	{
+		return false;
+	}
+
+	const qint64 fileSize = m_file.size();
+	uchar* data = m_file.map(0, fileSize);
+	if (!data)
+	{
+		m_file.close();
+		return false;
+	}
+
+	// read header
+	size_t offset = 0;
+	auto read = [&](void* dest, size_t size) -> bool
+	{
+		if (offset + size > static_cast<size_t>(fileSize))
+			return false;
+		memcpy(dest, data + offset, size);
+		offset += size;
+		return true;
+	};
+
+	char magic[8];
+	uint32_t version = 0;
+	uint32_t featureCount = 0;
+	uint64_t storedPointCount = 0;
+	double voxelSize = -1.0;
+	if (	!read(magic, sizeof(magic))
+		||	memcmp(magic, s_magic, sizeof(s_magic)) != 0
+		||	!read(&version, sizeof(version))
+		||	version != s_version
+		||	!read(&featureCount, sizeof(featureCount))
+		||	!read(&storedPointCount, sizeof(storedPointCount))
+		||	storedPointCount != pointCount
+		||	!read(&voxelSize, sizeof(voxelSize)))
+	{
+		m_file.unmap(data);
+		m_file.close();
+		return false;
+	}
+
+	std::vector<Entry> entries(featureCount);
+	for (Entry& entry : entries)
+	{
+		int32_t source = 0;
+		uint32_t nameLength = 0;
+		if (!read(&source, sizeof(source)) || !read(&nameLength, sizeof(nameLength)) || offset + nameLength > static_cast<size_t>(fileSize))
+		{
+			m_file.unmap(data);
+			m_file.close();
+			return false;
+		}
+		entry.source = static_cast<Features::Source>(source);
+		entry.name.assign(reinterpret_cast<const char*>(data + offset), nameLength);
+		offset += nameLength;
+	}
+
+	// columns
+	offset = ((offset + s_alignment - 1) / s_alignment) * s_alignment;
+	if (offset + featureCount * pointCount * sizeof(float) != static_cast<size_t>(fileSize))
+	{
+		m_file.unmap(data);
+		m_file.close();
+		return false;
+	}
+	for (Entry& entry : entries)
+	{
+		entry.values = reinterpret_cast<const float*>(data + offset);
+		offset += pointCount * sizeof(float);
+	}
+
+	m_entries = std::move(entries);
+	m_data = data;
+	m_voxelSize = voxelSize;
+
+	return true;
+}
+
+void FeatureCache::addFeatures(Features::Source source, Feature_set& features) const
+{
+	assert(isLoaded());
+	for (const Entry& entry : m_entries)
+	{
+		if (entry.source == source)
+		{
+			features.add<Cached_feature>(entry.name, entry.values);
+		}
+	}
+}
+
+bool FeatureCache::save(Feature_set& features, const std::vector<Features::Source>& sources, std::size_t pointCount, double voxelSize)
+{
+	assert(sources.size() == features.size());
+
+	std::vector<std::size_t> cached;
+	for (std::size_t i = 0; i < features.size(); ++i)
+	{
+		if (IsCacheable(sources[i]))
+			cached.push_back(i);
+	}
+	if (cached.empty())
+	{
+		return false;
+	}
+
+	QDir().mkpath(QFileInfo(m_file.fileName()).absolutePath());
+
+	// write in a temporary file first (so that an interrupted write never leaves a corrupted cache)
+	QString tempFileName = m_file.fileName() + ".tmp";
+	QFile out(tempFileName);
+	if (!out.open(QFile::WriteOnly | QFile::Truncate))
+	{
+		return false;
+	}
+
+	uint32_t featureCount = static_cast<uint32_t>(cached.size());
+	uint64_t storedPointCount = pointCount;
+	out.write(s_magic, sizeof(s_magic));
+	out.write(reinterpret_cast<const char*>(&s_version), sizeof(s_version));
+	out.write(reinterpret_cast<const char*>(&featureCount), sizeof(featureCount));
+	out.write(reinterpret_cast<const char*>(&storedPointCount), sizeof(storedPointCount));
+	out.write(reinterpret_cast<const char*>(&voxelSize), sizeof(voxelSize));
+	for (std::size_t index : cached)
+	{
+		int32_t source = static_cast<int32_t>(sources[index]);
+		std::string name = features[index]->name();
+		uint32_t nameLength = static_cast<uint32_t>(name.size());
+		out.write(reinterpret_cast<const char*>(&source), sizeof(source));
+		out.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+		out.write(name.data(), nameLength);
+	}
+	qint64 padding = ((out.pos() + s_alignment - 1) / s_alignment) * s_alignment - out.pos();
+	out.write(QByteArray(static_cast<int>(padding), '\0'));
+
+	std::vector<float> block;
+	block.reserve(s_blockSize);
+	for (std::size_t index : cached)
+	{
+		Feature_handle feature = features[index];
+		for (std::size_t start = 0; start < pointCount; start += s_blockSize)
+		{
+			std::size_t stop = std::min(pointCount, start + s_blockSize);
+			block.clear();
+			for (std::size_t i = start; i < stop; ++i)
+				block.push_back(feature->value(i));
+			if (out.write(reinterpret_cast<const char*>(block.data()), block.size() * sizeof(float)) < 0)
+			{
+				out.close();
+				out.remove();
+				return false;
+			}
+		}
+	}
+	out.close();
+
+	QFile::remove(m_file.fileName());
+	return QFile::rename(tempFileName, m_file.fileName());
+}
@@ -0,0 +1,257 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "FlatForest.h"
+
+//CGAL
+#include <CGAL/for_each.h>
+
+//system
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//! Number of points evaluated at once
+static const std::size_t s_blockSize = 256;
+
+// the trees and nodes of liblearning are either stored by value or by (smart) pointer
+template <typename T> static const T& Deref(const T& t) { return t; }
+template <typename T> static const T& Deref(const std::unique_ptr<T>& t) { return *t; }
+
+namespace
+{
+	//! Compiles the nodes of a tree (depth-first, the 'low' child is stored right after its parent)
+	template <typename Node>
+	class TreeCompiler
+	{
+	public:
+		TreeCompiler(std::size_t featureCount,
+					std::size_t classCount,
+					std::vector<uint32_t>& feature,
+					std::vector<float>& threshold,
+					std::vector<uint32_t>& children,
+					std::vector<uint32_t>& distribution,
+					std::vector<float>& distributions)
+			: m_probe(featureCount, 0.f)
+			, m_classCount(classCount)
+			, m_feature(feature)
+			, m_threshold(threshold)
+			, m_children(children)
+			, m_distribution(distribution)
+			, m_distributions(distributions)
+			, m_depth(0)
+		{}
+
+		//! Compiles a node and its children, returns the node index (or -1 on error)
+		int64_t compile(const Node& node, uint32_t depth)
+		{
+			m_depth = std::max(m_depth, depth);
+
+			uint32_t index = static_cast<uint32_t>(m_feature.size());
+			m_feature.push_back(0);
+			m_threshold.push_back(std::numeric_limits<float>::infinity());
+			m_children.push_back(index);
+			m_children.push_back(index);
+			m_distribution.push_back(0);
+
+			if (node.is_leaf)
+			{
+				// a leaf doesn't read the sample
+				const float* dist = node.evaluate(m_probe.data());
+				m_distribution[index] = static_cast<uint32_t>(m_distributions.size());
+				m_distributions.insert(m_distributions.end(), dist, dist + m_classCount);
+				return index;
+			}
+
+			const Node& left = Deref(node.left);
+			const Node& right = Deref(node.right);
+			int feature = node.splitter.feature;
+			float threshold = node.splitter.threshold;
+			if (feature < 0 || static_cast<std::size_t>(feature) >= m_probe.size())
+			{
+				return -1;
+			}
+
+			// find which child is selected below, at and above the threshold (with the node itself, so that
+			// the compiled forest doesn't depend on the split convention)
+			bool below, at, above;
+			if (!isRight(node, left, right, feature, std::nextafter(threshold, -std::numeric_limits<float>::infinity()), below)
+				|| !isRight(node, left, right, feature, threshold, at)
+				|| !isRight(node, left, right, feature, std::nextafter(threshold, std::numeric_limits<float>::infinity()), above)
+				|| below == above)
+			{
+				return -1;
+			}
+			const Node& low = (above ? left : right);
+			const Node& high = (above ? right : left);
+			bool tieHigh = (at == above);
+
+			m_feature[index] = static_cast<uint32_t>(feature);
+			m_threshold[index] = (tieHigh ? std::nextafter(threshold, -std::numeric_limits<float>::infinity()) : threshold);
+
+			int64_t lowIndex = compile(low, depth + 1);
+			if (lowIndex < 0)
+				return -1;
+			int64_t highIndex = compile(high, depth + 1);
+			if (highIndex < 0)
+				return -1;
+			m_children[2 * index] = static_cast<uint32_t>(lowIndex);
+			m_children[2 * index + 1] = static_cast<uint32_t>(highIndex);
+
+			return index;
+		}
+
+		//! Returns the depth of the compiled tree
+		uint32_t depth() const { return m_depth; }
+
+	protected:
+		//! Checks whether the node selects its right child for a given feature value
+		bool isRight(const Node& node, const Node& left, const Node& right, int feature, float value, bool& result)
+		{
+			m_probe[feature] = value;
+			const float* dist = node.evaluate(m_probe.data());
+			bool isLeft = (dist == left.evaluate(m_probe.data()));
+			result = (dist == right.evaluate(m_probe.data()));
+			m_probe[feature] = 0.f;
+			return (isLeft != result);
+		}
+
+		std::vector<float> m_probe;
+		std::size_t m_classCount;
+		std::vector<uint32_t>& m_feature;
+		std::vector<float>& m_threshold;
+		std::vector<uint32_t>& m_children;
+		std::vector<uint32_t>& m_distribution;
+		std::vector<float>& m_distributions;
+		uint32_t m_depth;
+	};
+}
+
+FlatForest::FlatForest()
+	: m_classCount(0)
+	, m_featureCount(0)
+{
+}
+
+bool FlatForest::compile(const ModelBundle::Forest& forest)
+{
+	*this = FlatForest();
+
+	if (forest.trees.empty() || forest.params.n_classes == 0 || forest.params.n_features == 0)
+	{
+		return false;
+	}
+	m_classCount = forest.params.n_classes;
+	m_featureCount = forest.params.n_features;
+
+	for (const auto& treeHandle : forest.trees)
+	{
+		const auto& tree = Deref(treeHandle);
+		typedef std::decay<decltype(Deref(tree.root_node))>::type Node;
+
+		TreeCompiler<Node> compiler(m_featureCount, m_classCount, m_feature, m_threshold, m_children, m_distribution, m_distributions);
+		int64_t root = compiler.compile(Deref(tree.root_node), 0);
+		if (root < 0)
+		{
+			*this = FlatForest();
+			return false;
+		}
+		m_roots.push_back(static_cast<uint32_t>(root));
+		m_depths.push_back(compiler.depth());
+	}
+
+	// only the features used by a split have to be read
+	std::vector<bool> used(m_featureCount, false);
+	for (std::size_t i = 0; i < m_feature.size(); ++i)
+	{
+		if (m_children[2 * i] != i) // not a leaf
+			used[m_feature[i]] = true;
+	}
+	for (uint32_t f = 0; f < m_featureCount; ++f)
+	{
+		if (used[f])
+			m_usedFeatures.push_back(f);
+	}
+
+	return true;
+}
+
+void FlatForest::evaluateBlock(const float* columns, std::size_t count, float* probabilities) const
+{
+	uint32_t nodes[s_blockSize];
+
+	std::fill(probabilities, probabilities + count * m_classCount, 0.f);
+
+	for (std::size_t t = 0; t < m_roots.size(); ++t)
+	{
+		std::fill(nodes, nodes + count, m_roots[t]);
+
+		// level by level traversal (the leaves loop on themselves)
+		for (uint32_t d = 0; d < m_depths[t]; ++d)
+		{
+			for (std::size_t p = 0; p < count; ++p)
+			{
+				uint32_t n = nodes[p];
+				float value = columns[m_feature[n] * s_blockSize + p];
+				nodes[p] = m_children[2 * n + (value > m_threshold[n] ? 1 : 0)];
+			}
+		}
+
+		for (std::size_t p = 0; p < count; ++p)
+		{
+			const float* dist = m_distributions.data() + m_distribution[nodes[p]];
+			float* out = probabilities + p * m_classCount;
+			for (std::size_t c = 0; c < m_classCount; ++c)
+				out[c] += dist[c];
+		}
+	}
+
+	// average over the trees (clamped as with the ETHZ classifier)
+	const float scale = 1.f / m_roots.size();
+	for (std::size_t i = 0; i < count * m_classCount; ++i)
+	{
+		probabilities[i] = std::min(1.f, std::max(0.f, probabilities[i] * scale));
+	}
+}
+
+void FlatForest::evaluate(const Feature_set& features, std::size_t pointCount, std::vector<float>& probabilities) const
+{
+	assert(isValid());
+	assert(features.size() == m_featureCount);
+
+	probabilities.resize(pointCount * m_classCount);
+
+	std::size_t blockCount = (pointCount + s_blockSize - 1) / s_blockSize;
+	CGAL::for_each<CGAL::Parallel_if_available_tag>(boost::irange<std::size_t>(0, blockCount), [&](std::size_t block) -> bool
+	{
+		std::size_t start = block * s_blockSize;
+		std::size_t count = std::min(s_blockSize, pointCount - start);
+
+		// column-major feature matrix (only the used features are read)
+		std::vector<float> columns(m_featureCount * s_blockSize, 0.f);
+		for (uint32_t f : m_usedFeatures)
+		{
+			Feature_handle feature = features[f];
+			float* column = columns.data() + f * s_blockSize;
+			for (std::size_t p = 0; p < count; ++p)
+				column[p] = feature->value(start + p);
+		}
+
+		evaluateBlock(columns.data(), count, probabilities.data() + start * m_classCount);
+		return true;
+	});
+}
@@ -0,0 +1,253 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "ForestEvaluator.h"
+#include "TrainingSampler.h"
+
+//Qt
+#include <QFile>
+#include <QTextStream>
+#include <QtConcurrentMap>
+
+//system
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <cmath>
+#include <random>
+
+ForestEvaluator::ForestEvaluator(Label_set& labels, Feature_set& features, const std::vector<int>& groundTruth)
+	: m_labels(labels)
+	, m_features(features)
+	, m_groundTruth(groundTruth)
+	, m_foldCount(0)
+{
+}
+
+void ForestEvaluator::makeSpatialFolds(int k, const Cloud_view& view, double blockSize, unsigned seed)
+{
+	assert(k > 1 && blockSize > 0);
+	assert(view.size() == m_groundTruth.size());
+
+	m_foldCount = k;
+	m_folds.assign(m_groundTruth.size(), -1);
+
+	// each block is assigned to a random fold (the same for all its points)
+	std::mt19937 rng(seed);
+	std::map<std::pair<int64_t, int64_t>, int> blockFolds;
+	for (std::size_t i = 0; i < m_groundTruth.size(); ++i)
+	{
+		if (m_groundTruth[i] == -1)
+			continue;
+		const CCVector3* P = view.point(i);
+		std::pair<int64_t, int64_t> block(static_cast<int64_t>(std::floor(P->x / blockSize)), static_cast<int64_t>(std::floor(P->y / blockSize)));
+		auto it = blockFolds.find(block);
+		if (it == blockFolds.end())
+		{
+			it = blockFolds.insert({ block, std::uniform_int_distribution<int>(0, k - 1)(rng) }).first;
+		}
+		m_folds[i] = it->second;
+	}
+}
+
+void ForestEvaluator::makeRandomFolds(int k, unsigned seed)
+{
+	assert(k > 1);
+
+	m_foldCount = k;
+	m_folds.assign(m_groundTruth.size(), -1);
+
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> fold(0, k - 1);
+	for (std::size_t i = 0; i < m_groundTruth.size(); ++i)
+	{
+		if (m_groundTruth[i] != -1)
+			m_folds[i] = fold(rng);
+	}
+}
+
+bool ForestEvaluator::evaluate(	const std::vector<Configuration>& configurations,
+								bool balanceClasses,
+								unsigned seed,
+								std::vector<Result>& results,
+								std::function<bool()> isCanceled)
+{
+	assert(m_foldCount > 1);
+
+	// predicted label of each point, for each configuration
+	std::vector<std::vector<int>> predictions(configurations.size(), std::vector<int>(m_groundTruth.size(), -1));
+	std::vector<double> trainTimes(configurations.size() * m_foldCount, 0);
+	std::vector<double> inferenceTimes(configurations.size() * m_foldCount, 0);
+
+	std::vector<std::size_t> tasks(configurations.size() * m_foldCount);
+	for (std::size_t t = 0; t < tasks.size(); ++t)
+	{
+		tasks[t] = t;
+	}
+
+	std::atomic<bool> canceled(false);
+	QtConcurrent::blockingMap(tasks, [&](std::size_t task)
+	{
+		if (canceled || (isCanceled && isCanceled()))
+		{
+			canceled = true;
+			return;
+		}
+
+		const Configuration& config = configurations[task / m_foldCount];
+		const int fold = static_cast<int>(task % m_foldCount);
+
+		// train on the other folds
+		std::vector<int> training(m_groundTruth.size(), -1);
+		for (std::size_t i = 0; i < m_groundTruth.size(); ++i)
+		{
+			if (m_folds[i] != -1 && m_folds[i] != fold)
+				training[i] = m_groundTruth[i];
+		}
+		TrainingSampler sampler(static_cast<std::size_t>(std::max(config.maxCorePoints, 0)), balanceClasses, 0, seed + static_cast<unsigned>(fold));
+		if (sampler.isActive())
+			sampler.select(training, nullptr);
+
+		CGAL::Real_timer timer;
+		timer.start();
+		Classification::ETHZ::Random_forest_classifier classifier(m_labels, m_features);
+		classifier.train(training, true, config.numTrees, config.maxDepth);
+		timer.stop();
+		trainTimes[task] = timer.time();
+
+		// predict the fold
+		timer.reset();
+		timer.start();
+		std::vector<int>& predicted = predictions[task / m_foldCount];
+		std::vector<float> probabilities;
+		for (std::size_t i = 0; i < m_groundTruth.size(); ++i)
+		{
+			if (m_folds[i] != fold)
+				continue;
+			classifier(i, probabilities);
+			predicted[i] = static_cast<int>(std::max_element(probabilities.begin(), probabilities.end()) - probabilities.begin());
+		}
+		timer.stop();
+		inferenceTimes[task] = timer.time();
+	});
+
+	if (canceled)
+	{
+		return false;
+	}
+
+	results.resize(configurations.size());
+	for (std::size_t c = 0; c < configurations.size(); ++c)
+	{
+		Result& result = results[c];
+		result.config = configurations[c];
+		for (int f = 0; f < m_foldCount; ++f)
+		{
+			result.trainTime += trainTimes[c * m_foldCount + f];
+			result.inferenceTime += inferenceTimes[c * m_foldCount + f];
+		}
+
+		Classification::Evaluation evaluation(m_labels, m_groundTruth, predictions[c]);
+		result.accuracy = evaluation.accuracy();
+		result.meanF1 = evaluation.mean_f1_score();
+		result.meanIoU = evaluation.mean_intersection_over_union();
+		result.precision.clear();
+		result.recall.clear();
+		result.iou.clear();
+		for (Label_handle label : m_labels)
+		{
+			result.precision.push_back(evaluation.precision(label));
+			result.recall.push_back(evaluation.recall(label));
+			result.iou.push_back(evaluation.intersection_over_union(label));
+		}
+	}
+
+	return true;
+}
+
+std::size_t ForestEvaluator::Best(const std::vector<Result>& results)
+{
+	std::size_t best = 0;
+	for (std::size_t i = 1; i < results.size(); ++i)
+	{
+		if (results[i].meanIoU > results[best].meanIoU)
+			best = i;
+	}
+	return best;
+}
+
+QStringList ForestEvaluator::report(const std::vector<Result>& results) const
+{
+	QStringList lines;
+	lines << QString("%1-fold cross-validation of %2 configuration(s)").arg(m_foldCount).arg(results.size());
+	for (const Result& result : results)
+	{
+		lines << QString("trees: %1, max depth: %2, max core points: %3 -> accuracy: %4, mean F1: %5, mean IoU: %6 (training: %7 s, inference: %8 s)")
+			.arg(result.config.numTrees)
+			.arg(result.config.maxDepth)
+			.arg(result.config.maxCorePoints)
+			.arg(result.accuracy)
+			.arg(result.meanF1)
+			.arg(result.meanIoU)
+			.arg(result.trainTime)
+			.arg(result.inferenceTime);
+		std::size_t l = 0;
+		for (Label_handle label : m_labels)
+		{
+			lines << QString("    %1: precision %2, recall %3, IoU %4")
+				.arg(QString::fromStdString(label->name()))
+				.arg(result.precision[l])
+				.arg(result.recall[l])
+				.arg(result.iou[l]);
+			++l;
+		}
+	}
+	return lines;
+}
+
+bool ForestEvaluator::saveCSV(const QString& filename, const std::vector<Result>& results, QString& errorMessage) const
+{
+	QFile file(filename);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+	{
+		errorMessage = QString("Failed to open file [%1] for writing").arg(filename);
+		return false;
+	}
+
+	QTextStream stream(&file);
+	stream << "num_trees,max_depth,max_core_points,accuracy,mean_f1,mean_iou,train_time,inference_time";
+	for (Label_handle label : m_labels)
+	{
+		QString name = QString::fromStdString(label->name());
+		stream << "," << name << " precision," << name << " recall," << name << " iou";
+	}
+	stream << "\n";
+
+	for (const Result& result : results)
+	{
+		stream << result.config.numTrees << "," << result.config.maxDepth << "," << result.config.maxCorePoints << ","
+			<< result.accuracy << "," << result.meanF1 << "," << result.meanIoU << ","
+			<< result.trainTime << "," << result.inferenceTime;
+		for (std::size_t l = 0; l < result.iou.size(); ++l)
+		{
+			stream << "," << result.precision[l] << "," << result.recall[l] << "," << result.iou[l];
+		}
+		stream << "\n";
+	}
+
+	return true;
+}
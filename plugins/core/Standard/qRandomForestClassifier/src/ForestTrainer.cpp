@@ -0,0 +1,92 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "ForestTrainer.h"
+
+//system
+#include <algorithm>
+#include <sstream>
+
+bool ForestTrainer::Train(	Forest_classifier& classifier,
+							const std::vector<int>& groundTruth,
+							bool reset,
+							std::size_t treeCount,
+							std::size_t maxDepth,
+							const Chunk_callback& callback)
+{
+	const std::size_t chunkSize = std::max<std::size_t>(1, treeCount / 10);
+
+	// parameters stored in the forest (for the trees added to it)
+	std::size_t forestTreeCount = 0;
+	for (std::size_t trained = 0; trained < treeCount; )
+	{
+		if (callback && !callback(trained))
+		{
+			return false;
+		}
+
+		std::size_t count = std::min(chunkSize, treeCount - trained);
+		if (reset && trained == 0)
+		{
+			// the forest is created with the parameters of the chunk
+			classifier.train(groundTruth, true, count, maxDepth);
+		}
+		else
+		{
+			// the parameters of a loaded forest (n_trees, max_depth) are always replaced before the first chunk
+			if (trained == 0 || count != forestTreeCount)
+			{
+				SetTreeParams(classifier, count, maxDepth);
+			}
+			classifier.train(groundTruth, false, count, maxDepth);
+		}
+		forestTreeCount = count;
+		trained += count;
+	}
+
+	return true;
+}
+
+std::size_t ForestTrainer::TreeCount(const Forest_classifier& classifier)
+{
+	std::ostringstream config(std::ios_base::binary);
+	classifier.save_configuration(config);
+
+	CGAL::internal::liblearning::RandomForest::ForestParams forestParams;
+	Forest forest(forestParams);
+	std::istringstream input(config.str(), std::ios_base::binary);
+	forest.read(input);
+	return forest.trees.size();
+}
+
+void ForestTrainer::SetTreeParams(Forest_classifier& classifier, std::size_t treeCount, std::size_t maxDepth)
+{
+	std::ostringstream config(std::ios_base::binary);
+	classifier.save_configuration(config);
+
+	CGAL::internal::liblearning::RandomForest::ForestParams forestParams;
+	Forest forest(forestParams);
+	std::istringstream input(config.str(), std::ios_base::binary);
+	forest.read(input);
+	forest.params.n_trees = treeCount;
+	forest.params.max_depth = maxDepth;
+
+	std::ostringstream output(std::ios_base::binary);
+	forest.write(output);
+	std::istringstream newConfig(output.str(), std::ios_base::binary);
+	classifier.load_configuration(newConfig);
+}
@@ -0,0 +1,108 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "KNeighborGraph.h"
+
+//CGAL
+#include <CGAL/for_each.h>
+
+//system
+#include <algorithm>
+#include <limits>
+
+//! Number of points whose neighbors are searched by the same task
+static const std::size_t s_blockSize = 4096;
+
+KNeighborGraph::KNeighborGraph(const Cloud_view& view, const Neighborhood& neighborhood, std::size_t k)
+	: m_view(view)
+	, m_k(std::min(k, view.size()))
+{
+	build(neighborhood.k_neighbor_query(m_k));
+}
+
+KNeighborGraph::KNeighborGraph(const Cloud_view& view, const OctreeNeighborhood& neighborhood, std::size_t k)
+	: m_view(view)
+	, m_k(std::min(k, view.size()))
+{
+	assert(neighborhood.isValid());
+	build(neighborhood.k_neighbor_query(static_cast<unsigned>(m_k)));
+}
+
+template <typename NeighborQuery>
+void KNeighborGraph::build(const NeighborQuery& neighborQuery)
+{
+	assert(m_view.size() <= std::numeric_limits<uint32_t>::max());
+
+	const std::size_t pointCount = m_view.size();
+	m_neighbors.resize(pointCount * m_k);
+	if (m_k == 0)
+	{
+		return;
+	}
+
+	if (m_view.subset)
+	{
+		m_subsetIndexes.reserve(pointCount);
+		for (std::size_t i = 0; i < pointCount; ++i)
+		{
+			m_subsetIndexes[m_view.localIndex(i)] = static_cast<uint32_t>(i);
+		}
+	}
+
+	CC_point_map pointMap{ m_view };
+	std::size_t blockCount = (pointCount + s_blockSize - 1) / s_blockSize;
+	CGAL::for_each<CGAL::Parallel_if_available_tag>(boost::irange<std::size_t>(0, blockCount), [&](std::size_t block) -> bool
+	{
+		std::vector<std::size_t> neighbors;
+		neighbors.reserve(m_k);
+		std::size_t end = std::min(pointCount, (block + 1) * s_blockSize);
+		for (std::size_t i = block * s_blockSize; i < end; ++i)
+		{
+			neighbors.clear();
+			neighborQuery(get(pointMap, i), std::back_inserter(neighbors));
+			uint32_t* out = m_neighbors.data() + i * m_k;
+			for (std::size_t j = 0; j < m_k; ++j)
+			{
+				// the point itself completes the list if fewer neighbors were found
+				out[j] = static_cast<uint32_t>(j < neighbors.size() ? neighbors[j] : i);
+			}
+		}
+		return true;
+	});
+}
+
+std::size_t KNeighborGraph::indexOf(const Point& point) const
+{
+	// the points are mapped in place onto the cloud(s): their address gives their index
+	const CCVector3* P = reinterpret_cast<const CCVector3*>(&point);
+	const CCVector3* first = m_view.cloud1->getPoint(0);
+	bool inCloud1 = (P >= first && P < first + m_view.cloud1->size());
+	if (!inCloud1)
+	{
+		assert(m_view.cloud2);
+		first = m_view.cloud2->getPoint(0);
+	}
+	unsigned localIndex = static_cast<unsigned>(P - first);
+
+	if (m_view.subset)
+	{
+		auto it = m_subsetIndexes.find(localIndex);
+		assert(it != m_subsetIndexes.end());
+		return it->second;
+	}
+	return inCloud1 ? localIndex : m_view.split + localIndex;
+}
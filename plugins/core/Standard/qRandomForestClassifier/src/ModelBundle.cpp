@@ -0,0 +1,431 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "ModelBundle.h"
+
+//CGAL
+#include <CGAL/for_each.h>
+
+//Qt
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+//system
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <sstream>
+
+// File layout:
+//  - magic (8 bytes), version (uint32), schema size (uint32)
+//  - schema (JSON)
+//  - ETHZ random forest configuration (up to the end of the file)
+static const char s_magic[8] = { 'R', 'F', 'C', 'M', 'O', 'D', 'E', 'L' };
+static const uint32_t s_version = 1;
+static const size_t s_headerSize = sizeof(s_magic) + 2 * sizeof(uint32_t);
+
+// the trees and nodes of liblearning are either stored by value or by (smart) pointer
+template <typename T> static const T& Deref(const T& t) { return t; }
+template <typename T> static const T& Deref(const std::unique_ptr<T>& t) { return *t; }
+
+// the trees of liblearning are either stored by (smart) pointer or in a pointer container
+template <typename T> static void AppendTrees(std::vector<std::unique_ptr<T>>& trees, std::vector<std::unique_ptr<T>>& others)
+{
+	for (std::unique_ptr<T>& tree : others)
+	{
+		trees.push_back(std::move(tree));
+	}
+	others.clear();
+}
+template <typename Trees> static void AppendTrees(Trees& trees, Trees& others)
+{
+	trees.transfer(trees.end(), others);
+}
+
+ModelBundle::ModelBundle()
+	: nscales(0)
+	, min_scale(-1.0)
+	, octree_neighborhoods(false)
+{
+}
+
+bool ModelBundle::load(const QString& filename, QString& errorMessage)
+{
+	*this = ModelBundle();
+
+	QFile file(filename);
+	if (!file.open(QFile::ReadOnly))
+	{
+		errorMessage = QString("Failed to open file [%1]").arg(filename);
+		return false;
+	}
+	QByteArray data = file.readAll();
+	file.close();
+
+	if (data.size() < static_cast<int>(s_headerSize) || memcmp(data.constData(), s_magic, sizeof(s_magic)) != 0)
+	{
+		// older classifier file (forest only)
+		forest.assign(data.constData(), data.size());
+		return true;
+	}
+
+	uint32_t version = 0;
+	uint32_t schemaSize = 0;
+	memcpy(&version, data.constData() + sizeof(s_magic), sizeof(version));
+	memcpy(&schemaSize, data.constData() + sizeof(s_magic) + sizeof(version), sizeof(schemaSize));
+	if (version > s_version)
+	{
+		errorMessage = QString("Classifier file [%1] was saved with a newer version of the plugin").arg(filename);
+		return false;
+	}
+	if (s_headerSize + schemaSize > static_cast<size_t>(data.size()))
+	{
+		errorMessage = QString("Classifier file [%1] is truncated").arg(filename);
+		return false;
+	}
+
+	QJsonParseError parseError;
+	QJsonDocument document = QJsonDocument::fromJson(data.mid(static_cast<int>(s_headerSize), static_cast<int>(schemaSize)), &parseError);
+	if (parseError.error != QJsonParseError::NoError || !document.isObject())
+	{
+		errorMessage = QString("Invalid classifier file [%1]: %2").arg(filename, parseError.errorString());
+		return false;
+	}
+
+	QJsonObject schema = document.object();
+	nscales = schema.value("scales").toInt(0);
+	min_scale = schema.value("min_scale").toDouble(-1.0);
+	octree_neighborhoods = (schema.value("neighborhoods").toString() == "octree");
+	for (const QJsonValue& value : schema.value("classes").toArray())
+	{
+		classes_list.push_back(value.toInt());
+	}
+	for (const QJsonValue& value : schema.value("labels").toArray())
+	{
+		label_names.push_back(value.toString().toStdString());
+	}
+	for (const QJsonValue& value : schema.value("sources").toArray())
+	{
+		QJsonObject object = value.toObject();
+		Source source;
+		source.source = static_cast<Features::Source>(object.value("source").toInt());
+		source.sf_name = object.value("name").toString().toStdString();
+		sources.push_back(source);
+	}
+	for (const QJsonValue& value : schema.value("features").toArray())
+	{
+		features.push_back(value.toString().toStdString());
+	}
+
+	const size_t forestStart = s_headerSize + schemaSize;
+	forest.assign(data.constData() + forestStart, data.size() - forestStart);
+
+	return true;
+}
+
+bool ModelBundle::save(const QString& filename, QString& errorMessage) const
+{
+	QJsonObject schema;
+	schema.insert("scales", nscales);
+	schema.insert("min_scale", min_scale);
+	schema.insert("neighborhoods", octree_neighborhoods ? "octree" : "cgal");
+	QJsonArray classes;
+	for (int index : classes_list)
+	{
+		classes.append(index);
+	}
+	schema.insert("classes", classes);
+	QJsonArray labels;
+	for (const std::string& name : label_names)
+	{
+		labels.append(QString::fromStdString(name));
+	}
+	schema.insert("labels", labels);
+	QJsonArray sourceArray;
+	for (const Source& source : sources)
+	{
+		QJsonObject object;
+		object.insert("source", static_cast<int>(source.source));
+		if (source.source == Features::Source::CC_SCALAR_FIELD)
+			object.insert("name", QString::fromStdString(source.sf_name));
+		sourceArray.append(object);
+	}
+	schema.insert("sources", sourceArray);
+	QJsonArray featureArray;
+	for (const std::string& name : features)
+	{
+		featureArray.append(QString::fromStdString(name));
+	}
+	schema.insert("features", featureArray);
+
+	QByteArray json = QJsonDocument(schema).toJson(QJsonDocument::Compact);
+	uint32_t schemaSize = static_cast<uint32_t>(json.size());
+
+	QFile file(filename);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate))
+	{
+		errorMessage = QString("Failed to open file [%1] for writing").arg(filename);
+		return false;
+	}
+	file.write(s_magic, sizeof(s_magic));
+	file.write(reinterpret_cast<const char*>(&s_version), sizeof(s_version));
+	file.write(reinterpret_cast<const char*>(&schemaSize), sizeof(schemaSize));
+	file.write(json);
+	if (file.write(forest.data(), static_cast<qint64>(forest.size())) != static_cast<qint64>(forest.size()))
+	{
+		errorMessage = QString("Failed to write file [%1]").arg(filename);
+		return false;
+	}
+	file.close();
+
+	return true;
+}
+
+bool ModelBundle::getFeatures(ccPointCloud* cloud, std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> >& out, QString& errorMessage) const
+{
+	out.clear();
+	for (const Source& source : sources)
+	{
+		CCCoreLib::ScalarField* sf = nullptr;
+		if (source.source == Features::Source::CC_SCALAR_FIELD)
+		{
+			int sfIdx = cloud->getScalarFieldIndexByName(source.sf_name.c_str());
+			if (sfIdx < 0)
+			{
+				errorMessage = QString("The classifier requires the scalar field '%1' (not found in cloud '%2')").arg(QString::fromStdString(source.sf_name), cloud->getName());
+				return false;
+			}
+			sf = cloud->getScalarField(sfIdx);
+		}
+		else if (source.source == Features::Source::CC_COLOR_FIELD && !cloud->hasColors())
+		{
+			errorMessage = QString("The classifier requires colors (not found in cloud '%1')").arg(cloud->getName());
+			return false;
+		}
+		else if (source.source == Features::Source::CC_NORMALS_FIELD && !cloud->hasNormals())
+		{
+			errorMessage = QString("The classifier requires normals (not found in cloud '%1')").arg(cloud->getName());
+			return false;
+		}
+		out.push_back({ source.source, sf });
+	}
+	return true;
+}
+
+void ModelBundle::readForest(Forest& rfc) const
+{
+	std::istringstream input(forest, std::ios_base::binary);
+	rfc.read(input);
+}
+
+bool ModelBundle::getFeatureUsage(std::vector<bool>& used) const
+{
+	used.clear();
+	if (!hasSchema())
+	{
+		return false;
+	}
+
+	CGAL::internal::liblearning::RandomForest::ForestParams forestParams;
+	Forest rfc(forestParams);
+	readForest(rfc);
+	if (rfc.params.n_features != features.size())
+	{
+		return false;
+	}
+
+	std::vector<std::size_t> count(features.size(), 0);
+	rfc.get_feature_usage(count);
+
+	used.resize(count.size());
+	for (std::size_t i = 0; i < count.size(); ++i)
+	{
+		used[i] = (count[i] != 0);
+	}
+	return true;
+}
+
+QStringList ModelBundle::description() const
+{
+	QStringList desc;
+	if (!hasSchema())
+	{
+		desc << "No feature description (older classifier file)";
+		return desc;
+	}
+
+	desc << QString("No. of scales: %1").arg(nscales);
+	if (min_scale > 0)
+		desc << QString("Min. scale: %1").arg(min_scale);
+	desc << QString("Neighborhoods: %1").arg(octree_neighborhoods ? "octree" : "CGAL");
+	QStringList classes;
+	for (int index : classes_list)
+	{
+		classes << QString::number(index);
+	}
+	desc << QString("Classes: %1").arg(classes.join(", "));
+	QStringList sourceNames;
+	for (const Source& source : sources)
+	{
+		switch (source.source)
+		{
+		case Features::Source::CGAL_GENERATED_FEATURE:
+			sourceNames << "point features";
+			break;
+		case Features::Source::CC_COLOR_FIELD:
+			sourceNames << "colors";
+			break;
+		case Features::Source::CC_NORMALS_FIELD:
+			sourceNames << "normals";
+			break;
+		case Features::Source::CC_SCALAR_FIELD:
+			sourceNames << QString::fromStdString(source.sf_name);
+			break;
+		default:
+			break;
+		}
+	}
+	desc << QString("Feature sources: %1").arg(sourceNames.join(", "));
+	desc << QString("No. of computed features: %1").arg(features.size());
+	std::vector<bool> used;
+	if (getFeatureUsage(used))
+		desc << QString("No. of features used by the forest: %1").arg(std::count(used.begin(), used.end(), true));
+
+	return desc;
+}
+
+std::size_t ModelBundle::keepBestTrees(std::size_t count, const std::vector<float>& samples, const std::vector<int>& labels)
+{
+	CGAL::internal::liblearning::RandomForest::ForestParams forestParams;
+	Forest rfc(forestParams);
+	readForest(rfc);
+	if (rfc.trees.size() <= count || rfc.params.n_features == 0)
+	{
+		return 0;
+	}
+	const std::size_t featureCount = rfc.params.n_features;
+	const std::size_t classCount = rfc.params.n_classes;
+	assert(samples.size() == labels.size() * featureCount);
+
+	// number of samples correctly predicted by each tree
+	std::vector<std::size_t> correct(rfc.trees.size(), 0);
+	CGAL::for_each<CGAL::Parallel_if_available_tag>(boost::irange<std::size_t>(0, rfc.trees.size()), [&](std::size_t t) -> bool
+	{
+		const auto& root = Deref(Deref(rfc.trees[t]).root_node);
+		for (std::size_t i = 0; i < labels.size(); ++i)
+		{
+			const float* distribution = root.evaluate(samples.data() + i * featureCount);
+			if (std::max_element(distribution, distribution + classCount) - distribution == labels[i])
+				++correct[t];
+		}
+		return true;
+	});
+
+	// the most accurate trees are kept (in their original order)
+	std::vector<std::size_t> order(rfc.trees.size());
+	for (std::size_t t = 0; t < order.size(); ++t)
+	{
+		order[t] = t;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return correct[a] > correct[b]; });
+	std::vector<bool> keep(rfc.trees.size(), false);
+	for (std::size_t t = 0; t < count; ++t)
+	{
+		keep[order[t]] = true;
+	}
+	for (std::size_t t = rfc.trees.size(); t-- > 0; )
+	{
+		if (!keep[t])
+			rfc.trees.erase(rfc.trees.begin() + t);
+	}
+	rfc.params.n_trees = rfc.trees.size();
+
+	std::ostringstream output(std::ios_base::binary);
+	rfc.write(output);
+	forest = output.str();
+
+	return order.size() - count;
+}
+
+bool ModelBundle::Merge(const QStringList& filenames, ModelBundle& merged, QString& errorMessage)
+{
+	if (filenames.empty())
+	{
+		errorMessage = "No classifier file to merge";
+		return false;
+	}
+
+	// the trees keep a pointer to the parameters of their forest: all the forests are kept until the merged one is written
+	std::vector<std::unique_ptr<Forest>> forests;
+	for (const QString& filename : filenames)
+	{
+		ModelBundle model;
+		if (!model.load(filename, errorMessage))
+		{
+			return false;
+		}
+
+		CGAL::internal::liblearning::RandomForest::ForestParams forestParams;
+		forests.emplace_back(new Forest(forestParams));
+		model.readForest(*forests.back());
+		if (forests.back()->trees.empty())
+		{
+			errorMessage = QString("Classifier file [%1] has no trees").arg(filename);
+			return false;
+		}
+
+		if (forests.size() == 1)
+		{
+			merged = model;
+			continue;
+		}
+
+		// same classes and features as the first file
+		bool sameSources = (model.sources.size() == merged.sources.size());
+		for (std::size_t i = 0; sameSources && i < model.sources.size(); ++i)
+		{
+			sameSources = (model.sources[i].source == merged.sources[i].source && model.sources[i].sf_name == merged.sources[i].sf_name);
+		}
+		if (	!sameSources
+			||	model.nscales != merged.nscales
+			||	model.min_scale != merged.min_scale
+			||	model.octree_neighborhoods != merged.octree_neighborhoods
+			||	model.classes_list != merged.classes_list
+			||	model.features != merged.features
+			||	forests.back()->params.n_classes != forests.front()->params.n_classes
+			||	forests.back()->params.n_features != forests.front()->params.n_features)
+		{
+			errorMessage = QString("Classifier file [%1] was not trained with the same classes and features as [%2]").arg(filename, filenames.front());
+			return false;
+		}
+	}
+
+	Forest& forest = *forests.front();
+	for (std::size_t i = 1; i < forests.size(); ++i)
+	{
+		AppendTrees(forest.trees, forests[i]->trees);
+	}
+	forest.params.n_trees = forest.trees.size();
+
+	std::ostringstream output(std::ios_base::binary);
+	forest.write(output);
+	merged.forest = output.str();
+
+	return true;
+}
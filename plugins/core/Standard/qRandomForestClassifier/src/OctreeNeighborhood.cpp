@@ -0,0 +1,280 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "OctreeNeighborhood.h"
+
+//system
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+OctreeNeighborhood::OctreeNeighborhood(const Cloud_view& view, CCCoreLib::GenericProgressCallback* progressCb)
+	: m_octree(nullptr)
+{
+	if (!view.cloud1 || view.cloud2)
+	{
+		return;
+	}
+
+	if (!view.subset)
+	{
+		m_sharedOctree = view.cloud1->getOctree();
+		if (m_sharedOctree)
+		{
+			m_octree = m_sharedOctree.data();
+			return;
+		}
+	}
+
+	// the octree is computed for the view (the indices of its points are the indices of the view)
+	CCCoreLib::GenericIndexedCloudPersist* cloud = view.cloud1;
+	if (view.subset)
+	{
+		m_subset.reset(new CCCoreLib::ReferenceCloud(view.cloud1));
+		if (!m_subset->reserve(static_cast<unsigned>(view.subset->size())))
+		{
+			m_subset.reset();
+			return;
+		}
+		for (unsigned index : *view.subset)
+		{
+			m_subset->addPointIndex(index);
+		}
+		cloud = m_subset.get();
+	}
+	m_ownOctree.reset(new CCCoreLib::DgmOctree(cloud));
+	if (m_ownOctree->build(progressCb) <= 0)
+	{
+		m_ownOctree.reset();
+		return;
+	}
+	m_octree = m_ownOctree.get();
+}
+
+unsigned char OctreeNeighborhood::levelFor(float voxelSize) const
+{
+	assert(m_octree && voxelSize > 0);
+
+	unsigned char bestLevel = 1;
+	double bestRatio = std::numeric_limits<double>::max();
+	for (unsigned char level = 1; level <= CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL; ++level)
+	{
+		double ratio = std::abs(std::log(m_octree->getCellSize(level) / voxelSize));
+		if (ratio < bestRatio)
+		{
+			bestLevel = level;
+			bestRatio = ratio;
+		}
+	}
+	return bestLevel;
+}
+
+OctreeNeighborhood::K_neighbor_query OctreeNeighborhood::k_neighbor_query(unsigned k) const
+{
+	assert(m_octree);
+	return K_neighbor_query(*this, k, m_octree->findBestLevelForAGivenPopulationPerCell(std::max(k, 3u)), false);
+}
+
+OctreeNeighborhood::Sphere_neighbor_query OctreeNeighborhood::sphere_neighbor_query(PointCoordinateType radius) const
+{
+	assert(m_octree);
+	return Sphere_neighbor_query(*this, radius, m_octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(radius), false);
+}
+
+unsigned char OctreeNeighborhood::prepareLevel(float voxelSize)
+{
+	unsigned char level = levelFor(voxelSize);
+	if (m_cells.find(level) != m_cells.end())
+	{
+		return level;
+	}
+
+	Cells& cells = m_cells[level];
+	const CCCoreLib::DgmOctree::cellsContainer& points = m_octree->pointsAndTheirCellCodes();
+	const CCCoreLib::GenericIndexedCloudPersist* cloud = m_octree->associatedCloud();
+	const unsigned char bitShift = CCCoreLib::DgmOctree::GET_BIT_SHIFT(level);
+
+	// the points are sorted by cell code: the points of a cell are contiguous
+	std::size_t start = 0;
+	while (start < points.size())
+	{
+		const CCCoreLib::DgmOctree::CellCode code = (points[start].theCode >> bitShift);
+		std::size_t end = start;
+		CCVector3d centroid(0, 0, 0);
+		for (; end < points.size() && (points[end].theCode >> bitShift) == code; ++end)
+		{
+			centroid += CCVector3d::fromArray(cloud->getPoint(points[end].theIndex)->u);
+		}
+		centroid /= static_cast<double>(end - start);
+
+		// same representative as the voxels of Point_set_neighborhood
+		unsigned representative = points[start].theIndex;
+		double minSquareDist = std::numeric_limits<double>::max();
+		for (std::size_t i = start; i < end; ++i)
+		{
+			double squareDist = (CCVector3d::fromArray(cloud->getPoint(points[i].theIndex)->u) - centroid).norm2();
+			if (squareDist < minSquareDist)
+			{
+				representative = points[i].theIndex;
+				minSquareDist = squareDist;
+			}
+		}
+
+		cells.codes.push_back(code);
+		cells.points.push_back(representative);
+		start = end;
+	}
+
+	return level;
+}
+
+template <typename Visitor>
+void OctreeNeighborhood::visitShell(const Cells& cells, unsigned char level, const Tuple3i& center, int distance, Visitor visitor) const
+{
+	const int cellCount = (1 << level);
+	for (int dx = -distance; dx <= distance; ++dx)
+	{
+		const int x = center.x + dx;
+		if (x < 0 || x >= cellCount)
+			continue;
+		for (int dy = -distance; dy <= distance; ++dy)
+		{
+			const int y = center.y + dy;
+			if (y < 0 || y >= cellCount)
+				continue;
+			// inside the shell, only its two faces along Z are visited
+			const bool inner = (std::abs(dx) != distance && std::abs(dy) != distance);
+			const int stepZ = (inner ? std::max(2 * distance, 1) : 1);
+			for (int dz = -distance; dz <= distance; dz += stepZ)
+			{
+				const int z = center.z + dz;
+				if (z < 0 || z >= cellCount)
+					continue;
+
+				const Tuple3i pos(x, y, z);
+				const CCCoreLib::DgmOctree::CellCode code = CCCoreLib::DgmOctree::GenerateTruncatedCellCode(pos, level);
+				auto it = std::lower_bound(cells.codes.begin(), cells.codes.end(), code);
+				if (it != cells.codes.end() && *it == code)
+				{
+					visitor(cells.points[it - cells.codes.begin()]);
+				}
+			}
+		}
+	}
+}
+
+void OctreeNeighborhood::kNearest(const CCVector3& P, unsigned k, unsigned char level, bool simplified, std::vector<unsigned>& neighbors) const
+{
+	neighbors.clear();
+	if (k == 0)
+	{
+		return;
+	}
+
+	if (!simplified)
+	{
+		CCCoreLib::ReferenceCloud Yk(m_octree->associatedCloud());
+		double maxSquareDist = 0;
+		m_octree->findPointNeighbourhood(&P, &Yk, k, level, maxSquareDist);
+		neighbors.reserve(Yk.size());
+		for (unsigned i = 0; i < Yk.size(); ++i)
+		{
+			neighbors.push_back(Yk.getPointGlobalIndex(i));
+		}
+		return;
+	}
+
+	auto cellsIt = m_cells.find(level);
+	assert(cellsIt != m_cells.end());
+	const Cells& cells = cellsIt->second;
+	const CCCoreLib::GenericIndexedCloudPersist* cloud = m_octree->associatedCloud();
+	const PointCoordinateType cellSize = m_octree->getCellSize(level);
+	Tuple3i center;
+	m_octree->getTheCellPosWhichIncludesThePoint(&P, center, level);
+
+	// max-heap of the k nearest representatives found so far (the cells are visited by growing shells)
+	std::vector<std::pair<PointCoordinateType, unsigned>> heap;
+	heap.reserve(k);
+	const std::size_t count = std::min(static_cast<std::size_t>(k), cells.points.size());
+	for (int distance = 0; distance < (1 << level); ++distance)
+	{
+		visitShell(cells, level, center, distance, [&](unsigned index)
+		{
+			PointCoordinateType squareDist = (*cloud->getPoint(index) - P).norm2();
+			if (heap.size() < count)
+			{
+				heap.emplace_back(squareDist, index);
+				std::push_heap(heap.begin(), heap.end());
+			}
+			else if (squareDist < heap.front().first)
+			{
+				std::pop_heap(heap.begin(), heap.end());
+				heap.back() = { squareDist, index };
+				std::push_heap(heap.begin(), heap.end());
+			}
+		});
+
+		// the cells of the next shells are at least 'distance' cells away from the point
+		PointCoordinateType reach = distance * cellSize;
+		if (heap.size() == count && heap.front().first <= reach * reach)
+		{
+			break;
+		}
+	}
+
+	std::sort_heap(heap.begin(), heap.end());
+	neighbors.reserve(heap.size());
+	for (const auto& neighbor : heap)
+	{
+		neighbors.push_back(neighbor.second);
+	}
+}
+
+void OctreeNeighborhood::inSphere(const CCVector3& P, PointCoordinateType radius, unsigned char level, bool simplified, std::vector<unsigned>& neighbors) const
+{
+	neighbors.clear();
+
+	if (!simplified)
+	{
+		CCCoreLib::DgmOctree::NeighboursSet neighbours;
+		m_octree->getPointsInSphericalNeighbourhood(P, radius, neighbours, level);
+		neighbors.reserve(neighbours.size());
+		for (const CCCoreLib::DgmOctree::PointDescriptor& neighbour : neighbours)
+		{
+			neighbors.push_back(neighbour.pointIndex);
+		}
+		return;
+	}
+
+	auto cellsIt = m_cells.find(level);
+	assert(cellsIt != m_cells.end());
+	const Cells& cells = cellsIt->second;
+	const CCCoreLib::GenericIndexedCloudPersist* cloud = m_octree->associatedCloud();
+	const PointCoordinateType squareRadius = radius * radius;
+	Tuple3i center;
+	m_octree->getTheCellPosWhichIncludesThePoint(&P, center, level);
+
+	const int maxDistance = static_cast<int>(std::ceil(radius / m_octree->getCellSize(level)));
+	for (int distance = 0; distance <= maxDistance; ++distance)
+	{
+		visitShell(cells, level, center, distance, [&](unsigned index)
+		{
+			if ((*cloud->getPoint(index) - P).norm2() <= squareRadius)
+				neighbors.push_back(index);
+		});
+	}
+}
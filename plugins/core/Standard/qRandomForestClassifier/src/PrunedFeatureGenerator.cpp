@@ -0,0 +1,205 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "PrunedFeatureGenerator.h"
+
+//system
+#include <algorithm>
+#include <cmath>
+
+// Point based features (same order as Point_set_feature_generator::generate_point_based_features)
+enum PointFeature
+{
+	DISTANCE_TO_PLANE = 0,
+	EIGENVALUE_0 = 1,
+	EIGENVALUE_1 = 2,
+	EIGENVALUE_2 = 3,
+	ELEVATION = 4,
+	HEIGHT_BELOW = 5,
+	HEIGHT_ABOVE = 6,
+	VERTICAL_RANGE = 7,
+	VERTICAL_DISPERSION = 8,
+	VERTICALITY = 9
+};
+
+//! Radius of the elevation feature (radius_dtm of Point_set_feature_generator), in voxels
+static const float s_dtmRadius = 10.0f;
+
+static bool RequiresEigenAnalysis(std::size_t feature)
+{
+	return (feature <= EIGENVALUE_2 || feature == VERTICALITY);
+}
+
+static bool RequiresGrid(std::size_t feature)
+{
+	return (feature >= ELEVATION && feature <= VERTICAL_DISPERSION);
+}
+
+double PrunedFeatureGenerator::SupportRadius(int nscales, double voxelSize)
+{
+	return s_dtmRadius * voxelSize * std::pow(2.0, std::max(nscales, 1) - 1);
+}
+
+PrunedFeatureGenerator::PrunedFeatureGenerator(const Index_range& input, CC_point_map pointMap, int nscales, float voxelSize, std::unique_ptr<OctreeNeighborhood> octree)
+	: m_input(input)
+	, m_pointMap(pointMap)
+	, m_scales(static_cast<std::size_t>(std::max(nscales, 1)))
+	, m_octree(std::move(octree))
+{
+	assert(voxelSize > 0);
+
+	// same bounding box as Point_set_feature_generator
+	CCVector3 bbMin(0, 0, 0);
+	CCVector3 bbMax(0, 0, 0);
+	for (std::size_t i = 0; i < m_input.size(); ++i)
+	{
+		const Point& P = get(m_pointMap, i);
+		if (i == 0)
+		{
+			bbMin = bbMax = CCVector3(P.x(), P.y(), P.z());
+			continue;
+		}
+		bbMin.x = std::min(bbMin.x, P.x()); bbMax.x = std::max(bbMax.x, P.x());
+		bbMin.y = std::min(bbMin.y, P.y()); bbMax.y = std::max(bbMax.y, P.y());
+		bbMin.z = std::min(bbMin.z, P.z()); bbMax.z = std::max(bbMax.z, P.z());
+	}
+	m_bbox = Iso_cuboid_3(bbMin.x, bbMin.y, bbMin.z, bbMax.x, bbMax.y, bbMax.z);
+
+	for (std::size_t j = 0; j < m_scales.size(); ++j)
+	{
+		m_scales[j].voxelSize = (j == 0 ? voxelSize : 2 * m_scales[j - 1].voxelSize);
+	}
+}
+
+void PrunedFeatureGenerator::generatePointBasedFeatures(Feature_set& features, const std::vector<bool>& used, const std::vector<std::string>& names, StageProfiler* profiler)
+{
+	typedef Classification::Feature::Distance_to_plane<Index_range, CC_point_map> Distance_to_plane;
+	typedef Classification::Feature::Eigenvalue Eigenvalue;
+	typedef Classification::Feature::Elevation<Kernel, Index_range, CC_point_map> Elevation;
+	typedef Classification::Feature::Height_below<Kernel, Index_range, CC_point_map> Height_below;
+	typedef Classification::Feature::Height_above<Kernel, Index_range, CC_point_map> Height_above;
+	typedef Classification::Feature::Vertical_range<Kernel, Index_range, CC_point_map> Vertical_range;
+	typedef Classification::Feature::Vertical_dispersion<Kernel, Index_range, CC_point_map> Vertical_dispersion;
+	typedef Classification::Feature::Verticality<Kernel> Verticality;
+
+	assert(used.size() == m_scales.size() * FeaturesPerScale);
+	assert(names.size() == used.size());
+
+	for (std::size_t j = 0; j < m_scales.size(); ++j)
+	{
+		Scale& scale = m_scales[j];
+
+		// compute the structures required by the used features of this scale
+		bool eigen = false;
+		bool grid = false;
+		for (std::size_t k = 0; k < FeaturesPerScale; ++k)
+		{
+			if (used[j * FeaturesPerScale + k])
+			{
+				eigen |= RequiresEigenAnalysis(k);
+				grid |= RequiresGrid(k);
+			}
+		}
+		StageProfiler::Scope stage((eigen && !scale.eigen) || (grid && !scale.grid) ? profiler : nullptr, "features: scale " + std::to_string(j) + " structures", m_input.size());
+		if (eigen && !scale.eigen)
+		{
+			if (m_octree)
+			{
+				// the same octree serves all the scales (one point per cell of the matching level, all the points for the first one)
+				if (j == 0)
+					scale.eigen.reset(new Local_eigen_analysis(Local_eigen_analysis::create_from_point_set
+						(m_input, m_pointMap, m_octree->k_neighbor_query(12), CGAL::Parallel_if_available_tag())));
+				else
+					scale.eigen.reset(new Local_eigen_analysis(Local_eigen_analysis::create_from_point_set
+						(m_input, m_pointMap, m_octree->k_neighbor_query(12, scale.voxelSize), CGAL::Parallel_if_available_tag())));
+			}
+			else
+			{
+				// the first scale of Point_set_feature_generator uses all the points (no voxel simplification)
+				if (j == 0)
+					scale.neighborhood.reset(new Neighborhood(m_input, m_pointMap));
+				else
+					scale.neighborhood.reset(new Neighborhood(m_input, m_pointMap, scale.voxelSize));
+				scale.eigen.reset(new Local_eigen_analysis(Local_eigen_analysis::create_from_point_set
+					(m_input, m_pointMap, scale.neighborhood->k_neighbor_query(12), CGAL::Parallel_if_available_tag())));
+			}
+		}
+		if (grid && !scale.grid)
+		{
+			// the coarser grids of Point_set_feature_generator are built from the finer ones, which gives the same cells
+			scale.grid.reset(new Planimetric_grid(m_input, m_pointMap, m_bbox, scale.voxelSize));
+		}
+
+		for (std::size_t k = 0; k < FeaturesPerScale; ++k)
+		{
+			std::size_t index = j * FeaturesPerScale + k;
+			if (!used[index])
+			{
+				features.add<Unused_feature>(names[index]);
+				continue;
+			}
+
+			switch (k)
+			{
+			case DISTANCE_TO_PLANE:
+				features.add_with_scale_id<Distance_to_plane>(j, m_input, m_pointMap, *scale.eigen);
+				break;
+			case EIGENVALUE_0:
+			case EIGENVALUE_1:
+			case EIGENVALUE_2:
+				features.add_with_scale_id<Eigenvalue>(j, m_input, *scale.eigen, static_cast<unsigned int>(k - EIGENVALUE_0));
+				break;
+			case ELEVATION:
+				features.add_with_scale_id<Elevation>(j, m_input, m_pointMap, *scale.grid, scale.voxelSize * s_dtmRadius);
+				break;
+			case HEIGHT_BELOW:
+				features.add_with_scale_id<Height_below>(j, m_input, m_pointMap, *scale.grid);
+				break;
+			case HEIGHT_ABOVE:
+				features.add_with_scale_id<Height_above>(j, m_input, m_pointMap, *scale.grid);
+				break;
+			case VERTICAL_RANGE:
+				features.add_with_scale_id<Vertical_range>(j, m_input, m_pointMap, *scale.grid);
+				break;
+			case VERTICAL_DISPERSION:
+				features.add_with_scale_id<Vertical_dispersion>(j, m_input, m_pointMap, *scale.grid, scale.voxelSize * 3); // radius_neighbors
+				break;
+			case VERTICALITY:
+				features.add_with_scale_id<Verticality>(j, m_input, *scale.eigen);
+				break;
+			default:
+				assert(false);
+				break;
+			}
+		}
+	}
+}
+
+void PrunedFeatureGenerator::generateColorBasedFeatures(Feature_set& features, CC_color_map colorMap)
+{
+	typedef Classification::Feature::Color_channel<Kernel, Index_range, CC_color_map> Color_channel;
+	for (std::size_t i = 0; i < 3; ++i)
+	{
+		features.add<Color_channel>(m_input, colorMap, Color_channel::Channel(i));
+	}
+}
+
+void PrunedFeatureGenerator::generateNormalBasedFeatures(Feature_set& features, CC_normal_map normalMap)
+{
+	typedef Classification::Feature::Verticality<Kernel> Verticality;
+	features.add<Verticality>(m_input, normalMap);
+}
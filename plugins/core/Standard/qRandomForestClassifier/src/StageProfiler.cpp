@@ -0,0 +1,196 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "StageProfiler.h"
+
+//Qt
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+//system
+#include <algorithm>
+#include <ctime>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+StageProfiler::Scope::Scope(StageProfiler* profiler, const std::string& name, std::size_t points)
+	: m_profiler(profiler)
+	, m_cpuStart(profiler ? CpuTime() : 0)
+{
+	m_stage.name = name;
+	m_stage.count = 1;
+	m_stage.points = points;
+	if (m_profiler)
+		m_timer.start();
+}
+
+StageProfiler::Scope::~Scope()
+{
+	stop();
+}
+
+void StageProfiler::Scope::stop()
+{
+	if (!m_profiler)
+		return;
+
+	m_timer.stop();
+	m_stage.wallTime = m_timer.time();
+	m_stage.cpuTime = CpuTime() - m_cpuStart;
+	m_stage.peakMemory = PeakMemory();
+	m_profiler->add(m_stage);
+	m_profiler = nullptr;
+}
+
+StageProfiler::StageProfiler()
+	: m_cpuStart(0)
+{
+	clear();
+}
+
+void StageProfiler::clear()
+{
+	QMutexLocker locker(&m_mutex);
+	m_stages.clear();
+	m_total.reset();
+	m_total.start();
+	m_cpuStart = CpuTime();
+}
+
+void StageProfiler::add(const Stage& stage)
+{
+	QMutexLocker locker(&m_mutex);
+	for (Stage& existing : m_stages)
+	{
+		if (existing.name == stage.name)
+		{
+			existing.count += stage.count;
+			existing.wallTime += stage.wallTime;
+			existing.cpuTime += stage.cpuTime;
+			existing.peakMemory = std::max(existing.peakMemory, stage.peakMemory);
+			existing.points += stage.points;
+			return;
+		}
+	}
+	m_stages.push_back(stage);
+}
+
+std::vector<StageProfiler::Stage> StageProfiler::stages() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_stages;
+}
+
+double StageProfiler::wallTime() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_total.time();
+}
+
+double StageProfiler::cpuTime() const
+{
+	QMutexLocker locker(&m_mutex);
+	return CpuTime() - m_cpuStart;
+}
+
+QByteArray StageProfiler::toJson(const QString& operation, bool compact) const
+{
+	QJsonArray stageArray;
+	for (const Stage& stage : stages())
+	{
+		QJsonObject object;
+		object.insert("name", QString::fromStdString(stage.name));
+		object.insert("count", static_cast<int>(stage.count));
+		object.insert("wall_time", stage.wallTime);
+		object.insert("cpu_time", stage.cpuTime);
+		object.insert("peak_memory", static_cast<double>(stage.peakMemory));
+		if (stage.points != 0)
+		{
+			object.insert("points", static_cast<double>(stage.points));
+			if (stage.wallTime > 0)
+				object.insert("points_per_second", stage.points / stage.wallTime);
+		}
+		stageArray.append(object);
+	}
+
+	QJsonObject report;
+	report.insert("operation", operation);
+	report.insert("wall_time", m_total.time());
+	report.insert("cpu_time", CpuTime() - m_cpuStart);
+	report.insert("peak_memory", static_cast<double>(PeakMemory()));
+	report.insert("stages", stageArray);
+
+	return QJsonDocument(report).toJson(compact ? QJsonDocument::Compact : QJsonDocument::Indented);
+}
+
+bool StageProfiler::save(const QString& filename, const QString& operation, QString& errorMessage) const
+{
+	QFile file(filename);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+	{
+		errorMessage = QString("Failed to open file [%1] for writing").arg(filename);
+		return false;
+	}
+	file.write(toJson(operation, false));
+	return true;
+}
+
+double StageProfiler::CpuTime()
+{
+#if defined(_WIN32)
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+		return 0;
+	ULARGE_INTEGER kernel, user;
+	kernel.LowPart = kernelTime.dwLowDateTime;
+	kernel.HighPart = kernelTime.dwHighDateTime;
+	user.LowPart = userTime.dwLowDateTime;
+	user.HighPart = userTime.dwHighDateTime;
+	return (kernel.QuadPart + user.QuadPart) * 1.0e-7; // 100 ns units
+#else
+	// clock() measures the CPU time of all the threads of the process
+	return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+std::size_t StageProfiler::PeakMemory()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#if defined(__APPLE__)
+	return static_cast<std::size_t>(usage.ru_maxrss); // bytes
+#else
+	return static_cast<std::size_t>(usage.ru_maxrss) * 1024; // kilobytes
+#endif
+#endif
+}
@@ -0,0 +1,234 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "SyntheticCloud.h"
+
+//qCC_db
+#include <ccPointCloud.h>
+#include <ccScalarField.h>
+
+//system
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+static const double s_pi = 3.14159265358979323846;
+
+namespace
+{
+	//! Object standing on the ground
+	struct Object
+	{
+		SyntheticCloud::Kind kind;
+		double x, y; //!< center of the footprint
+		double sx, sy; //!< footprint size (boxes), radius (sx, cylinders and crowns)
+		double height; //!< box or cylinder height, crown base
+		double rz; //!< vertical radius of the crowns
+	};
+
+	//! Returns the area (or volume for the crowns) the points of an object are drawn from
+	double ObjectWeight(const Object& object)
+	{
+		switch (object.kind)
+		{
+		case SyntheticCloud::PLANES:
+			return 2 * (object.sx + object.sy) * object.height + object.sx * object.sy;
+		case SyntheticCloud::CYLINDERS:
+			return 2 * s_pi * object.sx * object.height;
+		default:
+			return 4.0 / 3.0 * s_pi * object.sx * object.sx * object.rz;
+		}
+	}
+}
+
+std::vector<SyntheticCloud::Kind> SyntheticCloud::Kinds(const Layout& layout)
+{
+	std::vector<Kind> kinds = { GROUND };
+	if (layout.planes)
+		kinds.push_back(PLANES);
+	if (layout.cylinders)
+		kinds.push_back(CYLINDERS);
+	if (layout.vegetation)
+		kinds.push_back(VEGETATION);
+	return kinds;
+}
+
+std::vector<int> SyntheticCloud::Classes(const Layout& layout)
+{
+	std::vector<int> classes(Kinds(layout).size());
+	for (std::size_t i = 0; i < classes.size(); ++i)
+		classes[i] = static_cast<int>(i);
+	return classes;
+}
+
+ccPointCloud* SyntheticCloud::Generate(std::size_t pointCount, const Layout& layout, unsigned seed, QString& errorMessage)
+{
+	// object kinds (the label of the kind k is k + 1)
+	std::vector<Kind> kinds = Kinds(layout);
+	kinds.erase(kinds.begin());
+
+	std::size_t groundCount = kinds.empty() ? pointCount : static_cast<std::size_t>(std::round(pointCount * std::min(1.0, std::max(0.0, layout.groundRatio))));
+
+	// the ground keeps its density (and there is at least one cell per object kind)
+	double sceneSize = std::sqrt(static_cast<double>(groundCount)) * layout.spacing;
+	unsigned cellCount = std::max(1u, static_cast<unsigned>(sceneSize / layout.cellSize));
+	while (cellCount * cellCount < kinds.size())
+		++cellCount;
+	sceneSize = cellCount * layout.cellSize;
+
+	std::mt19937 generator(seed);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	std::normal_distribution<double> noise(0.0, layout.noise);
+	auto Uniform = [&](double min, double max) { return min + (max - min) * uniform(generator); };
+
+	// one object per cell (the kinds are evenly distributed over the shuffled cells)
+	std::vector<Object> objects;
+	if (!kinds.empty())
+	{
+		std::vector<unsigned> cells(cellCount * cellCount);
+		for (unsigned i = 0; i < cells.size(); ++i)
+			cells[i] = i;
+		std::shuffle(cells.begin(), cells.end(), generator);
+		for (unsigned i = 0; i < cells.size(); ++i)
+		{
+			Object object;
+			object.kind = kinds[i % kinds.size()];
+			double margin = 0.25 * layout.cellSize;
+			object.x = (cells[i] % cellCount) * layout.cellSize + Uniform(margin, layout.cellSize - margin);
+			object.y = (cells[i] / cellCount) * layout.cellSize + Uniform(margin, layout.cellSize - margin);
+			switch (object.kind)
+			{
+			case PLANES:
+				object.sx = Uniform(0.2, 0.45) * layout.cellSize;
+				object.sy = Uniform(0.2, 0.45) * layout.cellSize;
+				object.height = Uniform(0.3, 0.8) * layout.cellSize;
+				object.rz = 0;
+				break;
+			case CYLINDERS:
+				object.sx = object.sy = Uniform(0.015, 0.04) * layout.cellSize;
+				object.height = Uniform(0.3, 0.8) * layout.cellSize;
+				object.rz = 0;
+				break;
+			default:
+				object.sx = object.sy = Uniform(0.1, 0.25) * layout.cellSize;
+				object.height = Uniform(0.1, 0.3) * layout.cellSize;
+				object.rz = Uniform(0.1, 0.25) * layout.cellSize;
+				break;
+			}
+			objects.push_back(object);
+		}
+	}
+
+	ccPointCloud* cloud = new ccPointCloud(QString("synthetic_%1").arg(pointCount));
+	ccScalarField* labels = new ccScalarField("Classification");
+	if (!cloud->reserve(static_cast<unsigned>(pointCount)) || !labels->reserveSafe(static_cast<unsigned>(pointCount)))
+	{
+		labels->release();
+		delete cloud;
+		errorMessage = "Not enough memory to generate the synthetic cloud";
+		return nullptr;
+	}
+
+	auto AddPoint = [&](double x, double y, double z, int label)
+	{
+		cloud->addPoint(CCVector3(	static_cast<PointCoordinateType>(x + noise(generator)),
+									static_cast<PointCoordinateType>(y + noise(generator)),
+									static_cast<PointCoordinateType>(z + noise(generator))));
+		labels->addElement(static_cast<ScalarType>(label));
+	};
+
+	for (std::size_t i = 0; i < groundCount; ++i)
+	{
+		AddPoint(Uniform(0, sceneSize), Uniform(0, sceneSize), 0, 0);
+	}
+
+	// the remaining points are split evenly between the object kinds, then between their objects (by area)
+	std::size_t objectPointCount = pointCount - groundCount;
+	for (std::size_t k = 0; k < kinds.size(); ++k)
+	{
+		std::vector<const Object*> kindObjects;
+		std::vector<double> weights;
+		for (const Object& object : objects)
+		{
+			if (object.kind == kinds[k])
+			{
+				kindObjects.push_back(&object);
+				weights.push_back(ObjectWeight(object));
+			}
+		}
+		std::discrete_distribution<std::size_t> pick(weights.begin(), weights.end());
+
+		const int label = static_cast<int>(k + 1);
+		std::size_t count = objectPointCount / kinds.size() + (k < objectPointCount % kinds.size() ? 1 : 0);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const Object& object = *kindObjects[pick(generator)];
+			switch (object.kind)
+			{
+			case PLANES:
+			{
+				// walls and roof (by area)
+				double perimeter = 2 * (object.sx + object.sy);
+				double wallArea = perimeter * object.height;
+				if (uniform(generator) * (wallArea + object.sx * object.sy) < wallArea)
+				{
+					double t = Uniform(0, perimeter);
+					double x = -object.sx / 2, y = -object.sy / 2;
+					if (t < object.sx)
+						x += t;
+					else if (t < object.sx + object.sy)
+						x += object.sx, y += t - object.sx;
+					else if (t < 2 * object.sx + object.sy)
+						x += 2 * object.sx + object.sy - t, y += object.sy;
+					else
+						y += perimeter - t;
+					AddPoint(object.x + x, object.y + y, Uniform(0, object.height), label);
+				}
+				else
+				{
+					AddPoint(object.x + Uniform(-object.sx / 2, object.sx / 2), object.y + Uniform(-object.sy / 2, object.sy / 2), object.height, label);
+				}
+				break;
+			}
+			case CYLINDERS:
+			{
+				double angle = Uniform(0, 2 * s_pi);
+				AddPoint(object.x + object.sx * std::cos(angle), object.y + object.sx * std::sin(angle), Uniform(0, object.height), label);
+				break;
+			}
+			default:
+			{
+				// points scattered in the whole crown volume (foliage)
+				double z = Uniform(-1, 1);
+				double angle = Uniform(0, 2 * s_pi);
+				double r = std::cbrt(uniform(generator));
+				double h = std::sqrt(1 - z * z);
+				AddPoint(	object.x + object.sx * r * h * std::cos(angle),
+							object.y + object.sx * r * h * std::sin(angle),
+							object.height + object.rz * (1 + r * z),
+							label);
+				break;
+			}
+			}
+		}
+	}
+
+	labels->computeMinAndMax();
+	cloud->addScalarField(labels);
+
+	return cloud;
+}
@@ -0,0 +1,156 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "TrainingSampler.h"
+
+//system
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+namespace
+{
+	//! Voxel of a labelled point (label, voxel coordinates)
+	typedef std::tuple<int, int64_t, int64_t, int64_t> VoxelKey;
+
+	struct VoxelKeyHash
+	{
+		std::size_t operator()(const VoxelKey& key) const
+		{
+			std::size_t h = std::hash<int>()(std::get<0>(key));
+			h = h * 73856093u ^ std::hash<int64_t>()(std::get<1>(key));
+			h = h * 19349663u ^ std::hash<int64_t>()(std::get<2>(key));
+			h = h * 83492791u ^ std::hash<int64_t>()(std::get<3>(key));
+			return h;
+		}
+	};
+}
+
+TrainingSampler::TrainingSampler(std::size_t maxPoints, bool balanceClasses, double voxelSize, unsigned seed)
+	: m_maxPoints(maxPoints)
+	, m_balanceClasses(balanceClasses)
+	, m_voxelSize(voxelSize)
+	, m_rng(seed)
+{
+}
+
+void TrainingSampler::add(Reservoir& reservoir, std::size_t capacity, std::size_t index)
+{
+	++reservoir.seen;
+	if (reservoir.indices.size() < capacity)
+	{
+		reservoir.indices.push_back(index);
+		return;
+	}
+	// the new point replaces a random one with probability capacity/seen
+	std::size_t slot = std::uniform_int_distribution<std::size_t>(0, reservoir.seen - 1)(m_rng);
+	if (slot < capacity)
+		reservoir.indices[slot] = index;
+}
+
+std::size_t TrainingSampler::select(std::vector<int>& groundTruth, const Cloud_view* view)
+{
+	const std::size_t capacity = (m_maxPoints != 0 ? m_maxPoints : std::numeric_limits<std::size_t>::max());
+	const bool stratified = (m_voxelSize > 0 && view != nullptr);
+
+	// a reservoir per class (or a single one)
+	std::map<int, Reservoir> reservoirs;
+
+	if (stratified)
+	{
+		// one random point per (class, voxel)
+		std::unordered_map<VoxelKey, Reservoir, VoxelKeyHash> voxels;
+		for (std::size_t i = 0; i < groundTruth.size(); ++i)
+		{
+			if (groundTruth[i] == -1)
+				continue;
+			const CCVector3* P = view->point(i);
+			VoxelKey key(groundTruth[i],
+						static_cast<int64_t>(std::floor(P->x / m_voxelSize)),
+						static_cast<int64_t>(std::floor(P->y / m_voxelSize)),
+						static_cast<int64_t>(std::floor(P->z / m_voxelSize)));
+			add(voxels[key], 1, i);
+		}
+
+		// the representatives are sorted so that the selection doesn't depend on the hash map layout
+		std::vector<std::size_t> representatives;
+		representatives.reserve(voxels.size());
+		for (const auto& voxel : voxels)
+		{
+			representatives.push_back(voxel.second.indices.front());
+		}
+		std::sort(representatives.begin(), representatives.end());
+
+		for (std::size_t i : representatives)
+		{
+			add(reservoirs[m_balanceClasses ? groundTruth[i] : 0], capacity, i);
+		}
+	}
+	else
+	{
+		for (std::size_t i = 0; i < groundTruth.size(); ++i)
+		{
+			if (groundTruth[i] != -1)
+				add(reservoirs[m_balanceClasses ? groundTruth[i] : 0], capacity, i);
+		}
+	}
+
+	// share the point budget (the classes that have fewer points leave their share to the other ones)
+	std::map<int, std::size_t> quotas;
+	std::size_t budget = capacity;
+	std::size_t remaining = reservoirs.size();
+	std::vector<std::pair<std::size_t, int>> sizes;
+	for (const auto& reservoir : reservoirs)
+	{
+		sizes.push_back({ reservoir.second.indices.size(), reservoir.first });
+	}
+	std::sort(sizes.begin(), sizes.end());
+	for (const auto& size : sizes)
+	{
+		std::size_t share = budget / remaining;
+		quotas[size.second] = std::min(size.first, share);
+		budget -= quotas[size.second];
+		--remaining;
+	}
+
+	// keep a random subset of each reservoir
+	std::vector<bool> selected(groundTruth.size(), false);
+	std::size_t count = 0;
+	for (auto& reservoir : reservoirs)
+	{
+		std::vector<std::size_t>& indices = reservoir.second.indices;
+		std::size_t quota = quotas[reservoir.first];
+		if (quota < indices.size())
+			std::shuffle(indices.begin(), indices.end(), m_rng);
+		for (std::size_t k = 0; k < quota; ++k)
+		{
+			selected[indices[k]] = true;
+		}
+		count += quota;
+	}
+
+	for (std::size_t i = 0; i < groundTruth.size(); ++i)
+	{
+		if (!selected[i])
+			groundTruth[i] = -1;
+	}
+
+	return count;
+}
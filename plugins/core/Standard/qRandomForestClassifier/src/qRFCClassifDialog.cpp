@@ -352,6 +352,21 @@ bool qRFCClassifDialog::getExportFeatures() const {
 	bool exportFeatures = exportFeaturesCheckBox->isChecked();
 	return exportFeatures;
 }
+bool qRFCClassifDialog::getExportProbabilities() const {
+	return exportProbabilitiesCheckBox->isChecked();
+}
+double qRFCClassifDialog::getTileSize() const {
+	return tilingGroupBox->isChecked() ? tileSizeDoubleSpinBox->value() : 0.0;
+}
+double qRFCClassifDialog::getTileHalo() const {
+	return tileHaloDoubleSpinBox->value();
+}
+double qRFCClassifDialog::getSubsamplingDistance() const {
+	return subsamplingGroupBox->isChecked() ? subsamplingDistanceDoubleSpinBox->value() : 0.0;
+}
+int qRFCClassifDialog::getTransferNeighbors() const {
+	return transferNeighborsSpinBox->value();
+}
 QString qRFCClassifDialog::getClassifFilePath() const
 {
 	return classifFileLineEdit->text();
@@ -426,6 +441,13 @@ void qRFCClassifDialog::loadParamsFromPersistentSettings()
 	bool useConfThreshold = settings.value("UseConfThreshold", useConfThresholdGroupBox->isChecked()).toBool();
 	int regParam = settings.value("RegParam", regTypeComboBox->currentIndex()).toInt();
 	bool exportFeatures = settings.value("ExportFeatures", exportFeaturesCheckBox->isChecked()).toBool();
+	bool exportProbabilities = settings.value("ExportProbabilities", exportProbabilitiesCheckBox->isChecked()).toBool();
+	bool tiled = settings.value("Tiled", tilingGroupBox->isChecked()).toBool();
+	double tileSize = settings.value("TileSize", tileSizeDoubleSpinBox->value()).toDouble();
+	double tileHalo = settings.value("TileHalo", tileHaloDoubleSpinBox->value()).toDouble();
+	bool subsampled = settings.value("Subsampled", subsamplingGroupBox->isChecked()).toBool();
+	double subsamplingDistance = settings.value("SubsamplingDistance", subsamplingDistanceDoubleSpinBox->value()).toDouble();
+	int transferNeighbors = settings.value("TransferNeighbors", transferNeighborsSpinBox->value()).toInt();
 	settings.endGroup();
 
 	//apply parameters
@@ -438,6 +460,13 @@ void qRFCClassifDialog::loadParamsFromPersistentSettings()
 	regTypeComboBox->setCurrentIndex(regParam);
 	setFeatureList(features);
 	exportFeaturesCheckBox->setChecked(exportFeatures);
+	exportProbabilitiesCheckBox->setChecked(exportProbabilities);
+	tilingGroupBox->setChecked(tiled);
+	tileSizeDoubleSpinBox->setValue(tileSize);
+	tileHaloDoubleSpinBox->setValue(tileHalo);
+	subsamplingGroupBox->setChecked(subsampled);
+	subsamplingDistanceDoubleSpinBox->setValue(subsamplingDistance);
+	transferNeighborsSpinBox->setValue(transferNeighbors);
 
 	loadClassifierFile(classifFileLineEdit->text());
 }
@@ -461,6 +490,13 @@ void qRFCClassifDialog::saveParamsToPersistentSettings()
 	settings.setValue("UseConfThreshold", useConfThresholdGroupBox->isChecked());
 	settings.setValue("RegParam", regTypeComboBox->currentIndex());
 	settings.setValue("ExportFeatures", exportFeaturesCheckBox->isChecked());
+	settings.setValue("ExportProbabilities", exportProbabilitiesCheckBox->isChecked());
+	settings.setValue("Tiled", tilingGroupBox->isChecked());
+	settings.setValue("TileSize", tileSizeDoubleSpinBox->value());
+	settings.setValue("TileHalo", tileHaloDoubleSpinBox->value());
+	settings.setValue("Subsampled", subsamplingGroupBox->isChecked());
+	settings.setValue("SubsamplingDistance", subsamplingDistanceDoubleSpinBox->value());
+	settings.setValue("TransferNeighbors", transferNeighborsSpinBox->value());
 	settings.endGroup();
 }
 
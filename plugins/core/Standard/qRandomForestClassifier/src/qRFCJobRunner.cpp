@@ -0,0 +1,199 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "qRFCJobRunner.h"
+
+//qCC_plugins
+#include <ccMainAppInterface.h>
+
+//Qt
+#include <QMutexLocker>
+#include <QProgressDialog>
+#include <QtConcurrentRun>
+
+//! Refresh period of the progress dialog (ms)
+static const int s_refreshPeriod_ms = 200;
+
+qRFCJobProgress::qRFCJobProgress()
+	: m_percent(0)
+	, m_canceled(false)
+{
+}
+
+void qRFCJobProgress::update(float percent)
+{
+	m_percent = static_cast<int>(percent);
+}
+
+void qRFCJobProgress::setMethodTitle(const char* methodTitle)
+{
+	QMutexLocker locker(&m_mutex);
+	m_title = QString::fromUtf8(methodTitle);
+}
+
+void qRFCJobProgress::setInfo(const char* infoStr)
+{
+	QMutexLocker locker(&m_mutex);
+	m_info = QString::fromUtf8(infoStr);
+}
+
+void qRFCJobProgress::get(QString& title, QString& info, int& percent)
+{
+	QMutexLocker locker(&m_mutex);
+	title = m_title;
+	info = m_info;
+	percent = m_percent;
+}
+
+qRFCJobRunner::qRFCJobRunner(ccMainAppInterface* app, QObject* parent)
+	: QObject(parent)
+	, m_app(app)
+	, m_running(false)
+	, m_progressDlg(nullptr)
+{
+	connect(&m_watcher, &QFutureWatcher<bool>::finished, this, &qRFCJobRunner::onJobFinished);
+	connect(&m_timer, &QTimer::timeout, this, &qRFCJobRunner::refreshProgress);
+	m_timer.setInterval(s_refreshPeriod_ms);
+}
+
+qRFCJobRunner::~qRFCJobRunner()
+{
+	m_queue.clear();
+	if (m_running)
+	{
+		m_progress->cancel();
+		m_watcher.waitForFinished();
+	}
+}
+
+void qRFCJobRunner::enqueue(const Job& job)
+{
+	m_queue.push_back(job);
+	if (m_running)
+	{
+		if (m_app)
+			m_app->dispToConsole(QString("[RFC] Job '%1' queued (%2 job(s) pending)").arg(job.title).arg(jobCount()));
+		refreshProgress();
+		return;
+	}
+	startNext();
+}
+
+void qRFCJobRunner::cancelAll()
+{
+	// the queued jobs are never started
+	while (!m_queue.empty())
+	{
+		Job job = m_queue.front();
+		m_queue.pop_front();
+		if (job.finished)
+			job.finished(false, true);
+	}
+	if (m_running)
+	{
+		m_progress->cancel();
+	}
+}
+
+void qRFCJobRunner::startNext()
+{
+	if (m_running || m_queue.empty())
+	{
+		return;
+	}
+
+	m_current = m_queue.front();
+	m_queue.pop_front();
+	m_progress.reset(new qRFCJobProgress);
+	m_running = true;
+
+	if (!m_progressDlg)
+	{
+		m_progressDlg = new QProgressDialog(m_app ? m_app->getMainWindow() : nullptr);
+		m_progressDlg->setWindowIcon(QIcon(":/CC/plugin/qRandomForestClassifier/images/icon_classify.png"));
+		m_progressDlg->setWindowModality(Qt::NonModal); // the user can keep working meanwhile
+		m_progressDlg->setAutoClose(false);
+		m_progressDlg->setAutoReset(false);
+		m_progressDlg->setRange(0, 100);
+		m_progressDlg->setMinimumDuration(0);
+		connect(m_progressDlg, &QProgressDialog::canceled, this, &qRFCJobRunner::cancelAll);
+	}
+	m_progressDlg->reset(); // clears the 'canceled' state of the previous job
+	m_progressDlg->setValue(0);
+	m_progressDlg->show();
+	refreshProgress();
+
+	if (m_app)
+		m_app->dispToConsole(QString("[RFC] Job '%1' started").arg(m_current.title));
+
+	std::function<bool(CCCoreLib::GenericProgressCallback*)> run = m_current.run;
+	CCCoreLib::GenericProgressCallback* progress = m_progress.get();
+	m_watcher.setFuture(QtConcurrent::run([run, progress]() { return run(progress); }));
+	m_timer.start();
+}
+
+void qRFCJobRunner::onJobFinished()
+{
+	m_timer.stop();
+
+	Job job = m_current;
+	m_current = Job();
+	m_running = false;
+	bool canceled = m_progress->isCancelRequested();
+	bool success = m_watcher.result() && !canceled;
+
+	if (m_app)
+	{
+		if (canceled)
+			m_app->dispToConsole(QString("[RFC] Job '%1' canceled").arg(job.title), ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+		else if (!success)
+			m_app->dispToConsole(QString("[RFC] Job '%1' failed").arg(job.title), ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		else
+			m_app->dispToConsole(QString("[RFC] Job '%1' done").arg(job.title));
+	}
+
+	if (m_queue.empty() && m_progressDlg)
+	{
+		m_progressDlg->hide();
+	}
+
+	if (job.finished)
+		job.finished(success, canceled);
+
+	// the 'finished' function may have queued another job (already started in this case)
+	startNext();
+}
+
+void qRFCJobRunner::refreshProgress()
+{
+	if (!m_progressDlg || !m_running)
+	{
+		return;
+	}
+
+	QString title;
+	QString info;
+	int percent = 0;
+	m_progress->get(title, info, percent);
+
+	QString windowTitle = m_current.title;
+	if (!m_queue.empty())
+		windowTitle += QString(" (%1 more job(s) queued)").arg(m_queue.size());
+	m_progressDlg->setWindowTitle(windowTitle);
+	m_progressDlg->setLabelText(info.isEmpty() ? title : info);
+	m_progressDlg->setValue(percent);
+}
@@ -1,11 +1,14 @@
 #include "qRFCTools.h"
+#include "ClassificationOutput.h"
 
 //CCCoreLib
 #include <DistanceComputationTools.h>
 #include <Neighbourhood.h>
 #include <ParallelSort.h>
+#include <ReferenceCloud.h>
 
 //qCC_db
+#include <ccOctree.h>
 #include <ccPointCloud.h>
 #include <ccProgressDialog.h>
 #include <ccScalarField.h>
@@ -18,8 +21,13 @@
 #include <QApplication>
 #include <QComboBox>
 #include <QMainWindow>
+#include <QMutex>
 #include <QtConcurrentMap>
 
+//system
+#include <atomic>
+#include <map>
+
 QString qRFCTools::GetEntityName(ccHObject* obj)
 {
 	if (!obj)
@@ -103,3 +111,139 @@ bool qRFCTools::validScalarField(CCCoreLib::ScalarField* SF)
 
 	return true;
 }
+
+bool qRFCTools::TransferLabels(	ccPointCloud* sampledCloud,
+								const ClassificationOutput& sampledOutput,
+								ccPointCloud* cloud,
+								ClassificationOutput& output,
+								unsigned k,
+								bool votes,
+								CCCoreLib::GenericProgressCallback* progressCb)
+{
+	assert(sampledCloud && cloud);
+	assert(sampledOutput.size() == sampledCloud->size() && output.size() == cloud->size());
+	if (sampledCloud->size() == 0 || !sampledOutput.isValid() || !output.isValid())
+	{
+		return false;
+	}
+	k = std::max(1u, std::min(k, sampledCloud->size()));
+
+	ccOctree::Shared octree = sampledCloud->getOctree();
+	if (!octree)
+	{
+		octree = sampledCloud->computeOctree(progressCb);
+		if (!octree)
+		{
+			return false;
+		}
+	}
+	const unsigned char level = octree->findBestLevelForAGivenPopulationPerCell(std::max(k, 3u));
+
+	// the probabilities and features are copied from the nearest neighbor
+	std::vector<std::pair<const ccScalarField*, ccScalarField*>> copies;
+	if (sampledOutput.hasProbabilities() && output.hasProbabilities())
+	{
+		for (std::size_t c = 0; c < sampledOutput.classNames().size(); ++c)
+		{
+			copies.push_back({ sampledOutput.probability(c), output.probability(c) });
+		}
+		copies.push_back({ sampledOutput.confidence(), output.confidence() });
+	}
+	for (const auto& feature : sampledOutput.features())
+	{
+		ccScalarField* sf = output.feature(feature.first);
+		if (!sf)
+		{
+			return false;
+		}
+		copies.push_back({ feature.second, sf });
+	}
+	ccScalarField* voteField = nullptr;
+	if (votes)
+	{
+		voteField = output.feature("Label votes");
+		if (!voteField)
+		{
+			return false;
+		}
+	}
+
+	const ccScalarField* sampledLabels = sampledOutput.labels();
+	ccScalarField* labels = output.labels();
+	const unsigned pointCount = cloud->size();
+
+	// the points are processed by blocks (each block has its own neighborhood buffer)
+	static const unsigned s_blockSize = 4096;
+	std::vector<unsigned> blocks;
+	for (unsigned start = 0; start < pointCount; start += s_blockSize)
+	{
+		blocks.push_back(start);
+	}
+
+	CCCoreLib::NormalizedProgress nProgress(progressCb, static_cast<unsigned>(blocks.size()));
+	if (progressCb)
+	{
+		progressCb->setInfo("Transferring labels to the full cloud");
+		progressCb->start();
+	}
+	std::atomic<bool> canceled(false);
+	QMutex progressMutex;
+
+	QtConcurrent::blockingMap(blocks, [&](unsigned start)
+	{
+		if (canceled)
+			return;
+
+		CCCoreLib::ReferenceCloud neighbors(sampledCloud);
+		std::map<int, unsigned> count;
+		const unsigned end = std::min(start + s_blockSize, pointCount);
+		for (unsigned i = start; i < end; ++i)
+		{
+			neighbors.clear(false);
+			double maxSquareDist = 0;
+			if (octree->findPointNeighbourhood(cloud->getPoint(i), &neighbors, k, level, maxSquareDist) == 0)
+				continue;
+
+			// the neighbors are sorted by increasing distance
+			const unsigned nearest = neighbors.getPointGlobalIndex(0);
+			int label = static_cast<int>(sampledLabels->getValue(nearest));
+			unsigned best = 0;
+			if (neighbors.size() > 1)
+			{
+				count.clear();
+				for (unsigned j = 0; j < neighbors.size(); ++j)
+				{
+					++count[static_cast<int>(sampledLabels->getValue(neighbors.getPointGlobalIndex(j)))];
+				}
+				best = count[label];
+				for (const auto& c : count)
+				{
+					if (c.second > best)
+					{
+						label = c.first;
+						best = c.second;
+					}
+				}
+			}
+			else
+			{
+				best = 1;
+			}
+			labels->setValue(i, static_cast<ScalarType>(label));
+			if (voteField)
+				voteField->setValue(i, static_cast<ScalarType>(best) / neighbors.size());
+			for (const auto& copy : copies)
+			{
+				copy.second->setValue(i, copy.first->getValue(nearest));
+			}
+		}
+
+		QMutexLocker locker(&progressMutex);
+		if (!nProgress.oneStep())
+			canceled = true;
+	});
+
+	if (progressCb)
+		progressCb->stop();
+	return !canceled;
+}
@@ -418,6 +418,22 @@ int qRFCTrainingDialog::getMaxCorePoints() const
 {
 	return maxPointsSpinBox->value();
 }
+bool qRFCTrainingDialog::getOctreeNeighborhoods() const
+{
+	return octreeNeighborhoodsCheckBox->isChecked();
+}
+bool qRFCTrainingDialog::getBalanceClasses() const
+{
+	return balanceClassesCheckBox->isChecked();
+}
+double qRFCTrainingDialog::getSamplingVoxelSize() const
+{
+	return samplingVoxelDoubleSpinBox->value();
+}
+unsigned qRFCTrainingDialog::getSeed() const
+{
+	return static_cast<unsigned>(seedSpinBox->value());
+}
 int qRFCTrainingDialog::getNTrees() const
 {
 	return nTreesSpinBox->value();
@@ -721,9 +737,13 @@ void qRFCTrainingDialog::loadParamsFromPersistentSettings()
 
 	settings.beginGroup("Training");
 	unsigned maxPoints = settings.value("MaxPoints", maxPointsSpinBox->value()).toUInt();
+	bool balanceClasses = settings.value("BalanceClasses", balanceClassesCheckBox->isChecked()).toBool();
+	double samplingVoxelSize = settings.value("SamplingVoxelSize", samplingVoxelDoubleSpinBox->value()).toDouble();
+	int seed = settings.value("Seed", seedSpinBox->value()).toInt();
 	unsigned nTrees = settings.value("NTrees", nTreesSpinBox->value()).toUInt();
 	unsigned maxTreeDepth = settings.value("MaxTreeDepth", maxTreeDepthSpinBox->value()).toUInt();
 	bool evaluateParams = settings.value("EvaluateParams", evaluateParamsCheckBox->isChecked()).toBool();
+	bool octreeNeighborhoods = settings.value("OctreeNeighborhoods", octreeNeighborhoodsCheckBox->isChecked()).toBool();
 	settings.endGroup();
 
 	//apply parameters
@@ -732,9 +752,13 @@ void qRFCTrainingDialog::loadParamsFromPersistentSettings()
 	numberClassesSpinBox->setValue(nClasses);
 	classesLineEdit->setText(classesList);
 	maxPointsSpinBox->setValue(maxPoints);
+	balanceClassesCheckBox->setChecked(balanceClasses);
+	samplingVoxelDoubleSpinBox->setValue(samplingVoxelSize);
+	seedSpinBox->setValue(seed);
 	nTreesSpinBox->setValue(nTrees);
 	maxTreeDepthSpinBox->setValue(maxTreeDepth);
 	evaluateParamsCheckBox->setChecked(evaluateParams);
+	octreeNeighborhoodsCheckBox->setChecked(octreeNeighborhoods);
 	setFeatureList(features);
 }
 void qRFCTrainingDialog::saveParamsToPersistentSettings()
@@ -752,8 +776,12 @@ void qRFCTrainingDialog::saveParamsToPersistentSettings()
 
 	settings.beginGroup("Training");
 	settings.setValue("MaxPoints",maxPointsSpinBox->value());
+	settings.setValue("BalanceClasses", balanceClassesCheckBox->isChecked());
+	settings.setValue("SamplingVoxelSize", samplingVoxelDoubleSpinBox->value());
+	settings.setValue("Seed", seedSpinBox->value());
 	settings.setValue("NTrees", nTreesSpinBox->value());
 	settings.setValue("MaxTreeDepth", maxTreeDepthSpinBox->value());
 	settings.setValue("EvaluateParams", evaluateParamsCheckBox->isChecked());
+	settings.setValue("OctreeNeighborhoods", octreeNeighborhoodsCheckBox->isChecked());
 	settings.endGroup();
 }
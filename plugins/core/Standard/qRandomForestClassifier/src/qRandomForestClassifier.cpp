@@ -24,6 +24,9 @@
 #include "qRFCClassifDialog.h"
 #include "qRFCNoticeDialog.h"
 #include "Classifier.h"
+#include "qRFCCommands.h"
+#include "qRFCTools.h"
+#include "qRFCJobRunner.h"
 
 //CCCoreLib
 #include <CloudSamplingTools.h>
@@ -32,6 +35,116 @@
 #include <ccProgressDialog.h>
 #include <ccScalarField.h>
 
+//Qt
+#include <QFileDialog>
+#include <QFileInfo>
+
+//system
+#include <memory>
+
+//! Entities locked during a background job (unique ID and previous lock state)
+typedef std::vector<std::pair<unsigned, bool> > LockedEntities;
+
+//! Locks the clouds used by a background job (so that they can't be deleted meanwhile)
+static LockedEntities LockClouds(const std::vector<ccPointCloud*>& clouds)
+{
+	LockedEntities locked;
+	for (ccPointCloud* cloud : clouds)
+	{
+		locked.push_back({ cloud->getUniqueID(), cloud->isLocked() });
+		cloud->setLocked(true);
+	}
+	return locked;
+}
+
+//! Returns the cloud with the given unique ID (if it is still in the DB tree)
+static ccPointCloud* FindCloud(ccMainAppInterface* app, unsigned uniqueID)
+{
+	ccHObject* root = app ? app->dbRootObject() : nullptr;
+	ccHObject* obj = root ? root->find(uniqueID) : nullptr;
+	return (obj && obj->isA(CC_TYPES::POINT_CLOUD)) ? static_cast<ccPointCloud*>(obj) : nullptr;
+}
+
+//! Restores the lock state of the clouds used by a background job
+static void UnlockClouds(ccMainAppInterface* app, const LockedEntities& locked)
+{
+	for (const auto& entity : locked)
+	{
+		ccPointCloud* cloud = FindCloud(app, entity.first);
+		if (cloud)
+			cloud->setLocked(entity.second);
+	}
+}
+
+//! Results of a background classification
+struct ClassificationResults
+{
+	explicit ClassificationResults(ccMainAppInterface* app) : classifier(app) {}
+
+	Classifier classifier; //!< its console messages are displayed once the job is done
+	ClassificationOutput output; //!< scalar fields added to the cloud once the job is done
+	std::string report;
+};
+
+//! Queues the classification of a cloud (the labels are added to the cloud once the job is done)
+static void ClassifyInBackground(ccMainAppInterface* app, qRFCJobRunner* runner, ccPointCloud* cloud, const QString& classifierFilePath, const Classifier::ClassifyParams& params)
+{
+	unsigned cloudID = cloud->getUniqueID();
+	LockedEntities locked = LockClouds({ cloud });
+	std::shared_ptr<ClassificationResults> results = std::make_shared<ClassificationResults>(app);
+
+	qRFCJobRunner::Job job;
+	job.title = QString("Classification of '%1'").arg(cloud->getName());
+	job.run = [cloud, classifierFilePath, params, results](CCCoreLib::GenericProgressCallback* progressCb)
+	{
+		Classifier& classifier = results->classifier;
+		classifier.setProgressCallback(progressCb);
+		bool success = classifier.classify(cloud, classifierFilePath, results->output, params);
+		results->report = classifier.evaluationReport();
+		return success;
+	};
+	job.finished = [app, cloudID, locked, results](bool success, bool /*canceled*/)
+	{
+		results->classifier.flushConsoleMessages();
+		UnlockClouds(app, locked);
+		if (!success)
+			return;
+
+		ccPointCloud* cloud = FindCloud(app, cloudID);
+		if (!cloud)
+		{
+			app->dispToConsole("The classified cloud doesn't exist anymore", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			return;
+		}
+
+		QString errorMessage;
+		int idx = results->output.attach(cloud, errorMessage);
+		if (idx < 0)
+		{
+			app->dispToConsole(errorMessage, ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			return;
+		}
+		if (!errorMessage.isEmpty())
+			app->dispToConsole(errorMessage, ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+
+		cloud->setCurrentScalarField(idx);
+		cloud->setCurrentDisplayedScalarField(idx);
+		cloud->showSF(true);
+
+		cloud->prepareDisplayForRefresh();
+		app->refreshAll();
+		app->updateUI();
+
+		if (!results->report.empty())
+		{
+			EvaluationDialog evalDlg(results->report, (QWidget*)app->getMainWindow());
+			evalDlg.exec();
+		}
+	};
+
+	runner->enqueue(job);
+}
+
 // Constructor
 qRFC::qRFC( QObject *parent )
 	: QObject( parent )
@@ -39,9 +152,19 @@ qRFC::qRFC( QObject *parent )
 	//, m_action( nullptr )
 	, m_trainAction(nullptr)
 	, m_classifyAction(nullptr)
+	, m_jobRunner(nullptr)
 {
 }
 
+qRFCJobRunner* qRFC::jobRunner()
+{
+	if (!m_jobRunner)
+	{
+		m_jobRunner = new qRFCJobRunner(m_app, this);
+	}
+	return m_jobRunner;
+}
+
 void qRFC::onNewSelection(const ccHObject::Container& selectedEntities)
 {
 	if (m_classifyAction)
@@ -57,6 +180,18 @@ void qRFC::onNewSelection(const ccHObject::Container& selectedEntities)
 
 	m_selectedEntities = selectedEntities;
 }
+
+void qRFC::registerCommands(ccCommandLineInterface* cmd)
+{
+	if (!cmd)
+	{
+		assert(false);
+		return;
+	}
+	cmd->registerCommand(ccCommandLineInterface::Command::Shared(new CommandRFCTrain));
+	cmd->registerCommand(ccCommandLineInterface::Command::Shared(new CommandRFCClassify));
+	cmd->registerCommand(ccCommandLineInterface::Command::Shared(new CommandRFCMerge));
+}
 // This method returns all the 'actions' your plugin can perform.
 // getActions() will be called only once, when plugin is loaded.
 QList<QAction *> qRFC::getActions()
@@ -128,72 +263,15 @@ void qRFC::doClassifyAction()
 	params.classes_list = classesList;
 	params.eval_features = features;
 	params.export_features = exportFeatures;
+	params.export_probabilities = ctDlg.getExportProbabilities();
 	params.labels = labels;
+	params.tile_size = ctDlg.getTileSize();
+	params.tile_halo = ctDlg.getTileHalo();
+	params.subsampling_distance = ctDlg.getSubsamplingDistance();
+	params.transfer_neighbors = ctDlg.getTransferNeighbors();
 
-	Classifier classifier(m_app);
-	std::vector<int> label_indices;
-	std::map<std::string, std::vector<float>> exported_features;
-	std::tie(label_indices, exported_features) = classifier.classify(cloud, classifFilename, params);
-
-	if (label_indices.empty() && exported_features.empty())
-		return;
-
-	std::string SFName = "Classification";
-	if (cloud->getScalarFieldIndexByName(SFName.c_str()) != -1)
-	{
-		bool valid_name = false;
-		for (size_t i = 0; i < 256; ++i)
-			if (cloud->getScalarFieldIndexByName((SFName + " " + std::to_string(i)).c_str()) == -1)
-			{
-				SFName += " " + std::to_string(i);
-				valid_name = true;
-				break;
-			}
-		if (m_app && !valid_name)
-			m_app->dispToConsole("Name 'Classification' scalar field already exists.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-		if (!valid_name)
-			return;
-	}
-
-	ccScalarField* SF = new ccScalarField(SFName.c_str());
-	if (!SF->resizeSafe(cloud->size(), true, CCCoreLib::NAN_VALUE))
-	{
-		if (m_app)
-			m_app->dispToConsole("Not enough memory to store classification output.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-		return;
-	}
-
-	for (size_t i = 0; i < cloud->size(); ++i)
-	{
-		SF->setValue(i, label_indices.at(i));
-	}
-
-	SF->computeMinAndMax();
-	int idx = cloud->addScalarField(SF);
-	cloud->setCurrentScalarField(idx);
-	cloud->setCurrentDisplayedScalarField(idx);
-	cloud->showSF(true);
-
-	if (params.export_features)
-	{
-		std::cout << "Adding features to view" << std::endl;
-		for (auto& feature : exported_features)
-		{
-			if (feature.first.empty()) continue;
-			ccScalarField* eSF = new ccScalarField(feature.first.c_str());
-			eSF->resizeSafe(cloud->size(), true, CCCoreLib::NAN_VALUE);
-			for (size_t i = 0; i < cloud->size(); ++i)
-			{
-				eSF->setValue(i, feature.second.at(i));
-			}
-			eSF->computeMinAndMax();
-			cloud->addScalarField(eSF);
-		}
-	}
-
-	cloud->prepareDisplayForRefresh();
-	m_app->refreshAll();
-	m_app->updateUI();
+	// the classification runs in the background
+	ClassifyInBackground(m_app, jobRunner(), cloud, classifFilename, params);
 }
 
 void qRFC::doTrainAction()
@@ -221,12 +299,25 @@ void qRFC::doTrainAction()
 	Classifier::TrainParams params;
 	params.nscales = nScales;
 	params.min_scale = minScale;
+	params.octree_neighborhoods = ctDlg.getOctreeNeighborhoods();
 	params.evaluate_params = evaluateParams;
 	params.max_core_points = maxCorePoints;
+	params.balance_classes = ctDlg.getBalanceClasses();
+	params.sampling_voxel_size = ctDlg.getSamplingVoxelSize();
+	params.seed = ctDlg.getSeed();
 	params.num_trees = nTrees;
 	params.max_depth = maxTreeDepth;
 
-	QString classifier_path = "";
+	// the output file is selected beforehand (the background job can't open dialogs)
+	params.output_path = QFileDialog::getSaveFileName(m_app->getMainWindow(),
+		QString("Save classifier"),
+		"ethz_random_forest.bin",
+		QString("ETHZ Random Forest Classifier (*.bin);;All Files (*)"));
+	if (params.output_path.isEmpty())
+		return;
+
+	std::function<QString(Classifier&)> train;
+	std::vector<ccPointCloud*> trainingClouds;
 	if (ctDlg.getInputType())
 	{
 		params.classes_list = { 0,1 };
@@ -247,42 +338,13 @@ void qRFC::doTrainAction()
 		std::vector<std::pair<Features::Source, CCCoreLib::ScalarField*> > features2 = ctDlg.getFeatures(cloud2);
 		assert(features1.size() == features2.size());
 
-		ccPointCloud* evaluationCloud = ctDlg.getEvaluationCloud();
-
-		//progress dialog
-		//ccProgressDialog pDlg(true, m_app->getMainWindow());
-
 		assert(ctDlg.maxPointsSpinBox->value() > 0);
 
-		Classifier classifier(m_app);
-		classifier_path = classifier.train(cloud1, cloud2, features1, features2, params);
-
-		/*
-		if (params.export_features) {
-			std::cout << "Adding params to view" << std::endl;
-			for (auto& feature : exported_features) {
-				ccScalarField* eSF1 = new ccScalarField(feature.first.c_str());
-				eSF1->resizeSafe(cloud1->size(), true, CCCoreLib::NAN_VALUE);
-				for (size_t i = 0; i < cloud1->size(); ++i) {
-					eSF1->setValue(i, feature.second.at(i));
-				}
-				eSF1->computeMinAndMax();
-				cloud1->addScalarField(eSF1);
-
-				ccScalarField* eSF2 = new ccScalarField(feature.first.c_str());
-				eSF1->resizeSafe(cloud2->size(), true, CCCoreLib::NAN_VALUE);
-				for (size_t i = 0; i < cloud2->size(); ++i) {
-					eSF2->setValue(i, feature.second.at(cloud1->size() + i));
-				}
-				eSF2->computeMinAndMax();
-				cloud2->addScalarField(eSF2);
-			}
-			cloud1->prepareDisplayForRefresh();
-			cloud2->prepareDisplayForRefresh();
-			m_app->refreshAll();
-			m_app->updateUI();
-		}
-		*/
+		train = [cloud1, cloud2, features1, features2, params](Classifier& classifier)
+		{
+			return classifier.train(cloud1, cloud2, features1, features2, params);
+		};
+		trainingClouds = { cloud1, cloud2 };
 	}
 	else
 	{
@@ -308,17 +370,16 @@ void qRFC::doTrainAction()
 
 		params.features = ctDlg.getFeatures(cloud);
 
-		Classifier classifier(m_app);
-		classifier_path = classifier.train(cloud, SF, params);
-	}
-
-	if (classifier_path.isEmpty() || classifier_path.isNull())
-	{
-		if (m_app)
-			m_app->dispToConsole("Classifier either not created or saved.", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-		return;
+		train = [cloud, SF, params](Classifier& classifier)
+		{
+			return classifier.train(cloud, SF, params);
+		};
+		trainingClouds = { cloud };
 	}
 
+	// the evaluation cloud is classified once the classifier is trained
+	unsigned evaluationCloudID = 0;
+	Classifier::ClassifyParams classifyParams;
 	if (params.evaluate_params)
 	{
 		ccPointCloud* evaluationCloud = ctDlg.getEvaluationCloud();
@@ -328,78 +389,51 @@ void qRFC::doTrainAction()
 				m_app->dispToConsole("Evaluation point cloud was not defined!", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
 			return;
 		}
+		evaluationCloudID = evaluationCloud->getUniqueID();
 
-		std::cout << "classifier_path = " << classifier_path.toStdString() << std::endl;
-
-		Classifier::ClassifyParams classify_params;
-		classify_params.nscales = params.nscales;
-		classify_params.classes_list = params.classes_list;
-		classify_params.min_scale = params.min_scale;
-		classify_params.eval_features = ctDlg.getFeatures(evaluationCloud);
-		//classify_params.export_features = params.export_features;
-		Classifier classifier(m_app);
-		std::vector<int> label_indices;
-		std::map<std::string, std::vector<float>> exported_features;
-		std::tie(label_indices, exported_features) = classifier.classify(evaluationCloud, classifier_path, classify_params);
-
-		std::string SFName = "Classification";
-		if (evaluationCloud->getScalarFieldIndexByName(SFName.c_str()) != -1)
-		{
-			bool valid_name = false;
-			for (size_t i = 0; i < 256; ++i)
-			{
-				if (evaluationCloud->getScalarFieldIndexByName((SFName + " " + std::to_string(i)).c_str()) == -1)
-				{
-					SFName += " " + std::to_string(i);
-					valid_name = true;
-					break;
-				}
-			}
-			if (m_app && !valid_name)
-				m_app->dispToConsole("Name 'Classification' scalar field already exists.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-			if (!valid_name)
-				return;
-		}
+		classifyParams.nscales = params.nscales;
+		classifyParams.classes_list = params.classes_list;
+		classifyParams.min_scale = params.min_scale;
+		classifyParams.eval_features = ctDlg.getFeatures(evaluationCloud);
+		//classifyParams.export_features = params.export_features;
+	}
+
+	LockedEntities locked = LockClouds(trainingClouds);
+	std::shared_ptr<QString> classifierPath = std::make_shared<QString>();
+	// its console messages are displayed once the job is done
+	std::shared_ptr<Classifier> classifier = std::make_shared<Classifier>(m_app);
 
-		ccScalarField* SF = new ccScalarField(SFName.c_str());
-		if (!SF->resizeSafe(evaluationCloud->size(), true, CCCoreLib::NAN_VALUE))
+	qRFCJobRunner::Job job;
+	job.title = QString("Training of '%1'").arg(QFileInfo(params.output_path).fileName());
+	job.run = [train, classifier, classifierPath](CCCoreLib::GenericProgressCallback* progressCb)
+	{
+		classifier->setProgressCallback(progressCb);
+		*classifierPath = train(*classifier);
+		return !classifierPath->isEmpty();
+	};
+	job.finished = [this, locked, classifier, classifierPath, evaluationCloudID, classifyParams](bool success, bool canceled)
+	{
+		classifier->flushConsoleMessages();
+		UnlockClouds(m_app, locked);
+		if (!success)
 		{
-			if (m_app)
-				m_app->dispToConsole("Not enough memory to store classification output.", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			if (!canceled)
+				m_app->dispToConsole("Classifier either not created or saved.", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
 			return;
 		}
 
-		for (size_t i = 0; i < evaluationCloud->size(); ++i)
+		if (evaluationCloudID != 0)
 		{
-			SF->setValue(i, label_indices.at(i));
-		}
-
-		SF->computeMinAndMax();
-		int idx = evaluationCloud->addScalarField(SF);
-		evaluationCloud->setCurrentScalarField(idx);
-		evaluationCloud->setCurrentDisplayedScalarField(idx);
-		evaluationCloud->showSF(true);
-
-		evaluationCloud->prepareDisplayForRefresh();
-		m_app->refreshAll();
-		m_app->updateUI();
-		/*
-		if (params.export_features) {
-			std::cout << "Adding params to view" << std::endl;
-			for (auto& feature : exported_features) {
-				if (feature.first.empty()) continue;
-				ccScalarField* eSF = new ccScalarField(feature.first.c_str());
-				eSF->resizeSafe(cloudAndSF.first->size(), true, CCCoreLib::NAN_VALUE);
-				for (size_t i = 0; i < cloudAndSF.first->size(); ++i) {
-					eSF->setValue(i, feature.second.at(i));
-				}
-				eSF->computeMinAndMax();
-				cloudAndSF.first->addScalarField(eSF);
+			ccPointCloud* evaluationCloud = FindCloud(m_app, evaluationCloudID);
+			if (!evaluationCloud)
+			{
+				m_app->dispToConsole("The evaluation cloud doesn't exist anymore", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+				return;
 			}
-			cloudAndSF.first->prepareDisplayForRefresh();
-			m_app->refreshAll();
-			m_app->updateUI();
+			std::cout << "classifier_path = " << classifierPath->toStdString() << std::endl;
+			ClassifyInBackground(m_app, jobRunner(), evaluationCloud, *classifierPath, classifyParams);
 		}
-		*/
-	}
+	};
+
+	jobRunner()->enqueue(job);
 }
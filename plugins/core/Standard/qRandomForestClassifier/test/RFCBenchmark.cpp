@@ -0,0 +1,154 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "Benchmark.h"
+
+//Qt
+#include <QCommandLineParser>
+#include <QCoreApplication>
+
+//system
+#include <iostream>
+
+//! Parses a comma separated list of positive integers
+static bool ParseIntegerList(const QString& text, std::vector<int>& values)
+{
+	values.clear();
+	for (const QString& token : text.split(',', QString::SkipEmptyParts))
+	{
+		bool ok = false;
+		int value = token.toInt(&ok);
+		if (!ok || value < 1)
+		{
+			return false;
+		}
+		values.push_back(value);
+	}
+	return !values.empty();
+}
+
+//! Throughput benchmark of the classification pipeline on synthetic clouds (see Benchmark)
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("RFCBenchmark");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Measures the throughput of the training and classification of synthetic labelled clouds");
+	parser.addHelpOption();
+	QCommandLineOption sizesOption("sizes", "Comma separated numbers of points (default: 100000,1000000)", "values");
+	QCommandLineOption threadsOption("threads", "Comma separated thread counts (default: 1 and the number of cores)", "values");
+	QCommandLineOption layoutOption("layout", "Comma separated object kinds: PLANES, CYLINDERS and/or VEGETATION (default: all)", "kinds");
+	QCommandLineOption scalesOption("scales", "Number of scales (default: 5)", "count");
+	QCommandLineOption minScaleOption("min-scale", "Min. scale (default: estimated)", "scale");
+	QCommandLineOption octreeOption("octree-neighborhoods", "Octree neighborhoods (requires the min. scale)");
+	QCommandLineOption treesOption("num-trees", "Number of trees (default: 25)", "count");
+	QCommandLineOption depthOption("max-depth", "Max. depth of the trees (default: 20)", "depth");
+	QCommandLineOption corePointsOption("max-core-points", "Max. number of training points (default: all)", "count");
+	QCommandLineOption seedOption("seed", "Seed of the generated clouds and of the sampling (default: 0)", "seed");
+	QCommandLineOption reportOption("report", "Saves the results as a CSV file (one step per line)", "file.csv");
+	parser.addOptions({ sizesOption, threadsOption, layoutOption, scalesOption, minScaleOption, octreeOption, treesOption, depthOption, corePointsOption, seedOption, reportOption });
+	parser.process(app);
+
+	Benchmark::Settings settings;
+	bool ok = true;
+	if (parser.isSet(sizesOption))
+	{
+		std::vector<int> values;
+		ok = ParseIntegerList(parser.value(sizesOption), values);
+		settings.sizes.assign(values.begin(), values.end());
+	}
+	if (ok && parser.isSet(threadsOption))
+	{
+		ok = ParseIntegerList(parser.value(threadsOption), settings.threads);
+	}
+	if (ok && parser.isSet(layoutOption))
+	{
+		settings.layout.planes = settings.layout.cylinders = settings.layout.vegetation = false;
+		for (const QString& kind : parser.value(layoutOption).split(',', QString::SkipEmptyParts))
+		{
+			if (kind.toUpper() == "PLANES")
+				settings.layout.planes = true;
+			else if (kind.toUpper() == "CYLINDERS")
+				settings.layout.cylinders = true;
+			else if (kind.toUpper() == "VEGETATION")
+				settings.layout.vegetation = true;
+			else
+				ok = false;
+		}
+		ok = ok && (settings.layout.planes || settings.layout.cylinders || settings.layout.vegetation);
+	}
+	if (ok && parser.isSet(scalesOption))
+	{
+		settings.nscales = parser.value(scalesOption).toInt(&ok);
+		ok = ok && settings.nscales >= 1;
+	}
+	if (ok && parser.isSet(minScaleOption))
+	{
+		settings.min_scale = parser.value(minScaleOption).toDouble(&ok);
+	}
+	settings.octree_neighborhoods = parser.isSet(octreeOption);
+	if (ok && parser.isSet(treesOption))
+	{
+		settings.num_trees = parser.value(treesOption).toInt(&ok);
+		ok = ok && settings.num_trees >= 1;
+	}
+	if (ok && parser.isSet(depthOption))
+	{
+		settings.max_depth = parser.value(depthOption).toInt(&ok);
+		ok = ok && settings.max_depth >= 1;
+	}
+	if (ok && parser.isSet(corePointsOption))
+	{
+		settings.max_core_points = parser.value(corePointsOption).toInt(&ok);
+		ok = ok && settings.max_core_points >= 0;
+	}
+	if (ok && parser.isSet(seedOption))
+	{
+		settings.seed = parser.value(seedOption).toUInt(&ok);
+	}
+	if (!ok)
+	{
+		std::cerr << "Invalid parameter (see --help)" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<Benchmark::Result> results;
+	QString errorMessage;
+	Benchmark benchmark;
+	if (!benchmark.run(settings, results, errorMessage))
+	{
+		std::cerr << errorMessage.toStdString() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	for (const QString& line : Benchmark::Report(results))
+	{
+		std::cout << line.toStdString() << std::endl;
+	}
+	if (parser.isSet(reportOption))
+	{
+		if (!Benchmark::SaveCSV(parser.value(reportOption), results, errorMessage))
+		{
+			std::cerr << errorMessage.toStdString() << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::cout << "Benchmark report saved to '" << parser.value(reportOption).toStdString() << "'" << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "TestForestTrainer.h"
+
+#include "ForestTrainer.h"
+
+//system
+#include <random>
+#include <sstream>
+
+static const std::size_t s_sampleCount = 2000;
+
+//! Feature whose values are stored in a vector
+class Vector_feature : public CGAL::Classification::Feature_base
+{
+public:
+	Vector_feature(const std::string& name, const std::vector<float>& values)
+		: m_values(values)
+	{
+		this->set_name(name);
+	}
+
+	float value(std::size_t pt_index) override { return m_values[pt_index]; }
+
+protected:
+	const std::vector<float>& m_values;
+};
+
+//! Two noisy features and two labels (depending on their sum)
+struct TrainingData
+{
+	TrainingData()
+		: x(s_sampleCount)
+		, y(s_sampleCount)
+		, groundTruth(s_sampleCount)
+	{
+		std::mt19937 generator(1);
+		std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+		for (std::size_t i = 0; i < s_sampleCount; ++i)
+		{
+			x[i] = distribution(generator);
+			y[i] = distribution(generator);
+			groundTruth[i] = (x[i] + y[i] > 1.0f ? 1 : 0);
+		}
+
+		labels.add("low");
+		labels.add("high");
+		features.add<Vector_feature>("x", x);
+		features.add<Vector_feature>("y", y);
+	}
+
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<int> groundTruth;
+	Label_set labels;
+	Feature_set features;
+};
+
+//! Reads the forest of a classifier
+static void ReadForest(const ForestTrainer::Forest_classifier& classifier, ForestTrainer::Forest& forest)
+{
+	std::ostringstream config(std::ios_base::binary);
+	classifier.save_configuration(config);
+	std::istringstream input(config.str(), std::ios_base::binary);
+	forest.read(input);
+}
+
+void TestForestTrainer::testTreeCount() const
+{
+	TrainingData data;
+	ForestTrainer::Forest_classifier classifier(data.labels, data.features);
+
+	// chunks of 2 trees, the last one with a single tree
+	std::size_t chunkCount = 0;
+	QVERIFY(ForestTrainer::Train(classifier, data.groundTruth, true, 25, 10, [&](std::size_t) { ++chunkCount; return true; }));
+	QCOMPARE(chunkCount, std::size_t(13));
+	QCOMPARE(ForestTrainer::TreeCount(classifier), std::size_t(25));
+
+	// the classifier is trained again from scratch (with another max. depth)
+	QVERIFY(ForestTrainer::Train(classifier, data.groundTruth, true, 7, 3));
+
+	CGAL::internal::liblearning::RandomForest::ForestParams forestParams;
+	ForestTrainer::Forest forest(forestParams);
+	ReadForest(classifier, forest);
+	QCOMPARE(forest.trees.size(), std::size_t(7));
+	QCOMPARE(forest.params.max_depth, std::size_t(3));
+}
+
+void TestForestTrainer::testWarmStartTreeCount() const
+{
+	static const std::size_t NUM_TREES = 25;
+
+	TrainingData data;
+	ForestTrainer::Forest_classifier base(data.labels, data.features);
+	QVERIFY(ForestTrainer::Train(base, data.groundTruth, true, 4, 3));
+
+	// the new classifier is loaded from the saved one (as done by Classifier::train)
+	std::ostringstream config(std::ios_base::binary);
+	base.save_configuration(config);
+	ForestTrainer::Forest_classifier classifier(data.labels, data.features);
+	std::istringstream input(config.str(), std::ios_base::binary);
+	classifier.load_configuration(input);
+	QCOMPARE(ForestTrainer::TreeCount(classifier), std::size_t(4));
+
+	QVERIFY(ForestTrainer::Train(classifier, data.groundTruth, false, NUM_TREES, 5));
+
+	CGAL::internal::liblearning::RandomForest::ForestParams forestParams;
+	ForestTrainer::Forest forest(forestParams);
+	ReadForest(classifier, forest);
+	QCOMPARE(forest.trees.size(), 4 + NUM_TREES);
+	QCOMPARE(forest.params.max_depth, std::size_t(5));
+}
+
+QTEST_MAIN(TestForestTrainer)
@@ -0,0 +1,36 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_TEST_FOREST_TRAINER_HEADER
+#define Q_RFC_TEST_FOREST_TRAINER_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+//! Checks that the chunked training of the forest gives the requested trees
+class TestForestTrainer : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	//! Trains a new forest (with a last chunk smaller than the other ones)
+	void testTreeCount() const;
+	//! Adds trees to an existing forest (trained with other parameters)
+	void testWarmStartTreeCount() const;
+};
+
+#endif //Q_RFC_TEST_FOREST_TRAINER_HEADER
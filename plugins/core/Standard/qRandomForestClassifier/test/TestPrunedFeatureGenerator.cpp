@@ -0,0 +1,88 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#include "TestPrunedFeatureGenerator.h"
+
+#include "PrunedFeatureGenerator.h"
+#include "SyntheticCloud.h"
+
+//system
+#include <memory>
+
+static const int s_scaleCount = 3;
+static const float s_voxelSize = 0.2f;
+
+//! Compares the pruned features with the full ones (only the selected point based features are used)
+static void CompareFeatures(const std::vector<std::size_t>& usedFeatures)
+{
+	SyntheticCloud::Layout layout;
+	QString errorMessage;
+	std::unique_ptr<ccPointCloud> cloud(SyntheticCloud::Generate(20000, layout, 1, errorMessage));
+	QVERIFY2(cloud, qPrintable(errorMessage));
+
+	Cloud_view view(cloud.get());
+	Index_range input = view.range();
+
+	Feature_set fullFeatures;
+	Feature_generator generator(input, CC_point_map{ view }, s_scaleCount, s_voxelSize);
+	generator.generate_point_based_features(fullFeatures);
+	QCOMPARE(fullFeatures.size(), s_scaleCount * PrunedFeatureGenerator::FeaturesPerScale);
+
+	std::vector<std::string> names;
+	for (std::size_t i = 0; i < fullFeatures.size(); ++i)
+	{
+		names.push_back(fullFeatures[i]->name());
+	}
+	std::vector<bool> used(fullFeatures.size(), false);
+	for (std::size_t feature : usedFeatures)
+	{
+		used[feature] = true;
+	}
+
+	Feature_set prunedFeatures;
+	PrunedFeatureGenerator prunedGenerator(input, CC_point_map{ view }, s_scaleCount, s_voxelSize);
+	prunedGenerator.generatePointBasedFeatures(prunedFeatures, used, names);
+	QCOMPARE(prunedFeatures.size(), fullFeatures.size());
+
+	for (std::size_t feature : usedFeatures)
+	{
+		QCOMPARE(prunedFeatures[feature]->name(), fullFeatures[feature]->name());
+		for (std::size_t i = 0; i < view.size(); ++i)
+		{
+			if (prunedFeatures[feature]->value(i) != fullFeatures[feature]->value(i))
+			{
+				QFAIL(qPrintable(QString("Feature '%1' differs at point #%2").arg(QString::fromStdString(names[feature])).arg(i)));
+			}
+		}
+	}
+}
+
+void TestPrunedFeatureGenerator::testFirstScaleFeatures() const
+{
+	// eigenvalue 0, elevation and verticality of the first scale
+	CompareFeatures({ 1, 4, 9 });
+}
+
+void TestPrunedFeatureGenerator::testCoarserScaleFeatures() const
+{
+	// distance to plane of the second scale, vertical range and verticality of the third one
+	CompareFeatures({ PrunedFeatureGenerator::FeaturesPerScale,
+					  2 * PrunedFeatureGenerator::FeaturesPerScale + 7,
+					  2 * PrunedFeatureGenerator::FeaturesPerScale + 9 });
+}
+
+QTEST_MAIN(TestPrunedFeatureGenerator)
@@ -0,0 +1,36 @@
+//##########################################################################
+//#                                                                        #
+//#       CLOUDCOMPARE PLUGIN: Random Forest Classification Plugin         #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 of the License.               #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                           COPYRIGHT: Inria                             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_RFC_TEST_PRUNED_FEATURE_GENERATOR_HEADER
+#define Q_RFC_TEST_PRUNED_FEATURE_GENERATOR_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+//! Checks that the pruned features are the same as the ones of Point_set_feature_generator
+class TestPrunedFeatureGenerator : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	//! Compares the used features of the first scale (computed with all the points)
+	void testFirstScaleFeatures() const;
+	//! Compares the used features of the coarser scales (computed with voxel simplifications)
+	void testCoarserScaleFeatures() const;
+};
+
+#endif //Q_RFC_TEST_PRUNED_FEATURE_GENERATOR_HEADER